@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Archive Decoder
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Expands compressed YYYY.arc archives pulled off a plot's SD card back into
+// the CSV row format of the hourly MM-DD_HH.log files.
+//
+//   archive_decode [-s] FILE...
+//
+//   -s  print block, record and size statistics to stderr
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <archive.h>
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct decode_stats {
+  uint64_t blocks;
+  uint64_t bad_blocks;
+  uint64_t records;
+  uint64_t csv_bytes;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool decode_file(const char* path, decode_stats* stats);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  decode_stats stats = {};
+  bool print_stats = false;
+  bool ok = true;
+  int  num_files = 0;
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-s") == 0) {
+      print_stats = true;
+      continue;
+    }
+    ok &= decode_file(argv[i], &stats);
+    num_files++;
+  }
+
+  if(num_files == 0) {
+    fprintf(stderr, "usage: %s [-s] FILE...\n", argv[0]);
+    return 2;
+  }
+
+  if(print_stats) {
+    uint64_t arc_bytes = stats.blocks * ARCHIVE_BLOCK_SIZE;
+    fprintf(stderr, "blocks:       %llu (%llu bad)\n",
+      (unsigned long long)stats.blocks, (unsigned long long)stats.bad_blocks);
+    fprintf(stderr, "records:      %llu\n", (unsigned long long)stats.records);
+    fprintf(stderr, "archive size: %llu bytes\n", (unsigned long long)arc_bytes);
+    fprintf(stderr, "csv size:     %llu bytes\n", (unsigned long long)stats.csv_bytes);
+    if(stats.records > 0) {
+      fprintf(stderr, "bytes/record: %.1f (csv %.1f)\n",
+        (double)arc_bytes / stats.records, (double)stats.csv_bytes / stats.records);
+    }
+  }
+  return ok ? 0 : 1;
+}
+
+//==============================================================================
+// Decode One Archive File
+//==============================================================================
+static bool decode_file(const char* path, decode_stats* stats) {
+  // Local variables.
+  FILE*           in;
+  uint8_t         block[ARCHIVE_BLOCK_SIZE];
+  archive_decoder dec;
+  uint32_t        t;
+  float           values[ARCHIVE_MAX_COLUMNS];
+  uint64_t        block_num;
+
+  in = fopen(path, "rb");
+  if(!in) {
+    perror(path);
+    return false;
+  }
+
+  // Every block decodes on its own, so a corrupt sector only costs its
+  // own records.
+  block_num = 0;
+  while(fread(block, 1, ARCHIVE_BLOCK_SIZE, in) == ARCHIVE_BLOCK_SIZE) {
+    stats->blocks++;
+    if(!archive_dec_begin(&dec, block)) {
+      fprintf(stderr, "%s: skipping bad block %llu\n", path,
+        (unsigned long long)block_num);
+      stats->bad_blocks++;
+      block_num++;
+      continue;
+    }
+
+    while(archive_dec_next(&dec, &t, values)) {
+      // Timestamps are already shifted to local time by the firmware.
+      time_t    tt = (time_t)t;
+      struct tm tm;
+      char      date_string[32];
+      gmtime_r(&tt, &tm);
+      strftime(date_string, sizeof(date_string), "%Y-%m-%d %H:%M:%S PDT", &tm);
+
+      int len = printf("%s", date_string);
+      for(uint8_t i = 0; i < dec.num_columns; i++) {
+        len += printf(",%.2f", values[i]);
+      }
+      len += printf("\n");
+
+      stats->records++;
+      stats->csv_bytes += len;
+    }
+    if(dec.record != dec.num_records) {
+      fprintf(stderr, "%s: block %llu truncated after %u of %u records\n",
+        path, (unsigned long long)block_num, dec.record, dec.num_records);
+    }
+    block_num++;
+  }
+
+  fclose(in);
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,747 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Calibration Fitting
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Fits per-sensor calibration curves from raw captures and reference
+// measurements and writes Common/sensor_calc/calibration.h, so a new
+// calibration is a regenerated header instead of hand edits.
+//
+//   cal_fit [-r REFS.csv]... [-k FOLDS] [-j THREADS] [-w SECS] [-f]
+//           [-o HEADER] [CAPTURE.raw...]
+//
+//   -r  reference measurements, lines of "time,column,value" with the time
+//       as the logs write it and a log column name, e.g.
+//       "2021-07-01 12:00:00 PDT,irad_1_wsqm,812.4" from a reference
+//       pyranometer or "...,soil_0_volw,0.231" from a gravimetric sample
+//   -k  cross-validation folds (default 5); samples are split by day so a
+//       fold holds out whole days
+//   -j  threads (default: all cores)
+//   -w  how far a capture may be from a reference time (default 60)
+//   -f  use a fit even if it cross-validates worse than the current table
+//   -o  header to write (default stdout)
+//
+// Irradiance sensors are fitted with the firmware's polynomial in mean
+// ADS1115 counts (no constant term), TEROS-12s with a line in raw counts.
+// Each sensor's normal equations are accumulated in parallel over chunks of
+// its samples, once per fold, so every fold's training set is the total
+// minus that fold. Errors are measured through sensor_calc with the float
+// coefficients, i.e. as the board will log them.
+//
+// Sensors without enough references, or whose fit doesn't beat the current
+// coefficients under cross-validation, keep what calibration.h has now.
+// With no references at all the header is just rewritten as is.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <plot_log.h>
+#include <sensor_calc.h>
+#include <calibration.h>
+#include <raw_capture.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define MAX_PARAMS        (4)
+#define MAX_FOLDS         (32)
+#define DEFAULT_FOLDS     (5)
+#define DEFAULT_WINDOW    (60)
+#define MIN_SAMPLES       (10)
+#define LINE_LEN          (256)
+#define NUM_TARGETS       (NUM_IRAD_SENSORS + NUM_TEROS_12_SENSORS)
+#define COMMENT_COLUMN    (40)
+
+// Counts are scaled to about [-1, 1] so x^4 stays well conditioned.
+#define IRAD_SCALE        (32768.0)
+
+// Equation 6 from the TEROS 12 user manual 4.1.1 (mineral soil).
+#define TEROS_12_MANUAL_SLOPE   (0.0003879f)
+#define TEROS_12_MANUAL_OFFSET  (-0.6956f)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum target_kind {
+  TARGET_IRAD,
+  TARGET_TEROS_12
+};
+
+// A raw reading (mean counts or TEROS-12 raw) at a capture time.
+struct observation {
+  int64_t t;
+  float   x;
+};
+
+struct sample {
+  float   x;
+  float   y;
+  uint8_t fold;
+};
+
+// Accumulated A'A and A'y for one fold.
+struct normal_eq {
+  double   ata[MAX_PARAMS][MAX_PARAMS];
+  double   aty[MAX_PARAMS];
+  uint64_t n;
+};
+
+// One sensor to calibrate.
+struct target {
+  target_kind              kind;
+  uint8_t                  sensor;
+  char                     column[16];
+  uint8_t                  num_params;
+  std::vector<observation> obs;
+  std::vector<observation> refs;
+  std::vector<sample>      samples;
+  float                    current[MAX_PARAMS];
+  float                    fit[MAX_PARAMS];
+  bool                     solved;
+  bool                     used;
+  double                   cv_sse;
+  uint64_t                 cv_n;
+  double                   fit_rmse;
+  double                   cur_rmse;
+};
+
+// A thread's slice of every target's samples.
+struct chunk {
+  unsigned  index;
+  normal_eq eq[NUM_TARGETS][MAX_FOLDS];
+  double    cv_sse[NUM_TARGETS];
+  uint64_t  cv_n[NUM_TARGETS];
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static target   targets[NUM_TARGETS];
+static unsigned num_folds = DEFAULT_FOLDS;
+static unsigned num_threads = std::thread::hardware_concurrency();
+static int64_t  window = DEFAULT_WINDOW;
+
+// Per-fold solutions, filled between the two parallel passes.
+static float    fold_fit[NUM_TARGETS][MAX_FOLDS][MAX_PARAMS];
+static bool     fold_solved[NUM_TARGETS][MAX_FOLDS];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void    usage(const char* prog);
+static void    init_targets();
+static target* find_target(const char* column);
+static bool    read_refs(const char* path);
+static bool    read_capture(const char* path);
+static void    match_samples(target* tg);
+static void    accumulate(chunk* c);
+static void    cross_validate(chunk* c);
+static void    features(const target* tg, float x, double* phi);
+static float   predict(const target* tg, const float* coef, float x);
+static bool    solve(const normal_eq* eq, uint8_t n, const target* tg,
+                     float* coef);
+static double  rmse(const target* tg, const float* coef);
+static const char* plot_for(const char* column);
+static const char* format_float(float v, char* buf);
+static bool    write_header(FILE* out);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  const char*        out_path = NULL;
+  bool               force = false;
+  std::vector<chunk> chunks;
+
+  init_targets();
+  for(int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if(strcmp(argv[i], "-r") == 0 && has_value) {
+      if(!read_refs(argv[++i])) return 1;
+    }
+    else if(strcmp(argv[i], "-k") == 0 && has_value) num_folds = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-j") == 0 && has_value) num_threads = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-w") == 0 && has_value) window = atol(argv[++i]);
+    else if(strcmp(argv[i], "-o") == 0 && has_value) out_path = argv[++i];
+    else if(strcmp(argv[i], "-f") == 0) force = true;
+    else if(argv[i][0] != '-') {
+      if(!read_capture(argv[i])) return 1;
+    }
+    else usage(argv[0]);
+  }
+  if(num_folds < 2 || num_folds > MAX_FOLDS || window < 0) usage(argv[0]);
+  if(num_threads == 0) num_threads = 1;
+
+  for(target& tg : targets) match_samples(&tg);
+
+  // Pass 1: per-fold normal equations, each thread over its slice.
+  chunks.resize(num_threads);
+  std::vector<std::thread> threads;
+  for(unsigned i = 0; i < num_threads; i++) {
+    chunks[i].index = i;
+    threads.emplace_back(accumulate, &chunks[i]);
+  }
+  for(std::thread& t : threads) t.join();
+  threads.clear();
+
+  // Reduce, then solve the full fit and each fold's training set.
+  for(uint8_t g = 0; g < NUM_TARGETS; g++) {
+    target*   tg = &targets[g];
+    normal_eq total = {};
+    normal_eq folds[MAX_FOLDS] = {};
+
+    for(const chunk& c : chunks) {
+      for(unsigned f = 0; f < num_folds; f++) {
+        const normal_eq* e = &c.eq[g][f];
+        for(uint8_t r = 0; r < tg->num_params; r++) {
+          for(uint8_t s = 0; s < tg->num_params; s++) {
+            folds[f].ata[r][s] += e->ata[r][s];
+          }
+          folds[f].aty[r] += e->aty[r];
+        }
+        folds[f].n += e->n;
+      }
+    }
+    for(unsigned f = 0; f < num_folds; f++) {
+      for(uint8_t r = 0; r < tg->num_params; r++) {
+        for(uint8_t s = 0; s < tg->num_params; s++) {
+          total.ata[r][s] += folds[f].ata[r][s];
+        }
+        total.aty[r] += folds[f].aty[r];
+      }
+      total.n += folds[f].n;
+    }
+
+    tg->solved = total.n >= MIN_SAMPLES &&
+                 solve(&total, tg->num_params, tg, tg->fit);
+    for(unsigned f = 0; f < num_folds; f++) {
+      normal_eq train = total;
+      for(uint8_t r = 0; r < tg->num_params; r++) {
+        for(uint8_t s = 0; s < tg->num_params; s++) {
+          train.ata[r][s] -= folds[f].ata[r][s];
+        }
+        train.aty[r] -= folds[f].aty[r];
+      }
+      train.n -= folds[f].n;
+      fold_solved[g][f] = folds[f].n > 0 && train.n >= tg->num_params &&
+                          solve(&train, tg->num_params, tg, fold_fit[g][f]);
+    }
+  }
+
+  // Pass 2: held-out error of each fold's fit.
+  for(unsigned i = 0; i < num_threads; i++) {
+    threads.emplace_back(cross_validate, &chunks[i]);
+  }
+  for(std::thread& t : threads) t.join();
+
+  fprintf(stderr, "%-12s %7s %11s %11s %11s  %s\n", "sensor", "samples",
+    "current", "fit", "cross-val", "");
+  for(uint8_t g = 0; g < NUM_TARGETS; g++) {
+    target* tg = &targets[g];
+    for(const chunk& c : chunks) {
+      tg->cv_sse += c.cv_sse[g];
+      tg->cv_n += c.cv_n[g];
+    }
+    if(tg->samples.empty()) continue;
+
+    double cv_rmse = tg->cv_n ? sqrt(tg->cv_sse / tg->cv_n) : NAN;
+    tg->cur_rmse = rmse(tg, tg->current);
+    tg->fit_rmse = tg->solved ? rmse(tg, tg->fit) : NAN;
+    tg->used = tg->solved && (force || cv_rmse < tg->cur_rmse);
+    fprintf(stderr, "%-12s %7zu %11.4g %11.4g %11.4g  %s\n", tg->column,
+      tg->samples.size(), tg->cur_rmse, tg->fit_rmse, cv_rmse,
+      tg->used ? "updated" : !tg->solved ? "too few samples" : "kept");
+  }
+
+  // Write the header.
+  FILE* out = out_path ? fopen(out_path, "w") : stdout;
+  if(!out) {
+    perror(out_path);
+    return 1;
+  }
+  bool ok = write_header(out);
+  if(out != stdout) ok &= fclose(out) == 0;
+  return ok ? 0 : 1;
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+static void usage(const char* prog) {
+  fprintf(stderr, "usage: %s [-r REFS.csv]... [-k FOLDS] [-j THREADS] "
+    "[-w SECS] [-f] [-o HEADER] [CAPTURE.raw...]\n", prog);
+  exit(2);
+}
+
+//==============================================================================
+// Set Up Targets
+//==============================================================================
+// One per entry of the calibration tables, starting from their values.
+static void init_targets() {
+  for(uint8_t i = 0; i < NUM_IRAD_SENSORS; i++) {
+    target* tg = &targets[i];
+    tg->kind = TARGET_IRAD;
+    tg->sensor = i;
+    tg->num_params = 4;
+    snprintf(tg->column, sizeof(tg->column), "irad_%u_wsqm", i);
+    tg->current[0] = irad_cal[i].c4;
+    tg->current[1] = irad_cal[i].c3;
+    tg->current[2] = irad_cal[i].c2;
+    tg->current[3] = irad_cal[i].c1;
+  }
+  for(uint8_t i = 0; i < NUM_TEROS_12_SENSORS; i++) {
+    target* tg = &targets[NUM_IRAD_SENSORS + i];
+    tg->kind = TARGET_TEROS_12;
+    tg->sensor = i;
+    tg->num_params = 2;
+    snprintf(tg->column, sizeof(tg->column), "soil_%u_volw", i);
+    tg->current[0] = teros_12_cal[i].slope;
+    tg->current[1] = teros_12_cal[i].offset;
+  }
+}
+
+//==============================================================================
+// Find Target By Column
+//==============================================================================
+static target* find_target(const char* column) {
+  for(target& tg : targets) {
+    if(strcmp(tg.column, column) == 0) return &tg;
+  }
+  return NULL;
+}
+
+//==============================================================================
+// Read Reference Measurements
+//==============================================================================
+static bool read_refs(const char* path) {
+  // Local variables.
+  FILE*    in = fopen(path, "r");
+  char     line[LINE_LEN];
+  log_date date;
+  uint64_t line_num = 0;
+
+  if(!in) {
+    perror(path);
+    return false;
+  }
+
+  while(fgets(line, sizeof(line), in)) {
+    line_num++;
+    char* column = strchr(line, ',');
+    char* value = column ? strchr(column + 1, ',') : NULL;
+    if(!value || !log_parse_time(line, column, &date)) {
+      // A header line is fine; anything else later is a mistake.
+      if(line_num > 1) fprintf(stderr, "%s:%llu: bad line\n", path,
+        (unsigned long long)line_num);
+      continue;
+    }
+    *value++ = 0;
+
+    target* tg = find_target(column + 1);
+    if(!tg) {
+      fprintf(stderr, "%s:%llu: no calibration for %s\n", path,
+        (unsigned long long)line_num, column + 1);
+      continue;
+    }
+    tg->refs.push_back({log_time_from_date(&date), strtof(value, NULL)});
+  }
+
+  fclose(in);
+  return true;
+}
+
+//==============================================================================
+// Read Raw Capture
+//==============================================================================
+// Pulls out the mean irradiance counts and TEROS-12 raw counts of every
+// frame, the way read_sensors() computes them.
+static bool read_capture(const char* path) {
+  // Local variables.
+  FILE*                in = fopen(path, "rb");
+  std::vector<uint8_t> data;
+  uint8_t              buf[65536];
+  size_t               n;
+  raw_record           rec;
+  const plot_schema*   schema = NULL;
+  int64_t              t = 0;
+  uint32_t             torn = 0;
+
+  if(!in) {
+    perror(path);
+    return false;
+  }
+  while((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  fclose(in);
+
+  const uint8_t* p = data.data();
+  const uint8_t* end = p + data.size();
+  while(raw_next(&p, end, &rec, &torn)) {
+    if(rec.type == RAW_REC_FRAME) {
+      schema = plot_schema_by_id(rec.sensor);
+      t = raw_get_u32(rec.payload + 2);
+      continue;
+    }
+    if(!schema) continue;
+
+    if(rec.type == RAW_REC_ADC && rec.sensor < NUM_IRAD_SENSORS) {
+      int32_t sum = 0;
+      uint8_t samples = rec.len / sizeof(int16_t);
+      for(uint8_t i = 0; i < samples; i++) sum += raw_get_i16(rec.payload + 2 * i);
+      if(samples == 0) continue;
+      targets[rec.sensor].obs.push_back({t, (float)irad_mean_counts(sum, samples)});
+    }
+    else if(rec.type == RAW_REC_SDI && rec.sensor < NUM_TEROS_12_SENSORS) {
+      target* tg = &targets[NUM_IRAD_SENSORS + rec.sensor];
+      char     response[SDI_RESPONSE_LEN];
+      uint8_t  len = rec.len < SDI_RESPONSE_LEN ? rec.len : SDI_RESPONSE_LEN - 1;
+      float    raw, temp;
+      uint16_t conductivity;
+
+      // Only the soil sensors the plot logs VWC for are TEROS-12s.
+      bool is_teros_12 = false;
+      for(uint8_t c = 0; c < schema->num_columns; c++) {
+        is_teros_12 |= strcmp(schema->columns[c], tg->column) == 0;
+      }
+      if(!is_teros_12) continue;
+
+      memcpy(response, rec.payload, len);
+      response[len] = 0;
+      if(teros_12_parse(response, len, &raw, &temp, &conductivity)) {
+        tg->obs.push_back({t, raw});
+      }
+    }
+  }
+  if(torn) fprintf(stderr, "%s: skipped %lu torn bytes\n", path, (unsigned long)torn);
+  return true;
+}
+
+//==============================================================================
+// Pair References With Captures
+//==============================================================================
+// Each reference takes the nearest capture within the window. Folds go by
+// day so neighbouring minutes don't leak between training and held-out.
+static void match_samples(target* tg) {
+  auto by_time = [](const observation& a, const observation& b) {
+    return a.t < b.t;
+  };
+  std::sort(tg->obs.begin(), tg->obs.end(), by_time);
+
+  for(const observation& ref : tg->refs) {
+    auto it = std::lower_bound(tg->obs.begin(), tg->obs.end(), ref, by_time);
+    const observation* best = NULL;
+    if(it != tg->obs.end()) best = &*it;
+    if(it != tg->obs.begin() &&
+       (!best || ref.t - (it - 1)->t < best->t - ref.t)) {
+      best = &*(it - 1);
+    }
+    if(!best || llabs(best->t - ref.t) > window) continue;
+
+    int64_t day = ref.t / SECS_PER_DAY;
+    tg->samples.push_back({best->x, ref.x, (uint8_t)(day % num_folds)});
+  }
+}
+
+//==============================================================================
+// Accumulate Normal Equations
+//==============================================================================
+static void accumulate(chunk* c) {
+  for(uint8_t g = 0; g < NUM_TARGETS; g++) {
+    const target* tg = &targets[g];
+    size_t        n = tg->samples.size();
+    size_t        from = n * c->index / num_threads;
+    size_t        to = n * (c->index + 1) / num_threads;
+
+    memset(c->eq[g], 0, sizeof(c->eq[g]));
+    for(size_t i = from; i < to; i++) {
+      const sample* s = &tg->samples[i];
+      normal_eq*    e = &c->eq[g][s->fold];
+      double        phi[MAX_PARAMS];
+
+      features(tg, s->x, phi);
+      for(uint8_t r = 0; r < tg->num_params; r++) {
+        for(uint8_t q = 0; q < tg->num_params; q++) {
+          e->ata[r][q] += phi[r] * phi[q];
+        }
+        e->aty[r] += phi[r] * s->y;
+      }
+      e->n++;
+    }
+  }
+}
+
+//==============================================================================
+// Held-Out Error
+//==============================================================================
+static void cross_validate(chunk* c) {
+  for(uint8_t g = 0; g < NUM_TARGETS; g++) {
+    const target* tg = &targets[g];
+    size_t        n = tg->samples.size();
+    size_t        from = n * c->index / num_threads;
+    size_t        to = n * (c->index + 1) / num_threads;
+
+    c->cv_sse[g] = 0;
+    c->cv_n[g] = 0;
+    for(size_t i = from; i < to; i++) {
+      const sample* s = &tg->samples[i];
+      if(!fold_solved[g][s->fold]) continue;
+      double err = predict(tg, fold_fit[g][s->fold], s->x) - s->y;
+      c->cv_sse[g] += err * err;
+      c->cv_n[g]++;
+    }
+  }
+}
+
+//==============================================================================
+// Model Features
+//==============================================================================
+// Irradiance: u^4, u^3, u^2, u with u the scaled counts, matching c4..c1.
+// TEROS-12: raw, 1, matching slope and offset.
+static void features(const target* tg, float x, double* phi) {
+  if(tg->kind == TARGET_IRAD) {
+    double u = x / IRAD_SCALE;
+    phi[3] = u;
+    phi[2] = u * u;
+    phi[1] = phi[2] * u;
+    phi[0] = phi[1] * u;
+  }
+  else {
+    phi[0] = x;
+    phi[1] = 1;
+  }
+}
+
+//==============================================================================
+// Predict As The Board Would
+//==============================================================================
+static float predict(const target* tg, const float* coef, float x) {
+  if(tg->kind == TARGET_IRAD) {
+    irad_poly poly = {coef[0], coef[1], coef[2], coef[3]};
+    return irad_wsqm((int16_t)x, &poly);
+  }
+  teros_12_line line = {coef[0], coef[1]};
+  return teros_12_volw(x, &line);
+}
+
+//==============================================================================
+// Solve Normal Equations
+//==============================================================================
+// Gaussian elimination with partial pivoting; false if singular. The result
+// is unscaled into the firmware's coefficients.
+static bool solve(const normal_eq* eq, uint8_t n, const target* tg,
+                  float* coef) {
+  double a[MAX_PARAMS][MAX_PARAMS + 1];
+  double x[MAX_PARAMS];
+  double scale = 0;
+
+  for(uint8_t r = 0; r < n; r++) {
+    for(uint8_t s = 0; s < n; s++) a[r][s] = eq->ata[r][s];
+    a[r][n] = eq->aty[r];
+    scale = fmax(scale, fabs(a[r][r]));
+  }
+  if(scale == 0) return false;
+
+  for(uint8_t col = 0; col < n; col++) {
+    uint8_t pivot = col;
+    for(uint8_t r = col + 1; r < n; r++) {
+      if(fabs(a[r][col]) > fabs(a[pivot][col])) pivot = r;
+    }
+    if(fabs(a[pivot][col]) < scale * 1e-14) return false;
+    for(uint8_t s = 0; s <= n; s++) std::swap(a[col][s], a[pivot][s]);
+    for(uint8_t r = col + 1; r < n; r++) {
+      double m = a[r][col] / a[col][col];
+      for(uint8_t s = col; s <= n; s++) a[r][s] -= m * a[col][s];
+    }
+  }
+  for(int r = n - 1; r >= 0; r--) {
+    double v = a[r][n];
+    for(uint8_t s = r + 1; s < n; s++) v -= a[r][s] * x[s];
+    x[r] = v / a[r][r];
+  }
+
+  if(tg->kind == TARGET_IRAD) {
+    for(uint8_t k = 0; k < 4; k++) coef[k] = x[k] / pow(IRAD_SCALE, 4 - k);
+  }
+  else {
+    coef[0] = x[0];
+    coef[1] = x[1];
+  }
+  return true;
+}
+
+//==============================================================================
+// RMS Error Over All Samples
+//==============================================================================
+static double rmse(const target* tg, const float* coef) {
+  double sse = 0;
+  for(const sample& s : tg->samples) {
+    double err = predict(tg, coef, s.x) - s.y;
+    sse += err * err;
+  }
+  return tg->samples.empty() ? NAN : sqrt(sse / tg->samples.size());
+}
+
+//==============================================================================
+// Plot Logging A Column
+//==============================================================================
+static const char* plot_for(const char* column) {
+  static const char* names[NUM_PLOTS] = {"Plot-1", "Plot-2", "Plot-3"};
+  for(uint8_t p = 0; p < NUM_PLOTS; p++) {
+    for(uint8_t c = 0; c < plot_schemas[p].num_columns; c++) {
+      if(strcmp(plot_schemas[p].columns[c], column) == 0) {
+        return names[plot_schemas[p].plot_id - 1];
+      }
+    }
+  }
+  return "unused";
+}
+
+//==============================================================================
+// Shortest Float Literal
+//==============================================================================
+// The fewest significant digits that read back as the same float.
+static const char* format_float(float v, char* buf) {
+  for(int digits = 1; digits <= 9; digits++) {
+    snprintf(buf, 32, "%.*g", digits, v);
+    if(strtof(buf, NULL) == v) break;
+  }
+  return buf;
+}
+
+//==============================================================================
+// Write Calibration Header
+//==============================================================================
+static bool write_header(FILE* out) {
+  char note[128];
+  char num[32];
+
+  fputs(
+    "//------------------------------------------------------------------------------\n"
+    "// GFU Agrivoltaics Sensor Calibration\n"
+    "// Nathaniel Hudson\n"
+    "// nhudson18@georgefox.edu\n"
+    "// Summer 2021\n"
+    "//------------------------------------------------------------------------------\n"
+    "//\n"
+    "// Per-sensor coefficients, indexed by the sensor number in the log column\n"
+    "// names: irad_cal[1] is irad_1 (Plot-2), teros_12_cal[0] is soil_0\n"
+    "// (Plot-1).\n"
+    "//\n"
+    "// Generated by Cal-Fit from raw captures and reference measurements;\n"
+    "// rerun it rather than editing by hand. Entries without a fit are the\n"
+    "// previous values; TEROS 12 eq. 6 is the user manual's mineral soil\n"
+    "// equation.\n"
+    "//\n"
+    "//------------------------------------------------------------------------------\n"
+    "\n"
+    "#ifndef CALIBRATION_H\n"
+    "#define CALIBRATION_H\n"
+    "\n"
+    "//------------------------------------------------------------------------------\n"
+    "//             __             __   ___  __\n"
+    "//     | |\\ | /  ` |    |  | |  \\ |__  /__`\n"
+    "//     | | \\| \\__, |___ \\__/ |__/ |___ .__/\n"
+    "//\n"
+    "//------------------------------------------------------------------------------\n"
+    "\n"
+    "#include \"sensor_calc.h\"\n"
+    "\n"
+    "//------------------------------------------------------------------------------\n"
+    "//      __   ___  ___         ___  __\n"
+    "//     |  \\ |__  |__  | |\\ | |__  /__`\n"
+    "//     |__/ |___ |    | | \\| |___ .__/\n"
+    "//\n"
+    "//------------------------------------------------------------------------------\n"
+    "\n", out);
+  fprintf(out, "#define NUM_IRAD_SENSORS      (%d)\n", NUM_IRAD_SENSORS);
+  fprintf(out, "#define NUM_TEROS_12_SENSORS  (%d)\n", NUM_TEROS_12_SENSORS);
+  fputs(
+    "\n"
+    "//------------------------------------------------------------------------------\n"
+    "//                __          __        ___  __\n"
+    "//     \\  /  /\\  |__) |  /\\  |__) |    |__  /__`\n"
+    "//      \\/  /~~\\ |  \\ | /~~\\ |__) |___ |___ .__/\n"
+    "//\n"
+    "//------------------------------------------------------------------------------\n"
+    "\n", out);
+
+  for(uint8_t g = 0; g < NUM_TARGETS; g++) {
+    const target* tg = &targets[g];
+    const float*  c = tg->used ? tg->fit : tg->current;
+
+    if(g == 0) {
+      fputs("constexpr irad_poly irad_cal[NUM_IRAD_SENSORS] = {\n", out);
+    }
+    if(g == NUM_IRAD_SENSORS) {
+      fputs("constexpr teros_12_line teros_12_cal[NUM_TEROS_12_SENSORS] = {\n", out);
+    }
+
+    if(tg->used) {
+      snprintf(note, sizeof(note), "%s, %s: fit to %zu references, "
+        "RMSE %.3g", tg->column, plot_for(tg->column), tg->samples.size(),
+        tg->fit_rmse);
+    }
+    else if(tg->kind == TARGET_TEROS_12 && c[0] == TEROS_12_MANUAL_SLOPE &&
+            c[1] == TEROS_12_MANUAL_OFFSET) {
+      snprintf(note, sizeof(note), "%s, %s: TEROS 12 eq. 6",
+        tg->column, plot_for(tg->column));
+    }
+    else {
+      snprintf(note, sizeof(note), "%s, %s", tg->column, plot_for(tg->column));
+    }
+
+    // Entry, then the comment lined up after it.
+    int len = fprintf(out, "  {");
+    for(uint8_t k = 0; k < tg->num_params; k++) {
+      len += fprintf(out, "%s%s", k ? ", " : "", format_float(c[k], num));
+    }
+    len += fprintf(out, "},");
+    fprintf(out, "%*s// %s\n", len < COMMENT_COLUMN ? COMMENT_COLUMN - len : 1,
+      "", note);
+
+    if(g == NUM_IRAD_SENSORS - 1 || g == NUM_TARGETS - 1) fputs("};\n\n", out);
+  }
+  fputs("#endif\n", out);
+  return !ferror(out);
+}
@@ -0,0 +1,264 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Column Store Query
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Range queries against a plot-N.col store written by Log-Ingest -c.
+//
+//   col_query [-f FROM] [-t TO] [-H FIRST-LAST] [-c COL,...]
+//             [-w COL:MIN:MAX]... [-s] FILE
+//
+//   -f  start time, "YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS" (inclusive)
+//   -t  end time, same forms (exclusive)
+//   -H  only rows whose hour is FIRST through LAST, e.g. 12-13
+//   -c  columns to print (default: all)
+//   -w  only rows with MIN <= COL <= MAX; blocks whose zone map rules
+//       this out are never read
+//   -s  print block and row counts to stderr
+//
+// PV backsheet temperatures from 12:00 to 14:00 in July:
+//
+//   col_query -f 2021-07-01 -t 2021-08-01 -H 12-13
+//             -c temp_2_temp,temp_3_temp,temp_4_temp plot-2.col
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <column_store.h>
+#include <plot_log.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define MAX_FILTERS  (8)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct print_ctx {
+  uint8_t num_columns;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool parse_when(const char* arg, int64_t* t);
+static bool parse_columns(const col_store* s, char* arg, uint8_t* columns,
+                          uint8_t* num_columns);
+static bool parse_filter(const col_store* s, char* arg, col_filter* f);
+static void print_row(void* ctx, int64_t t, const float* values);
+static void usage(const char* name);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  col_store       store;
+  col_query       q = {};
+  col_query_stats stats;
+  uint8_t         columns[COL_MAX_COLUMNS];
+  col_filter      filters[MAX_FILTERS];
+  const char*     path = NULL;
+  char*           column_arg = NULL;
+  char*           filter_args[MAX_FILTERS];
+  uint8_t         num_filter_args = 0;
+  bool            print_stats = false;
+  print_ctx       ctx;
+  timespec        start, stop;
+
+  q.from = INT64_MIN;
+  q.to = INT64_MAX;
+  q.first_hour = -1;
+
+  for(int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if(strcmp(argv[i], "-f") == 0 && has_value) {
+      if(!parse_when(argv[++i], &q.from)) usage(argv[0]);
+    }
+    else if(strcmp(argv[i], "-t") == 0 && has_value) {
+      if(!parse_when(argv[++i], &q.to)) usage(argv[0]);
+    }
+    else if(strcmp(argv[i], "-H") == 0 && has_value) {
+      int first, last;
+      if(sscanf(argv[++i], "%d-%d", &first, &last) != 2 || first < 0 ||
+         first > 23 || last < 0 || last > 23) {
+        usage(argv[0]);
+      }
+      q.first_hour = first;
+      q.last_hour = last;
+    }
+    else if(strcmp(argv[i], "-c") == 0 && has_value) {
+      column_arg = argv[++i];
+    }
+    else if(strcmp(argv[i], "-w") == 0 && has_value &&
+            num_filter_args < MAX_FILTERS) {
+      filter_args[num_filter_args++] = argv[++i];
+    }
+    else if(strcmp(argv[i], "-s") == 0) {
+      print_stats = true;
+    }
+    else if(argv[i][0] != '-' && !path) {
+      path = argv[i];
+    }
+    else {
+      usage(argv[0]);
+    }
+  }
+  if(!path) usage(argv[0]);
+  if(!col_open(&store, path, false)) return 1;
+
+  // Column names can only be resolved once the store is open.
+  if(column_arg) {
+    if(!parse_columns(&store, column_arg, columns, &q.num_columns)) return 2;
+  }
+  else {
+    q.num_columns = store.header->num_columns;
+    for(uint8_t i = 0; i < q.num_columns; i++) columns[i] = i;
+  }
+  for(uint8_t i = 0; i < num_filter_args; i++) {
+    if(!parse_filter(&store, filter_args[i], &filters[i])) return 2;
+  }
+  q.columns = columns;
+  q.filters = filters;
+  q.num_filters = num_filter_args;
+
+  printf("time");
+  for(uint8_t i = 0; i < q.num_columns; i++) {
+    printf(",%s", store.header->names[columns[i]]);
+  }
+  printf("\n");
+
+  ctx.num_columns = q.num_columns;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  col_run_query(&store, &q, print_row, &ctx, &stats);
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  if(print_stats) {
+    fprintf(stderr, "blocks: %llu of %u in range, %llu skipped by zone maps\n",
+      (unsigned long long)stats.blocks_in_range, store.header->num_blocks,
+      (unsigned long long)stats.blocks_skipped);
+    fprintf(stderr, "rows:   %llu scanned, %llu returned of %llu\n",
+      (unsigned long long)stats.rows_scanned,
+      (unsigned long long)stats.rows_returned,
+      (unsigned long long)store.header->num_rows);
+    fprintf(stderr, "time:   %.3f ms\n", (stop.tv_sec - start.tv_sec) * 1e3 +
+      (stop.tv_nsec - start.tv_nsec) / 1e6);
+  }
+
+  col_close(&store);
+  return 0;
+}
+
+//==============================================================================
+// Parse Time Argument
+//==============================================================================
+static bool parse_when(const char* arg, int64_t* t) {
+  char     buf[LOG_TIME_LEN + 1];
+  log_date date;
+
+  // A bare date means midnight.
+  if(strlen(arg) == 10) {
+    snprintf(buf, sizeof(buf), "%s 00:00:00", arg);
+    arg = buf;
+  }
+  if(!log_parse_time(arg, arg + strlen(arg), &date)) return false;
+  *t = log_time_from_date(&date);
+  return true;
+}
+
+//==============================================================================
+// Parse Column List
+//==============================================================================
+static bool parse_columns(const col_store* s, char* arg, uint8_t* columns,
+                          uint8_t* num_columns) {
+  *num_columns = 0;
+  for(char* name = strtok(arg, ","); name; name = strtok(NULL, ",")) {
+    int c = col_find_column(s, name);
+    if(c < 0 || *num_columns == COL_MAX_COLUMNS) {
+      fprintf(stderr, "unknown column '%s'\n", name);
+      return false;
+    }
+    columns[(*num_columns)++] = c;
+  }
+  return *num_columns > 0;
+}
+
+//==============================================================================
+// Parse Value Filter
+//==============================================================================
+static bool parse_filter(const col_store* s, char* arg, col_filter* f) {
+  char* min_str = strchr(arg, ':');
+  char* max_str = min_str ? strchr(min_str + 1, ':') : NULL;
+
+  if(!max_str) {
+    fprintf(stderr, "filter '%s' is not COL:MIN:MAX\n", arg);
+    return false;
+  }
+  *min_str++ = 0;
+  *max_str++ = 0;
+
+  int c = col_find_column(s, arg);
+  if(c < 0) {
+    fprintf(stderr, "unknown column '%s'\n", arg);
+    return false;
+  }
+  f->column = c;
+  f->min = strtof(min_str, NULL);
+  f->max = strtof(max_str, NULL);
+  return true;
+}
+
+//==============================================================================
+// Print One Row
+//==============================================================================
+static void print_row(void* ctx, int64_t t, const float* values) {
+  const print_ctx* p = (const print_ctx*)ctx;
+  char             date_string[LOG_TIME_LEN + 1];
+
+  log_format_time(t, date_string);
+  fputs(date_string, stdout);
+  for(uint8_t i = 0; i < p->num_columns; i++) printf(",%.2f", values[i]);
+  putchar('\n');
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-f FROM] [-t TO] [-H FIRST-LAST] [-c COL,...] "
+    "[-w COL:MIN:MAX]... [-s] FILE\n", name);
+  exit(2);
+}
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics ADS1115 Reader
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "ads1115.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define REG_CONVERSION   (0x00)
+#define REG_CONFIG       (0x01)
+
+// Start single-shot, AIN0 + channel vs GND, +/-6.144 V, single-shot mode,
+// 128 SPS, comparator off.
+#define CONFIG_SINGLE    (0xC183)
+#define CONFIG_MUX_SHIFT (12)
+
+// 1/128 s, plus the oscillator's 10% tolerance.
+#define CONVERSION_US    (8600)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void config_done(twi_xfer* x);
+static void result_done(twi_xfer* x);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Set Up Reader
+//==============================================================================
+void ads1115_init(ads1115* a, uint8_t addr) {
+  a->addr = addr;
+  a->step = ADS1115_IDLE;
+  a->counts = 0;
+  a->errors = 0;
+  a->xfer.addr = addr;
+  a->xfer.priority = TWI_PRIORITY_HIGH;
+  a->xfer.context = a;
+  a->xfer.next = NULL;
+}
+
+//==============================================================================
+// Start Conversion
+//==============================================================================
+// Returns false if the last conversion is still going.
+bool ads1115_start(ads1115* a, uint8_t channel) {
+  uint16_t config = CONFIG_SINGLE | (uint16_t)(channel & 0x03) << CONFIG_MUX_SHIFT;
+
+  if(a->step != ADS1115_IDLE && a->step != ADS1115_DONE) return false;
+
+  a->xfer.write_len = 3;
+  a->xfer.read_len = 0;
+  a->xfer.data[0] = REG_CONFIG;
+  a->xfer.data[1] = config >> 8;
+  a->xfer.data[2] = config & 0xFF;
+  a->xfer.done = config_done;
+  a->step = ADS1115_CONFIGURING;
+  if(!twi_submit(&a->xfer)) {
+    a->step = ADS1115_IDLE;
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// Poll Conversion
+//==============================================================================
+// Moves the conversion along; true once a->counts holds the result, which
+// is 0 if the ADC didn't answer (as the Adafruit library gave).
+bool ads1115_poll(ads1115* a) {
+  twi_service();
+
+  if(a->step == ADS1115_CONVERTING &&
+     micros() - a->start_us >= CONVERSION_US) {
+    a->xfer.write_len = 1;
+    a->xfer.read_len = 2;
+    a->xfer.data[0] = REG_CONVERSION;
+    a->xfer.done = result_done;
+    a->step = ADS1115_READING;
+    if(!twi_submit(&a->xfer)) {
+      a->counts = 0;
+      a->errors++;
+      a->step = ADS1115_DONE;
+    }
+  }
+  return a->step == ADS1115_DONE;
+}
+
+//==============================================================================
+// Read Channel
+//==============================================================================
+int16_t ads1115_read(ads1115* a, uint8_t channel) {
+  if(!ads1115_start(a, channel)) {
+    a->errors++;
+    return 0;
+  }
+  while(!ads1115_poll(a));
+  return a->counts;
+}
+
+//==============================================================================
+// Config Written
+//==============================================================================
+static void config_done(twi_xfer* x) {
+  ads1115* a = (ads1115*)x->context;
+
+  if(x->status != TWI_OK) {
+    a->counts = 0;
+    a->errors++;
+    a->step = ADS1115_DONE;
+    return;
+  }
+  a->start_us = micros();
+  a->step = ADS1115_CONVERTING;
+}
+
+//==============================================================================
+// Result Read
+//==============================================================================
+static void result_done(twi_xfer* x) {
+  ads1115* a = (ads1115*)x->context;
+
+  if(x->status != TWI_OK) {
+    a->counts = 0;
+    a->errors++;
+  } else {
+    a->counts = (int16_t)((uint16_t)x->data[0] << 8 | x->data[1]);
+  }
+  a->step = ADS1115_DONE;
+}
+
+#endif
@@ -1,9 +1,22 @@
 //------------------------------------------------------------------------------
-// METER TEROS-12 and TEROS-21 Driver
+// GFU Agrivoltaics ADS1115 Reader
 // Nathaniel Hudson
 // nhudson18@georgefox.edu
 // Summer 2021
 //------------------------------------------------------------------------------
+//
+// Single-shot ADS1115 conversions over the I2C queue, at high priority so
+// a queued AM2315 reading never delays a sample. Set up the same as
+// Adafruit_ADS1115's readADC_SingleEnded() did (+/-6.144 V, 128 SPS), so
+// the counts, and the irradiance calibration, are unchanged.
+//
+// ads1115_start() and ads1115_poll() leave the CPU free during the
+// conversion; ads1115_read() is the blocking version.
+//
+//------------------------------------------------------------------------------
+
+#ifndef ADS1115_H
+#define ADS1115_H
 
 //------------------------------------------------------------------------------
 //             __             __   ___  __
@@ -12,8 +25,7 @@
 //
 //------------------------------------------------------------------------------
 
-#include <Arduino.h>
-#include <SDI12.h>
+#include <twi_queue.h>
 
 //------------------------------------------------------------------------------
 //      __   ___  ___         ___  __
@@ -22,6 +34,15 @@
 //
 //------------------------------------------------------------------------------
 
+#define ADS1115_ADDR          (0x48)
+
+// Where a conversion is.
+#define ADS1115_IDLE          (0)
+#define ADS1115_CONFIGURING   (1)
+#define ADS1115_CONVERTING    (2)
+#define ADS1115_READING       (3)
+#define ADS1115_DONE          (4)
+
 //------------------------------------------------------------------------------
 //     ___      __   ___  __   ___  ___  __
 //      |  \ / |__) |__  |  \ |__  |__  /__`
@@ -29,12 +50,14 @@
 //
 //------------------------------------------------------------------------------
 
-//------------------------------------------------------------------------------
-//                __          __        ___  __
-//     \  /  /\  |__) |  /\  |__) |    |__  /__`
-//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
-//
-//------------------------------------------------------------------------------
+struct ads1115 {
+  uint8_t  addr;
+  uint8_t  step;
+  uint32_t start_us;
+  int16_t  counts;
+  uint16_t errors;
+  twi_xfer xfer;
+};
 
 //------------------------------------------------------------------------------
 //      __   __   __  ___  __  ___      __   ___  __
@@ -43,13 +66,9 @@
 //
 //------------------------------------------------------------------------------
 
-bool teros_init(uint8_t teros_12_addr, uint8_t teros_21_addr);
-bool teros_12_read(double *vwc, float *temp, uint16_t *conductivity);
-bool teros_21_read(double *matric_potential, float *temp);
+void    ads1115_init(ads1115* a, uint8_t addr);
+bool    ads1115_start(ads1115* a, uint8_t channel);
+bool    ads1115_poll(ads1115* a);
+int16_t ads1115_read(ads1115* a, uint8_t channel);
 
-//------------------------------------------------------------------------------
-//      __        __          __
-//     |__) |  | |__) |    | /  `
-//     |    \__/ |__) |___ | \__,
-//
-//------------------------------------------------------------------------------
\ No newline at end of file
+#endif
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics AM2315 Sensor
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "am2315.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define READ_REGISTERS   (0x03)
+#define NUM_REGISTERS    (4)
+#define SIGN_BIT         (0x8000)
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Reset Sensor State
+//==============================================================================
+// The first reading starts on the next am2315_service().
+void am2315_init(am2315_sensor* s, uint32_t now) {
+  memset(s, 0, sizeof(*s));
+  s->step = AM2315_IDLE;
+  s->cycle_ms = now - AM2315_REFRESH_MS;
+}
+
+//==============================================================================
+// Parse Read Response
+//==============================================================================
+// The reply to "read 4 registers from 0": function code, byte count,
+// humidity and temperature (big-endian tenths, temperature sign and
+// magnitude), then a Modbus CRC low byte first.
+bool am2315_parse(const uint8_t* frame, int16_t* temp, int16_t* humd) {
+  uint16_t crc = frame[6] | (uint16_t)frame[7] << 8;
+  uint16_t t = (uint16_t)frame[4] << 8 | frame[5];
+
+  if(frame[0] != READ_REGISTERS || frame[1] != NUM_REGISTERS) return false;
+  if(crc != am2315_crc16(frame, AM2315_FRAME_SIZE - 2)) return false;
+
+  *humd = (int16_t)((uint16_t)frame[2] << 8 | frame[3]);
+  *temp = (t & SIGN_BIT) ? -(int16_t)(t & ~SIGN_BIT) : (int16_t)t;
+  return true;
+}
+
+//==============================================================================
+// Store Reading
+//==============================================================================
+// Past AM2315_MAX_READINGS in a minute (a late take) readings only update
+// the age.
+void am2315_store(am2315_sensor* s, int16_t temp, int16_t humd,
+                  uint32_t now) {
+  if(s->count < AM2315_MAX_READINGS) {
+    s->readings[s->count][0] = temp;
+    s->readings[s->count][1] = humd;
+    s->count++;
+  }
+  s->last_ms = now;
+  s->have_reading = true;
+}
+
+//==============================================================================
+// Take Minute's Means
+//==============================================================================
+// Means of the readings since the last take, NAN if there were none, and
+// starts the next minute.
+void am2315_take(am2315_sensor* s, float* temp, float* humd) {
+  int32_t temp_sum = 0;
+  int32_t humd_sum = 0;
+
+  for(uint8_t i = 0; i < s->count; i++) {
+    temp_sum += s->readings[i][0];
+    humd_sum += s->readings[i][1];
+  }
+  *temp = am2315_mean(temp_sum, s->count);
+  *humd = am2315_mean(humd_sum, s->count);
+  s->count = 0;
+}
+
+//==============================================================================
+// Reading Age
+//==============================================================================
+// Milliseconds since the newest good reading; UINT32_MAX if there has
+// never been one.
+uint32_t am2315_age(const am2315_sensor* s, uint32_t now) {
+  return s->have_reading ? now - s->last_ms : UINT32_MAX;
+}
+
+//==============================================================================
+// Modbus CRC-16
+//==============================================================================
+uint16_t am2315_crc16(const uint8_t* p, uint8_t len) {
+  uint16_t crc = 0xFFFF;
+
+  while(len--) {
+    crc ^= *p++;
+    for(uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics AM2315 Sensor
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// The AM2315 only measures every 2 seconds, and reading it faster just
+// returns the last measurement again. So it is read on its own schedule,
+// one reading per refresh (see am2315_io.h), and each minute takes the
+// mean of every reading made since the last one, along with how old the
+// newest reading is.
+//
+// Plain C++; the I2C side is am2315_io.h.
+//
+//------------------------------------------------------------------------------
+
+#ifndef AM2315_H
+#define AM2315_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sensor_calc.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define AM2315_ADDR          (0x5C)
+#define AM2315_REFRESH_MS    (2000)
+#define AM2315_STALE_MS      (10000)
+#define AM2315_FRAME_SIZE    (8)
+
+// Where a reading is in am2315_service().
+#define AM2315_IDLE          (0)
+#define AM2315_WAKING        (1)
+#define AM2315_MEASURING     (2)
+#define AM2315_BUSY          (3)  // On the I2C queue; its callback sets the
+                                  // next step.
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct am2315_sensor {
+  uint8_t  step;
+  uint32_t cycle_ms;     // When the current reading started.
+  uint32_t step_ms;
+  uint32_t last_ms;      // When the newest good reading came in.
+  bool     have_reading;
+  uint16_t errors;
+
+  // Readings since the last am2315_take(), temperature and humidity in
+  // tenths as the sensor reports them.
+  uint8_t  count;
+  int16_t  readings[AM2315_MAX_READINGS][2];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     am2315_init(am2315_sensor* s, uint32_t now);
+bool     am2315_parse(const uint8_t* frame, int16_t* temp, int16_t* humd);
+void     am2315_store(am2315_sensor* s, int16_t temp, int16_t humd,
+                      uint32_t now);
+void     am2315_take(am2315_sensor* s, float* temp, float* humd);
+uint32_t am2315_age(const am2315_sensor* s, uint32_t now);
+uint16_t am2315_crc16(const uint8_t* p, uint8_t len);
+
+#endif
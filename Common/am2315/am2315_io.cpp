@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics AM2315 Reader
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; am2315.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <twi_queue.h>
+#include "am2315_io.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// The sensor sleeps between readings; it needs 800 us to wake and goes
+// back to sleep if not addressed, and 1.5 ms to measure.
+#define WAKE_MS          (2)
+#define AWAKE_MS         (500)
+#define MEASURE_MS       (2)
+
+#define READ_REGISTERS   (0x03)
+#define FIRST_REGISTER   (0x00)
+#define NUM_REGISTERS    (4)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// There's only ever one AM2315 on the bus (its address is fixed).
+static twi_xfer xfer;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void woken(twi_xfer* x);
+static void requested(twi_xfer* x);
+static void fetched(twi_xfer* x);
+static void finish(am2315_sensor* s, bool ok);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Start Reader
+//==============================================================================
+// The I2C queue must already be running (twi_begin()).
+void am2315_begin(am2315_sensor* s) {
+  am2315_init(s, millis());
+  xfer.addr = AM2315_ADDR;
+  xfer.priority = TWI_PRIORITY_LOW;
+  xfer.context = s;
+}
+
+//==============================================================================
+// Service Reader
+//==============================================================================
+// Each step waits for the last transaction's callback, then for the
+// sensor's own delay. Goes by the step the callbacks set, not xfer.status,
+// which is set before the callback runs.
+void am2315_service(am2315_sensor* s) {
+  uint32_t now;
+
+  twi_service();
+  if(s->step == AM2315_BUSY) return;
+  now = millis();
+
+  switch(s->step) {
+    case AM2315_IDLE:
+      if(now - s->cycle_ms < AM2315_REFRESH_MS) return;
+
+      // Just the address, to wake it; that's NACKed.
+      s->cycle_ms = now;
+      xfer.write_len = 0;
+      xfer.read_len = 0;
+      xfer.done = woken;
+      s->step = AM2315_BUSY;
+      if(!twi_submit(&xfer)) finish(s, false);
+      return;
+
+    case AM2315_WAKING:
+      if(now - s->step_ms < WAKE_MS) return;
+      if(now - s->step_ms > AWAKE_MS) {
+        // Asleep again; start over.
+        s->step = AM2315_IDLE;
+        s->cycle_ms = now - AM2315_REFRESH_MS;
+        return;
+      }
+      xfer.write_len = 3;
+      xfer.read_len = 0;
+      xfer.data[0] = READ_REGISTERS;
+      xfer.data[1] = FIRST_REGISTER;
+      xfer.data[2] = NUM_REGISTERS;
+      xfer.done = requested;
+      s->step = AM2315_BUSY;
+      if(!twi_submit(&xfer)) finish(s, false);
+      return;
+
+    case AM2315_MEASURING:
+      if(now - s->step_ms < MEASURE_MS) return;
+      xfer.write_len = 0;
+      xfer.read_len = AM2315_FRAME_SIZE;
+      xfer.done = fetched;
+      s->step = AM2315_BUSY;
+      if(!twi_submit(&xfer)) finish(s, false);
+      return;
+  }
+}
+
+//==============================================================================
+// Wake-Up Sent
+//==============================================================================
+// A NACK or a timeout (it can hold SCL while waking) are both normal.
+static void woken(twi_xfer* x) {
+  am2315_sensor* s = (am2315_sensor*)x->context;
+
+  s->step = AM2315_WAKING;
+  s->step_ms = millis();
+}
+
+//==============================================================================
+// Read Command Sent
+//==============================================================================
+static void requested(twi_xfer* x) {
+  am2315_sensor* s = (am2315_sensor*)x->context;
+
+  if(x->status != TWI_OK) {
+    finish(s, false);
+    return;
+  }
+  s->step = AM2315_MEASURING;
+  s->step_ms = millis();
+}
+
+//==============================================================================
+// Reading Fetched
+//==============================================================================
+static void fetched(twi_xfer* x) {
+  am2315_sensor* s = (am2315_sensor*)x->context;
+  int16_t        temp;
+  int16_t        humd;
+  bool           ok = x->status == TWI_OK && am2315_parse(x->data, &temp, &humd);
+
+  if(ok) am2315_store(s, temp, humd, millis());
+  finish(s, ok);
+}
+
+//==============================================================================
+// End Reading
+//==============================================================================
+static void finish(am2315_sensor* s, bool ok) {
+  if(!ok) s->errors++;
+  s->step = AM2315_IDLE;
+}
+
+#endif
@@ -0,0 +1,37 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics AM2315 Reader
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Reads the AM2315 once per refresh without blocking: am2315_service() is
+// called from every wait in the plot and moves a reading one step along
+// (wake, measure, fetch) when its delay is up. Each step is a low-priority
+// transaction on the I2C queue (twi_queue.h).
+//
+//------------------------------------------------------------------------------
+
+#ifndef AM2315_IO_H
+#define AM2315_IO_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "am2315.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void am2315_begin(am2315_sensor* s);
+void am2315_service(am2315_sensor* s);
+
+#endif
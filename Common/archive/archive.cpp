@@ -0,0 +1,384 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Compressed Time-Series Archive
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "archive.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Header field offsets.
+#define OFS_MAGIC        (0)
+#define OFS_VERSION      (2)
+#define OFS_PLOT_ID      (3)
+#define OFS_NUM_COLUMNS  (4)
+#define OFS_NUM_RECORDS  (6)
+#define OFS_NUM_BITS     (8)
+#define OFS_CRC          (10)
+#define OFS_FIRST_TIME   (12)
+
+// Worst-case encoded sizes, used to decide when a block is full.
+#define MAX_TIME_BITS    (4 + 32)
+#define MAX_VALUE_BITS   (2 + 5 + 5 + 32)
+
+// Marks a column with no XOR window yet.
+#define NO_WINDOW        (0xFF)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void     put_bits(archive_encoder* enc, uint32_t value, uint8_t num_bits);
+static uint32_t get_bits(archive_decoder* dec, uint8_t num_bits);
+static uint8_t  leading_zeros(uint32_t x);
+static uint8_t  trailing_zeros(uint32_t x);
+static void     put_u16(uint8_t* p, uint16_t v);
+static void     put_u32(uint8_t* p, uint32_t v);
+static uint16_t get_u16(const uint8_t* p);
+static uint32_t get_u32(const uint8_t* p);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Encoder
+//==============================================================================
+void archive_enc_init(archive_encoder* enc, uint8_t plot_id, uint8_t num_columns) {
+  enc->plot_id     = plot_id;
+  enc->num_columns = (num_columns > ARCHIVE_MAX_COLUMNS) ?
+    ARCHIVE_MAX_COLUMNS : num_columns;
+  archive_enc_new_block(enc);
+}
+
+//==============================================================================
+// Start a New Block
+//==============================================================================
+void archive_enc_new_block(archive_encoder* enc) {
+  memset(enc->block, 0, ARCHIVE_BLOCK_SIZE);
+  enc->bit_pos     = 0;
+  enc->num_records = 0;
+  enc->prev_time   = 0;
+  enc->prev_delta  = 0;
+  for(uint8_t i = 0; i < ARCHIVE_MAX_COLUMNS; i++) {
+    enc->prev_value[i] = 0;
+    enc->prev_lead[i]  = NO_WINDOW;
+    enc->prev_trail[i] = 0;
+  }
+  archive_enc_finish(enc);
+}
+
+//==============================================================================
+// Append Record to Current Block
+//==============================================================================
+// Returns false, leaving the block untouched, if the record might not fit.
+// The caller should then write the block out, start a new one and retry.
+bool archive_enc_append(archive_encoder* enc, uint32_t t, const float* values) {
+  // Refuse the record unless its worst-case encoding fits.
+  uint16_t worst = MAX_TIME_BITS + (uint16_t)enc->num_columns * MAX_VALUE_BITS;
+  if(enc->bit_pos + worst > ARCHIVE_PAYLOAD_BITS) return false;
+
+  // The first record of a block stores its timestamp in the header and its
+  // values verbatim.
+  if(enc->num_records == 0) {
+    put_u32(&enc->block[OFS_FIRST_TIME], t);
+    enc->prev_time  = t;
+    enc->prev_delta = 0;
+    for(uint8_t i = 0; i < enc->num_columns; i++) {
+      memcpy(&enc->prev_value[i], &values[i], sizeof(uint32_t));
+      put_bits(enc, enc->prev_value[i], 32);
+    }
+    enc->num_records++;
+    return true;
+  }
+
+  // Timestamp as delta-of-delta, in variable-width buckets.
+  int32_t delta = (int32_t)(t - enc->prev_time);
+  int32_t dod   = delta - enc->prev_delta;
+  if(dod == 0) {
+    put_bits(enc, 0x0, 1);
+  }
+  else if(dod >= -63 && dod <= 64) {
+    put_bits(enc, 0x2, 2);
+    put_bits(enc, (uint32_t)(dod + 63), 7);
+  }
+  else if(dod >= -255 && dod <= 256) {
+    put_bits(enc, 0x6, 3);
+    put_bits(enc, (uint32_t)(dod + 255), 9);
+  }
+  else if(dod >= -2047 && dod <= 2048) {
+    put_bits(enc, 0xE, 4);
+    put_bits(enc, (uint32_t)(dod + 2047), 12);
+  }
+  else {
+    put_bits(enc, 0xF, 4);
+    put_bits(enc, (uint32_t)dod, 32);
+  }
+  enc->prev_time  = t;
+  enc->prev_delta = delta;
+
+  // Each value as the XOR against the previous value of its column.
+  for(uint8_t i = 0; i < enc->num_columns; i++) {
+    uint32_t bits;
+    memcpy(&bits, &values[i], sizeof(uint32_t));
+    uint32_t x = bits ^ enc->prev_value[i];
+    enc->prev_value[i] = bits;
+
+    // Identical value.
+    if(x == 0) {
+      put_bits(enc, 0x0, 1);
+      continue;
+    }
+
+    uint8_t lead  = leading_zeros(x);
+    uint8_t trail = trailing_zeros(x);
+    if(lead > 31) lead = 31;
+
+    // Meaningful bits fall inside the previous window, so reuse it.
+    if(enc->prev_lead[i] != NO_WINDOW &&
+       lead >= enc->prev_lead[i] && trail >= enc->prev_trail[i]) {
+      put_bits(enc, 0x2, 2);
+      put_bits(enc, x >> enc->prev_trail[i],
+        32 - enc->prev_lead[i] - enc->prev_trail[i]);
+    }
+    // Otherwise send a new window.
+    else {
+      uint8_t len = 32 - lead - trail;
+      put_bits(enc, 0x3, 2);
+      put_bits(enc, lead, 5);
+      put_bits(enc, len - 1, 5);
+      put_bits(enc, x >> trail, len);
+      enc->prev_lead[i]  = lead;
+      enc->prev_trail[i] = trail;
+    }
+  }
+
+  enc->num_records++;
+  return true;
+}
+
+//==============================================================================
+// Finish Block Header
+//==============================================================================
+// Fills in counts and CRC so the block can be written out as-is. Safe to call
+// after every append; the block stays open for more records.
+void archive_enc_finish(archive_encoder* enc) {
+  uint8_t* b = enc->block;
+  put_u16(&b[OFS_MAGIC], ARCHIVE_MAGIC);
+  b[OFS_VERSION]     = ARCHIVE_VERSION;
+  b[OFS_PLOT_ID]     = enc->plot_id;
+  b[OFS_NUM_COLUMNS] = enc->num_columns;
+  b[OFS_NUM_COLUMNS + 1] = 0;
+  put_u16(&b[OFS_NUM_RECORDS], enc->num_records);
+  put_u16(&b[OFS_NUM_BITS], enc->bit_pos);
+
+  uint16_t crc = archive_crc16(b, OFS_CRC, 0xFFFF);
+  crc = archive_crc16(&b[OFS_FIRST_TIME], ARCHIVE_BLOCK_SIZE - OFS_FIRST_TIME, crc);
+  put_u16(&b[OFS_CRC], crc);
+}
+
+//==============================================================================
+// Begin Decoding a Block
+//==============================================================================
+// Returns false if the block is empty, unformatted or fails its CRC.
+bool archive_dec_begin(archive_decoder* dec, const uint8_t* block) {
+  if(get_u16(&block[OFS_MAGIC]) != ARCHIVE_MAGIC) return false;
+  if(block[OFS_VERSION] != ARCHIVE_VERSION) return false;
+
+  uint16_t crc = archive_crc16(block, OFS_CRC, 0xFFFF);
+  crc = archive_crc16(&block[OFS_FIRST_TIME], ARCHIVE_BLOCK_SIZE - OFS_FIRST_TIME, crc);
+  if(crc != get_u16(&block[OFS_CRC])) return false;
+
+  dec->block       = block;
+  dec->bit_pos     = 0;
+  dec->num_bits    = get_u16(&block[OFS_NUM_BITS]);
+  dec->num_records = get_u16(&block[OFS_NUM_RECORDS]);
+  dec->record      = 0;
+  dec->plot_id     = block[OFS_PLOT_ID];
+  dec->num_columns = block[OFS_NUM_COLUMNS];
+  dec->prev_time   = get_u32(&block[OFS_FIRST_TIME]);
+  dec->prev_delta  = 0;
+  if(dec->num_columns > ARCHIVE_MAX_COLUMNS) return false;
+  if(dec->num_bits > ARCHIVE_PAYLOAD_BITS) return false;
+  for(uint8_t i = 0; i < ARCHIVE_MAX_COLUMNS; i++) {
+    dec->prev_value[i] = 0;
+    dec->prev_lead[i]  = NO_WINDOW;
+    dec->prev_trail[i] = 0;
+  }
+  return true;
+}
+
+//==============================================================================
+// Decode Next Record
+//==============================================================================
+// Returns false once every record of the block has been read, or if the
+// payload turns out to be malformed.
+bool archive_dec_next(archive_decoder* dec, uint32_t* t, float* values) {
+  if(dec->record >= dec->num_records) return false;
+
+  // First record: timestamp from header, values verbatim.
+  if(dec->record == 0) {
+    for(uint8_t i = 0; i < dec->num_columns; i++) {
+      dec->prev_value[i] = get_bits(dec, 32);
+    }
+  }
+  else {
+    // Timestamp bucket prefix.
+    int32_t dod;
+    if(get_bits(dec, 1) == 0)      dod = 0;
+    else if(get_bits(dec, 1) == 0) dod = (int32_t)get_bits(dec, 7) - 63;
+    else if(get_bits(dec, 1) == 0) dod = (int32_t)get_bits(dec, 9) - 255;
+    else if(get_bits(dec, 1) == 0) dod = (int32_t)get_bits(dec, 12) - 2047;
+    else                           dod = (int32_t)get_bits(dec, 32);
+    dec->prev_delta += dod;
+    dec->prev_time  += (uint32_t)dec->prev_delta;
+
+    for(uint8_t i = 0; i < dec->num_columns; i++) {
+      if(get_bits(dec, 1) == 0) continue;
+
+      uint32_t x;
+      if(get_bits(dec, 1) == 0) {
+        if(dec->prev_lead[i] == NO_WINDOW) return false;
+        x = get_bits(dec, 32 - dec->prev_lead[i] - dec->prev_trail[i]);
+        x <<= dec->prev_trail[i];
+      }
+      else {
+        uint8_t lead = get_bits(dec, 5);
+        uint8_t len  = get_bits(dec, 5) + 1;
+        if(lead + len > 32) return false;
+        uint8_t trail = 32 - lead - len;
+        x = get_bits(dec, len) << trail;
+        dec->prev_lead[i]  = lead;
+        dec->prev_trail[i] = trail;
+      }
+      dec->prev_value[i] ^= x;
+    }
+  }
+
+  if(dec->bit_pos > dec->num_bits) return false;
+
+  *t = dec->prev_time;
+  for(uint8_t i = 0; i < dec->num_columns; i++) {
+    memcpy(&values[i], &dec->prev_value[i], sizeof(float));
+  }
+  dec->record++;
+  return true;
+}
+
+//==============================================================================
+// CRC-16/CCITT
+//==============================================================================
+uint16_t archive_crc16(const uint8_t* data, uint16_t len, uint16_t crc) {
+  while(len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for(uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+//==============================================================================
+// Write Bits to Payload (MSB First)
+//==============================================================================
+static void put_bits(archive_encoder* enc, uint32_t value, uint8_t num_bits) {
+  uint8_t* payload = &enc->block[ARCHIVE_HEADER_SIZE];
+  while(num_bits > 0) {
+    uint8_t room = 8 - (enc->bit_pos & 7);
+    uint8_t take = (num_bits < room) ? num_bits : room;
+    uint8_t chunk = (uint8_t)((value >> (num_bits - take)) & ((1U << take) - 1));
+    payload[enc->bit_pos >> 3] |= chunk << (room - take);
+    enc->bit_pos += take;
+    num_bits -= take;
+  }
+}
+
+//==============================================================================
+// Read Bits from Payload (MSB First)
+//==============================================================================
+static uint32_t get_bits(archive_decoder* dec, uint8_t num_bits) {
+  const uint8_t* payload = &dec->block[ARCHIVE_HEADER_SIZE];
+  uint32_t value = 0;
+  while(num_bits > 0) {
+    // Running off the payload reads zeros; the caller catches it via num_bits.
+    if(dec->bit_pos >= ARCHIVE_PAYLOAD_BITS) {
+      value = (num_bits >= 32) ? 0 : value << num_bits;
+      dec->bit_pos += num_bits;
+      break;
+    }
+    uint8_t room = 8 - (dec->bit_pos & 7);
+    uint8_t take = (num_bits < room) ? num_bits : room;
+    uint8_t chunk = (payload[dec->bit_pos >> 3] >> (room - take)) & ((1U << take) - 1);
+    value = (value << take) | chunk;
+    dec->bit_pos += take;
+    num_bits -= take;
+  }
+  return value;
+}
+
+//==============================================================================
+// Count Leading/Trailing Zero Bits
+//==============================================================================
+// Written out by hand since int is 16 bits on the AVR and 32 on the host.
+static uint8_t leading_zeros(uint32_t x) {
+  uint8_t n = 0;
+  while(n < 32 && !(x & 0x80000000UL)) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+}
+
+static uint8_t trailing_zeros(uint32_t x) {
+  uint8_t n = 0;
+  while(n < 32 && !(x & 1)) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+
+//==============================================================================
+// Little-Endian Field Access
+//==============================================================================
+static void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+    ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Compressed Time-Series Archive
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Each archive file is a sequence of fixed 512-byte blocks (one SD sector).
+// Every block is self-contained: it carries a header with the block's first
+// timestamp, and its payload is a bit-packed stream of records. Timestamps
+// are stored as delta-of-delta and every value is stored as the XOR against
+// the previous value of the same column (the Gorilla scheme), so a minute of
+// slowly varying readings usually costs a few bits per column.
+//
+// The encoder and decoder are plain C++ so the same code runs on the AVR
+// (encoder) and on Linux (decoder).
+//
+//  Block layout (little-endian):
+//    0  uint16  magic (ARCHIVE_MAGIC)
+//    2  uint8   format version
+//    3  uint8   plot ID
+//    4  uint8   number of columns
+//    5  uint8   reserved (0)
+//    6  uint16  number of records
+//    8  uint16  number of payload bits used
+//   10  uint16  CRC-16/CCITT over bytes 0-9 and 12-511
+//   12  uint32  timestamp of first record
+//   16  ...     payload
+//
+//------------------------------------------------------------------------------
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define ARCHIVE_MAGIC         (0x4147)
+#define ARCHIVE_VERSION       (1)
+#define ARCHIVE_BLOCK_SIZE    (512)
+#define ARCHIVE_HEADER_SIZE   (16)
+#define ARCHIVE_PAYLOAD_SIZE  (ARCHIVE_BLOCK_SIZE - ARCHIVE_HEADER_SIZE)
+#define ARCHIVE_PAYLOAD_BITS  (ARCHIVE_PAYLOAD_SIZE * 8)
+#define ARCHIVE_MAX_COLUMNS   (12)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// Streaming encoder for one block at a time.
+struct archive_encoder {
+  uint8_t  block[ARCHIVE_BLOCK_SIZE];
+  uint16_t bit_pos;
+  uint16_t num_records;
+  uint8_t  plot_id;
+  uint8_t  num_columns;
+  uint32_t prev_time;
+  int32_t  prev_delta;
+  uint32_t prev_value[ARCHIVE_MAX_COLUMNS];
+  uint8_t  prev_lead[ARCHIVE_MAX_COLUMNS];
+  uint8_t  prev_trail[ARCHIVE_MAX_COLUMNS];
+};
+
+// Decoder for a single block.
+struct archive_decoder {
+  const uint8_t* block;
+  uint16_t       bit_pos;
+  uint16_t       num_bits;
+  uint16_t       num_records;
+  uint16_t       record;
+  uint8_t        plot_id;
+  uint8_t        num_columns;
+  uint32_t       prev_time;
+  int32_t        prev_delta;
+  uint32_t       prev_value[ARCHIVE_MAX_COLUMNS];
+  uint8_t        prev_lead[ARCHIVE_MAX_COLUMNS];
+  uint8_t        prev_trail[ARCHIVE_MAX_COLUMNS];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     archive_enc_init(archive_encoder* enc, uint8_t plot_id, uint8_t num_columns);
+void     archive_enc_new_block(archive_encoder* enc);
+bool     archive_enc_append(archive_encoder* enc, uint32_t t, const float* values);
+void     archive_enc_finish(archive_encoder* enc);
+
+bool     archive_dec_begin(archive_decoder* dec, const uint8_t* block);
+bool     archive_dec_next(archive_decoder* dec, uint32_t* t, float* values);
+
+uint16_t archive_crc16(const uint8_t* data, uint16_t len, uint16_t crc);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Compressed Archive SD Card Writer
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; the host tools use archive.cpp alone.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "archive_sd.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Open Archive File
+//==============================================================================
+// Does nothing if the named archive is already open. Otherwise a new block is
+// started on the next sector boundary after any existing data; a block left
+// partially filled by a reset is simply kept as it is.
+bool archive_writer_open(archive_writer* w, const char* name,
+                         uint8_t plot_id, uint8_t num_columns) {
+  if(w->file && strcmp(w->name, name) == 0) return true;
+
+  // Close the current file and open the new one without O_APPEND,
+  // so the open block can be rewritten in place.
+  if(w->file) w->file.close();
+  strncpy(w->name, name, sizeof(w->name) - 1);
+  w->name[sizeof(w->name) - 1] = 0;
+  w->file = SD.open(w->name, O_READ | O_WRITE | O_CREAT);
+  if(!w->file) return false;
+
+  uint32_t size = w->file.size();
+  w->block_pos = ((size + ARCHIVE_BLOCK_SIZE - 1) / ARCHIVE_BLOCK_SIZE) *
+    ARCHIVE_BLOCK_SIZE;
+  archive_enc_init(&w->enc, plot_id, num_columns);
+  return true;
+}
+
+//==============================================================================
+// Append Record
+//==============================================================================
+bool archive_writer_append(archive_writer* w, uint32_t t, const float* values) {
+  if(!w->file) return false;
+
+  // If the open block is full it is already on the card in its final form,
+  // so move on to the next sector.
+  if(!archive_enc_append(&w->enc, t, values)) {
+    w->block_pos += ARCHIVE_BLOCK_SIZE;
+    archive_enc_new_block(&w->enc);
+    if(!archive_enc_append(&w->enc, t, values)) return false;
+  }
+
+  // Rewrite the open block.
+  archive_enc_finish(&w->enc);
+  if(!w->file.seek(w->block_pos)) return false;
+  if(w->file.write(w->enc.block, ARCHIVE_BLOCK_SIZE) != ARCHIVE_BLOCK_SIZE) {
+    return false;
+  }
+  w->file.flush();
+  return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Compressed Archive SD Card Writer
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Keeps the open block of an archive file in RAM and rewrites that one
+// sector every time a record is appended, so a power cut loses at most the
+// record being written. Finished blocks are never touched again.
+//
+//------------------------------------------------------------------------------
+
+#ifndef ARCHIVE_SD_H
+#define ARCHIVE_SD_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <SD.h>
+#include "archive.h"
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct archive_writer {
+  File            file;
+  uint32_t        block_pos;
+  char            name[13];
+  archive_encoder enc;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool archive_writer_open(archive_writer* w, const char* name,
+                         uint8_t plot_id, uint8_t num_columns);
+bool archive_writer_append(archive_writer* w, uint32_t t, const float* values);
+
+#endif
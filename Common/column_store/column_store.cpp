@@ -0,0 +1,460 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Columnar Plot Store
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "column_store.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define SECS_PER_DAY    (86400)
+#define SECS_PER_HOUR   (3600)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static size_t   page_round(size_t n);
+static size_t   block_size(uint8_t num_columns);
+static size_t   block_offset(const col_store* s, uint32_t block);
+static bool     map_file(col_store* s, size_t size);
+static bool     add_block(col_store* s);
+static uint32_t first_block_ending_after(const col_store* s, int64_t t);
+static uint32_t first_row_at(const int64_t* times, uint32_t n, int64_t t);
+static bool     zone_excludes(const col_block_header* b, const col_query* q);
+static bool     in_hours(int64_t t, const col_query* q);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Create Empty Store
+//==============================================================================
+bool col_create(col_store* s, const char* path, uint8_t plot_id,
+                uint8_t num_columns, const char* const* names) {
+  memset(s, 0, sizeof(*s));
+  s->fd = -1;
+  if(num_columns == 0 || num_columns > COL_MAX_COLUMNS) return false;
+
+  s->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(s->fd < 0 || ftruncate(s->fd, COL_PAGE_SIZE) != 0) {
+    perror(path);
+    col_close(s);
+    return false;
+  }
+  s->writable = true;
+  s->block_size = block_size(num_columns);
+  if(!map_file(s, COL_PAGE_SIZE)) {
+    col_close(s);
+    return false;
+  }
+
+  memcpy(s->header->magic, COL_MAGIC, 4);
+  s->header->version = COL_VERSION;
+  s->header->plot_id = plot_id;
+  s->header->num_columns = num_columns;
+  s->header->block_rows = COL_BLOCK_ROWS;
+  for(uint8_t i = 0; i < num_columns; i++) {
+    strncpy(s->header->names[i], names[i], COL_NAME_LEN - 1);
+  }
+  return true;
+}
+
+//==============================================================================
+// Open Existing Store
+//==============================================================================
+bool col_open(col_store* s, const char* path, bool writable) {
+  struct stat st;
+  col_header  header;
+
+  memset(s, 0, sizeof(*s));
+  s->fd = open(path, writable ? O_RDWR : O_RDONLY);
+  if(s->fd < 0 || fstat(s->fd, &st) != 0) {
+    perror(path);
+    col_close(s);
+    return false;
+  }
+
+  if(pread(s->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+     memcmp(header.magic, COL_MAGIC, 4) != 0 ||
+     header.version != COL_VERSION || header.block_rows != COL_BLOCK_ROWS ||
+     header.num_columns == 0 || header.num_columns > COL_MAX_COLUMNS) {
+    fprintf(stderr, "%s: not a column store\n", path);
+    col_close(s);
+    return false;
+  }
+
+  s->writable = writable;
+  s->block_size = block_size(header.num_columns);
+  if((size_t)st.st_size < COL_PAGE_SIZE + header.num_blocks * s->block_size) {
+    fprintf(stderr, "%s: truncated\n", path);
+    col_close(s);
+    return false;
+  }
+  if(!map_file(s, COL_PAGE_SIZE + header.num_blocks * s->block_size)) {
+    col_close(s);
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// Close Store
+//==============================================================================
+void col_close(col_store* s) {
+  if(s->map) munmap(s->map, s->map_size);
+  if(s->fd >= 0) close(s->fd);
+  s->map = NULL;
+  s->header = NULL;
+  s->fd = -1;
+}
+
+//==============================================================================
+// Flush To Disk
+//==============================================================================
+bool col_sync(col_store* s) {
+  return !s->map || msync(s->map, s->map_size, MS_SYNC) == 0;
+}
+
+//==============================================================================
+// Append Row
+//==============================================================================
+// Rows must arrive in time order (equal times are allowed).
+bool col_append(col_store* s, int64_t t, const float* values) {
+  // Local variables.
+  col_header*       h = s->header;
+  col_block_header* b;
+  uint32_t          row;
+
+  if(!s->writable) return false;
+  if(h->num_rows > 0 && t < col_last_time(s)) return false;
+
+  if(h->num_blocks == 0 ||
+     col_block(s, h->num_blocks - 1)->num_rows == COL_BLOCK_ROWS) {
+    if(!add_block(s)) return false;
+    h = s->header;
+  }
+
+  uint32_t block = h->num_blocks - 1;
+  b = (col_block_header*)(s->map + block_offset(s, block));
+  row = b->num_rows;
+
+  ((int64_t*)col_block_times(s, block))[row] = t;
+  for(uint8_t c = 0; c < h->num_columns; c++) {
+    ((float*)col_block_values(s, block, c))[row] = values[c];
+    if(isnan(values[c])) continue;
+    if(values[c] < b->zones[c].min) b->zones[c].min = values[c];
+    if(values[c] > b->zones[c].max) b->zones[c].max = values[c];
+  }
+  if(row == 0) b->first_time = t;
+  b->last_time = t;
+  b->num_rows++;
+  h->num_rows++;
+  return true;
+}
+
+//==============================================================================
+// Latest Timestamp
+//==============================================================================
+int64_t col_last_time(const col_store* s) {
+  if(s->header->num_blocks == 0) return INT64_MIN;
+  return col_block(s, s->header->num_blocks - 1)->last_time;
+}
+
+//==============================================================================
+// Find Column By Name
+//==============================================================================
+int col_find_column(const col_store* s, const char* name) {
+  for(uint8_t i = 0; i < s->header->num_columns; i++) {
+    if(strncmp(s->header->names[i], name, COL_NAME_LEN) == 0) return i;
+  }
+  return -1;
+}
+
+//==============================================================================
+// Block Accessors
+//==============================================================================
+const col_block_header* col_block(const col_store* s, uint32_t block) {
+  return (const col_block_header*)(s->map + block_offset(s, block));
+}
+
+const int64_t* col_block_times(const col_store* s, uint32_t block) {
+  return (const int64_t*)(s->map + block_offset(s, block) + COL_PAGE_SIZE);
+}
+
+const float* col_block_values(const col_store* s, uint32_t block,
+                              uint8_t column) {
+  return (const float*)(s->map + block_offset(s, block) + COL_PAGE_SIZE +
+    page_round(COL_BLOCK_ROWS * sizeof(int64_t)) +
+    column * page_round(COL_BLOCK_ROWS * sizeof(float)));
+}
+
+//==============================================================================
+// Run Range Query
+//==============================================================================
+// Calls fn for every row in [from, to) that passes the hour window and
+// filters. stats may be NULL.
+bool col_run_query(const col_store* s, const col_query* q, col_row_fn fn,
+                   void* ctx, col_query_stats* stats) {
+  // Local variables.
+  col_query_stats local = {};
+  float           out[COL_MAX_COLUMNS];
+
+  for(uint8_t i = 0; i < q->num_columns; i++) {
+    if(q->columns[i] >= s->header->num_columns) return false;
+  }
+  for(uint8_t i = 0; i < q->num_filters; i++) {
+    if(q->filters[i].column >= s->header->num_columns) return false;
+  }
+
+  for(uint32_t block = first_block_ending_after(s, q->from);
+      block < s->header->num_blocks; block++) {
+    const col_block_header* b = col_block(s, block);
+    if(b->first_time >= q->to) break;
+    local.blocks_in_range++;
+
+    if(zone_excludes(b, q)) {
+      local.blocks_skipped++;
+      continue;
+    }
+
+    // Narrow to the rows in range; only the timestamp array is touched.
+    const int64_t* times = col_block_times(s, block);
+    uint32_t first = first_row_at(times, b->num_rows, q->from);
+    uint32_t last = first_row_at(times, b->num_rows, q->to);
+
+    const float* filter_cols[COL_MAX_COLUMNS];
+    const float* out_cols[COL_MAX_COLUMNS];
+    for(uint8_t i = 0; i < q->num_filters; i++) {
+      filter_cols[i] = col_block_values(s, block, q->filters[i].column);
+    }
+    for(uint8_t i = 0; i < q->num_columns; i++) {
+      out_cols[i] = col_block_values(s, block, q->columns[i]);
+    }
+
+    for(uint32_t r = first; r < last; r++) {
+      local.rows_scanned++;
+      if(!in_hours(times[r], q)) continue;
+
+      bool keep = true;
+      for(uint8_t i = 0; i < q->num_filters && keep; i++) {
+        float v = filter_cols[i][r];
+        keep = v >= q->filters[i].min && v <= q->filters[i].max;
+      }
+      if(!keep) continue;
+
+      for(uint8_t i = 0; i < q->num_columns; i++) out[i] = out_cols[i][r];
+      fn(ctx, times[r], out);
+      local.rows_returned++;
+    }
+  }
+
+  if(stats) *stats = local;
+  return true;
+}
+
+//==============================================================================
+// Earliest Timestamp
+//==============================================================================
+int64_t col_first_time(const col_store* s) {
+  if(s->header->num_blocks == 0) return INT64_MAX;
+  return col_block(s, 0)->first_time;
+}
+
+//==============================================================================
+// Position Cursor
+//==============================================================================
+// Puts the cursor on the first row at or after t.
+void col_cursor_seek(col_cursor* c, const col_store* s, int64_t t) {
+  c->store = s;
+  c->block = first_block_ending_after(s, t);
+  c->row = 0;
+  if(c->block < s->header->num_blocks) {
+    c->row = first_row_at(col_block_times(s, c->block),
+      col_block(s, c->block)->num_rows, t);
+  }
+}
+
+//==============================================================================
+// Cursor Accessors
+//==============================================================================
+bool col_cursor_valid(const col_cursor* c) {
+  return c->block < c->store->header->num_blocks &&
+         c->row < col_block(c->store, c->block)->num_rows;
+}
+
+int64_t col_cursor_time(const col_cursor* c) {
+  return col_block_times(c->store, c->block)[c->row];
+}
+
+float col_cursor_value(const col_cursor* c, uint8_t column) {
+  return col_block_values(c->store, c->block, column)[c->row];
+}
+
+//==============================================================================
+// Advance Cursor
+//==============================================================================
+void col_cursor_next(col_cursor* c) {
+  if(!col_cursor_valid(c)) return;
+  if(++c->row == col_block(c->store, c->block)->num_rows) {
+    c->block++;
+    c->row = 0;
+  }
+}
+
+//==============================================================================
+// Round Up To Page
+//==============================================================================
+static size_t page_round(size_t n) {
+  return (n + COL_PAGE_SIZE - 1) / COL_PAGE_SIZE * COL_PAGE_SIZE;
+}
+
+//==============================================================================
+// Bytes Per Block
+//==============================================================================
+static size_t block_size(uint8_t num_columns) {
+  return COL_PAGE_SIZE + page_round(COL_BLOCK_ROWS * sizeof(int64_t)) +
+         num_columns * page_round(COL_BLOCK_ROWS * sizeof(float));
+}
+
+//==============================================================================
+// Block Position In File
+//==============================================================================
+static size_t block_offset(const col_store* s, uint32_t block) {
+  return COL_PAGE_SIZE + (size_t)block * s->block_size;
+}
+
+//==============================================================================
+// (Re)map The File
+//==============================================================================
+static bool map_file(col_store* s, size_t size) {
+  void* p;
+
+  if(s->map) {
+    p = mremap(s->map, s->map_size, size, MREMAP_MAYMOVE);
+  }
+  else {
+    p = mmap(NULL, size, s->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+      MAP_SHARED, s->fd, 0);
+  }
+  if(p == MAP_FAILED) {
+    perror("mmap");
+    return false;
+  }
+
+  s->map = (uint8_t*)p;
+  s->map_size = size;
+  s->header = (col_header*)p;
+  return true;
+}
+
+//==============================================================================
+// Grow By One Block
+//==============================================================================
+static bool add_block(col_store* s) {
+  uint32_t block = s->header->num_blocks;
+  size_t   size = block_offset(s, block + 1);
+
+  if(ftruncate(s->fd, size) != 0) {
+    perror("ftruncate");
+    return false;
+  }
+  if(!map_file(s, size)) return false;
+
+  // New pages read back as zeros; only the zone maps need setting up.
+  col_block_header* b = (col_block_header*)(s->map + block_offset(s, block));
+  for(uint8_t c = 0; c < COL_MAX_COLUMNS; c++) {
+    b->zones[c].min = INFINITY;
+    b->zones[c].max = -INFINITY;
+  }
+  s->header->num_blocks++;
+  return true;
+}
+
+//==============================================================================
+// Sparse Index Search
+//==============================================================================
+// First block whose last row is at or after t.
+static uint32_t first_block_ending_after(const col_store* s, int64_t t) {
+  uint32_t lo = 0;
+  uint32_t hi = s->header->num_blocks;
+
+  while(lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if(col_block(s, mid)->last_time < t) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+//==============================================================================
+// Row Search Within Block
+//==============================================================================
+// First row at or after t.
+static uint32_t first_row_at(const int64_t* times, uint32_t n, int64_t t) {
+  uint32_t lo = 0;
+  uint32_t hi = n;
+
+  while(lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if(times[mid] < t) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+//==============================================================================
+// Zone Map Check
+//==============================================================================
+static bool zone_excludes(const col_block_header* b, const col_query* q) {
+  for(uint8_t i = 0; i < q->num_filters; i++) {
+    const col_zone& z = b->zones[q->filters[i].column];
+    if(z.max < q->filters[i].min || z.min > q->filters[i].max) return true;
+  }
+  return false;
+}
+
+//==============================================================================
+// Time-Of-Day Check
+//==============================================================================
+// A window with first_hour > last_hour wraps past midnight.
+static bool in_hours(int64_t t, const col_query* q) {
+  if(q->first_hour < 0) return true;
+
+  int64_t secs = t % SECS_PER_DAY;
+  if(secs < 0) secs += SECS_PER_DAY;
+  int hour = secs / SECS_PER_HOUR;
+
+  if(q->first_hour <= q->last_hour) {
+    return hour >= q->first_hour && hour <= q->last_hour;
+  }
+  return hour >= q->first_hour || hour <= q->last_hour;
+}
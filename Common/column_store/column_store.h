@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Columnar Plot Store
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Host-side storage for a plot's full history, read through mmap so queries
+// only fault in the pages they use.
+//
+// A store file is a header page followed by fixed-size blocks of
+// COL_BLOCK_ROWS rows. Each block is a header page (row count, first/last
+// timestamp, and a min/max zone map per column) followed by one page-aligned
+// array per column: int64 timestamps, then a float32 array for each reading.
+// Because blocks have a fixed size, block i sits at a known offset and the
+// first timestamps of the block headers form a sparse time index that is
+// binary searched. A query for a time range and a few columns touches the
+// headers along that search, plus only the selected arrays of the blocks
+// in range whose zone maps can match.
+//
+// Rows are appended in time order; the last block fills in place, so the
+// same file can be written a row at a time (ThingSpeak-Server) or in bulk
+// (Log-Ingest).
+//
+//  File header (page 0, little-endian):
+//    0  char[4]  magic "AGCS"
+//    4  uint16   format version
+//    6  uint8    plot ID
+//    7  uint8    number of columns
+//    8  uint32   rows per block
+//   12  uint32   number of blocks
+//   16  uint64   number of rows
+//   24  char[COL_MAX_COLUMNS][COL_NAME_LEN] column names
+//
+//------------------------------------------------------------------------------
+
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define COL_MAGIC         "AGCS"
+#define COL_VERSION       (1)
+#define COL_PAGE_SIZE     (4096)
+#define COL_BLOCK_ROWS    (4096)
+#define COL_MAX_COLUMNS   (16)
+#define COL_NAME_LEN      (32)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct col_header {
+  char     magic[4];
+  uint16_t version;
+  uint8_t  plot_id;
+  uint8_t  num_columns;
+  uint32_t block_rows;
+  uint32_t num_blocks;
+  uint64_t num_rows;
+  char     names[COL_MAX_COLUMNS][COL_NAME_LEN];
+};
+
+struct col_zone {
+  float    min;
+  float    max;
+};
+
+struct col_block_header {
+  uint32_t num_rows;
+  uint32_t reserved;
+  int64_t  first_time;
+  int64_t  last_time;
+  col_zone zones[COL_MAX_COLUMNS];
+};
+
+struct col_store {
+  int         fd;
+  bool        writable;
+  uint8_t*    map;
+  size_t      map_size;
+  size_t      block_size;
+  col_header* header;
+};
+
+// Optional value filter: rows where column is outside [min, max] are
+// skipped, and so are whole blocks whose zone map rules them out.
+struct col_filter {
+  uint8_t  column;
+  float    min;
+  float    max;
+};
+
+struct col_query {
+  int64_t           from;          // inclusive
+  int64_t           to;            // exclusive
+  const uint8_t*    columns;       // columns to return
+  uint8_t           num_columns;
+  const col_filter* filters;
+  uint8_t           num_filters;
+  int8_t            first_hour;    // time-of-day window, -1 for all day
+  int8_t            last_hour;     // inclusive
+};
+
+struct col_query_stats {
+  uint64_t blocks_in_range;
+  uint64_t blocks_skipped;         // ruled out by zone maps
+  uint64_t rows_scanned;
+  uint64_t rows_returned;
+};
+
+// Gets each matching row: its time and the selected columns, in order.
+typedef void (*col_row_fn)(void* ctx, int64_t t, const float* values);
+
+// Forward-only position in a store, for streaming through it row by row.
+struct col_cursor {
+  const col_store* store;
+  uint32_t         block;
+  uint32_t         row;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool  col_create(col_store* s, const char* path, uint8_t plot_id,
+                 uint8_t num_columns, const char* const* names);
+bool  col_open(col_store* s, const char* path, bool writable);
+void  col_close(col_store* s);
+bool  col_sync(col_store* s);
+
+bool  col_append(col_store* s, int64_t t, const float* values);
+int64_t col_last_time(const col_store* s);
+int   col_find_column(const col_store* s, const char* name);
+
+const col_block_header* col_block(const col_store* s, uint32_t block);
+const int64_t*          col_block_times(const col_store* s, uint32_t block);
+const float*            col_block_values(const col_store* s, uint32_t block,
+                                         uint8_t column);
+
+bool  col_run_query(const col_store* s, const col_query* q, col_row_fn fn,
+                    void* ctx, col_query_stats* stats);
+
+int64_t col_first_time(const col_store* s);
+void    col_cursor_seek(col_cursor* c, const col_store* s, int64_t t);
+bool    col_cursor_valid(const col_cursor* c);
+int64_t col_cursor_time(const col_cursor* c);
+float   col_cursor_value(const col_cursor* c, uint8_t column);
+void    col_cursor_next(col_cursor* c);
+
+#endif
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Daily Summary
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <archive.h>
+#include <sensor_calc.h>
+#include "daily_summary.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define SECS_PER_DAY      (86400UL)
+#define MINUTES_PER_HOUR  (60.0f)
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Start A Day
+//==============================================================================
+// Clears the aggregates for the day containing t. The sequence number
+// carries on so the newest EEPROM slot can be told apart.
+void daily_begin(daily_summary* s, const daily_config* cfg, uint32_t t) {
+  uint32_t seq = s->magic == DAILY_SUMMARY_MAGIC ? s->seq : 0;
+
+  memset(s, 0, sizeof(*s));
+  s->magic = DAILY_SUMMARY_MAGIC;
+  s->plot_id = cfg->plot_id;
+  s->num_columns = cfg->num_columns;
+  s->seq = seq;
+  s->day = daily_day(t);
+}
+
+//==============================================================================
+// Add A Minute
+//==============================================================================
+// values is the row as logged. NaN and the DS18B20 disconnected reading are
+// left out; each row counts as one minute.
+void daily_add(daily_summary* s, const daily_config* cfg,
+               const float* values) {
+  for(uint8_t c = 0; c < s->num_columns; c++) {
+    daily_stat* st = &s->stats[c];
+    float       v = values[c];
+
+    if(isnan(v) || v == DS18B20_DISCONNECTED_C) continue;
+    if(st->count == 0 || v < st->min) st->min = v;
+    if(st->count == 0 || v > st->max) st->max = v;
+    st->sum += v;
+    st->count++;
+    if(!isnan(cfg->thresholds[c]) && v > cfg->thresholds[c]) {
+      st->minutes_above++;
+    }
+
+    // One minute of irradiance is W/m^2 * 1/60 h.
+    if(c == cfg->irad_column && v > 0) s->insolation += v / MINUTES_PER_HOUR;
+  }
+}
+
+//==============================================================================
+// Same Day Check
+//==============================================================================
+bool daily_same_day(const daily_summary* s, uint32_t t) {
+  return s->day == daily_day(t);
+}
+
+//==============================================================================
+// Summary Belongs To Config
+//==============================================================================
+// A summary restored from EEPROM is only used by the plot that wrote it.
+bool daily_matches(const daily_summary* s, const daily_config* cfg) {
+  return s->magic == DAILY_SUMMARY_MAGIC && s->plot_id == cfg->plot_id &&
+         s->num_columns == cfg->num_columns &&
+         s->num_columns <= DAILY_SUMMARY_MAX_COLUMNS;
+}
+
+//==============================================================================
+// Day Number
+//==============================================================================
+// Days since 1970 in the plot's local time (the clock is already local).
+uint32_t daily_day(uint32_t t) {
+  return t / SECS_PER_DAY;
+}
+
+//==============================================================================
+// Summary CRC
+//==============================================================================
+uint16_t daily_crc(const daily_summary* s) {
+  return archive_crc16((const uint8_t*)s, offsetof(daily_summary, crc), 0xFFFF);
+}
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Daily Summary
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Running per-day aggregates of a plot's logged columns, updated with each
+// minute's row: min, max and mean, minutes above a per-column threshold,
+// and insolation (irradiance integrated over the day, Wh/m^2). At the first
+// row of a new day the finished day is written out as one line, so daily
+// reports don't need the day's 24 hourly files.
+//
+// Plain C++; the EEPROM and SD card side is daily_summary_io.h.
+//
+//------------------------------------------------------------------------------
+
+#ifndef DAILY_SUMMARY_H
+#define DAILY_SUMMARY_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DAILY_SUMMARY_MAGIC        (0x5344)
+#define DAILY_SUMMARY_MAX_COLUMNS  (10)
+#define DAILY_NO_IRAD              (-1)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// What a plot summarizes. thresholds[c] is NAN for columns without one.
+struct daily_config {
+  uint8_t      plot_id;
+  uint8_t      num_columns;
+  int8_t       irad_column;
+  const float* thresholds;
+};
+
+struct daily_stat {
+  float    min;
+  float    max;
+  float    sum;
+  uint16_t count;
+  uint16_t minutes_above;
+};
+
+// Exactly what is stored in EEPROM, CRC last.
+struct daily_summary {
+  uint16_t   magic;
+  uint8_t    plot_id;
+  uint8_t    num_columns;
+  uint32_t   seq;
+  uint32_t   day;
+  float      insolation;
+  daily_stat stats[DAILY_SUMMARY_MAX_COLUMNS];
+  uint16_t   crc;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     daily_begin(daily_summary* s, const daily_config* cfg, uint32_t t);
+void     daily_add(daily_summary* s, const daily_config* cfg,
+                   const float* values);
+bool     daily_same_day(const daily_summary* s, uint32_t t);
+bool     daily_matches(const daily_summary* s, const daily_config* cfg);
+uint32_t daily_day(uint32_t t);
+uint16_t daily_crc(const daily_summary* s);
+
+#endif
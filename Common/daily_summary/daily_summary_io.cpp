@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Daily Summary Storage
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; daily_summary.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <EEPROM.h>
+#include <SD.h>
+#include <TimeLib.h>
+#include <eeprom_map.h>
+#include <eeprom_ring.h>
+#include "daily_summary_io.h"
+
+static_assert(sizeof(daily_summary) <= EEPROM_SUMMARY_SLOT_SIZE,
+              "daily summary doesn't fit its EEPROM slot");
+
+//------------------------------------------------------------------------------
+//      __   __        __  ___              ___  __
+//     /  ` /  \ |\ | /__`  |   /\  |\ |  |  /__`
+//     \__, \__/ | \| .__/  |  /~~\ | \|  |  .__/
+//
+//------------------------------------------------------------------------------
+
+static const eeprom_ring ring = {
+  EEPROM_SUMMARY_ADDR, EEPROM_SUMMARY_SLOT_SIZE, EEPROM_SUMMARY_SLOTS,
+  DAILY_SUMMARY_MAGIC, offsetof(daily_summary, magic),
+  offsetof(daily_summary, seq), offsetof(daily_summary, crc)
+};
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Restore Summary
+//==============================================================================
+// Loads the newest valid slot written by this plot. Returns false, leaving
+// s cleared, if there is none.
+bool daily_load(daily_summary* s, const daily_config* cfg) {
+  uint16_t addr;
+
+  memset(s, 0, sizeof(*s));
+  if(!eeprom_ring_newest(&ring, &addr)) return false;
+  EEPROM.get(addr, *s);
+  if(!daily_matches(s, cfg)) {
+    memset(s, 0, sizeof(*s));
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// Save Summary
+//==============================================================================
+// Writes the next slot in the ring; EEPROM.put() skips unchanged bytes.
+void daily_save(daily_summary* s) {
+  s->seq++;
+  s->crc = daily_crc(s);
+  EEPROM.put(eeprom_ring_slot(&ring, s->seq), *s);
+}
+
+//==============================================================================
+// Write Day To Card
+//==============================================================================
+// Appends "date,min,max,mean,minutes above,... per column,insolation" to
+// DAILY_FILE_NAME, with a header if the file is new. Fields are numbered
+// like the log header.
+bool daily_write(const daily_summary* s) {
+  bool   exists = SD.exists(DAILY_FILE_NAME);
+  File   file = SD.open(DAILY_FILE_NAME, FILE_WRITE);
+  time_t t = (time_t)s->day * SECS_PER_DAY;
+  char   date[11];
+
+  if(!file) return false;
+
+  if(!exists) {
+    file.print(F("date"));
+    for(uint8_t c = 1; c <= s->num_columns; c++) {
+      file.print(F(",field"));
+      file.print(c);
+      file.print(F("_min,field"));
+      file.print(c);
+      file.print(F("_max,field"));
+      file.print(c);
+      file.print(F("_mean,field"));
+      file.print(c);
+      file.print(F("_above"));
+    }
+    file.println(F(",insolation_whsqm"));
+  }
+
+  sprintf(date, "%04d-%02d-%02d", year(t), month(t), day(t));
+  file.print(date);
+  for(uint8_t c = 0; c < s->num_columns; c++) {
+    const daily_stat* st = &s->stats[c];
+    file.print(',');
+    file.print(st->count ? st->min : NAN);
+    file.print(',');
+    file.print(st->count ? st->max : NAN);
+    file.print(',');
+    file.print(st->count ? st->sum / st->count : NAN);
+    file.print(',');
+    file.print(st->minutes_above);
+  }
+  file.print(',');
+  file.println(s->insolation);
+  file.close();
+  return true;
+}
+
+#endif
@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Daily Summary Storage
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Keeps the running daily summary in EEPROM across resets and writes the
+// finished day's line to the SD card.
+//
+// Saves rotate through EEPROM_SUMMARY_SLOTS slots with a sequence number,
+// and only changed bytes are written, so saving every 15 minutes plus
+// before every planned reset stays far inside the cells' write endurance.
+//
+//------------------------------------------------------------------------------
+
+#ifndef DAILY_SUMMARY_IO_H
+#define DAILY_SUMMARY_IO_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "daily_summary.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DAILY_FILE_NAME      "daily.csv"
+#define DAILY_SAVE_MINUTES   (15)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool daily_load(daily_summary* s, const daily_config* cfg);
+void daily_save(daily_summary* s);
+bool daily_write(const daily_summary* s);
+
+#endif
@@ -0,0 +1,230 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Diagnostics Output
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; Diag-Decode uses the headers alone.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <avr/pgmspace.h>
+#include "diag.h"
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct diag_entry {
+  uint8_t     code;
+  const char* text;
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Message text and the code lookup table, both in flash.
+#define DIAG_TEXT_DEF(name, code, text) static const char name##_text[] PROGMEM = text;
+DIAG_MESSAGES(DIAG_TEXT_DEF)
+#undef DIAG_TEXT_DEF
+
+#define DIAG_TABLE_ENTRY(name, code, text) {code, name##_text},
+static const diag_entry diag_table[] PROGMEM = {
+  DIAG_MESSAGES(DIAG_TABLE_ENTRY)
+};
+#undef DIAG_TABLE_ENTRY
+
+// Never called: a code given twice in DIAG_MESSAGES is a duplicate case
+// label here, which stops the build.
+#define DIAG_CASE(name, code, text) case code:
+static inline void diag_codes_unique(uint8_t code) {
+  switch(code) {
+    DIAG_MESSAGES(DIAG_CASE)
+    break;
+  }
+}
+#undef DIAG_CASE
+
+static uint8_t  diag_mode = DIAG_TEXT;
+static uint16_t dropped = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void emit(uint8_t code, uint8_t type, const void* arg, uint8_t len);
+static bool send_frame(uint8_t code, uint8_t type, const void* arg, uint8_t len);
+static void print_text(uint8_t code, uint8_t type, const void* arg);
+static void print_arg(uint8_t type, const void* arg);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Select Output Mode
+//==============================================================================
+void diag_begin(uint8_t mode) {
+  diag_mode = mode;
+  dropped = 0;
+}
+
+//==============================================================================
+// Emit Message
+//==============================================================================
+void diag(uint8_t code) {
+  emit(code, DIAG_ARG_NONE, NULL, 0);
+}
+
+void diag_int(uint8_t code, int32_t value) {
+  emit(code, DIAG_ARG_INT, &value, sizeof(value));
+}
+
+void diag_float(uint8_t code, float value) {
+  emit(code, DIAG_ARG_FLOAT, &value, sizeof(value));
+}
+
+void diag_str(uint8_t code, const char* value) {
+  size_t len = strlen(value);
+  emit(code, DIAG_ARG_STR, value,
+    (len > DIAG_MAX_PAYLOAD) ? DIAG_MAX_PAYLOAD : len);
+}
+
+void diag_ip(uint8_t code, uint32_t ip) {
+  emit(code, DIAG_ARG_IP, &ip, sizeof(ip));
+}
+
+//==============================================================================
+// Wait for Output to Drain
+//==============================================================================
+// For use right before a reset, so the last messages make it out.
+void diag_flush() {
+  Serial.flush();
+}
+
+//==============================================================================
+// Route Message to Current Mode
+//==============================================================================
+static void emit(uint8_t code, uint8_t type, const void* arg, uint8_t len) {
+  if(diag_mode == DIAG_TEXT) {
+    print_text(code, type, arg);
+    return;
+  }
+
+  // Report earlier drops first, once there is room for it.
+  if(dropped > 0) {
+    int32_t count = dropped;
+    if(send_frame(DIAG_DROPPED, DIAG_ARG_INT, &count, sizeof(count))) {
+      dropped = 0;
+    }
+  }
+  if(!send_frame(code, type, arg, len)) {
+    dropped++;
+  }
+}
+
+//==============================================================================
+// Send Binary Frame
+//==============================================================================
+// Only writes if the whole frame fits in the TX buffer, so it never blocks.
+static bool send_frame(uint8_t code, uint8_t type, const void* arg, uint8_t len) {
+  const uint8_t* payload = (const uint8_t*)arg;
+  uint8_t crc = 0;
+
+  if(Serial.availableForWrite() < len + DIAG_FRAME_OVERHEAD) return false;
+
+  Serial.write(DIAG_FRAME_START);
+  Serial.write(code);
+  Serial.write(type);
+  Serial.write(len);
+  crc = diag_crc8(crc, code);
+  crc = diag_crc8(crc, type);
+  crc = diag_crc8(crc, len);
+  for(uint8_t i = 0; i < len; i++) {
+    Serial.write(payload[i]);
+    crc = diag_crc8(crc, payload[i]);
+  }
+  Serial.write(crc);
+  return true;
+}
+
+//==============================================================================
+// Print Message as Text
+//==============================================================================
+static void print_text(uint8_t code, uint8_t type, const void* arg) {
+  // Find the message text for this code.
+  const char* text = NULL;
+  for(uint8_t i = 0; i < sizeof(diag_table) / sizeof(diag_table[0]); i++) {
+    if(pgm_read_byte(&diag_table[i].code) == code) {
+      text = (const char*)pgm_read_ptr(&diag_table[i].text);
+      break;
+    }
+  }
+
+  // Unknown code: print it raw.
+  if(!text) {
+    Serial.print(F("Diag "));
+    Serial.print(code);
+    Serial.print(F(": "));
+    print_arg(type, arg);
+    Serial.println();
+    return;
+  }
+
+  // Copy text out of flash, substituting the argument for '%'.
+  char c;
+  while((c = pgm_read_byte(text++))) {
+    if(c == '%') print_arg(type, arg);
+    else Serial.write(c);
+  }
+  Serial.println();
+}
+
+//==============================================================================
+// Print Message Argument
+//==============================================================================
+static void print_arg(uint8_t type, const void* arg) {
+  switch(type) {
+    case DIAG_ARG_INT:
+      Serial.print(*(const int32_t*)arg);
+      break;
+    case DIAG_ARG_FLOAT:
+      Serial.print(*(const float*)arg);
+      break;
+    case DIAG_ARG_STR:
+      Serial.print((const char*)arg);
+      break;
+    case DIAG_ARG_IP: {
+      const uint8_t* ip = (const uint8_t*)arg;
+      for(uint8_t i = 0; i < 4; i++) {
+        if(i > 0) Serial.write('.');
+        Serial.print(ip[i]);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+#endif
@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Diagnostics Output
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// All serial diagnostics go through here. Message text lives in flash (see
+// diag_codes.h). In DIAG_TEXT mode messages are printed as before; in
+// DIAG_BINARY mode only a short frame with the code and argument is sent,
+// and a frame that does not fit in the serial TX buffer is dropped (and
+// counted) rather than stalling the loop.
+//
+//------------------------------------------------------------------------------
+
+#ifndef DIAG_H
+#define DIAG_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "diag_codes.h"
+#include "diag_frame.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DIAG_TEXT    (0)
+#define DIAG_BINARY  (1)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void diag_begin(uint8_t mode);
+void diag(uint8_t code);
+void diag_int(uint8_t code, int32_t value);
+void diag_float(uint8_t code, float value);
+void diag_str(uint8_t code, const char* value);
+void diag_ip(uint8_t code, uint32_t ip);
+void diag_flush();
+
+#endif
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Diagnostic Message Codes
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Every diagnostic message the firmwares print, with a fixed numeric code.
+// The boards keep the text in flash and either print it or send just the
+// code and argument; Diag-Decode uses this same table to expand the codes
+// back into text. A '%' in the text marks where the argument goes.
+//
+// Never renumber an existing code; add new ones at the end of their group.
+//
+//------------------------------------------------------------------------------
+
+#ifndef DIAG_CODES_H
+#define DIAG_CODES_H
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DIAG_MESSAGES(X) \
+  /* System and setup. */ \
+  X(DIAG_DROPPED,            1, "(% diagnostic messages dropped)") \
+  X(DIAG_SYSTEM_RESET,       2, "//////////////////\r\n// SYSTEM RESET //\r\n//////////////////") \
+  X(DIAG_LOCAL_IP,           3, "Local IP: %") \
+  X(DIAG_LINK_STATUS,        4, "Link status: %") \
+  X(DIAG_HARDWARE_STATUS,    5, "Hardware status: %") \
+  X(DIAG_NTP_TIME,           6, "NTP time: %") \
+  X(DIAG_TEMP_INIT,          7, "Temp sensors initialized") \
+  X(DIAG_TEMP_COUNT,         8, "% sensors found") \
+  X(DIAG_AMBIENT_INIT,       9, "Ambient temp sensor initialized") \
+  X(DIAG_ADC_INIT,          10, "ADC initialized") \
+  X(DIAG_SDI_INIT,          11, "SDI-12 bus initialized") \
+  X(DIAG_WATCHDOG_TASK,     12, "Watchdog reset in task %") \
+  X(DIAG_WATCHDOG_STEP,     13, "Watchdog reset at checkpoint %") \
+  X(DIAG_WATCHDOG_STALL,    14, "Watchdog reset after % ms without progress") \
+  X(DIAG_WATCHDOG_RESETS,   15, "Watchdog resets so far: %") \
+  /* Main loop. */ \
+  X(DIAG_READING_SENSORS,   20, "Reading sensors") \
+  X(DIAG_WRITING_CARD,      21, "Writing to card") \
+  X(DIAG_ENABLING_LOADS,    22, "Enabling loads") \
+  X(DIAG_SENDING_ENV,       23, "Sending environmental data to ThingSpeak") \
+  X(DIAG_SENDING_PV,        24, "Sending PV data to ThingSpeak") \
+  X(DIAG_THINGSPEAK_RESP,   25, "ThingSpeak response: %") \
+  X(DIAG_DISABLING_LOADS,   26, "Disabling loads") \
+  X(DIAG_LOAD_MASK,         27, "Load mask: %") \
+  X(DIAG_LOAD_MINUTES,      28, "Load on-time: % min") \
+  X(DIAG_LOAD_WSQM,         29, "Derated irradiance: %") \
+  /* Resets. */ \
+  X(DIAG_RESET_CAUSE,       30, "Reset cause: %") \
+  X(DIAG_RESET_TASK,        31, "Task at reset: %") \
+  X(DIAG_RESET_UPTIME,      32, "Up % s before reset") \
+  X(DIAG_RESET_DOWNTIME,    33, "Down % s before logging again") \
+  X(DIAG_RESET_TALLY,       34, "Resets (cause x count, s down): %") \
+  X(DIAG_RESET_UNPLANNED,   35, "Unplanned resets so far: %") \
+  /* Sensor readings. */ \
+  X(DIAG_IRAD_ADC,          40, "Irradiance ADC: %") \
+  X(DIAG_IRAD,              41, "Irradiance: %") \
+  X(DIAG_SOIL_VWC,          42, "Soil VWC: %") \
+  X(DIAG_SOIL_TEMP,         43, "Soil Temp: %") \
+  X(DIAG_SOIL_SOWP,         44, "Soil Matric Potential: %") \
+  X(DIAG_TEROS_12_ERROR,    45, "TEROS-12 Error!") \
+  X(DIAG_TEROS_21_ERROR,    46, "TEROS-21 Error!") \
+  X(DIAG_AMBIENT_TEMP,      47, "Ambient Temp: %") \
+  X(DIAG_AMBIENT_HUMD,      48, "Ambient Humidity: %") \
+  X(DIAG_TEMP_0,            50, "Temp 0: %") \
+  X(DIAG_TEMP_1,            51, "Temp 1: %") \
+  X(DIAG_TEMP_2,            52, "Temp 2: %") \
+  X(DIAG_TEMP_3,            53, "Temp 3: %") \
+  X(DIAG_TEMP_4,            54, "Temp 4: %") \
+  X(DIAG_TEMP_5,            55, "Temp 5: %") \
+  X(DIAG_TEMP_6,            56, "Temp 6: %") \
+  X(DIAG_TEMP_7,            57, "Temp 7: %") \
+  X(DIAG_AMBIENT_STALE,     58, "Ambient reading % s old") \
+  X(DIAG_ADC_ERRORS,        59, "ADC errors: %") \
+  X(DIAG_I2C_RECOVERIES,    60, "I2C bus recoveries: %") \
+  X(DIAG_SDI_NO_RESPONSE,   61, "SDI-12 probe % not responding") \
+  X(DIAG_SDI_RETRIES,       62, "SDI-12 retries: %") \
+  X(DIAG_SDI_PROBES,        63, "% SDI-12 probes found") \
+  X(DIAG_SDI_PROBE,         64, "SDI-12 probe %") \
+  X(DIAG_SOIL_WRITE_FAIL,   65, "Soil probe file write failed") \
+  X(DIAG_SOIL_BULK_EC,      66, "Soil Bulk EC: %") \
+  X(DIAG_SOIL_PORE_EC,      67, "Soil Pore EC: %") \
+  /* SD card. */ \
+  X(DIAG_FILE_OPEN_FAIL,    70, "File failed to open with name '%'") \
+  X(DIAG_FILE_OPENED,       71, "Opened log_file file with name '%'") \
+  X(DIAG_ARCHIVE_OPEN_FAIL, 72, "Archive failed to open with name '%'") \
+  X(DIAG_ARCHIVE_WRITE_FAIL,73, "Archive write failed") \
+  X(DIAG_CAPTURE_OPEN_FAIL, 74, "Raw capture failed to open with name '%'") \
+  X(DIAG_CAPTURE_STALLS,    75, "Raw capture stalls: %") \
+  X(DIAG_SUMMARY_WRITE_FAIL,76, "Daily summary write failed") \
+  X(DIAG_SUMMARY_RESTORED,  77, "Daily summary restored") \
+  X(DIAG_TEMP_REBOUND,      78, "Temp probe % rebound") \
+  X(DIAG_TEMP_CRC_ERRORS,   79, "Temp CRC errors: %") \
+  /* Memory. */ \
+  X(DIAG_FREE_RAM,          80, "Free RAM: %") \
+  X(DIAG_HEAP_USED,         81, "Heap used: %") \
+  X(DIAG_LOW_WATER,         82, "RAM low water: %")
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum diag_code {
+#define DIAG_ENUM(name, code, text) name = code,
+  DIAG_MESSAGES(DIAG_ENUM)
+#undef DIAG_ENUM
+};
+
+#endif
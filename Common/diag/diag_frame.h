@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Diagnostic Frame Format
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// In binary mode each message goes out as one frame:
+//
+//   0xA5  code  type  length  payload[length]  crc8
+//
+// The CRC-8 (poly 0x07) covers code through the end of the payload. Numbers
+// are little-endian. Text output never contains 0xA5, so a reader can mix
+// both modes on one port and resynchronize on the start byte.
+//
+//------------------------------------------------------------------------------
+
+#ifndef DIAG_FRAME_H
+#define DIAG_FRAME_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DIAG_FRAME_START     (0xA5)
+#define DIAG_FRAME_OVERHEAD  (5)
+#define DIAG_MAX_PAYLOAD     (32)
+
+// Argument types.
+#define DIAG_ARG_NONE        (0)
+#define DIAG_ARG_INT         (1)
+#define DIAG_ARG_FLOAT       (2)
+#define DIAG_ARG_STR         (3)
+#define DIAG_ARG_IP          (4)
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Frame CRC-8
+//==============================================================================
+static inline uint8_t diag_crc8(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for(uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  }
+  return crc;
+}
+
+#endif
@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics EEPROM Map
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Where everything the firmware keeps in EEPROM lives, so regions can't
+// overlap. The mega2560 has 4096 bytes, the uno 1024; Relay-Control keeps
+// nothing in EEPROM.
+//
+// EEPROM cells are good for about 100,000 writes. Anything written often is
+// spread over a ring of slots (eeprom_ring.h).
+//
+//------------------------------------------------------------------------------
+
+#ifndef EEPROM_MAP_H
+#define EEPROM_MAP_H
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define EEPROM_PLOT_SIZE          (4096)
+
+// Daily summary (Common/daily_summary): a ring of slots, newest wins.
+#define EEPROM_SUMMARY_ADDR       (0)
+#define EEPROM_SUMMARY_SLOT_SIZE  (192)
+#define EEPROM_SUMMARY_SLOTS      (8)
+#define EEPROM_SUMMARY_END        (EEPROM_SUMMARY_ADDR + \
+                                   EEPROM_SUMMARY_SLOT_SIZE * EEPROM_SUMMARY_SLOTS)
+
+// One-wire probe binding (Common/onewire_bind): one slot per bus, written
+// only when a probe is swapped.
+#define EEPROM_ONEWIRE_ADDR       (EEPROM_SUMMARY_END)
+#define EEPROM_ONEWIRE_SIZE       (80)
+#define EEPROM_ONEWIRE_SLOTS      (4)
+#define EEPROM_ONEWIRE_END        (EEPROM_ONEWIRE_ADDR + \
+                                   EEPROM_ONEWIRE_SIZE * EEPROM_ONEWIRE_SLOTS)
+
+// Watchdog post-mortem (Common/watchdog): one record, written only after a
+// watchdog reset.
+#define EEPROM_WATCHDOG_ADDR      (EEPROM_ONEWIRE_END)
+#define EEPROM_WATCHDOG_SIZE      (16)
+#define EEPROM_WATCHDOG_END       (EEPROM_WATCHDOG_ADDR + EEPROM_WATCHDOG_SIZE)
+
+// Reset log (Common/reset_log): a ring of events, newest wins, written
+// once per reset.
+#define EEPROM_RESETS_ADDR        (EEPROM_WATCHDOG_END)
+#define EEPROM_RESETS_SLOT_SIZE   (80)
+#define EEPROM_RESETS_SLOTS       (16)
+#define EEPROM_RESETS_END         (EEPROM_RESETS_ADDR + \
+                                   EEPROM_RESETS_SLOT_SIZE * EEPROM_RESETS_SLOTS)
+
+#if EEPROM_RESETS_END > EEPROM_PLOT_SIZE
+#error "EEPROM map doesn't fit"
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics EEPROM Ring
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <EEPROM.h>
+#include <archive.h>
+#include "eeprom_ring.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool slot_valid(const eeprom_ring* r, uint16_t addr, uint32_t* seq);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Find Newest Slot
+//==============================================================================
+// Returns false, leaving addr alone, if no slot holds a valid record.
+bool eeprom_ring_newest(const eeprom_ring* r, uint16_t* addr) {
+  bool     found = false;
+  uint32_t best_seq = 0;
+
+  for(uint8_t i = 0; i < r->slots; i++) {
+    uint16_t slot = r->addr + i * r->slot_size;
+    uint32_t seq;
+    if(slot_valid(r, slot, &seq) && (!found || seq > best_seq)) {
+      *addr = slot;
+      best_seq = seq;
+      found = true;
+    }
+  }
+  return found;
+}
+
+//==============================================================================
+// Slot For Record
+//==============================================================================
+// Where the record with sequence number seq is written.
+uint16_t eeprom_ring_slot(const eeprom_ring* r, uint32_t seq) {
+  return r->addr + (seq % r->slots) * r->slot_size;
+}
+
+//==============================================================================
+// Check EEPROM Slot
+//==============================================================================
+// CRC computed straight from EEPROM so no second copy is needed in RAM.
+static bool slot_valid(const eeprom_ring* r, uint16_t addr, uint32_t* seq) {
+  uint16_t magic;
+  uint16_t stored;
+  uint16_t crc = 0xFFFF;
+
+  EEPROM.get(addr + r->magic_at, magic);
+  if(magic != r->magic) return false;
+
+  for(uint16_t i = 0; i < r->crc_at; i++) {
+    uint8_t b = EEPROM.read(addr + i);
+    crc = archive_crc16(&b, 1, crc);
+  }
+  EEPROM.get(addr + r->crc_at, stored);
+  EEPROM.get(addr + r->seq_at, *seq);
+  return crc == stored;
+}
+
+#endif
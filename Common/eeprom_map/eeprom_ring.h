@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics EEPROM Ring
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// A region of equal slots written round-robin so no one cell wears out.
+// Each record carries a magic number, a sequence number that goes up by one
+// per write, and a CRC of everything before it; the newest slot whose
+// magic and CRC check out is the current record. The record is written to
+// the slot its sequence number picks, so a torn write only loses that one.
+//
+//------------------------------------------------------------------------------
+
+#ifndef EEPROM_RING_H
+#define EEPROM_RING_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// Where the ring is (eeprom_map.h) and where the record keeps its magic
+// (uint16_t), sequence number (uint32_t) and CRC (uint16_t, archive_crc16()
+// of every byte before it).
+struct eeprom_ring {
+  uint16_t addr;
+  uint16_t slot_size;
+  uint8_t  slots;
+  uint16_t magic;
+  uint8_t  magic_at;
+  uint8_t  seq_at;
+  uint8_t  crc_at;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool     eeprom_ring_newest(const eeprom_ring* r, uint16_t* addr);
+uint16_t eeprom_ring_slot(const eeprom_ring* r, uint32_t seq);
+
+#endif
@@ -0,0 +1,50 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Scheduling Rules
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Rules used by Plot-2 and, by default, by Schedule-Sim. Load A comes on
+// first; load B only once there is clearly enough sun for both.
+//
+//------------------------------------------------------------------------------
+
+#ifndef LOAD_RULES_H
+#define LOAD_RULES_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "load_schedule.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define LOAD_SMOOTHING_MINUTES  (5)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+//                                   loads         window  on   off  min  min  re-  daily
+//                                                         W/m2 W/m2 on   off  fresh budget
+static const load_rule load_rules[] = {
+  {RELAY_LOAD_A, 9, 17, 300, 200, 15,  10,  5,   0},
+  {RELAY_LOAD_B, 10, 16, 600, 450, 15,  15,  5,   0},
+};
+
+#define NUM_LOAD_RULES  (sizeof(load_rules) / sizeof(load_rules[0]))
+
+#endif
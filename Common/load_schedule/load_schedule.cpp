@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Irradiance-Aware Load Scheduler
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "load_schedule.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t on_minutes(const load_rule* rule);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Scheduler
+//==============================================================================
+void load_schedule_init(load_schedule* s, const load_rule* rules,
+                        uint8_t num_rules, uint8_t smoothing) {
+  memset(s, 0, sizeof(*s));
+  if(num_rules > LOAD_SCHEDULE_MAX_RULES) num_rules = LOAD_SCHEDULE_MAX_RULES;
+  s->rules = rules;
+  s->num_rules = num_rules;
+  s->smoothing = smoothing > 0 ? smoothing : 1;
+
+  // Start every rule as if it has been off long enough to turn on.
+  for(uint8_t i = 0; i < num_rules; i++) {
+    s->state[i].minutes_in_state = rules[i].min_off_minutes;
+  }
+}
+
+//==============================================================================
+// Temperature-Derated Irradiance
+//==============================================================================
+// Scales irradiance by the PV power temperature coefficient, giving a rough
+// measure of what the panels can actually deliver.
+float load_schedule_derate(float irad_wsqm, float pv_temp) {
+  // NaN and negative readings (dark offset, bad sensor) count as no sun.
+  if(!(irad_wsqm > 0)) return 0;
+  if(!(pv_temp > LOAD_PV_TEMP_INVALID)) return irad_wsqm;
+
+  float scale = 1 + LOAD_PV_TEMP_COEFF * (pv_temp - LOAD_PV_TEMP_REF);
+  if(scale < 0) scale = 0;
+  return irad_wsqm * scale;
+}
+
+//==============================================================================
+// Advance One Minute
+//==============================================================================
+// Call once per minute with the latest readings. Fills cmds (room for
+// num_rules entries) with the relay commands to send this minute and returns
+// how many there are. Rules that produce the same on-time are merged into a
+// single command.
+uint8_t load_schedule_step(load_schedule* s, uint8_t day, uint8_t hour,
+                           float irad_wsqm, float pv_temp,
+                           relay_cmd* cmds) {
+  // Local variables.
+  uint8_t num_cmds = 0;
+  float   eff = load_schedule_derate(irad_wsqm, pv_temp);
+
+  // Smooth out passing clouds.
+  if(!s->primed) {
+    s->filtered_wsqm = eff;
+    s->day = day;
+    s->primed = true;
+  }
+  else {
+    s->filtered_wsqm += (eff - s->filtered_wsqm) / s->smoothing;
+  }
+
+  // New day, new budget.
+  if(day != s->day) {
+    s->day = day;
+    for(uint8_t i = 0; i < s->num_rules; i++) s->state[i].minutes_today = 0;
+  }
+
+  for(uint8_t i = 0; i < s->num_rules; i++) {
+    const load_rule* rule = &s->rules[i];
+    load_rule_state* st = &s->state[i];
+    uint8_t minutes = 0xFF;
+
+    // Account for the minute just gone.
+    if(st->minutes_in_state < 0xFFFF) st->minutes_in_state++;
+    if(st->on) {
+      st->minutes_today++;
+      st->since_refresh++;
+    }
+
+    bool in_window = hour >= rule->start_hour && hour <= rule->end_hour;
+    bool in_budget = rule->max_daily_minutes == 0 ||
+                     st->minutes_today < rule->max_daily_minutes;
+
+    if(st->on) {
+      // The window and budget are hard limits; low sun has to wait out the
+      // minimum on-time.
+      if(!in_window || !in_budget ||
+         (s->filtered_wsqm < rule->off_wsqm &&
+          st->minutes_in_state >= rule->min_on_minutes)) {
+        st->on = false;
+        st->minutes_in_state = 0;
+        minutes = 0;
+      }
+      else if(st->since_refresh >= rule->refresh_minutes) {
+        st->since_refresh = 0;
+        minutes = on_minutes(rule);
+      }
+    }
+    else if(in_window && in_budget && s->filtered_wsqm >= rule->on_wsqm &&
+            st->minutes_in_state >= rule->min_off_minutes) {
+      st->on = true;
+      st->minutes_in_state = 0;
+      st->since_refresh = 0;
+      minutes = on_minutes(rule);
+    }
+
+    if(minutes == 0xFF) continue;
+
+    // Share a frame with any other load getting the same command.
+    uint8_t j;
+    for(j = 0; j < num_cmds; j++) {
+      if(cmds[j].minutes == minutes) {
+        cmds[j].loads |= rule->loads;
+        break;
+      }
+    }
+    if(j == num_cmds) {
+      cmds[num_cmds].loads = rule->loads;
+      cmds[num_cmds].minutes = minutes;
+      num_cmds++;
+    }
+  }
+  return num_cmds;
+}
+
+//==============================================================================
+// Command On-Time
+//==============================================================================
+static uint8_t on_minutes(const load_rule* rule) {
+  uint16_t minutes = rule->refresh_minutes + LOAD_ON_MARGIN_MINUTES;
+  return minutes > RELAY_MAX_MINUTES ? RELAY_MAX_MINUTES : minutes;
+}
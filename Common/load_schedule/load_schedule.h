@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Irradiance-Aware Load Scheduler
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Decides once a minute, from the plot's irradiance and PV backsheet
+// temperature, whether each group of loads should run. Irradiance is derated
+// for panel temperature and smoothed, then compared against on/off
+// thresholds (hysteresis) with minimum on and off times, inside an allowed
+// time-of-day window and a daily on-time budget.
+//
+// While a rule is on it re-sends its command every refresh_minutes with an
+// on-time slightly longer than that, so the loads stay on as long as the
+// plot keeps confirming, and drop out on their own if it stops. Turning off
+// sends an explicit 0-minute command.
+//
+// Plain C++ so Schedule-Sim can run the exact same logic over old logs.
+//
+//------------------------------------------------------------------------------
+
+#ifndef LOAD_SCHEDULE_H
+#define LOAD_SCHEDULE_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <relay_protocol.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define LOAD_SCHEDULE_MAX_RULES  (4)
+
+// PV power temperature coefficient (per degree C above 25 C).
+#define LOAD_PV_TEMP_COEFF       (-0.004f)
+#define LOAD_PV_TEMP_REF         (25.0f)
+
+// PV temperatures below this are treated as a missing probe.
+#define LOAD_PV_TEMP_INVALID     (-50.0f)
+
+// Extra on-time added to each command beyond the refresh period, so a
+// late refresh doesn't let the loads blink off.
+#define LOAD_ON_MARGIN_MINUTES   (2)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct load_rule {
+  uint8_t  loads;              // RELAY_LOAD_* mask
+  uint8_t  start_hour;         // allowed window, both ends inclusive
+  uint8_t  end_hour;
+  int16_t  on_wsqm;            // turn on at or above (derated W/m^2)
+  int16_t  off_wsqm;           // turn off below
+  uint8_t  min_on_minutes;
+  uint8_t  min_off_minutes;
+  uint8_t  refresh_minutes;    // re-send period while on
+  uint16_t max_daily_minutes;  // on-time budget per day, 0 = unlimited
+};
+
+struct load_rule_state {
+  bool     on;
+  uint16_t minutes_in_state;
+  uint16_t minutes_today;
+  uint8_t  since_refresh;
+};
+
+struct load_schedule {
+  const load_rule* rules;
+  uint8_t          num_rules;
+  uint8_t          smoothing;     // EMA length in minutes
+  uint8_t          day;
+  bool             primed;
+  float            filtered_wsqm;
+  load_rule_state  state[LOAD_SCHEDULE_MAX_RULES];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void  load_schedule_init(load_schedule* s, const load_rule* rules,
+                         uint8_t num_rules, uint8_t smoothing);
+float load_schedule_derate(float irad_wsqm, float pv_temp);
+uint8_t load_schedule_step(load_schedule* s, uint8_t day, uint8_t hour,
+                           float irad_wsqm, float pv_temp,
+                           relay_cmd* cmds);
+
+#endif
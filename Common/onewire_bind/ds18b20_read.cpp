@@ -0,0 +1,204 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics DS18B20 Reader
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <sensor_calc.h>
+#include <eeprom_map.h>
+#include "onewire_bind_io.h"
+#include "ds18b20_read.h"
+
+static_assert(DS18B20_MAX_BUSES <= EEPROM_ONEWIRE_SLOTS,
+              "not enough EEPROM slots for every bus");
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define CONVERT_T         (0x44)
+#define READ_SCRATCHPAD   (0xBE)
+#define READ_POWER_SUPPLY (0xB4)
+#define SCRATCHPAD_SIZE   (9)
+#define TEMP_BYTES        (2)
+
+// 12-bit conversion time; each bit less halves it.
+#define CONVERSION_MS     (750)
+#define MAX_RESOLUTION    (12)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void read_bus(ds18b20_array* a, ds18b20_bus* bus, int16_t* raw,
+                     bool verify);
+static bool read_scratchpad(OneWire* wire, const uint8_t* rom, uint8_t* pad,
+                            uint8_t len);
+static bool parasite_powered(OneWire* wire);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Bind All Buses
+//==============================================================================
+// Binds each bus from its EEPROM slot. defaults holds every probe's
+// secrets.h address, bus by bus, and raw readings are numbered the same
+// way. *rebound gets the mask of probes that changed. Returns how many
+// probes answered.
+uint8_t ds18b20_begin(ds18b20_array* a, ds18b20_bus* buses,
+                      uint8_t num_buses, const onewire_rom* defaults,
+                      uint8_t resolution, uint32_t* rebound) {
+  uint8_t present = 0;
+
+  a->buses = buses;
+  a->num_buses = num_buses > DS18B20_MAX_BUSES ? DS18B20_MAX_BUSES : num_buses;
+  a->num_probes = 0;
+  a->conversion_ms = CONVERSION_MS >> (MAX_RESOLUTION - resolution);
+  a->crc_errors = 0;
+  *rebound = 0;
+
+  for(uint8_t b = 0; b < a->num_buses; b++) {
+    ds18b20_bus* bus = &buses[b];
+    uint8_t      changed;
+
+    bus->first = a->num_probes;
+    bus->trusted = 0;
+    bus->parasite = parasite_powered(bus->wire);
+    present += onewire_bind(&bus->binding, bus->wire, b, bus->num_probes,
+                            defaults ? defaults + bus->first : NULL, &changed);
+    *rebound |= (uint32_t)changed << bus->first;
+    a->num_probes += bus->num_probes;
+  }
+  return present;
+}
+
+//==============================================================================
+// Sample All Probes
+//==============================================================================
+// Starts a conversion on every bus, then reads each bus once its probes
+// are done (they answer read slots with 1) or the conversion time is up.
+// A parasite-powered bus keeps the strong pull-up on until the timeout;
+// a read slot would cut the probes' power mid-conversion.
+// raw gets one reading per probe, DS18B20_DISCONNECTED_RAW for a probe that
+// didn't answer or failed its CRC. verify forces full reads, so the caller
+// can recheck every probe once a minute.
+void ds18b20_sample(ds18b20_array* a, int16_t* raw, bool verify) {
+  uint8_t  pending = 0;
+  uint32_t start;
+
+  for(uint8_t b = 0; b < a->num_buses; b++) {
+    OneWire* wire = a->buses[b].wire;
+    if(wire->reset()) {
+      wire->skip();
+      wire->write(CONVERT_T, a->buses[b].parasite);
+    }
+    pending |= 1 << b;
+  }
+  start = millis();
+
+  while(pending) {
+    bool timed_out = millis() - start >= a->conversion_ms;
+    for(uint8_t b = 0; b < a->num_buses; b++) {
+      ds18b20_bus* bus = &a->buses[b];
+      uint8_t      bit = 1 << b;
+      if(!(pending & bit)) continue;
+      if(timed_out || (!bus->parasite && bus->wire->read_bit())) {
+        if(bus->parasite) bus->wire->depower();
+        read_bus(a, bus, raw, verify);
+        pending &= ~bit;
+      }
+    }
+  }
+}
+
+//==============================================================================
+// Read One Bus
+//==============================================================================
+static void read_bus(ds18b20_array* a, ds18b20_bus* bus, int16_t* raw,
+                     bool verify) {
+  uint8_t pad[SCRATCHPAD_SIZE];
+
+  for(uint8_t r = 0; r < bus->num_probes; r++) {
+    const uint8_t* rom = bus->binding.rom[r];
+    int16_t*       out = &raw[bus->first + r];
+    uint8_t        bit = 1 << r;
+
+    *out = DS18B20_DISCONNECTED_RAW;
+    if(onewire_rom_empty(rom)) continue;
+
+    // Short read. All ones is what a probe that isn't there gives back.
+    if(!verify && (bus->trusted & bit) &&
+       read_scratchpad(bus->wire, rom, pad, TEMP_BYTES) &&
+       !(pad[0] == 0xFF && pad[1] == 0xFF) &&
+       ds18b20_raw_plausible(ds18b20_scratch_raw(pad))) {
+      *out = ds18b20_scratch_raw(pad);
+      continue;
+    }
+
+    if(read_scratchpad(bus->wire, rom, pad, SCRATCHPAD_SIZE) &&
+       onewire_crc8(pad, SCRATCHPAD_SIZE - 1) == pad[SCRATCHPAD_SIZE - 1] &&
+       !(pad[0] == 0xFF && pad[1] == 0xFF)) {
+      *out = ds18b20_scratch_raw(pad);
+      bus->trusted |= bit;
+    } else {
+      bus->trusted &= ~bit;
+      a->crc_errors++;
+    }
+  }
+
+  // Ends the last short read.
+  bus->wire->reset();
+}
+
+//==============================================================================
+// Read Scratchpad
+//==============================================================================
+// The first len bytes; a read cut short is ended by the next reset.
+static bool read_scratchpad(OneWire* wire, const uint8_t* rom, uint8_t* pad,
+                            uint8_t len) {
+  if(!wire->reset()) return false;
+  wire->select(rom);
+  wire->write(READ_SCRATCHPAD);
+  wire->read_bytes(pad, len);
+  return true;
+}
+
+//==============================================================================
+// Check For Parasite Power
+//==============================================================================
+// Any parasite-powered probe answers Read Power Supply with a 0. A bus with
+// nothing on it counts as externally powered.
+static bool parasite_powered(OneWire* wire) {
+  bool parasite;
+
+  if(!wire->reset()) return false;
+  wire->skip();
+  wire->write(READ_POWER_SUPPLY);
+  parasite = !wire->read_bit();
+  wire->reset();
+  return parasite;
+}
+
+#endif
@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics DS18B20 Reader
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Samples every DS18B20 on one or more one-wire buses. Conversions are
+// started on all buses at once and each bus is read as soon as its probes
+// report done, so adding a bus adds a few milliseconds of reads, not
+// another conversion time. ds18b20_begin() asks each bus whether any probe
+// on it is parasite powered (Read Power Supply). Such a bus is held high
+// through the strong pull-up while it converts, can't be polled, and is
+// read at the conversion timeout.
+//
+// A probe whose last full scratchpad read passed its CRC is read short:
+// just the two temperature bytes, with the next reset cutting the read
+// off. Anything implausible in a short read gets a full read with CRC on
+// the spot.
+//
+// Readings are raw 1/128 C like DallasTemperature::getTemp(), so they go
+// straight into the raw capture and the sensor_calc functions.
+//
+//------------------------------------------------------------------------------
+
+#ifndef DS18B20_READ_H
+#define DS18B20_READ_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <OneWire.h>
+#include "onewire_bind.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Each bus has its own binding in EEPROM.
+#define DS18B20_MAX_BUSES    (4)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// One bus and the probes bound on it. The plot sets wire and num_probes;
+// the rest is filled in by ds18b20_begin().
+struct ds18b20_bus {
+  OneWire*        wire;
+  uint8_t         num_probes;
+  uint8_t         first;      // Index of the bus's first probe overall.
+  uint8_t         trusted;    // Probes that may be read short.
+  bool            parasite;   // A probe draws power from the data line.
+  onewire_binding binding;
+};
+
+struct ds18b20_array {
+  ds18b20_bus* buses;
+  uint8_t      num_buses;
+  uint8_t      num_probes;
+  uint16_t     conversion_ms;
+  uint16_t     crc_errors;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+uint8_t ds18b20_begin(ds18b20_array* a, ds18b20_bus* buses,
+                      uint8_t num_buses, const onewire_rom* defaults,
+                      uint8_t resolution, uint32_t* rebound);
+void    ds18b20_sample(ds18b20_array* a, int16_t* raw, bool verify);
+
+#endif
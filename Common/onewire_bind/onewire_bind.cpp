@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics One-Wire Probe Binding
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string.h>
+#include <archive.h>
+#include "onewire_bind.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static int8_t find_rom(const onewire_rom* roms, uint8_t n, const uint8_t* rom);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Empty Binding
+//==============================================================================
+void onewire_binding_init(onewire_binding* b, uint8_t num_roles) {
+  memset(b, 0, sizeof(*b));
+  b->magic = ONEWIRE_BIND_MAGIC;
+  b->num_roles = num_roles;
+}
+
+//==============================================================================
+// Check Cached Binding
+//==============================================================================
+// A cache written for a different number of roles is thrown away.
+bool onewire_binding_valid(const onewire_binding* b, uint8_t num_roles) {
+  return b->magic == ONEWIRE_BIND_MAGIC && b->num_roles == num_roles &&
+         num_roles <= ONEWIRE_MAX_ROLES && b->crc == onewire_binding_crc(b);
+}
+
+//==============================================================================
+// Binding CRC
+//==============================================================================
+uint16_t onewire_binding_crc(const onewire_binding* b) {
+  return archive_crc16((const uint8_t*)b, offsetof(onewire_binding, crc),
+                       0xFFFF);
+}
+
+//==============================================================================
+// Assign Probes To Roles
+//==============================================================================
+// found is the result of a bus search. A role keeps its probe if it was
+// found. A role whose probe is missing takes, in order of preference, its
+// default (the secrets.h address) or the first found probe no role has
+// claimed; with nothing left over it keeps the old address, so a probe that
+// is only loose comes back by itself. defaults may be NULL. Returns a mask
+// of the roles that changed probe.
+uint8_t onewire_assign(onewire_binding* b, const onewire_rom* found,
+                       uint8_t num_found, const onewire_rom* defaults) {
+  bool    claimed[ONEWIRE_MAX_FOUND] = {false};
+  uint8_t open = 0;
+  uint8_t changed = 0;
+
+  if(num_found > ONEWIRE_MAX_FOUND) num_found = ONEWIRE_MAX_FOUND;
+
+  for(uint8_t r = 0; r < b->num_roles; r++) {
+    int8_t i = find_rom(found, num_found, b->rom[r]);
+    if(i >= 0 && !onewire_rom_empty(b->rom[r])) {
+      claimed[i] = true;
+    } else {
+      open |= 1 << r;
+    }
+  }
+
+  // Defaults first, so a fresh cache binds the same way secrets.h did.
+  for(uint8_t r = 0; r < b->num_roles && defaults; r++) {
+    if(!(open & (1 << r))) continue;
+    int8_t i = find_rom(found, num_found, defaults[r]);
+    if(i >= 0 && !claimed[i]) {
+      claimed[i] = true;
+      open &= ~(1 << r);
+      if(memcmp(b->rom[r], found[i], ONEWIRE_ROM_SIZE) != 0) {
+        memcpy(b->rom[r], found[i], ONEWIRE_ROM_SIZE);
+        changed |= 1 << r;
+      }
+    }
+  }
+
+  for(uint8_t r = 0, i = 0; r < b->num_roles; r++) {
+    if(!(open & (1 << r))) continue;
+    while(i < num_found && claimed[i]) i++;
+    if(i >= num_found) break;
+    claimed[i] = true;
+    memcpy(b->rom[r], found[i], ONEWIRE_ROM_SIZE);
+    changed |= 1 << r;
+  }
+  return changed;
+}
+
+//==============================================================================
+// Check ROM Code
+//==============================================================================
+// A DS18B20 whose ROM came through the search intact.
+bool onewire_rom_valid(const uint8_t* rom) {
+  return rom[0] == DS18B20_FAMILY &&
+         onewire_crc8(rom, ONEWIRE_ROM_SIZE - 1) == rom[ONEWIRE_ROM_SIZE - 1];
+}
+
+bool onewire_rom_empty(const uint8_t* rom) {
+  for(uint8_t i = 0; i < ONEWIRE_ROM_SIZE; i++) {
+    if(rom[i]) return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// Dallas CRC-8
+//==============================================================================
+// x^8 + x^5 + x^4 + 1, LSB first, as used for ROM codes and scratchpads.
+uint8_t onewire_crc8(const uint8_t* p, uint8_t len) {
+  uint8_t crc = 0;
+
+  while(len--) {
+    uint8_t b = *p++;
+    for(uint8_t i = 0; i < 8; i++) {
+      uint8_t mix = (crc ^ b) & 0x01;
+      crc >>= 1;
+      if(mix) crc ^= 0x8C;
+      b >>= 1;
+    }
+  }
+  return crc;
+}
+
+//==============================================================================
+// Find ROM In List
+//==============================================================================
+static int8_t find_rom(const onewire_rom* roms, uint8_t n, const uint8_t* rom) {
+  for(uint8_t i = 0; i < n; i++) {
+    if(memcmp(roms[i], rom, ONEWIRE_ROM_SIZE) == 0) return i;
+  }
+  return -1;
+}
@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics One-Wire Probe Binding
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Which DS18B20 fills which role (the plot's temp_N probes), cached in
+// EEPROM so boot only has to check the bound probes answer instead of
+// searching the bus. When one doesn't, the bus is searched and probes
+// nobody has claimed are handed to the roles that lost theirs, so a
+// swapped probe is picked up without a reflash.
+//
+// Plain C++; the bus and EEPROM side is onewire_bind_io.h.
+//
+//------------------------------------------------------------------------------
+
+#ifndef ONEWIRE_BIND_H
+#define ONEWIRE_BIND_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define ONEWIRE_BIND_MAGIC   (0x4F57)
+#define ONEWIRE_ROM_SIZE     (8)
+#define ONEWIRE_MAX_ROLES    (8)
+#define ONEWIRE_MAX_FOUND    (12)
+#define DS18B20_FAMILY       (0x28)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+typedef uint8_t onewire_rom[ONEWIRE_ROM_SIZE];
+
+// Exactly what is stored in EEPROM, CRC last. An all-zero ROM is an
+// unbound role.
+struct onewire_binding {
+  uint16_t    magic;
+  uint8_t     num_roles;
+  onewire_rom rom[ONEWIRE_MAX_ROLES];
+  uint16_t    crc;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     onewire_binding_init(onewire_binding* b, uint8_t num_roles);
+bool     onewire_binding_valid(const onewire_binding* b, uint8_t num_roles);
+uint16_t onewire_binding_crc(const onewire_binding* b);
+uint8_t  onewire_assign(onewire_binding* b, const onewire_rom* found,
+                        uint8_t num_found, const onewire_rom* defaults);
+bool     onewire_rom_valid(const uint8_t* rom);
+bool     onewire_rom_empty(const uint8_t* rom);
+uint8_t  onewire_crc8(const uint8_t* p, uint8_t len);
+
+#endif
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics One-Wire Probe Binding Storage
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; onewire_bind.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include <EEPROM.h>
+#include <eeprom_map.h>
+#include "onewire_bind_io.h"
+
+static_assert(sizeof(onewire_binding) <= EEPROM_ONEWIRE_SIZE,
+              "one-wire binding doesn't fit its EEPROM region");
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define READ_SCRATCHPAD   (0xBE)
+#define SCRATCHPAD_SIZE   (9)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t search_bus(OneWire* bus, onewire_rom* found);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Bind Probes
+//==============================================================================
+// Loads the bus's binding from its EEPROM slot and checks each bound probe
+// with a ROM-match read. If they all answer that's it; otherwise the bus is
+// searched and the roles reassigned (see onewire_assign()). *rebound gets
+// the mask of roles that changed probe. Returns how many roles have a probe
+// that answered.
+uint8_t onewire_bind(onewire_binding* b, OneWire* bus, uint8_t slot,
+                     uint8_t num_roles, const onewire_rom* defaults,
+                     uint8_t* rebound) {
+  uint16_t    addr = EEPROM_ONEWIRE_ADDR + slot * EEPROM_ONEWIRE_SIZE;
+  onewire_rom found[ONEWIRE_MAX_FOUND];
+  uint8_t     num_found;
+  uint8_t     present = 0;
+
+  *rebound = 0;
+  EEPROM.get(addr, *b);
+  if(onewire_binding_valid(b, num_roles)) {
+    for(uint8_t r = 0; r < num_roles; r++) {
+      if(onewire_present(bus, b->rom[r])) present++;
+    }
+    if(present == num_roles) return present;
+  } else {
+    onewire_binding_init(b, num_roles);
+  }
+
+  num_found = search_bus(bus, found);
+  *rebound = onewire_assign(b, found, num_found, defaults);
+  if(*rebound || b->crc != onewire_binding_crc(b)) {
+    b->crc = onewire_binding_crc(b);
+    EEPROM.put(addr, *b);
+  }
+
+  present = 0;
+  for(uint8_t r = 0; r < num_roles; r++) {
+    for(uint8_t i = 0; i < num_found; i++) {
+      if(memcmp(b->rom[r], found[i], ONEWIRE_ROM_SIZE) == 0) {
+        present++;
+        break;
+      }
+    }
+  }
+  return present;
+}
+
+//==============================================================================
+// Check Probe Answers
+//==============================================================================
+// Addresses the probe alone and reads its scratchpad; only a probe that is
+// there returns one with a good CRC.
+bool onewire_present(OneWire* bus, const uint8_t* rom) {
+  uint8_t pad[SCRATCHPAD_SIZE];
+
+  if(onewire_rom_empty(rom) || !bus->reset()) return false;
+  bus->select(rom);
+  bus->write(READ_SCRATCHPAD);
+  bus->read_bytes(pad, SCRATCHPAD_SIZE);
+  if(!bus->reset()) return false;
+
+  // An empty bus reads all ones, which a CRC check alone doesn't reject.
+  return onewire_crc8(pad, SCRATCHPAD_SIZE - 1) == pad[SCRATCHPAD_SIZE - 1] &&
+         !(pad[0] == 0xFF && pad[1] == 0xFF);
+}
+
+//==============================================================================
+// Search The Bus
+//==============================================================================
+// Collects the DS18B20s whose ROM came through intact, up to
+// ONEWIRE_MAX_FOUND.
+static uint8_t search_bus(OneWire* bus, onewire_rom* found) {
+  uint8_t n = 0;
+
+  bus->reset_search();
+  while(n < ONEWIRE_MAX_FOUND && bus->search(found[n])) {
+    if(onewire_rom_valid(found[n])) n++;
+  }
+  return n;
+}
+
+#endif
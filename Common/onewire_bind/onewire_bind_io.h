@@ -0,0 +1,39 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics One-Wire Probe Binding Storage
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Boot-time binding of a bus's DS18B20s. Each bus has its own EEPROM slot,
+// only written back when a role changes probe, so the EEPROM sees a write
+// per probe swap.
+//
+//------------------------------------------------------------------------------
+
+#ifndef ONEWIRE_BIND_IO_H
+#define ONEWIRE_BIND_IO_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <OneWire.h>
+#include "onewire_bind.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+uint8_t onewire_bind(onewire_binding* b, OneWire* bus, uint8_t slot,
+                     uint8_t num_roles, const onewire_rom* defaults,
+                     uint8_t* rebound);
+bool    onewire_present(OneWire* bus, const uint8_t* rom);
+
+#endif
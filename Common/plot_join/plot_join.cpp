@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Cross-Plot Time Alignment
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <math.h>
+#include "plot_join.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void load_next(join_stream* j);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Start Stream
+//==============================================================================
+// Grid times must then be asked for in increasing order from start.
+void join_stream_init(join_stream* j, const col_store* store,
+                      const uint8_t* columns, uint8_t num_columns,
+                      int64_t start, int64_t tolerance) {
+  j->num_columns = num_columns;
+  for(uint8_t i = 0; i < num_columns; i++) j->columns[i] = columns[i];
+  j->have_prev = false;
+
+  // Anything older than start - tolerance can never be used.
+  col_cursor_seek(&j->cursor, store, start - tolerance);
+  load_next(j);
+}
+
+//==============================================================================
+// Sample At Grid Time
+//==============================================================================
+// Fills out with one value per stream column. Returns false (and NaNs) when
+// no sample is close enough to t.
+bool join_stream_sample(join_stream* j, int64_t t, join_mode mode,
+                        int64_t tolerance, float* out) {
+  // Step forward until prev is the last sample at or before t.
+  while(j->have_next && j->next_time <= t) {
+    j->prev_time = j->next_time;
+    for(uint8_t i = 0; i < j->num_columns; i++) j->prev[i] = j->next[i];
+    j->have_prev = true;
+    load_next(j);
+  }
+
+  bool prev_ok = j->have_prev && t - j->prev_time <= tolerance;
+  bool next_ok = j->have_next && j->next_time - t <= tolerance;
+
+  if(mode == JOIN_LINEAR && prev_ok && next_ok && j->prev_time != t) {
+    float w = (float)(t - j->prev_time) / (j->next_time - j->prev_time);
+    for(uint8_t i = 0; i < j->num_columns; i++) {
+      out[i] = j->prev[i] + w * (j->next[i] - j->prev[i]);
+    }
+    return true;
+  }
+
+  if(prev_ok) {
+    for(uint8_t i = 0; i < j->num_columns; i++) out[i] = j->prev[i];
+    return true;
+  }
+
+  for(uint8_t i = 0; i < j->num_columns; i++) out[i] = NAN;
+  return false;
+}
+
+//==============================================================================
+// Read Next Sample From Store
+//==============================================================================
+static void load_next(join_stream* j) {
+  j->have_next = col_cursor_valid(&j->cursor);
+  if(!j->have_next) return;
+
+  j->next_time = col_cursor_time(&j->cursor);
+  for(uint8_t i = 0; i < j->num_columns; i++) {
+    j->next[i] = col_cursor_value(&j->cursor, j->columns[i]);
+  }
+  col_cursor_next(&j->cursor);
+}
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Cross-Plot Time Alignment
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Puts plots that sample on their own clocks onto one time grid. Each plot
+// is a join_stream walking forward through its column store, holding only
+// the samples on either side of the current grid point, so memory use does
+// not depend on the length of the range.
+//
+// At grid time g a stream reports either
+//   JOIN_ASOF    the latest sample at or before g, or
+//   JOIN_LINEAR  the straight line between the samples either side of g
+//                (as-of if only the earlier one is close enough),
+// as long as the samples used are no more than the tolerance away from g;
+// otherwise the values are NaN.
+//
+//------------------------------------------------------------------------------
+
+#ifndef PLOT_JOIN_H
+#define PLOT_JOIN_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <column_store.h>
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum join_mode {
+  JOIN_ASOF,
+  JOIN_LINEAR
+};
+
+struct join_stream {
+  col_cursor cursor;
+  uint8_t    num_columns;
+  uint8_t    columns[COL_MAX_COLUMNS];
+  bool       have_prev;
+  bool       have_next;
+  int64_t    prev_time;
+  int64_t    next_time;
+  float      prev[COL_MAX_COLUMNS];
+  float      next[COL_MAX_COLUMNS];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void join_stream_init(join_stream* j, const col_store* store,
+                      const uint8_t* columns, uint8_t num_columns,
+                      int64_t start, int64_t tolerance);
+bool join_stream_sample(join_stream* j, int64_t t, join_mode mode,
+                        int64_t tolerance, float* out);
+
+#endif
@@ -0,0 +1,330 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Plot Log Scanner
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Fast path for reading plot logs on the host, specialized at compile time
+// on the number of columns in a row:
+//
+//   log_scanner<plot_traits<2>::num_columns> scan;
+//   p = scan.scan(p, end, last, on_row, on_other);
+//
+// Commas and newlines are located 32 (AVX2) or 16 (SSE2) bytes at a time
+// and walked with count-trailing-zeros. Timestamps are decoded from their
+// fixed "YYYY-MM-DD HH:MM:SS" layout, with the date part cached since every
+// row of an hourly file shares it. Values of the form [-]digits[.digits]
+// (everything the firmware prints) are converted directly; anything else
+// goes through strtof.
+//
+// on_row(int64_t t, const float* values) gets every well-formed row.
+// on_other(const char* line, const char* eol) gets everything else (header
+// lines, rows from a different plot, damaged rows) so the caller can fall
+// back to log_parse_row() or count it.
+//
+//------------------------------------------------------------------------------
+
+#ifndef LOG_SCAN_H
+#define LOG_SCAN_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "plot_log.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+#define LOG_SCAN_WIDTH  (32)
+#define LOG_SCAN_ISA    "avx2"
+#elif defined(__SSE2__)
+#define LOG_SCAN_WIDTH  (16)
+#define LOG_SCAN_ISA    "sse2"
+#else
+#define LOG_SCAN_WIDTH  (16)
+#define LOG_SCAN_ISA    "scalar"
+#endif
+
+// Longest mantissa the direct float conversion handles exactly.
+#define LOG_SCAN_MAX_DIGITS  (15)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// Column counts, matching plot_schemas[].
+template<uint8_t PLOT_ID> struct plot_traits;
+template<> struct plot_traits<1> { static const uint8_t num_columns = 7; };
+template<> struct plot_traits<2> { static const uint8_t num_columns = 10; };
+template<> struct plot_traits<3> { static const uint8_t num_columns = 4; };
+
+// Finds ',' and '\n' in order.
+class log_delims {
+public:
+  log_delims(const char* p, const char* end)
+    : block(p), end(end), mask(0) {
+    load(p);
+  }
+
+  // Next delimiter at or after the current position, or NULL at the end.
+  inline const char* next() {
+    while(mask == 0) {
+      block += LOG_SCAN_WIDTH;
+      if(block >= end) return NULL;
+      load(block);
+    }
+    const char* p = block + __builtin_ctz(mask);
+    mask &= mask - 1;
+    return p;
+  }
+
+private:
+  const char* block;
+  const char* end;
+  uint32_t    mask;
+
+  inline void load(const char* p) {
+    // Full blocks use vector compares; the tail never reads past end.
+    if(end - p >= LOG_SCAN_WIDTH) {
+#if defined(__AVX2__)
+      __m256i v = _mm256_loadu_si256((const __m256i*)p);
+      __m256i m = _mm256_or_si256(
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+      mask = (uint32_t)_mm256_movemask_epi8(m);
+#elif defined(__SSE2__)
+      __m128i v = _mm_loadu_si128((const __m128i*)p);
+      __m128i m = _mm_or_si128(
+        _mm_cmpeq_epi8(v, _mm_set1_epi8(',')),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+      mask = (uint32_t)_mm_movemask_epi8(m);
+#else
+      mask = 0;
+      for(uint8_t i = 0; i < LOG_SCAN_WIDTH; i++) {
+        if(p[i] == ',' || p[i] == '\n') mask |= 1u << i;
+      }
+#endif
+    }
+    else {
+      mask = 0;
+      for(uint8_t i = 0; i < end - p; i++) {
+        if(p[i] == ',' || p[i] == '\n') mask |= 1u << i;
+      }
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Fast Float Conversion
+//==============================================================================
+// Handles [-]digits[.digits]; returns false for anything else.
+static inline bool log_scan_float(const char* p, const char* end, float* out) {
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15
+  };
+  const char* start = p;
+  bool        neg = false;
+  uint64_t    m = 0;
+  uint8_t     digits = 0;
+  uint8_t     frac = 0;
+  uint64_t    bits;
+
+  if(p < end && *p == '-') {
+    neg = true;
+    p++;
+  }
+  for(; p < end && (uint8_t)(*p - '0') <= 9; p++, digits++) {
+    m = m * 10 + (*p - '0');
+  }
+  if(p < end && *p == '.') {
+    for(p++; p < end && (uint8_t)(*p - '0') <= 9; p++, digits++, frac++) {
+      m = m * 10 + (*p - '0');
+    }
+  }
+  if(p != end || digits == 0 || digits > LOG_SCAN_MAX_DIGITS) return false;
+
+  // m and 10^frac are both exact in a double, so the quotient is rounded
+  // once to double, then again to float. The second rounding can only
+  // differ from strtof() when the first lands exactly halfway between two
+  // floats (the 29 bits float drops are 1000...0); strtof() settles those.
+  double v = (double)m / pow10[frac];
+  memcpy(&bits, &v, sizeof(bits));
+  if((bits & 0x1FFFFFFF) == 0x10000000) {
+    char text[LOG_SCAN_MAX_DIGITS + 3];
+    memcpy(text, start, end - start);
+    text[end - start] = '\0';
+    *out = strtof(text, NULL);
+    return true;
+  }
+  *out = (float)(neg ? -v : v);
+  return true;
+}
+
+//==============================================================================
+// Scanner
+//==============================================================================
+template<uint8_t N>
+class log_scanner {
+public:
+  log_scanner() : cached_days(0) {
+    memset(cached_date, 0, sizeof(cached_date));
+  }
+
+  //============================================================================
+  // Scan Buffer
+  //============================================================================
+  // Scans complete lines in [p, end). A final line without a newline is
+  // only consumed if last is true; otherwise its start is returned so the
+  // caller can carry it into the next buffer.
+  template<class ROW, class OTHER>
+  const char* scan(const char* p, const char* end, bool last,
+                   ROW on_row, OTHER on_other) {
+    // Local variables.
+    log_delims  delims(p, end);
+    const char* line = p;
+    const char* field = p;
+    const char* d;
+    uint8_t     col = 0;
+    int64_t     t = 0;
+    float       values[N];
+    bool        ok = true;
+
+    while((d = delims.next()) != NULL) {
+      const char* field_end = d;
+
+      if(*d == '\n') {
+        if(field_end > field && field_end[-1] == '\r') field_end--;
+        if(ok && col == N &&
+           convert(field, field_end, &values[N - 1])) {
+          on_row(t, (const float*)values);
+        }
+        else {
+          on_other(line, d);
+        }
+        line = field = d + 1;
+        col = 0;
+        ok = true;
+        continue;
+      }
+
+      // Comma: close the current field.
+      if(!ok) continue;
+      if(col == 0) {
+        ok = parse_time(field, field_end, &t);
+      }
+      else if(col <= N - 1) {
+        ok = convert(field, field_end, &values[col - 1]);
+      }
+      else {
+        ok = false;
+      }
+      col++;
+      field = d + 1;
+    }
+
+    if(line < end && last) {
+      if(parse_line(line, end, &t, values)) on_row(t, (const float*)values);
+      else on_other(line, end);
+      return end;
+    }
+    return line;
+  }
+
+  //============================================================================
+  // Parse One Line
+  //============================================================================
+  // Scalar version of the scan loop for a single line without its newline.
+  bool parse_line(const char* p, const char* eol, int64_t* t, float* values) {
+    const char* comma = (const char*)memchr(p, ',', eol - p);
+
+    if(eol > p && eol[-1] == '\r') eol--;
+    if(!comma || !parse_time(p, comma, t)) return false;
+    for(uint8_t col = 0; col < N; col++) {
+      const char* field = comma + 1;
+      comma = (const char*)memchr(field, ',', eol - field);
+      if((col < N - 1) != (comma != NULL)) return false;
+      if(!convert(field, comma ? comma : eol, &values[col])) return false;
+    }
+    return true;
+  }
+
+  //============================================================================
+  // Parse Timestamp
+  //============================================================================
+  // Decodes "YYYY-MM-DD HH:MM:SS" plus an optional " TZ" suffix.
+  inline bool parse_time(const char* p, const char* end, int64_t* t) {
+    if(end - p < 19 || (end - p > 19 && p[19] != ' ')) return false;
+
+    if(memcmp(p, cached_date, 10) != 0) {
+      log_date date;
+      if(!log_parse_time(p, end, &date)) return false;
+      date.hour = date.minute = date.second = 0;
+      cached_days = log_time_from_date(&date);
+      memcpy(cached_date, p, 10);
+    }
+
+    uint8_t h1 = p[11] - '0', h0 = p[12] - '0';
+    uint8_t m1 = p[14] - '0', m0 = p[15] - '0';
+    uint8_t s1 = p[17] - '0', s0 = p[18] - '0';
+    if(p[10] != ' ' || p[13] != ':' || p[16] != ':' || h1 > 2 || h0 > 9 ||
+       m1 > 5 || m0 > 9 || s1 > 6 || s0 > 9) {
+      return false;
+    }
+    uint8_t hour = h1 * 10 + h0;
+    if(hour > 23) return false;
+
+    *t = cached_days + hour * 3600 + (m1 * 10 + m0) * SECS_PER_MINUTE +
+         s1 * 10 + s0;
+    return true;
+  }
+
+private:
+  char    cached_date[10];
+  int64_t cached_days;
+
+  static inline bool convert(const char* p, const char* end, float* out) {
+    if(log_scan_float(p, end, out)) return true;
+
+    // Rare: exponents, nan, inf.
+    char  field[32];
+    char* conv_end;
+    size_t len = end - p;
+    if(len == 0 || len >= sizeof(field)) return false;
+    memcpy(field, p, len);
+    field[len] = 0;
+    *out = strtof(field, &conv_end);
+    return conv_end == field + len;
+  }
+};
+
+#endif
@@ -0,0 +1,297 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Plot Log Format
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "plot_log.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Column names follow the variable names in each plot's loop().
+static const char* const plot_1_columns[] = {
+  "soil_0_volw", "soil_0_temp", "temp_0_temp", "tmph_0_temp",
+  "tmph_0_humd", "irad_0_wsqm", "soil_2_sowp"
+};
+
+static const char* const plot_2_columns[] = {
+  "soil_1_volw", "soil_1_temp", "temp_1_temp", "tmph_1_temp",
+  "tmph_1_humd", "irad_1_wsqm", "soil_3_sowp", "temp_2_temp",
+  "temp_3_temp", "temp_4_temp"
+};
+
+static const char* const plot_3_columns[] = {
+  "temp_5_temp", "temp_6_temp", "temp_7_temp", "irad_2_wsqm"
+};
+
+const plot_schema plot_schemas[NUM_PLOTS] = {
+  {1, "sun",   7,  plot_1_columns},
+  {2, "shade", 10, plot_2_columns},
+  {3, "roof",  4,  plot_3_columns},
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool parse_digits(const char* p, uint8_t n, int* value);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Look Up Schema By Plot
+//==============================================================================
+const plot_schema* plot_schema_by_id(uint8_t plot_id) {
+  for(uint8_t i = 0; i < NUM_PLOTS; i++) {
+    if(plot_schemas[i].plot_id == plot_id) return &plot_schemas[i];
+  }
+  return NULL;
+}
+
+//==============================================================================
+// Look Up Schema By Column Count
+//==============================================================================
+// Every plot logs a different number of columns, so a row identifies its
+// own plot.
+const plot_schema* plot_schema_by_columns(uint8_t num_columns) {
+  for(uint8_t i = 0; i < NUM_PLOTS; i++) {
+    if(plot_schemas[i].num_columns == num_columns) return &plot_schemas[i];
+  }
+  return NULL;
+}
+
+//==============================================================================
+// Date To Seconds
+//==============================================================================
+// Days-from-civil on the proleptic Gregorian calendar.
+int64_t log_time_from_date(const log_date* date) {
+  int      y = date->year - (date->month <= 2);
+  int      era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned mp = (date->month + 9) % 12;
+  unsigned doy = (153 * mp + 2) / 5 + date->day - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  int64_t  days = (int64_t)era * 146097 + doe - 719468;
+
+  return days * SECS_PER_DAY + date->hour * 3600 +
+         date->minute * SECS_PER_MINUTE + date->second;
+}
+
+//==============================================================================
+// Seconds To Date
+//==============================================================================
+void log_date_from_time(int64_t t, log_date* date) {
+  int64_t  days = t / SECS_PER_DAY;
+  int64_t  secs = t % SECS_PER_DAY;
+  if(secs < 0) {
+    secs += SECS_PER_DAY;
+    days--;
+  }
+
+  int64_t  z = days + 719468;
+  int64_t  era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = (unsigned)(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  unsigned month = mp < 10 ? mp + 3 : mp - 9;
+
+  date->year = (int)(yoe + era * 400 + (month <= 2));
+  date->month = month;
+  date->day = doy - (153 * mp + 2) / 5 + 1;
+  date->hour = secs / 3600;
+  date->minute = secs / 60 % 60;
+  date->second = secs % 60;
+}
+
+//==============================================================================
+// Format Timestamp
+//==============================================================================
+// Writes LOG_TIME_LEN characters plus a terminator, matching the firmware.
+// Years outside 0-9999 are clamped so the width never changes.
+void log_format_time(int64_t t, char* buf) {
+  log_date date;
+  log_date_from_time(t, &date);
+  if(date.year < 0) date.year = 0;
+  if(date.year > 9999) date.year = 9999;
+  snprintf(buf, LOG_TIME_LEN + 1, "%04d-%02d-%02d %02d:%02d:%02d PDT",
+    date.year, date.month % 100, date.day % 100, date.hour % 100,
+    date.minute % 100, date.second % 100);
+}
+
+//==============================================================================
+// Format Value
+//==============================================================================
+// Prints a float the way the firmware's log_file.print() does (Arduino
+// Print::printFloat with 2 digits, in AVR single precision): round by adding
+// 0.005, then emit the integer part and two truncated digits. Returns the
+// length written.
+int log_format_value(float value, char* buf) {
+  if(isnan(value)) return sprintf(buf, "nan");
+  if(isinf(value)) return sprintf(buf, "inf");
+  if(value > 4294967040.0f || value < -4294967040.0f) return sprintf(buf, "ovf");
+
+  int   len = 0;
+  float rounding = 0.5f;
+  if(value < 0.0f) {
+    buf[len++] = '-';
+    value = -value;
+  }
+  rounding /= 10.0f;
+  rounding /= 10.0f;
+  value += rounding;
+
+  uint32_t int_part = (uint32_t)value;
+  float    remainder = value - (float)int_part;
+  len += sprintf(buf + len, "%lu.", (unsigned long)int_part);
+  for(uint8_t i = 0; i < 2; i++) {
+    remainder *= 10.0f;
+    unsigned digit = (unsigned)remainder;
+    buf[len++] = '0' + digit;
+    remainder -= digit;
+  }
+  buf[len] = 0;
+  return len;
+}
+
+//==============================================================================
+// Parse Row Timestamp
+//==============================================================================
+bool log_parse_time(const char* p, const char* end, log_date* date) {
+  int year, month, day, hour, minute, second;
+
+  if(end - p < 19) return false;
+  if(p[4] != '-' || p[7] != '-' || p[10] != ' ' || p[13] != ':' ||
+     p[16] != ':') {
+    return false;
+  }
+  if(!parse_digits(p, 4, &year) || !parse_digits(p + 5, 2, &month) ||
+     !parse_digits(p + 8, 2, &day) || !parse_digits(p + 11, 2, &hour) ||
+     !parse_digits(p + 14, 2, &minute) || !parse_digits(p + 17, 2, &second)) {
+    return false;
+  }
+  if(month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 ||
+     minute > 59 || second > 60) {
+    return false;
+  }
+
+  date->year = year;
+  date->month = month;
+  date->day = day;
+  date->hour = hour;
+  date->minute = minute;
+  date->second = second;
+  return true;
+}
+
+//==============================================================================
+// Parse Log Row
+//==============================================================================
+// Parses one line (without its newline) into a date and up to max_columns
+// values. Returns the number of values, or -1 if the line is malformed or
+// has more than max_columns values.
+int log_parse_row(const char* p, const char* end, log_date* date,
+                  float* values, uint8_t max_columns) {
+  // Local variables.
+  char  field[32];
+  int   num_values = 0;
+
+  if(!log_parse_time(p, end, date)) return -1;
+  p = (const char*)memchr(p, ',', end - p);
+
+  while(p) {
+    const char* start = p + 1;
+    const char* stop = (const char*)memchr(start, ',', end - start);
+    size_t      len = (stop ? stop : end) - start;
+    char*       conv_end;
+
+    if(num_values == max_columns || len == 0 || len >= sizeof(field)) {
+      return -1;
+    }
+
+    // The field isn't terminated in the mapped file, so copy it out.
+    memcpy(field, start, len);
+    field[len] = 0;
+    values[num_values] = strtof(field, &conv_end);
+    if(conv_end == field) return -1;
+    if(*conv_end != 0 && *conv_end != '\r') return -1;
+
+    num_values++;
+    p = stop;
+  }
+  return num_values;
+}
+
+//==============================================================================
+// Parse Hourly File Name
+//==============================================================================
+// Reads MM-DD_HH from a MM-DD_HH.log name (any directory prefix is
+// ignored). The year is left at 0; the name doesn't carry one.
+bool log_parse_name(const char* name, log_date* date) {
+  const char* base = strrchr(name, '/');
+  int         month, day, hour;
+
+  base = base ? base + 1 : name;
+  if(strlen(base) != 12 ||
+     (strcmp(base + 8, ".log") != 0 && strcmp(base + 8, ".LOG") != 0)) {
+    return false;
+  }
+  if(base[2] != '-' || base[5] != '_' || !parse_digits(base, 2, &month) ||
+     !parse_digits(base + 3, 2, &day) || !parse_digits(base + 6, 2, &hour)) {
+    return false;
+  }
+  if(month < 1 || month > 12 || day < 1 || day > 31 || hour > 23) {
+    return false;
+  }
+
+  memset(date, 0, sizeof(*date));
+  date->month = month;
+  date->day = day;
+  date->hour = hour;
+  return true;
+}
+
+//==============================================================================
+// Detect Header Line
+//==============================================================================
+bool log_is_header(const char* p, const char* end) {
+  return end - p >= 10 && memcmp(p, "created_at", 10) == 0;
+}
+
+//==============================================================================
+// Parse Fixed-Width Decimal
+//==============================================================================
+static bool parse_digits(const char* p, uint8_t n, int* value) {
+  int v = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    if(p[i] < '0' || p[i] > '9') return false;
+    v = v * 10 + (p[i] - '0');
+  }
+  *value = v;
+  return true;
+}
@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Plot Log Format
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Host-side description of the hourly MM-DD_HH.log files the plots write:
+// one row per minute of
+//
+//   YYYY-MM-DD HH:MM:SS PDT,<value>,<value>,...
+//
+// with a per-plot column list, below a ThingSpeak-style header line.
+// Timestamps are local wall-clock time; they are handled here as seconds
+// since 1970-01-01 00:00:00 of that same wall clock, the same convention as
+// the firmware's time_t.
+//
+//------------------------------------------------------------------------------
+
+#ifndef PLOT_LOG_H
+#define PLOT_LOG_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define PLOT_LOG_MAX_COLUMNS  (12)
+#define NUM_PLOTS             (3)
+
+// "YYYY-MM-DD HH:MM:SS PDT"
+#define LOG_TIME_LEN          (23)
+
+// Longest value log_format_value() writes, plus a terminator.
+#define LOG_VALUE_LEN         (16)
+
+#define SECS_PER_MINUTE       (60)
+#define SECS_PER_DAY          (86400)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct plot_schema {
+  uint8_t            plot_id;
+  const char*        name;
+  uint8_t            num_columns;
+  const char* const* columns;
+};
+
+struct log_date {
+  int     year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+extern const plot_schema plot_schemas[NUM_PLOTS];
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+const plot_schema* plot_schema_by_id(uint8_t plot_id);
+const plot_schema* plot_schema_by_columns(uint8_t num_columns);
+
+int64_t log_time_from_date(const log_date* date);
+void    log_date_from_time(int64_t t, log_date* date);
+void    log_format_time(int64_t t, char* buf);
+int     log_format_value(float value, char* buf);
+
+bool    log_parse_time(const char* p, const char* end, log_date* date);
+int     log_parse_row(const char* p, const char* end, log_date* date,
+                      float* values, uint8_t max_columns);
+bool    log_parse_name(const char* name, log_date* date);
+bool    log_is_header(const char* p, const char* end);
+
+#endif
@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics RAM Usage Monitor
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <diag.h>
+#include "ram_monitor.h"
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Provided by the linker and avr-libc malloc.
+extern uint8_t  __heap_start;
+extern char*    __brkval;
+
+// Lowest low-water mark reported so far.
+static uint16_t low_water = 0xFFFF;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void ram_paint() __attribute__((naked, used, section(".init3")));
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Paint Free RAM
+//==============================================================================
+// Runs from .init3, after the stack pointer is set up and before .data/.bss
+// are initialized or any constructor has touched the heap. Must not call
+// anything or use the stack.
+void ram_paint() {
+  uint8_t* p = &__heap_start;
+  while(p < (uint8_t*)SP) {
+    *p++ = RAM_CANARY;
+  }
+}
+
+//==============================================================================
+// Current Free RAM
+//==============================================================================
+// Bytes between the top of the heap and the stack pointer right now.
+uint16_t ram_free() {
+  uint8_t top_of_stack;
+  uint8_t* heap_end = __brkval ? (uint8_t*)__brkval : &__heap_start;
+  return &top_of_stack - heap_end;
+}
+
+//==============================================================================
+// Heap In Use
+//==============================================================================
+uint16_t ram_heap_used() {
+  return __brkval ? (uint8_t*)__brkval - &__heap_start : 0;
+}
+
+//==============================================================================
+// Stack/Heap Low-Water Mark
+//==============================================================================
+// Counts untouched canary bytes above the heap. This is the smallest gap
+// there has ever been between heap and stack since reset.
+uint16_t ram_low_water() {
+  uint8_t* p = __brkval ? (uint8_t*)__brkval : &__heap_start;
+  uint8_t  top_of_stack;
+  uint16_t count = 0;
+
+  while(p < &top_of_stack && *p == RAM_CANARY) {
+    p++;
+    count++;
+  }
+  if(count < low_water) low_water = count;
+  return low_water;
+}
+
+//==============================================================================
+// Print RAM Usage
+//==============================================================================
+void ram_print_usage() {
+  diag_int(DIAG_FREE_RAM, ram_free());
+  diag_int(DIAG_HEAP_USED, ram_heap_used());
+  diag_int(DIAG_LOW_WATER, ram_low_water());
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics RAM Usage Monitor
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// The free RAM between the heap and the stack is painted with a canary byte
+// before main() runs. Scanning for the first overwritten byte gives the
+// closest the stack (or heap) has ever come to a collision since boot.
+//
+// The build-time half of this lives in ram_report.py, which every plot
+// runs as a post-link script.
+//
+//------------------------------------------------------------------------------
+
+#ifndef RAM_MONITOR_H
+#define RAM_MONITOR_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define RAM_CANARY  (0xC5)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+uint16_t ram_free();
+uint16_t ram_heap_used();
+uint16_t ram_low_water();
+void     ram_print_usage();
+
+#endif
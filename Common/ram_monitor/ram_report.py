@@ -0,0 +1,189 @@
+#-------------------------------------------------------------------------------
+# GFU Agrivoltaics Build-Time RAM Report
+# Nathaniel Hudson
+# nhudson18@georgefox.edu
+# Summer 2021
+#-------------------------------------------------------------------------------
+#
+# PlatformIO post-link script. Breaks the firmware's static RAM (.data,
+# .bss, .noinit) down by module using the linker map, lists the largest stack
+# frame of each module from -fstack-usage, and fails the build if the RAM
+# left after the configured heap and stack reserves drops below the minimum
+# headroom.
+#
+# platformio.ini:
+#   build_flags = -fstack-usage
+#   extra_scripts = post:../Common/ram_monitor/ram_report.py
+#   custom_ram_heap_reserve = 512
+#   custom_ram_stack_reserve = 1536
+#   custom_ram_min_headroom = 512
+#
+#-------------------------------------------------------------------------------
+
+Import("env")
+
+import glob
+import os
+import re
+
+#-------------------------------------------------------------------------------
+# Defines
+#-------------------------------------------------------------------------------
+
+RAM_SECTIONS = (".data", ".bss", ".noinit")
+
+DEFAULT_HEAP_RESERVE = 512
+DEFAULT_STACK_RESERVE = 1536
+DEFAULT_MIN_HEADROOM = 512
+
+MAP_PATH = os.path.join("$BUILD_DIR", "${PROGNAME}.map")
+
+# Input section on one line, or name alone with address/size on the next.
+INPUT_LINE = re.compile(r"^ (\.\S+|COMMON)\s+0x[0-9a-f]+\s+0x([0-9a-f]+)\s+(\S.*)$")
+INPUT_NAME = re.compile(r"^ (\.\S+|COMMON)\s*$")
+INPUT_REST = re.compile(r"^\s+0x[0-9a-f]+\s+0x([0-9a-f]+)\s+(\S.*)$")
+OUTPUT_LINE = re.compile(r"^(\.\S+)")
+
+#-------------------------------------------------------------------------------
+# Functions
+#-------------------------------------------------------------------------------
+
+def module_name(path):
+    """Name the library, framework or project part an object belongs to."""
+    path = path.replace("\\", "/")
+
+    # Archive member: /path/libFoo.a(bar.cpp.o)
+    match = re.match(r"(.*)\((.*)\)$", path)
+    if match:
+        archive = os.path.basename(match.group(1))
+        return re.sub(r"^lib|\.a$", "", archive)
+
+    parts = path.split("/")
+    if "src" in parts:
+        return "src"
+    for i, part in enumerate(parts):
+        if re.match(r"lib[0-9a-f]+$", part) and i + 1 < len(parts):
+            return parts[i + 1]
+    return os.path.basename(path)
+
+
+def parse_map(map_path):
+    """Sum RAM input sections from the linker map per module."""
+    usage = {}
+    output_section = None
+    pending = None
+
+    with open(map_path) as map_file:
+        for line in map_file:
+            line = line.rstrip("\n")
+
+            # Output sections start in the first column.
+            match = OUTPUT_LINE.match(line)
+            if match:
+                output_section = match.group(1)
+                pending = None
+                continue
+            if output_section not in RAM_SECTIONS:
+                continue
+
+            match = INPUT_LINE.match(line)
+            if match:
+                name, size, path = match.groups()
+            elif pending:
+                match = INPUT_REST.match(line)
+                pending_name = pending
+                pending = None
+                if not match:
+                    continue
+                name = pending_name
+                size, path = match.groups()
+            else:
+                match = INPUT_NAME.match(line)
+                if match:
+                    pending = match.group(1)
+                continue
+
+            size = int(size, 16)
+            if size == 0:
+                continue
+            module = usage.setdefault(module_name(path),
+                                      {s: 0 for s in RAM_SECTIONS})
+            module[output_section] += size
+    return usage
+
+
+def parse_stack_usage(build_dir):
+    """Largest single stack frame per module from -fstack-usage output."""
+    frames = {}
+    for su_path in glob.glob(os.path.join(build_dir, "**", "*.su"),
+                             recursive=True):
+        parts = os.path.relpath(su_path, build_dir).replace("\\", "/").split("/")
+        if re.match(r"lib[0-9a-f]+$", parts[0]) and len(parts) > 2:
+            module = parts[1]
+        else:
+            module = parts[0]
+        with open(su_path) as su_file:
+            for line in su_file:
+                fields = line.rstrip("\n").split("\t")
+                if len(fields) < 2 or not fields[1].isdigit():
+                    continue
+                function = fields[0].split(":", 3)[-1]
+                size = int(fields[1])
+                if size > frames.get(module, (0, ""))[0]:
+                    frames[module] = (size, function)
+    return frames
+
+
+def option(name, default):
+    return int(env.GetProjectOption(name, default))
+
+
+def ram_report(source, target, env):
+    build_dir = env.subst("$BUILD_DIR")
+    map_path = env.subst(MAP_PATH)
+    ram_size = int(env.BoardConfig().get("upload.maximum_ram_size"))
+    heap_reserve = option("custom_ram_heap_reserve", DEFAULT_HEAP_RESERVE)
+    stack_reserve = option("custom_ram_stack_reserve", DEFAULT_STACK_RESERVE)
+    min_headroom = option("custom_ram_min_headroom", DEFAULT_MIN_HEADROOM)
+
+    usage = parse_map(map_path)
+    frames = parse_stack_usage(build_dir)
+
+    print("")
+    print("RAM usage by module")
+    print("%-24s %7s %7s %7s %7s   %s" %
+          ("module", ".data", ".bss", ".noinit", "total", "largest frame"))
+    totals = {s: 0 for s in RAM_SECTIONS}
+    rows = sorted(usage.items(), key=lambda kv: -sum(kv[1].values()))
+    for module, sections in rows:
+        for s in RAM_SECTIONS:
+            totals[s] += sections[s]
+        frame = frames.get(module)
+        frame_text = "%d (%s)" % frame if frame else ""
+        print("%-24s %7d %7d %7d %7d   %s" %
+              (module, sections[".data"], sections[".bss"],
+               sections[".noinit"], sum(sections.values()), frame_text))
+
+    static = sum(totals.values())
+    headroom = ram_size - static - heap_reserve - stack_reserve
+    print("%-24s %7d %7d %7d %7d" %
+          ("TOTAL", totals[".data"], totals[".bss"], totals[".noinit"], static))
+    print("")
+    print("RAM size:       %5d" % ram_size)
+    print("Static:         %5d" % static)
+    print("Heap reserve:   %5d" % heap_reserve)
+    print("Stack reserve:  %5d" % stack_reserve)
+    print("Headroom:       %5d (minimum %d)" % (headroom, min_headroom))
+    print("")
+
+    if headroom < min_headroom:
+        print("Error: RAM headroom %d is below the %d byte minimum" %
+              (headroom, min_headroom))
+        env.Exit(1)
+
+#-------------------------------------------------------------------------------
+# Public
+#-------------------------------------------------------------------------------
+
+env.Append(LINKFLAGS=["-Wl,-Map," + MAP_PATH])
+env.AddPostAction(os.path.join("$BUILD_DIR", "${PROGNAME}.elf"), ram_report)
\ No newline at end of file
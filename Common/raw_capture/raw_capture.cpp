@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Raw Sensor Capture Format
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "raw_capture.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool valid_header(const uint8_t* p, const uint8_t* end);
+static bool torn(const uint8_t* p, const uint8_t* end);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Next Record
+//==============================================================================
+// Reads the record at *p and advances past it. A header that can't be a
+// record (unknown type, or running past the end), or a record with a frame
+// inside it, is a torn write: bytes are skipped, and counted in *skipped, up
+// to the next frame. Returns false at the end of the data.
+bool raw_next(const uint8_t** p, const uint8_t* end, raw_record* rec,
+              uint32_t* skipped) {
+  const uint8_t* q = *p;
+
+  while(q < end && (!valid_header(q, end) || torn(q, end))) {
+    q++;
+    while(q < end && !raw_is_frame(q, end)) q++;
+  }
+  *skipped += q - *p;
+  if(q >= end) {
+    *p = end;
+    return false;
+  }
+
+  rec->type = q[0];
+  rec->sensor = q[1];
+  rec->len = q[2];
+  rec->payload = q + RAW_HEADER_SIZE;
+  *p = q + RAW_HEADER_SIZE + rec->len;
+  return true;
+}
+
+//==============================================================================
+// Detect Frame Record
+//==============================================================================
+bool raw_is_frame(const uint8_t* p, const uint8_t* end) {
+  return end - p >= RAW_HEADER_SIZE + RAW_FRAME_SIZE &&
+         p[0] == RAW_REC_FRAME && p[2] == RAW_FRAME_SIZE &&
+         p[3] == RAW_FRAME_MAGIC_0 && p[4] == RAW_FRAME_MAGIC_1;
+}
+
+//==============================================================================
+// Little-Endian Fields
+//==============================================================================
+int16_t raw_get_i16(const uint8_t* p) {
+  return (int16_t)(p[0] | (uint16_t)p[1] << 8);
+}
+
+uint32_t raw_get_u32(const uint8_t* p) {
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+//==============================================================================
+// Check Record Header
+//==============================================================================
+static bool valid_header(const uint8_t* p, const uint8_t* end) {
+  if(end - p < RAW_HEADER_SIZE || end - p < RAW_HEADER_SIZE + p[2]) {
+    return false;
+  }
+  switch(p[0]) {
+    case RAW_REC_FRAME:   return raw_is_frame(p, end);
+    case RAW_REC_ADC:
+    case RAW_REC_AM2315:
+    case RAW_REC_DS18B20: return p[2] % 2 == 0;
+    case RAW_REC_SDI:     return true;
+    default:              return false;
+  }
+}
+
+//==============================================================================
+// Check For Torn Record
+//==============================================================================
+// A record cut short by a reset runs on into the next session's first frame.
+static bool torn(const uint8_t* p, const uint8_t* end) {
+  if(p[0] == RAW_REC_FRAME) return false;
+
+  const uint8_t* stop = p + RAW_HEADER_SIZE + p[2];
+  for(const uint8_t* q = p + 1; q < stop; q++) {
+    if(raw_is_frame(q, end)) return true;
+  }
+  return false;
+}
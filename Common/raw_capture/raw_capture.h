@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Raw Sensor Capture Format
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// A raw capture file (MM-DD.raw, one per day) keeps every reading that goes
+// into a minute's logged values, before any averaging or calibration, so
+// history can be recomputed with new coefficients.
+//
+// The file is a stream of records, each a 3-byte header followed by its
+// payload:
+//
+//    0  uint8   record type
+//    1  uint8   sensor (meaning depends on the type)
+//    2  uint8   payload length
+//    3  ...     payload, little-endian
+//
+//  RAW_REC_FRAME    sensor = plot ID; 'R' 'C' uint32 time. Starts a minute.
+//  RAW_REC_ADC      sensor = irradiance sensor; int16 ADS1115 counts per
+//                   sample.
+//  RAW_REC_SDI      sensor = soil sensor; the SDI-12 data response as read,
+//                   without terminator. Empty if the sensor didn't answer.
+//  RAW_REC_AM2315   sensor = tmph sensor; int16 temperature and int16
+//                   humidity in tenths, per sample.
+//  RAW_REC_DS18B20  sensor = number of probes; per sample, an int16 raw
+//                   reading (1/128 C) from each probe in log column order.
+//
+// The length is one byte, so no payload may pass RAW_MAX_PAYLOAD; the plots
+// check their fixed-size records against it at compile time.
+//
+// Records are streamed to the card as they are sampled, so a reset can leave
+// a torn record at the end of a session. The reader skips ahead to the next
+// frame when it meets one.
+//
+//------------------------------------------------------------------------------
+
+#ifndef RAW_CAPTURE_H
+#define RAW_CAPTURE_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define RAW_HEADER_SIZE     (3)
+#define RAW_MAX_PAYLOAD     (255)
+#define RAW_FRAME_SIZE      (6)
+#define RAW_FRAME_MAGIC_0   ('R')
+#define RAW_FRAME_MAGIC_1   ('C')
+
+#define RAW_REC_FRAME       ('F')
+#define RAW_REC_ADC         ('A')
+#define RAW_REC_SDI         ('S')
+#define RAW_REC_AM2315      ('H')
+#define RAW_REC_DS18B20     ('T')
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// One record, pointing into the caller's buffer.
+struct raw_record {
+  uint8_t        type;
+  uint8_t        sensor;
+  uint8_t        len;
+  const uint8_t* payload;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool     raw_next(const uint8_t** p, const uint8_t* end, raw_record* rec,
+                  uint32_t* skipped);
+bool     raw_is_frame(const uint8_t* p, const uint8_t* end);
+int16_t  raw_get_i16(const uint8_t* p);
+uint32_t raw_get_u32(const uint8_t* p);
+
+#endif
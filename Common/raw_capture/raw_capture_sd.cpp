@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Raw Sensor Capture SD Card Writer
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; the host tools use raw_capture.cpp alone.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "raw_capture_sd.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool write_buffer(raw_capture* c, const uint8_t* buf, uint16_t len);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Open Capture File
+//==============================================================================
+// Does nothing if the named file is already open. Otherwise whatever is
+// buffered goes to the old file before switching.
+bool raw_capture_open(raw_capture* c, const char* name) {
+  if(c->file && strcmp(c->name, name) == 0) return true;
+
+  if(c->file) {
+    raw_capture_flush(c);
+    c->file.close();
+  }
+  c->fill = 0;
+  c->pending = 0;
+
+  strncpy(c->name, name, sizeof(c->name) - 1);
+  c->name[sizeof(c->name) - 1] = 0;
+  c->file = SD.open(c->name, FILE_WRITE);
+  return c->file;
+}
+
+//==============================================================================
+// Begin Record
+//==============================================================================
+// The payload follows in raw_capture_put() calls totalling len bytes.
+void raw_capture_begin(raw_capture* c, uint8_t type, uint8_t sensor,
+                       uint8_t len) {
+  uint8_t header[RAW_HEADER_SIZE] = {type, sensor, len};
+  raw_capture_put(c, header, RAW_HEADER_SIZE);
+}
+
+//==============================================================================
+// Append Bytes
+//==============================================================================
+void raw_capture_put(raw_capture* c, const void* data, uint8_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+
+  if(!c->file) return;
+
+  while(len > 0) {
+    uint16_t n = RAW_CAPTURE_BUF_SIZE - c->fill;
+    if(n > len) n = len;
+    memcpy(c->buf[c->active] + c->fill, p, n);
+    c->fill += n;
+    p += n;
+    len -= n;
+
+    // Hand the full buffer off, writing the other one now if the loop
+    // hasn't got to it yet.
+    if(c->fill == RAW_CAPTURE_BUF_SIZE) {
+      if(c->pending) {
+        c->stalls++;
+        raw_capture_service(c);
+      }
+      c->pending = RAW_CAPTURE_BUF_SIZE;
+      c->active ^= 1;
+      c->fill = 0;
+    }
+  }
+}
+
+//==============================================================================
+// Frame Record
+//==============================================================================
+void raw_capture_frame(raw_capture* c, uint8_t plot_id, uint32_t t) {
+  uint8_t magic[2] = {RAW_FRAME_MAGIC_0, RAW_FRAME_MAGIC_1};
+
+  raw_capture_begin(c, RAW_REC_FRAME, plot_id, RAW_FRAME_SIZE);
+  raw_capture_put(c, magic, sizeof(magic));
+  raw_capture_put(c, &t, sizeof(t));
+}
+
+//==============================================================================
+// SDI-12 Response Record
+//==============================================================================
+void raw_capture_sdi(raw_capture* c, uint8_t sensor, const char* response,
+                     uint8_t len) {
+  raw_capture_begin(c, RAW_REC_SDI, sensor, len);
+  raw_capture_put(c, response, len);
+}
+
+//==============================================================================
+// Write Pending Buffer
+//==============================================================================
+// Called from loop(); a no-op unless a buffer is waiting.
+bool raw_capture_service(raw_capture* c) {
+  if(!c->pending) return true;
+
+  bool ok = write_buffer(c, c->buf[c->active ^ 1], c->pending);
+  c->pending = 0;
+  return ok;
+}
+
+//==============================================================================
+// Flush All Buffered Data
+//==============================================================================
+// Before a reset or closing the file; the partial buffer goes out too.
+bool raw_capture_flush(raw_capture* c) {
+  bool ok = raw_capture_service(c);
+
+  if(c->fill) {
+    ok &= write_buffer(c, c->buf[c->active], c->fill);
+    c->fill = 0;
+  }
+  return ok;
+}
+
+//==============================================================================
+// Write Buffer To Card
+//==============================================================================
+static bool write_buffer(raw_capture* c, const uint8_t* buf, uint16_t len) {
+  if(!c->file) return false;
+  if(c->file.write(buf, len) != len) return false;
+  c->file.flush();
+  return true;
+}
+
+#endif
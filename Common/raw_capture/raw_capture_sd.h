@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Raw Sensor Capture SD Card Writer
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Double-buffered writer for raw capture files. read_sensors() streams each
+// reading into the active buffer as it is sampled, so no whole frame is held
+// in RAM; a full buffer is handed off and written by raw_capture_service()
+// from loop() once the minute's work is done. The card is only touched
+// during sampling when both buffers fill before the loop gets a chance to
+// write (a stall, counted for diagnostics).
+//
+// RAW_CAPTURE_BUF_SIZE is per buffer; the writer uses twice that in RAM.
+// It must hold at least one minute of capture (Plot-2 writes about 384
+// bytes a minute). A smaller buffer fills twice in some minutes, and the
+// second fill stalls sampling on an SD write.
+//
+//------------------------------------------------------------------------------
+
+#ifndef RAW_CAPTURE_SD_H
+#define RAW_CAPTURE_SD_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <SD.h>
+#include "raw_capture.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#ifndef RAW_CAPTURE_BUF_SIZE
+#define RAW_CAPTURE_BUF_SIZE  (512)
+#endif
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct raw_capture {
+  File     file;
+  char     name[13];
+  uint8_t  buf[2][RAW_CAPTURE_BUF_SIZE];
+  uint16_t fill;
+  uint16_t pending;
+  uint8_t  active;
+  uint16_t stalls;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool raw_capture_open(raw_capture* c, const char* name);
+void raw_capture_begin(raw_capture* c, uint8_t type, uint8_t sensor,
+                       uint8_t len);
+void raw_capture_put(raw_capture* c, const void* data, uint8_t len);
+void raw_capture_frame(raw_capture* c, uint8_t plot_id, uint32_t t);
+void raw_capture_sdi(raw_capture* c, uint8_t sensor, const char* response,
+                     uint8_t len);
+bool raw_capture_service(raw_capture* c);
+bool raw_capture_flush(raw_capture* c);
+
+#endif
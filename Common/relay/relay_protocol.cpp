@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Relay Trigger Protocol
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "relay_protocol.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Encode Command Word
+//==============================================================================
+uint16_t relay_encode(uint8_t loads, uint8_t minutes) {
+  if(minutes > RELAY_MAX_MINUTES) minutes = RELAY_MAX_MINUTES;
+  uint8_t cmd = (uint8_t)((loads & RELAY_LOADS_ALL) << 6) | minutes;
+  return ((uint16_t)cmd << 8) | (uint8_t)~cmd;
+}
+
+//==============================================================================
+// Decode Frame from LOW Pulse Widths
+//==============================================================================
+// Returns false for anything that is neither a valid frame nor the legacy
+// two-pulse trigger.
+bool relay_decode(const uint8_t* pulse_ms, uint8_t num_pulses, relay_cmd* cmd) {
+  // Legacy trigger: two short pulses, no start pulse.
+  if(num_pulses == RELAY_LEGACY_PULSES &&
+     pulse_ms[0] < RELAY_START_MIN_MS && pulse_ms[1] < RELAY_START_MIN_MS) {
+    cmd->loads   = RELAY_LOADS_ALL;
+    cmd->minutes = RELAY_LEGACY_MINUTES;
+    return true;
+  }
+
+  // Encoded command.
+  if(num_pulses != RELAY_FRAME_PULSES) return false;
+  if(pulse_ms[0] < RELAY_START_MIN_MS || pulse_ms[0] > RELAY_START_MAX_MS) {
+    return false;
+  }
+
+  uint16_t word = 0;
+  for(uint8_t i = 1; i < RELAY_FRAME_PULSES; i++) {
+    if(pulse_ms[i] >= RELAY_START_MIN_MS) return false;
+    word = (word << 1) | (pulse_ms[i] >= RELAY_BIT_SPLIT_MS ? 1 : 0);
+  }
+
+  uint8_t value = word >> 8;
+  uint8_t check = word & 0xFF;
+  if((uint8_t)~value != check) return false;
+
+  cmd->loads   = value >> 6;
+  cmd->minutes = value & RELAY_MAX_MINUTES;
+  return true;
+}
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Relay Trigger Protocol
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Plot-2 tells Relay-Control which loads to run, and for how long, over the
+// single trigger wire. The line idles HIGH and information is carried in the
+// widths of LOW pulses:
+//
+//   start   LOW RELAY_START_MS
+//   16 bits HIGH RELAY_GAP_MS, then LOW RELAY_ZERO_MS or RELAY_ONE_MS,
+//           most significant bit first
+//   end     line stays HIGH for RELAY_IDLE_MS
+//
+// The decoder closes a frame after RELAY_FRAME_END_MS of HIGH, well inside
+// the sender's idle, so a frame sent straight after another isn't merged
+// into it.
+//
+// The 16 bits are a command byte followed by its complement. The command
+// byte holds the load mask in the top two bits and the on-time in minutes
+// in the low six (0 turns the selected loads off).
+//
+// The original trigger (two 20 ms LOW pulses with no start pulse) is still
+// understood as "both loads for RELAY_LEGACY_MINUTES".
+//
+//------------------------------------------------------------------------------
+
+#ifndef RELAY_PROTOCOL_H
+#define RELAY_PROTOCOL_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Waveform timing (ms).
+#define RELAY_START_MS        (60)
+#define RELAY_GAP_MS          (10)
+#define RELAY_ZERO_MS         (10)
+#define RELAY_ONE_MS          (30)
+#define RELAY_IDLE_MS         (100)
+
+// Decoder pulse classification (ms).
+#define RELAY_GLITCH_MS       (3)
+#define RELAY_BIT_SPLIT_MS    (20)
+#define RELAY_START_MIN_MS    (45)
+#define RELAY_START_MAX_MS    (90)
+
+// Decoder frame end (ms): longer than any HIGH inside a frame (RELAY_GAP_MS,
+// 20 in the legacy trigger) and at most half the sender's idle.
+#define RELAY_FRAME_END_MS    (50)
+
+#if RELAY_FRAME_END_MS * 2 > RELAY_IDLE_MS
+#error "relay frame end leaves no margin before the next frame"
+#endif
+
+// Frame contents.
+#define RELAY_FRAME_BITS      (16)
+#define RELAY_FRAME_PULSES    (1 + RELAY_FRAME_BITS)
+#define RELAY_LEGACY_PULSES   (2)
+
+// Decoder buffer: a frame and a couple of stray pulses.
+#define RELAY_MAX_PULSES      (RELAY_FRAME_PULSES + 2)
+
+// Loads.
+#define RELAY_LOAD_A          (0x01)
+#define RELAY_LOAD_B          (0x02)
+#define RELAY_LOADS_ALL       (RELAY_LOAD_A | RELAY_LOAD_B)
+#define RELAY_MAX_MINUTES     (63)
+#define RELAY_LEGACY_MINUTES  (10)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct relay_cmd {
+  uint8_t loads;
+  uint8_t minutes;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+uint16_t relay_encode(uint8_t loads, uint8_t minutes);
+bool     relay_decode(const uint8_t* pulse_ms, uint8_t num_pulses, relay_cmd* cmd);
+
+#endif
@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Relay Trigger Sender
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "relay_tx.h"
+
+// Relay-Control (Uno) shares relay_protocol.h but has no Timer4.
+#if defined(ARDUINO) && defined(TCCR4A)
+
+#include <avr/interrupt.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Timer4 at clk/64 runs 250 ticks per millisecond.
+#define TICKS_PER_MS   (F_CPU / 64 / 1000)
+
+// Start pulse, a gap and pulse per bit, and the closing idle.
+#define MAX_SEGMENTS   (1 + 2 * RELAY_FRAME_BITS + 1)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Segment durations in ms. Segments alternate LOW, HIGH, LOW... starting
+// with LOW, and the last one is always HIGH.
+static uint8_t          segments[MAX_SEGMENTS];
+static uint8_t          num_segments;
+static volatile uint8_t segment;
+static volatile bool    busy;
+static uint8_t          tx_pin;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool start_waveform();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Trigger Output
+//==============================================================================
+void relay_tx_begin(uint8_t pin) {
+  tx_pin = pin;
+  pinMode(tx_pin, OUTPUT);
+  digitalWrite(tx_pin, HIGH);
+
+  // Timer4 stopped, CTC mode on OCR4A.
+  TCCR4A = 0;
+  TCCR4B = _BV(WGM42);
+  TIMSK4 = 0;
+  busy = false;
+}
+
+//==============================================================================
+// Queue Encoded Command
+//==============================================================================
+// Returns false if a waveform is still being sent.
+bool relay_tx_send(uint8_t loads, uint8_t minutes) {
+  if(busy) return false;
+
+  uint16_t word = relay_encode(loads, minutes);
+  num_segments = 0;
+  segments[num_segments++] = RELAY_START_MS;
+  for(int8_t bit = RELAY_FRAME_BITS - 1; bit >= 0; bit--) {
+    segments[num_segments++] = RELAY_GAP_MS;
+    segments[num_segments++] = (word >> bit) & 1 ? RELAY_ONE_MS : RELAY_ZERO_MS;
+  }
+  segments[num_segments++] = RELAY_IDLE_MS;
+  return start_waveform();
+}
+
+//==============================================================================
+// Queue Legacy Trigger
+//==============================================================================
+// LOW 20 / HIGH 20 / LOW 20, as sent before commands were encoded.
+bool relay_tx_send_legacy() {
+  if(busy) return false;
+
+  num_segments = 0;
+  segments[num_segments++] = 20;
+  segments[num_segments++] = 20;
+  segments[num_segments++] = 20;
+  segments[num_segments++] = RELAY_IDLE_MS;
+  return start_waveform();
+}
+
+//==============================================================================
+// Check for Waveform in Progress
+//==============================================================================
+bool relay_tx_busy() {
+  return busy;
+}
+
+//==============================================================================
+// Start Playing Segments
+//==============================================================================
+static bool start_waveform() {
+  busy = true;
+  segment = 0;
+
+  // First segment starts now; the ISR moves on at each compare match.
+  digitalWrite(tx_pin, LOW);
+  TCNT4 = 0;
+  OCR4A = segments[0] * TICKS_PER_MS - 1;
+  TIFR4 = _BV(OCF4A);
+  TIMSK4 = _BV(OCIE4A);
+  TCCR4B = _BV(WGM42) | _BV(CS41) | _BV(CS40);
+  return true;
+}
+
+//==============================================================================
+// Timer4 Compare Interrupt
+//==============================================================================
+ISR(TIMER4_COMPA_vect) {
+  segment++;
+
+  // Done: stop the timer and leave the line idle.
+  if(segment >= num_segments) {
+    TCCR4B = _BV(WGM42);
+    TIMSK4 = 0;
+    digitalWrite(tx_pin, HIGH);
+    busy = false;
+    return;
+  }
+
+  // Even segments are LOW, odd are HIGH.
+  digitalWrite(tx_pin, (segment & 1) ? HIGH : LOW);
+  OCR4A = segments[segment] * TICKS_PER_MS - 1;
+}
+
+#endif
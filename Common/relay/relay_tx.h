@@ -0,0 +1,39 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Relay Trigger Sender
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Plays a relay_protocol.h waveform out of the trigger pin from the Timer4
+// compare interrupt, so loop() never waits on it. Mega only (Timer0 runs
+// millis() and the SDI-12 library owns Timer2).
+//
+//------------------------------------------------------------------------------
+
+#ifndef RELAY_TX_H
+#define RELAY_TX_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "relay_protocol.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void relay_tx_begin(uint8_t pin);
+bool relay_tx_send(uint8_t loads, uint8_t minutes);
+bool relay_tx_send_legacy();
+bool relay_tx_busy();
+
+#endif
@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Reset Log
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string.h>
+#include <archive.h>
+#include "reset_log.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Classify Reset
+//==============================================================================
+// flags is MCUSR at startup; warm is whether RAM the run before left
+// behind survived; planned is what system_reset() asked for, or
+// RESET_NOT_PLANNED; hung and caught are from the watchdog's post-mortem.
+//
+// With no flags (the bootloader cleared them) RAM is all there is to go
+// on. Otherwise power-on sets more than one flag, so they're checked in
+// order.
+uint8_t reset_cause(uint8_t flags, bool warm, uint8_t planned, bool hung,
+                    bool caught) {
+  if(!flags) {
+    if(!warm) return RESET_POWER;
+    if(planned < RESET_NUM_CAUSES) return planned;
+    if(hung) return RESET_HUNG;
+    return RESET_WARM;
+  }
+
+  if(flags & RESET_FLAG_POWER) return RESET_POWER;
+  if(flags & RESET_FLAG_BROWNOUT) return RESET_BROWNOUT;
+  if(flags & (RESET_FLAG_EXTERNAL | RESET_FLAG_JTAG)) return RESET_EXTERNAL;
+  if(flags & RESET_FLAG_WATCHDOG) {
+    if(hung) return caught ? RESET_HUNG : RESET_WATCHDOG;
+    if(planned < RESET_NUM_CAUSES) return planned;
+    return RESET_WATCHDOG;
+  }
+  return RESET_WARM;
+}
+
+//==============================================================================
+// Start Event
+//==============================================================================
+// Carries the totals on from prev, the newest stored event, if there is
+// one. The caller fills in what it knows of the run before.
+void reset_begin(reset_event* e, const reset_event* prev, uint8_t cause,
+                 uint8_t flags) {
+  memset(e, 0, sizeof(*e));
+  if(prev) {
+    e->seq = prev->seq;
+    memcpy(e->counts, prev->counts, sizeof(e->counts));
+    memcpy(e->down_s, prev->down_s, sizeof(e->down_s));
+  }
+  e->magic = RESET_LOG_MAGIC;
+  e->cause = cause;
+  e->flags = flags;
+  e->seq++;
+  e->uptime_s = RESET_NO_TIME;
+  if(e->counts[cause] < 0xFFFF) e->counts[cause]++;
+}
+
+//==============================================================================
+// Finish Event
+//==============================================================================
+// boot_time is the first minute logged after the reset.
+void reset_finish(reset_event* e, uint32_t boot_time) {
+  uint32_t down;
+
+  e->boot_time = boot_time >= RESET_EPOCH ? boot_time : 0;
+  down = reset_downtime(e);
+  if(down != RESET_NO_TIME) e->down_s[e->cause] += down;
+}
+
+//==============================================================================
+// Downtime
+//==============================================================================
+// Sampling time lost to the reset, in seconds: the gap between logged
+// minutes less the minute there would have been anyway. RESET_NO_TIME when
+// the reset lost the clock along with RAM.
+uint32_t reset_downtime(const reset_event* e) {
+  if(e->reset_time < RESET_EPOCH || e->boot_time < e->reset_time) {
+    return RESET_NO_TIME;
+  }
+  if(e->boot_time - e->reset_time < RESET_SAMPLE_S) return 0;
+  return e->boot_time - e->reset_time - RESET_SAMPLE_S;
+}
+
+//==============================================================================
+// Unplanned Resets
+//==============================================================================
+// Every reset but the hourly one, which is the only one nothing went wrong
+// for.
+uint16_t reset_unplanned(const reset_event* e) {
+  uint16_t n = 0;
+
+  for(uint8_t c = 0; c < RESET_NUM_CAUSES; c++) {
+    if(c != RESET_HOURLY) n += e->counts[c];
+  }
+  return n;
+}
+
+//==============================================================================
+// Total Downtime
+//==============================================================================
+uint32_t reset_total_down(const reset_event* e) {
+  uint32_t down = 0;
+
+  for(uint8_t c = 0; c < RESET_NUM_CAUSES; c++) down += e->down_s[c];
+  return down;
+}
+
+//==============================================================================
+// Event CRC
+//==============================================================================
+uint16_t reset_crc(const reset_event* e) {
+  return archive_crc16((const uint8_t*)e, offsetof(reset_event, crc), 0xFFFF);
+}
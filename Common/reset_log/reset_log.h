@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Reset Log
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// One event per reset: why the board reset, what it was doing, how long it
+// had been up and how long it was down before it was logging again. Each
+// event also carries the running count and downtime of every cause since
+// the log was cleared, so the newest event alone answers how much sampling
+// time resets cost and what caused them.
+//
+// Plain C++: reset_log_io.h gathers the event at boot and keeps it in an
+// EEPROM ring.
+//
+//------------------------------------------------------------------------------
+
+#ifndef RESET_LOG_H
+#define RESET_LOG_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define RESET_LOG_MAGIC      (0x524C)
+
+// Why the board reset. Stored in EEPROM, so never renumber one.
+#define RESET_WARM           (0)  // A warm reset nothing explains: behind
+                                  // the bootloader, the reset button or a
+                                  // watchdog reset the interrupt never saw;
+                                  // otherwise a jump to the reset vector,
+                                  // e.g. after a stack overflow.
+#define RESET_POWER          (1)  // Or RAM was lost with it.
+#define RESET_BROWNOUT       (2)
+#define RESET_EXTERNAL       (3)  // Reset button, reflash or JTAG.
+#define RESET_HUNG           (4)  // A supervised task ran out its budget.
+#define RESET_WATCHDOG       (5)  // Watchdog reset the interrupt never saw,
+                                  // so interrupts were off.
+#define RESET_HOURLY         (6)  // Planned: the hourly reset.
+#define RESET_UPLOAD         (7)  // Planned: ThingSpeak -301 with FAIL_RESET.
+#define RESET_NUM_CAUSES     (8)
+
+// MCUSR's reset flags on the ATmega2560. The plots' stk500v2 bootloader
+// clears MCUSR before the sketch starts, so they're usually all 0 and the
+// cause is worked out from what survived in RAM instead.
+#define RESET_FLAG_POWER     (0x01)
+#define RESET_FLAG_EXTERNAL  (0x02)
+#define RESET_FLAG_BROWNOUT  (0x04)
+#define RESET_FLAG_WATCHDOG  (0x08)
+#define RESET_FLAG_JTAG      (0x10)
+
+// Planned resets are the ones system_reset() asks for.
+#define RESET_NOT_PLANNED    (0xFF)
+
+// Times before this (2021-01-01) mean NTP hadn't answered yet.
+#define RESET_EPOCH          (1609459200UL)
+#define RESET_NO_TIME        (0xFFFFFFFFUL)
+
+// The plots log a row every minute.
+#define RESET_SAMPLE_S       (60)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// Exactly what is stored in EEPROM, CRC last.
+struct reset_event {
+  uint16_t magic;
+  uint8_t  cause;
+  uint8_t  flags;        // MCUSR at startup.
+  uint8_t  task;         // The innermost watchdog task and its last
+  uint8_t  step;         // checkpoint; WATCHDOG_NO_TASK if RAM was lost.
+  int16_t  upload;       // The last ThingSpeak response before the reset.
+  uint16_t free_ram;     // Free RAM at the last logged minute.
+  uint32_t seq;
+  uint32_t uptime_s;     // How long the run before had been up, or
+                         // RESET_NO_TIME.
+  uint32_t reset_time;   // The last minute logged before the reset, or 0.
+  uint32_t boot_time;    // When the clock was set again, or 0.
+  uint16_t counts[RESET_NUM_CAUSES];
+  uint32_t down_s[RESET_NUM_CAUSES];
+  uint16_t crc;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+uint8_t  reset_cause(uint8_t flags, bool warm, uint8_t planned, bool hung,
+                     bool caught);
+void     reset_begin(reset_event* e, const reset_event* prev, uint8_t cause,
+                     uint8_t flags);
+void     reset_finish(reset_event* e, uint32_t boot_time);
+uint32_t reset_downtime(const reset_event* e);
+uint16_t reset_unplanned(const reset_event* e);
+uint32_t reset_total_down(const reset_event* e);
+uint16_t reset_crc(const reset_event* e);
+
+#endif
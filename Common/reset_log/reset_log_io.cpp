@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Reset Log Storage
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; reset_log.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <EEPROM.h>
+#include <diag.h>
+#include <eeprom_map.h>
+#include <eeprom_ring.h>
+#include "reset_log_io.h"
+
+static_assert(sizeof(reset_event) <= EEPROM_RESETS_SLOT_SIZE,
+              "reset event doesn't fit its EEPROM slot");
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define CRUMB_MAGIC      (0x5243)
+
+// Where this boot's event is.
+#define EVENT_NONE       (0)
+#define EVENT_PENDING    (1)
+#define EVENT_UNSENT     (2)
+#define EVENT_SENT       (3)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// What the run before left behind.
+struct reset_crumb {
+  uint16_t magic;
+  uint8_t  planned;
+  int16_t  upload;
+  uint16_t free_ram;
+  uint32_t time;
+  uint32_t uptime_ms;
+};
+
+//------------------------------------------------------------------------------
+//      __   __        __  ___              ___  __
+//     /  ` /  \ |\ | /__`  |   /\  |\ |  |  /__`
+//     \__, \__/ | \| .__/  |  /~~\ | \|  |  .__/
+//
+//------------------------------------------------------------------------------
+
+static const eeprom_ring ring = {
+  EEPROM_RESETS_ADDR, EEPROM_RESETS_SLOT_SIZE, EEPROM_RESETS_SLOTS,
+  RESET_LOG_MAGIC, offsetof(reset_event, magic), offsetof(reset_event, seq),
+  offsetof(reset_event, crc)
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Survives a reset; startup only clears .bss.
+static reset_crumb crumb __attribute__((section(".noinit")));
+static reset_event event;
+static uint8_t     event_state = EVENT_NONE;
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Start Reset Log
+//==============================================================================
+// Call right after watchdog_begin() with what it returned. The run before's
+// last logged minute is kept until this run logs one, so a reset during
+// setup() counts its downtime from the minute the first reset lost.
+void reset_log_begin(const watchdog_record* last, bool hung) {
+  bool        kept = crumb.magic == CRUMB_MAGIC;
+  uint8_t     flags = watchdog_reset_flags();
+  uint16_t    newest;
+  bool        have_prev = eeprom_ring_newest(&ring, &newest);
+  reset_event prev;
+
+  if(have_prev) EEPROM.get(newest, prev);
+  reset_begin(&event, have_prev ? &prev : NULL,
+              reset_cause(flags, kept,
+                          kept ? crumb.planned : RESET_NOT_PLANNED,
+                          hung, last->caught),
+              flags);
+  event.task = last->task;
+  event.step = last->step;
+
+  if(kept) {
+    event.upload = crumb.upload;
+    event.free_ram = crumb.free_ram;
+    event.uptime_s = crumb.uptime_ms / 1000;
+    event.reset_time = crumb.time;
+  }
+  else {
+    crumb.magic = CRUMB_MAGIC;
+    crumb.upload = 0;
+    crumb.free_ram = 0;
+    crumb.time = 0;
+  }
+  crumb.planned = RESET_NOT_PLANNED;
+  crumb.uptime_ms = 0;
+  event_state = EVENT_PENDING;
+}
+
+//==============================================================================
+// Mark Logged Minute
+//==============================================================================
+// Call once a minute once the row is logged. The first call with the clock
+// set stores this boot's event, and returns true.
+bool reset_log_mark(uint32_t t, int16_t upload, uint16_t free_ram) {
+  crumb.upload = upload;
+  crumb.free_ram = free_ram;
+  crumb.uptime_ms = millis();
+  if(t < RESET_EPOCH) return false;
+  crumb.time = t;
+
+  if(event_state != EVENT_PENDING) return false;
+  reset_finish(&event, t);
+  event.crc = reset_crc(&event);
+  EEPROM.put(eeprom_ring_slot(&ring, event.seq), event);
+  event_state = EVENT_UNSENT;
+  return true;
+}
+
+//==============================================================================
+// Note Planned Reset
+//==============================================================================
+// system_reset() says why, just before watchdog_reboot().
+void reset_log_planned(uint8_t cause) {
+  crumb.planned = cause;
+  crumb.uptime_ms = millis();
+}
+
+//==============================================================================
+// Event To Upload
+//==============================================================================
+// This boot's event once it's stored, until reset_log_sent(); NULL
+// otherwise.
+const reset_event* reset_log_unsent() {
+  return event_state == EVENT_UNSENT ? &event : NULL;
+}
+
+//==============================================================================
+// Event Uploaded
+//==============================================================================
+void reset_log_sent() {
+  if(event_state == EVENT_UNSENT) event_state = EVENT_SENT;
+}
+
+//==============================================================================
+// Print Event
+//==============================================================================
+// The reset, then the count and downtime of each cause seen so far.
+void reset_log_print(const reset_event* e) {
+  char tally[24];
+
+  diag_int(DIAG_RESET_CAUSE, e->cause);
+  if(e->task != WATCHDOG_NO_TASK) diag_int(DIAG_RESET_TASK, e->task);
+  if(e->uptime_s != RESET_NO_TIME) diag_int(DIAG_RESET_UPTIME, e->uptime_s);
+  if(reset_downtime(e) != RESET_NO_TIME) {
+    diag_int(DIAG_RESET_DOWNTIME, reset_downtime(e));
+  }
+  for(uint8_t c = 0; c < RESET_NUM_CAUSES; c++) {
+    if(!e->counts[c]) continue;
+    sprintf(tally, "%u x %u, %lu", c, e->counts[c], e->down_s[c]);
+    diag_str(DIAG_RESET_TALLY, tally);
+  }
+  diag_int(DIAG_RESET_UNPLANNED, reset_unplanned(e));
+}
+
+#endif
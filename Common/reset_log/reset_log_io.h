@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Reset Log Storage
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Records every reset in EEPROM. What the run before was doing is kept in
+// RAM that startup doesn't clear: each logged minute notes the time, free
+// RAM and last ThingSpeak response, and system_reset() notes why it's
+// resetting. At boot, reset_log_begin() turns that, the watchdog's
+// post-mortem and MCUSR (when the bootloader left it) into an event, which
+// is stored once the first minute after the reset is logged, so its
+// downtime is the sampling time actually lost. Whether that RAM survived
+// tells a cold start from a warm reset.
+//
+// Events rotate through EEPROM_RESETS_SLOTS slots with a sequence number.
+// Even the 24 planned resets a day write each slot less than twice a day.
+//
+//------------------------------------------------------------------------------
+
+#ifndef RESET_LOG_IO_H
+#define RESET_LOG_IO_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <watchdog_io.h>
+#include "reset_log.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void               reset_log_begin(const watchdog_record* last, bool hung);
+bool               reset_log_mark(uint32_t t, int16_t upload,
+                                  uint16_t free_ram);
+void               reset_log_planned(uint8_t cause);
+const reset_event* reset_log_unsent();
+void               reset_log_sent();
+void               reset_log_print(const reset_event* e);
+
+#endif
@@ -0,0 +1,329 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics SDI-12 Transactions
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "sdi12_bus.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Where a transaction is in sdi12_service().
+#define STEP_IDLE    (0)
+#define STEP_SEND    (1)
+#define STEP_REPLY   (2)
+#define STEP_WAIT    (3)
+
+// CRC-16 (reflected 0x8005), sent as three characters of six, four and
+// six bits, each with 0x40 set.
+#define CRC_POLY     (0xA001)
+#define CRC_CHAR     (0x40)
+
+// What read_line() found.
+#define LINE_NONE    (0)
+#define LINE_DONE    (1)
+#define LINE_BAD     (2)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void    begin(sdi12_xact* x);
+static void    listen(sdi12_xact* x, uint32_t now);
+static uint8_t read_line(sdi12_xact* x, uint32_t now);
+static bool    reply_valid(sdi12_xact* x);
+static bool    strip_crc(sdi12_xact* x);
+static void    retry(sdi12_xact* x);
+static void    finish(sdi12_xact* x, uint8_t status);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Transaction
+//==============================================================================
+void sdi12_init(sdi12_xact* x, const sdi12_port* port) {
+  memset(x, 0, sizeof(*x));
+  x->port = port;
+  x->max_retries = SDI12_RETRIES;
+  x->step = STEP_IDLE;
+  x->status = SDI12_OK;
+}
+
+//==============================================================================
+// Start Measurement
+//==============================================================================
+// Sends aMC!, waits the ttt seconds it answers with (or for the sensor's
+// service request), then reads the values with aD0!.
+void sdi12_measure(sdi12_xact* x, char addr) {
+  x->addr = addr;
+  x->cmd[0] = addr;
+  x->cmd[1] = 'M';
+  x->cmd[2] = 'C';
+  x->cmd[3] = '!';
+  x->cmd[4] = 0;
+  x->measuring = true;
+  x->crc = true;
+  begin(x);
+}
+
+//==============================================================================
+// Start Command
+//==============================================================================
+// For commands answered with one line that starts with the address (or any
+// address, for ?!). A measurement command sets whether the data commands
+// after it expect a CRC.
+void sdi12_command(sdi12_xact* x, const char* cmd) {
+  strncpy(x->cmd, cmd, SDI12_CMD_LEN - 1);
+  x->cmd[SDI12_CMD_LEN - 1] = 0;
+  x->addr = x->cmd[0];
+  x->measuring = false;
+  if(x->cmd[1] == 'M' || x->cmd[1] == 'C') x->crc = x->cmd[2] == 'C';
+  begin(x);
+}
+
+//==============================================================================
+// Service Transaction
+//==============================================================================
+// Does whatever the transaction is waiting on, if it's ready, and returns.
+// The only blocking part is sending a command, which the SDI12 library does
+// in about 50 ms.
+uint8_t sdi12_service(sdi12_xact* x) {
+  const sdi12_port* p = x->port;
+  uint32_t          now;
+  uint8_t           line;
+  uint16_t          seconds;
+  uint8_t           count;
+
+  switch(x->step) {
+  case STEP_SEND:
+    p->clear(p->bus);
+    p->send(p->bus, x->cmd);
+    listen(x, p->millis(p->bus));
+    x->step = STEP_REPLY;
+    break;
+
+  case STEP_REPLY:
+    now = p->millis(p->bus);
+    line = read_line(x, now);
+    if(line == LINE_NONE) {
+      if(now - x->step_ms > (x->heard ? SDI12_CHAR_GAP_MS
+                                      : SDI12_FIRST_CHAR_MS) ||
+         now - x->line_ms > SDI12_LINE_MS) {
+        retry(x);
+      }
+    }
+    else if(line == LINE_BAD || !reply_valid(x)) {
+      retry(x);
+    }
+    else if(!x->measuring) {
+      finish(x, SDI12_OK);
+    }
+    else if(!sdi12_parse_measure(x->response, x->len, x->addr, &seconds,
+                                 &count) ||
+            count == 0 || seconds > SDI12_MAX_READY_S) {
+      retry(x);
+    }
+    else {
+      x->ready_ms = now + seconds * 1000UL +
+                    (seconds ? SDI12_READY_SLACK_MS : 0);
+      listen(x, now);
+      x->step = STEP_WAIT;
+    }
+    break;
+
+  case STEP_WAIT:
+    // The sensor may send its address alone once the data is ready.
+    now = p->millis(p->bus);
+    line = read_line(x, now);
+    if((line == LINE_DONE && x->len == 1 && x->response[0] == x->addr) ||
+       (int32_t)(now - x->ready_ms) >= 0) {
+      x->cmd[1] = 'D';
+      x->cmd[2] = '0';
+      x->cmd[3] = '!';
+      x->cmd[4] = 0;
+      x->measuring = false;
+      x->tries = 0;
+      x->replied = false;
+      x->step = STEP_SEND;
+    }
+    else if(line != LINE_NONE) {
+      listen(x, now);
+    }
+    break;
+  }
+
+  return x->status;
+}
+
+//==============================================================================
+// Parse Measurement Reply
+//==============================================================================
+// An aM! or aMC! reply is atttn: the address, the seconds until the data
+// is ready and how many values there will be (two digits, atttnn, for
+// some commands).
+bool sdi12_parse_measure(const char* reply, uint8_t len, char addr,
+                         uint16_t* seconds, uint8_t* count) {
+  if((len != 5 && len != 6) || reply[0] != addr) return false;
+  for(uint8_t i = 1; i < len; i++) {
+    if(reply[i] < '0' || reply[i] > '9') return false;
+  }
+
+  *seconds = (reply[1] - '0') * 100 + (reply[2] - '0') * 10 + (reply[3] - '0');
+  *count = reply[4] - '0';
+  if(len == 6) *count = *count * 10 + (reply[5] - '0');
+  return true;
+}
+
+//==============================================================================
+// Reply CRC
+//==============================================================================
+// The three characters a sensor appends to the first len characters of
+// reply, address included.
+void sdi12_crc(const char* reply, uint8_t len, char* crc) {
+  uint16_t c = 0;
+
+  for(uint8_t i = 0; i < len; i++) {
+    c ^= (uint8_t)reply[i];
+    for(uint8_t b = 0; b < 8; b++) {
+      c = (c & 1) ? (c >> 1) ^ CRC_POLY : c >> 1;
+    }
+  }
+  crc[0] = CRC_CHAR | (c >> 12);
+  crc[1] = CRC_CHAR | ((c >> 6) & 0x3F);
+  crc[2] = CRC_CHAR | (c & 0x3F);
+}
+
+//==============================================================================
+// Begin Command
+//==============================================================================
+static void begin(sdi12_xact* x) {
+  x->tries = 0;
+  x->replied = false;
+  x->len = 0;
+  x->response[0] = 0;
+  x->status = SDI12_BUSY;
+  x->step = STEP_SEND;
+}
+
+//==============================================================================
+// Listen For A Line
+//==============================================================================
+static void listen(sdi12_xact* x, uint32_t now) {
+  x->len = 0;
+  x->response[0] = 0;
+  x->heard = false;
+  x->bad = false;
+  x->step_ms = now;
+  x->line_ms = now;
+}
+
+//==============================================================================
+// Read Line
+//==============================================================================
+// Takes in whatever characters have arrived. A line is done at <CR><LF>;
+// NULs the library sees while the line settles are dropped from the front.
+// A line with anything but printable characters in it is read to its end
+// and then called bad; one too long to keep is bad straight away.
+static uint8_t read_line(sdi12_xact* x, uint32_t now) {
+  const sdi12_port* p = x->port;
+  int               c;
+
+  while((c = p->read(p->bus)) >= 0) {
+    x->heard = true;
+    x->replied = true;
+    x->step_ms = now;
+    if(c == 0 && x->len == 0) continue;
+
+    if(c == '\n') {
+      if(x->len == 0 || x->response[x->len - 1] != '\r') x->bad = true;
+      else x->len--;
+      x->response[x->len] = 0;
+      return x->bad ? LINE_BAD : LINE_DONE;
+    }
+
+    if((c < ' ' && c != '\r') || c > '~') x->bad = true;
+    if(x->len == SDI12_LINE_LEN - 1) {
+      x->response[x->len] = 0;
+      return LINE_BAD;
+    }
+    x->response[x->len++] = (char)c;
+    x->response[x->len] = 0;
+  }
+
+  return LINE_NONE;
+}
+
+//==============================================================================
+// Check Reply
+//==============================================================================
+// The reply has to come from the sensor that was asked, and data has to
+// start with a value's sign and, after a CRC measurement, end in the right
+// CRC, which is then dropped.
+static bool reply_valid(sdi12_xact* x) {
+  if(x->len == 0) return false;
+  if(x->addr != '?' && x->response[0] != x->addr) return false;
+  if(x->cmd[1] == 'D') {
+    if(x->crc && !strip_crc(x)) return false;
+    return x->len > 1 && (x->response[1] == '+' || x->response[1] == '-');
+  }
+  return true;
+}
+
+//==============================================================================
+// Check And Drop CRC
+//==============================================================================
+static bool strip_crc(sdi12_xact* x) {
+  char crc[SDI12_CRC_LEN];
+
+  if(x->len <= SDI12_CRC_LEN) return false;
+  x->len -= SDI12_CRC_LEN;
+  sdi12_crc(x->response, x->len, crc);
+  if(memcmp(crc, x->response + x->len, SDI12_CRC_LEN) != 0) return false;
+  x->response[x->len] = 0;
+  return true;
+}
+
+//==============================================================================
+// Retry Command
+//==============================================================================
+// Gives up after max_retries resends: a sensor that never said anything
+// isn't there, one that did isn't being understood.
+static void retry(sdi12_xact* x) {
+  if(x->tries >= x->max_retries) {
+    finish(x, x->replied ? SDI12_GARBLED : SDI12_NO_RESPONSE);
+    return;
+  }
+  x->tries++;
+  x->retries++;
+  x->step = STEP_SEND;
+}
+
+//==============================================================================
+// Finish Transaction
+//==============================================================================
+static void finish(sdi12_xact* x, uint8_t status) {
+  x->status = status;
+  x->step = STEP_IDLE;
+}
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics SDI-12 Transactions
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Runs SDI-12 commands without blocking. sdi12_measure() starts an aMC!
+// measurement and sdi12_command() a single-reply command such as a! or aI!;
+// sdi12_service() is then called from the plot's waits until it stops
+// returning SDI12_BUSY. Every reply is read up to its <CR><LF> as the
+// characters come in (the SDI12 library buffers them from its pin-change
+// interrupt), with a timeout on the first character and between characters.
+// A command that times out or comes back garbled is sent again, up to
+// SDI12_RETRIES times, so a missing sensor costs about a second instead of
+// hanging the board until the watchdog resets it.
+//
+// Measurements are the CRC variants (aMC!, aCC!), so their data comes back
+// with the spec's 3-character CRC. A flipped bit in a digit still looks
+// like a value; the CRC is the only thing that catches it, and a reply
+// whose CRC doesn't match is asked for again like any other garbled one.
+//
+// Plain C++: the bus is reached through an sdi12_port, which sdi12_port.h
+// fills in for the SDI12 library and SDI-Sim for a simulated sensor.
+//
+//------------------------------------------------------------------------------
+
+#ifndef SDI12_BUS_H
+#define SDI12_BUS_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// A reply has to start this soon after its command went out (the spec
+// allows 15 ms; the rest is slack for the library's line handling) and
+// keep coming with no longer gaps than this. At 1200 baud a character
+// takes 8.3 ms.
+#define SDI12_FIRST_CHAR_MS  (100)
+#define SDI12_CHAR_GAP_MS    (50)
+
+// The longest line takes 333 ms; a sensor still talking after this is
+// babbling.
+#define SDI12_LINE_MS        (400)
+
+// Extra time allowed past a measurement's ttt before asking for the data,
+// and the longest ttt taken as real rather than garbled (the plots' sensors
+// all take a second).
+#define SDI12_READY_SLACK_MS (50)
+#define SDI12_MAX_READY_S    (5)
+
+#define SDI12_RETRIES        (3)
+#define SDI12_CMD_LEN        (8)
+#define SDI12_LINE_LEN       (40)
+
+// Data replies to a CRC measurement end in this many characters of CRC.
+#define SDI12_CRC_LEN        (3)
+
+// What sdi12_service() returns, also kept in status.
+#define SDI12_BUSY           (0)
+#define SDI12_OK             (1)
+#define SDI12_NO_RESPONSE    (2)
+#define SDI12_GARBLED        (3)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// The bus. send() puts a command on the line (with the break and marking
+// in front of it); read() returns the next received character or -1.
+struct sdi12_port {
+  void*    bus;
+  void     (*send)(void* bus, const char* cmd);
+  int      (*read)(void* bus);
+  void     (*clear)(void* bus);
+  uint32_t (*millis)(void* bus);
+};
+
+struct sdi12_xact {
+  const sdi12_port* port;
+  uint8_t  step;
+  uint8_t  status;
+  char     addr;
+  char     cmd[SDI12_CMD_LEN];
+  bool     measuring;    // cmd is aMC!, so a data command follows.
+  bool     crc;          // The last measurement was aMC! or aCC!, so its
+                         // data replies carry a CRC.
+  uint8_t  tries;
+  uint8_t  max_retries;  // SDI12_RETRIES unless the caller changes it.
+  bool     replied;      // Something came back for the current command.
+  bool     heard;        // Something came back for the current try.
+  bool     bad;          // The current reply has a character it shouldn't.
+  uint32_t step_ms;      // When the last character came in.
+  uint32_t line_ms;      // When the current line was started on.
+  uint32_t ready_ms;     // When a measurement's data can be read.
+  uint16_t retries;      // Resends since sdi12_init(), for diagnostics.
+
+  // The reply without its <CR><LF> (or CRC), NUL terminated; for a
+  // measurement it's the aD0! data.
+  uint8_t  len;
+  char     response[SDI12_LINE_LEN];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void    sdi12_init(sdi12_xact* x, const sdi12_port* port);
+void    sdi12_measure(sdi12_xact* x, char addr);
+void    sdi12_command(sdi12_xact* x, const char* cmd);
+uint8_t sdi12_service(sdi12_xact* x);
+bool    sdi12_parse_measure(const char* reply, uint8_t len, char addr,
+                            uint16_t* seconds, uint8_t* count);
+void    sdi12_crc(const char* reply, uint8_t len, char* crc);
+
+#endif
@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics SDI-12 Port
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; sdi12_bus.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "sdi12_port.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void     port_send(void* bus, const char* cmd);
+static int      port_read(void* bus);
+static void     port_clear(void* bus);
+static uint32_t port_millis(void* bus);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Port
+//==============================================================================
+// The bus must already be started (SDI12::begin()).
+void sdi12_port_init(sdi12_port* port, SDI12* bus) {
+  port->bus = bus;
+  port->send = port_send;
+  port->read = port_read;
+  port->clear = port_clear;
+  port->millis = port_millis;
+}
+
+//==============================================================================
+// Send Command
+//==============================================================================
+// sendCommand() wakes the sensors with a break, sends the command and
+// leaves the bus listening; the reply is buffered by the library's
+// interrupt.
+static void port_send(void* bus, const char* cmd) {
+  ((SDI12*)bus)->sendCommand(cmd);
+}
+
+//==============================================================================
+// Read Character
+//==============================================================================
+static int port_read(void* bus) {
+  SDI12* sdi = (SDI12*)bus;
+  return sdi->available() > 0 ? sdi->read() : -1;
+}
+
+//==============================================================================
+// Clear Received Characters
+//==============================================================================
+static void port_clear(void* bus) {
+  ((SDI12*)bus)->clearBuffer();
+}
+
+//==============================================================================
+// Current Time
+//==============================================================================
+static uint32_t port_millis(void* bus) {
+  (void)bus;
+  return millis();
+}
+
+#endif
@@ -0,0 +1,34 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics SDI-12 Port
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Connects sdi12_bus.h to the SDI12 library's bus.
+//
+//------------------------------------------------------------------------------
+
+#ifndef SDI12_PORT_H
+#define SDI12_PORT_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <SDI12.h>
+#include "sdi12_bus.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void sdi12_port_init(sdi12_port* port, SDI12* bus);
+
+#endif
@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Sensor Calibration
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Per-sensor coefficients, indexed by the sensor number in the log column
+// names: irad_cal[1] is irad_1 (Plot-2), teros_12_cal[0] is soil_0
+// (Plot-1).
+//
+// Generated by Cal-Fit from raw captures and reference measurements;
+// rerun it rather than editing by hand. Entries without a fit are the
+// previous values; TEROS 12 eq. 6 is the user manual's mineral soil
+// equation.
+//
+//------------------------------------------------------------------------------
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "sensor_calc.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define NUM_IRAD_SENSORS      (3)
+#define NUM_TEROS_12_SENSORS  (2)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+constexpr irad_poly irad_cal[NUM_IRAD_SENSORS] = {
+  {-8e-10, 3e-06, -0.00302, 1.1024},    // irad_0_wsqm, Plot-1
+  {-8e-10, 3e-06, -0.00302, 1.1024},    // irad_1_wsqm, Plot-2
+  {-6e-10, 2.7e-06, -0.0031, 1.1},      // irad_2_wsqm, Plot-3
+};
+
+constexpr teros_12_line teros_12_cal[NUM_TEROS_12_SENSORS] = {
+  {0.0003879, -0.6956},                 // soil_0_volw, Plot-1: TEROS 12 eq. 6
+  {0.0003879, -0.6956},                 // soil_1_volw, Plot-2: TEROS 12 eq. 6
+};
+
+#endif
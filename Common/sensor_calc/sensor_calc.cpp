@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Sensor Conversions
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "sensor_calc.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Mean Irradiance Counts
+//==============================================================================
+// Averages the summed single-ended readings; a negative sum reads as dark.
+int16_t irad_mean_counts(int32_t sum, uint8_t n) {
+  return (sum < 0) ? 0 : sum / n;
+}
+
+//==============================================================================
+// Irradiance From Counts
+//==============================================================================
+// Horner form of the calibration polynomial, truncated to whole W/m^2 as
+// the int16_t log column always has been.
+int16_t irad_wsqm(int16_t counts, const irad_poly* cal) {
+  float x = counts;
+  return (int16_t)(((cal->c4 * x + cal->c3) * x + cal->c2) * x * x +
+                   cal->c1 * x);
+}
+
+//==============================================================================
+// TEROS-12 Water Content
+//==============================================================================
+float teros_12_volw(float raw, const teros_12_line* cal) {
+  return cal->slope * raw + cal->offset;
+}
+
+//==============================================================================
+// DS18B20 Celsius
+//==============================================================================
+// DallasTemperature::getTempC() on a raw getTemp() reading, so the raw value
+// can be kept as well.
+float ds18b20_celsius(int16_t raw) {
+  if(raw <= DS18B20_DISCONNECTED_RAW) return DS18B20_DISCONNECTED_C;
+  return (float)raw * 0.0078125f;
+}
+
+//==============================================================================
+// DS18B20 Scratchpad Temperature
+//==============================================================================
+// Bytes 0-1 of the scratchpad are 1/16 C; scaled to getTemp()'s 1/128 C.
+int16_t ds18b20_scratch_raw(const uint8_t* scratchpad) {
+  return (int16_t)((scratchpad[0] | (uint16_t)scratchpad[1] << 8) << 3);
+}
+
+//==============================================================================
+// DS18B20 Reading Check
+//==============================================================================
+// For reads taken without the scratchpad CRC: anything out of range, or
+// the power-on value, needs a checked read.
+bool ds18b20_raw_plausible(int16_t raw) {
+  return raw > DS18B20_DISCONNECTED_RAW && raw <= DS18B20_MAX_RAW &&
+         raw != DS18B20_POWER_ON_RAW;
+}
+
+//==============================================================================
+// DS18B20 Mean
+//==============================================================================
+// raw_sum is n connected readings. The mean is rounded to centi-degrees in
+// integer math, so nothing is lost to float sums and the logged two
+// decimals are exact. No readings gives the disconnected value.
+int16_t ds18b20_mean_centi(int32_t raw_sum, uint8_t n) {
+  int32_t num = raw_sum * 100;
+  int32_t den = (int32_t)n * 128;
+
+  if(n == 0) return (int16_t)(DS18B20_DISCONNECTED_C * 100);
+  return (int16_t)((num >= 0 ? num + den / 2 : num - den / 2) / den);
+}
+
+float ds18b20_mean(int32_t raw_sum, uint8_t n) {
+  return ds18b20_mean_centi(raw_sum, n) / 100.0f;
+}
+
+//==============================================================================
+// AM2315 Value
+//==============================================================================
+// The sensor reports temperature and humidity in tenths; the Adafruit
+// library divides in float.
+float am2315_value(int16_t tenths) {
+  float value = tenths;
+  value /= 10;
+  return value;
+}
+
+//==============================================================================
+// AM2315 Mean
+//==============================================================================
+// n readings summed in tenths; NAN if there were none.
+float am2315_mean(int32_t tenths_sum, uint8_t n) {
+  if(n == 0) return NAN;
+  return (float)tenths_sum / (n * 10);
+}
+
+//==============================================================================
+// Parse TEROS-12 Response
+//==============================================================================
+// Parses an "a+raw±temp+cond" data response of len characters in place;
+// response[len] must be 0. Leading NULs (sent while the line settles) are
+// skipped.
+bool teros_12_parse(char* response, uint8_t len, float* raw, float* temp,
+                    uint16_t* conductivity) {
+  // Local variables.
+  char* input = response;
+  char* temp_str;
+  char* vwc_str;
+  char* cond_str;
+  bool  temp_neg = true;
+
+  while(len > 0 && *input == 0) {
+    input++;
+    len--;
+  }
+
+  // Get pointers to delimiters within response string.
+  temp_str = strchr(input, '-');
+  vwc_str = strchr(input, '+');
+  cond_str = strrchr(input, '+');
+
+  // Without VWC and conductivity delimiters the response is no good.
+  if(!vwc_str || !cond_str) return false;
+
+  // Replace delimiters with null characters and advance pointers.
+  vwc_str++;
+  *cond_str = 0;
+  cond_str++;
+
+  // If no temperature delimiter was found, temperature is positive.
+  if(!temp_str) {
+    temp_str = strchr(vwc_str, '+');
+    temp_neg = false;
+    if(!temp_str) return false;
+  }
+
+  // Replace temperature delimiter with null character and advance pointer.
+  *temp_str = 0;
+  temp_str++;
+
+  *raw = (float)atof(vwc_str);
+  *temp = temp_neg ? (float)atof(temp_str) * -1 : (float)atof(temp_str);
+  *conductivity = atoi(cond_str);
+  return true;
+}
+
+//==============================================================================
+// Parse TEROS-21 Response
+//==============================================================================
+// Parses an "a-potential±temp" data response like teros_12_parse().
+bool teros_21_parse(char* response, uint8_t len, float* matric_potential,
+                    float* temp) {
+  // Local variables.
+  char* input = response;
+  char* mtc_pot_str;
+  char* temp_str;
+  bool  temp_neg = false;
+
+  while(len > 0 && *input == 0) {
+    input++;
+    len--;
+  }
+
+  // Get pointers to delimiters within response string.
+  mtc_pot_str = strchr(input, '-');
+  temp_str = strchr(input, '+');
+
+  // Without the matric potential delimiter the response is no good.
+  if(!mtc_pot_str) return false;
+  mtc_pot_str++;
+
+  // If no positive temperature delimiter was found, temperature is negative.
+  if(!temp_str) {
+    temp_str = strrchr(input, '-');
+    temp_neg = true;
+  }
+
+  // Replace temperature delimiter with null character and advance pointer.
+  *temp_str = 0;
+  temp_str++;
+
+  *matric_potential = (float)atof(mtc_pot_str) * -1;
+  *temp = temp_neg ? (float)atof(temp_str) * -1 : (float)atof(temp_str);
+  return true;
+}
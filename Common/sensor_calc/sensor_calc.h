@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Sensor Conversions
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Everything read_sensors() does between the raw readings and the logged
+// values: averaging ADC counts, the irradiance polynomial, parsing TEROS
+// SDI-12 responses, the TEROS-12 water content equation and the DS18B20 and
+// AM2315 unit conversions the libraries apply. No Arduino dependencies, so
+// host tools (Sensor-Replay) run the same code.
+//
+// AVR double is a 32-bit float. Everything here is float so a host build
+// gets the same results as the boards.
+//
+//------------------------------------------------------------------------------
+
+#ifndef SENSOR_CALC_H
+#define SENSOR_CALC_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Readings averaged per minute.
+#define SENSOR_NUM_SAMPLES  (20)
+
+// Most AM2315 readings in a minute, one per 2 s refresh.
+#define AM2315_MAX_READINGS (30)
+
+// Longest SDI-12 data response kept, including the terminator.
+#define SDI_RESPONSE_LEN    (25)
+
+// DallasTemperature's disconnected reading, raw (1/128 C) and converted.
+#define DS18B20_DISCONNECTED_RAW  (-7040)
+#define DS18B20_DISCONNECTED_C    (-127.0f)
+
+// DS18B20 top of range (125 C) and power-on value (85 C), raw. The bottom
+// (-55 C) is the disconnected reading.
+#define DS18B20_MAX_RAW           (16000)
+#define DS18B20_POWER_ON_RAW      (10880)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// W/m^2 = c4 x^4 + c3 x^3 + c2 x^2 + c1 x, x = mean ADS1115 counts.
+struct irad_poly {
+  float c4;
+  float c3;
+  float c2;
+  float c1;
+};
+
+// m^3/m^3 = slope * raw + offset, raw = TEROS-12 calibrated counts.
+struct teros_12_line {
+  float slope;
+  float offset;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+int16_t irad_mean_counts(int32_t sum, uint8_t n);
+int16_t irad_wsqm(int16_t counts, const irad_poly* cal);
+float   teros_12_volw(float raw, const teros_12_line* cal);
+bool    teros_12_parse(char* response, uint8_t len, float* raw, float* temp,
+                       uint16_t* conductivity);
+bool    teros_21_parse(char* response, uint8_t len, float* matric_potential,
+                       float* temp);
+float   ds18b20_celsius(int16_t raw);
+int16_t ds18b20_scratch_raw(const uint8_t* scratchpad);
+bool    ds18b20_raw_plausible(int16_t raw);
+int16_t ds18b20_mean_centi(int32_t raw_sum, uint8_t n);
+float   ds18b20_mean(int32_t raw_sum, uint8_t n);
+float   am2315_value(int16_t tenths);
+float   am2315_mean(int32_t tenths_sum, uint8_t n);
+
+#endif
@@ -0,0 +1,255 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Soil Physics
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "soil_physics.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_word(p) (*(p))
+#endif
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Raw counts and temperatures are interpolated in 1/16ths.
+#define Q4_SHIFT         (4)
+#define Q4               (1 << Q4_SHIFT)
+
+// The temperature ratio is kept in 1/8192ths; it's 2.48 at -10 C.
+#define RATIO_SHIFT      (13)
+
+#define SOIL_KNOTS(X) \
+  X(0)  X(1)  X(2)  X(3)  X(4)  X(5)  X(6)  X(7)  X(8)  X(9)  X(10) \
+  X(11) X(12) X(13) X(14) X(15) X(16) X(17) X(18) X(19) X(20) X(21) \
+  X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31) X(32) \
+  X(33) X(34) X(35) X(36) X(37) X(38) X(39) X(40) X(41) X(42) X(43) \
+  X(44) X(45) X(46) X(47) X(48) X(49) X(50) X(51) X(52) X(53) X(54) \
+  X(55) X(56) X(57) X(58) X(59) X(60) X(61) X(62) X(63) X(64)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static int16_t volw_fixed(const soil_config* cfg, float raw, int32_t raw_q);
+static int16_t clamp_fixed(int32_t volw);
+static int32_t interpolate(const int16_t* table, int32_t q, int32_t first,
+                           uint8_t shift);
+static int32_t to_q4(float x);
+
+//------------------------------------------------------------------------------
+//      __   __        __  ___              ___  __
+//     /  ` /  \ |\ | /__`  |   /\  |\ |  |  /__`
+//     \__, \__/ | \| .__/  |  /~~\ | \|  |  .__/
+//
+//------------------------------------------------------------------------------
+
+// The curves at the table knots, worked out by the compiler.
+
+static constexpr double knot_raw(int k) {
+  return SOIL_RAW_FIRST + (double)(k << SOIL_RAW_SHIFT);
+}
+
+static constexpr double knot_temp(int k) {
+  return SOIL_TEMP_FIRST + (double)(k << SOIL_TEMP_SHIFT);
+}
+
+static constexpr int32_t round_fixed(double x) {
+  return x < 0 ? (int32_t)(x - 0.5) : (int32_t)(x + 0.5);
+}
+
+// Water content is capped at 1 in the tables so it fits int16_t, but left
+// negative and clamped at 0 after interpolating: a knot either side of the
+// dry end's corner would otherwise cut it off by up to 0.002 m^3/m^3.
+static constexpr double cap_volw(double v) {
+  return v > 1 ? 1 : v;
+}
+
+// TEROS 12 manual: sqrt(permittivity) is a cubic in raw, no less than 1 (air).
+static constexpr double root_perm(double r) {
+  return ((2.887e-9 * r - 2.080e-5) * r + 5.276e-2) * r - 43.39;
+}
+
+static constexpr double perm(double r) {
+  return root_perm(r) < 1 ? 1 : root_perm(r) * root_perm(r);
+}
+
+// TEROS 12 manual: soilless media (potting soil, rockwool, perlite).
+static constexpr double soilless_volw(double r) {
+  return ((6.771e-10 * r - 5.105e-6) * r + 1.302e-2) * r - 10.848;
+}
+
+// Topp et al. (1980), for soils without their own calibration.
+static constexpr double topp_volw(double e) {
+  return ((4.3e-6 * e - 5.5e-4) * e + 2.92e-2) * e - 5.3e-2;
+}
+
+// exp(x) to about 1e-7 over the table's -2 to 0.4, from its Taylor series.
+static constexpr double exp_term(double x, int n, double term) {
+  return n > 24 ? term : term + exp_term(x, n + 1, term * x / n);
+}
+
+static constexpr double exp_series(double x) {
+  return exp_term(x, 1, 1.0);
+}
+
+// Sheets and Hendrickx (1995): EC at 25 C = EC at T * (0.447 + 1.4034
+// e^(-T / 26.815)).
+static constexpr double ec_ratio(double t) {
+  return 0.4470 + 1.4034 * exp_series(-t / 26.815);
+}
+
+#define PERM_KNOT(k) \
+  (int16_t)round_fixed(perm(knot_raw(k)) * SOIL_PERM_SCALE),
+#define SOILLESS_KNOT(k) \
+  (int16_t)round_fixed(cap_volw(soilless_volw(knot_raw(k))) * SOIL_VWC_SCALE),
+#define TOPP_KNOT(k) \
+  (int16_t)round_fixed(cap_volw(topp_volw(perm(knot_raw(k)))) * \
+                       SOIL_VWC_SCALE),
+#define RATIO_KNOT(k) \
+  (int16_t)round_fixed(ec_ratio(knot_temp(k)) * (1L << RATIO_SHIFT)),
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Permittivity tops out near 155 (15500), so it fits the signed tables.
+static const int16_t perm_table[SOIL_NUM_KNOTS] PROGMEM = {
+  SOIL_KNOTS(PERM_KNOT)
+};
+static const int16_t soilless_table[SOIL_NUM_KNOTS] PROGMEM = {
+  SOIL_KNOTS(SOILLESS_KNOT)
+};
+static const int16_t topp_table[SOIL_NUM_KNOTS] PROGMEM = {
+  SOIL_KNOTS(TOPP_KNOT)
+};
+static const int16_t ratio_table[SOIL_NUM_KNOTS] PROGMEM = {
+  SOIL_KNOTS(RATIO_KNOT)
+};
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Compute Soil Reading
+//==============================================================================
+// raw, temp and ec are a TEROS-12's three values. Pore-water EC is left at
+// SOIL_NO_PORE_EC when the soil is too dry for Hilhorst's model. Everything
+// but the mineral line is integer math on the tables.
+void soil_compute(const soil_config* cfg, float raw, float temp, uint16_t ec,
+                  soil_reading* out) {
+  int32_t raw_q  = to_q4(raw);
+  int32_t temp_q = to_q4(temp);
+  int32_t ratio, perm_water, denom;
+
+  out->volw = volw_fixed(cfg, raw, raw_q);
+  out->perm = (uint16_t)interpolate(perm_table, raw_q, SOIL_RAW_FIRST,
+                                    SOIL_RAW_SHIFT);
+
+  ratio = interpolate(ratio_table, temp_q, SOIL_TEMP_FIRST, SOIL_TEMP_SHIFT);
+  out->bulk_ec = (int32_t)(((uint32_t)ec * (uint32_t)ratio +
+                            (1UL << (RATIO_SHIFT - 1))) >> RATIO_SHIFT);
+
+  // Hilhorst (2000): pore EC = pore water permittivity * bulk EC /
+  // (bulk permittivity - 4.1), the permittivities in 1/100.
+  perm_water = SOIL_PERM_WATER_20C -
+               (SOIL_PERM_WATER_SLOPE * (temp_q - 20 * Q4)) / Q4;
+  denom = (int32_t)out->perm - SOIL_PERM_OFFSET;
+  if(out->perm < SOIL_PORE_MIN_PERM) {
+    out->pore_ec = SOIL_NO_PORE_EC;
+  }
+  else {
+    out->pore_ec = (perm_water * out->bulk_ec + denom / 2) / denom;
+  }
+}
+
+//==============================================================================
+// Soil Water Content
+//==============================================================================
+// In m^3/m^3 for the log column; mineral soil keeps the calibration line's
+// full float result.
+float soil_volw(const soil_config* cfg, float raw) {
+  if(cfg->substrate == SOIL_MINERAL) return teros_12_volw(raw, cfg->line);
+  return (float)volw_fixed(cfg, raw, to_q4(raw)) / SOIL_VWC_SCALE;
+}
+
+//==============================================================================
+// Fixed-Point Water Content
+//==============================================================================
+static int16_t volw_fixed(const soil_config* cfg, float raw, int32_t raw_q) {
+  switch(cfg->substrate) {
+  case SOIL_SOILLESS:
+    return clamp_fixed(interpolate(soilless_table, raw_q, SOIL_RAW_FIRST,
+                                   SOIL_RAW_SHIFT));
+  case SOIL_TOPP:
+    return clamp_fixed(interpolate(topp_table, raw_q, SOIL_RAW_FIRST,
+                                   SOIL_RAW_SHIFT));
+  default:
+    return (int16_t)round_fixed(teros_12_volw(raw, cfg->line) *
+                                SOIL_VWC_SCALE);
+  }
+}
+
+//==============================================================================
+// Clamp Water Content
+//==============================================================================
+static int16_t clamp_fixed(int32_t volw) {
+  return (int16_t)(volw < 0 ? 0 : volw);
+}
+
+//==============================================================================
+// Interpolate Table
+//==============================================================================
+// q is in 1/16ths of the table's units; past either end the end knot is
+// used. Rounds to the nearest unit, where a plain shift would lose up to a
+// whole one.
+static int32_t interpolate(const int16_t* table, int32_t q, int32_t first,
+                           uint8_t shift) {
+  int32_t k = q - first * Q4;
+  int32_t frac, lo, hi;
+
+  if(k < 0) return (int16_t)pgm_read_word(&table[0]);
+  frac = k & ((1L << (shift + Q4_SHIFT)) - 1);
+  k >>= shift + Q4_SHIFT;
+  if(k >= SOIL_NUM_KNOTS - 1) {
+    return (int16_t)pgm_read_word(&table[SOIL_NUM_KNOTS - 1]);
+  }
+
+  lo = (int16_t)pgm_read_word(&table[k]);
+  hi = (int16_t)pgm_read_word(&table[k + 1]);
+  return lo + (((hi - lo) * frac + (1L << (shift + Q4_SHIFT - 1))) >>
+               (shift + Q4_SHIFT));
+}
+
+//==============================================================================
+// To 1/16ths
+//==============================================================================
+static int32_t to_q4(float x) {
+  return round_fixed((double)x * Q4);
+}
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Soil Physics
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// What a TEROS-12 reading says beyond the mineral soil water content:
+//
+//   - water content for the substrate the probe sits in: the probe's
+//     calibration line for mineral soil, the TEROS 12 manual's soilless
+//     media equation, or Topp's equation on the permittivity for anything
+//     without its own
+//   - bulk permittivity, from the manual's equation on the raw counts
+//   - bulk EC brought from the soil temperature to 25 C with the
+//     Sheets-Hendrickx ratio
+//   - pore-water EC by Hilhorst's model, which only holds in soil wetter
+//     than about 0.10 m^3/m^3; that's taken as a permittivity of
+//     SOIL_PORE_MIN_PERM (Topp's equation) so the cutoff doesn't move with
+//     the substrate
+//
+// The curves are tabulated at compile time (kept in flash on the boards)
+// and interpolated in integer math, so a reading costs the same few
+// multiplies whatever the substrate.
+//
+//------------------------------------------------------------------------------
+
+#ifndef SOIL_PHYSICS_H
+#define SOIL_PHYSICS_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <sensor_calc.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define SOIL_MINERAL         (0)
+#define SOIL_SOILLESS        (1)
+#define SOIL_TOPP            (2)
+
+// Fixed-point units: water content in 1/10000 m^3/m^3, permittivity in
+// 1/100.
+#define SOIL_VWC_SCALE       (10000)
+#define SOIL_PERM_SCALE      (100)
+
+// Tables have a knot every 32 raw counts from 1600 (drier than air) to
+// 3648 (wetter than water), and every 1 C from -10 C to 54 C. Over raw
+// 1850-3200 and -5 C to 45 C that keeps water content within 0.0006
+// m^3/m^3, bulk EC within 0.1% and permittivity within 0.2% of the
+// equations (0.012 below 5, where its 1/100 units are most of that);
+// Sensor-Replay -p checks it.
+#define SOIL_RAW_FIRST       (1600)
+#define SOIL_RAW_SHIFT       (5)
+#define SOIL_TEMP_FIRST      (-10)
+#define SOIL_TEMP_SHIFT      (0)
+#define SOIL_NUM_KNOTS       (65)
+
+// Hilhorst's model: pore water permittivity 80.3 - 0.37 (T - 20), and the
+// bulk permittivity at zero bulk EC, 4.1.
+#define SOIL_PERM_WATER_20C  (8030)
+#define SOIL_PERM_WATER_SLOPE (37)
+#define SOIL_PERM_OFFSET     (410)
+#define SOIL_PORE_MIN_PERM   (583)
+
+// pore_ec when the soil is too dry for the model.
+#define SOIL_NO_PORE_EC      (-1)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// What a plot's TEROS-12s sit in. line is only used for SOIL_MINERAL.
+struct soil_config {
+  uint8_t              substrate;
+  const teros_12_line* line;
+};
+
+struct soil_reading {
+  int16_t  volw;        // 1/10000 m^3/m^3
+  uint16_t perm;        // 1/100
+  int32_t  bulk_ec;     // uS/cm at 25 C
+  int32_t  pore_ec;     // uS/cm at 25 C, or SOIL_NO_PORE_EC
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     soil_compute(const soil_config* cfg, float raw, float temp,
+                      uint16_t ec, soil_reading* out);
+float    soil_volw(const soil_config* cfg, float raw);
+
+#endif
@@ -0,0 +1,301 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics TEROS Probe Table
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include <math.h>
+#include "teros.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Where the table is in teros_service().
+#define STEP_IDLE        (0)
+#define STEP_ACK         (1)
+#define STEP_ID          (2)
+#define STEP_START       (3)
+#define STEP_WAIT        (4)
+#define STEP_DATA        (5)
+
+// aI! replies are the address, the SDI-12 version (2), vendor (8), model
+// (6) and sensor version (3), then optional serial number.
+#define ID_MODEL         (11)
+#define ID_MIN_LEN       (17)
+#define ID_MODEL_LEN     (5)
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void send(teros_probes* t, char addr, const char* cmd);
+static void next_scan(teros_probes* t);
+static void next_start(teros_probes* t);
+static void next_data(teros_probes* t);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Probe Table
+//==============================================================================
+// The table is empty until teros_discover() has run.
+void teros_init(teros_probes* t, sdi12_xact* x) {
+  memset(t, 0, sizeof(*t));
+  t->xact = x;
+  t->step = STEP_IDLE;
+}
+
+//==============================================================================
+// Start Discovery
+//==============================================================================
+void teros_discover(teros_probes* t) {
+  t->num_probes = 0;
+  t->num_failed = 0;
+  t->xact->max_retries = TEROS_SCAN_RETRIES;
+  t->scan_addr = TEROS_FIRST_ADDR;
+  send(t, t->scan_addr, "!");
+  t->step = STEP_ACK;
+}
+
+//==============================================================================
+// Start Reading
+//==============================================================================
+// Probes of unknown models are left out.
+void teros_sample(teros_probes* t) {
+  t->num_failed = 0;
+  for(uint8_t i = 0; i < t->num_probes; i++) {
+    t->probes[i].measuring = false;
+    t->probes[i].ok = false;
+    t->probes[i].len = 0;
+    t->probes[i].response[0] = 0;
+    if(t->probes[i].model != TEROS_UNKNOWN) t->num_failed++;
+  }
+  t->ready_ms = t->xact->port->millis(t->xact->port->bus);
+  t->index = 0;
+  t->step = STEP_START;
+  next_start(t);
+}
+
+//==============================================================================
+// Service Probe Table
+//==============================================================================
+// Returns SDI12_BUSY until the discovery or reading is done, then
+// SDI12_OK; how each probe did is in the table.
+uint8_t teros_service(teros_probes* t) {
+  sdi12_xact*  x = t->xact;
+  teros_probe* p = &t->probes[t->index];
+  uint8_t      status;
+  uint16_t     seconds;
+  uint8_t      count;
+  uint32_t     now;
+
+  if(t->step == STEP_IDLE) return SDI12_OK;
+
+  if(t->step == STEP_WAIT) {
+    now = x->port->millis(x->port->bus);
+    if((int32_t)(now - t->ready_ms) >= 0) {
+      t->index = 0;
+      t->step = STEP_DATA;
+      next_data(t);
+    }
+    return t->step == STEP_IDLE ? SDI12_OK : SDI12_BUSY;
+  }
+
+  status = sdi12_service(x);
+  if(status == SDI12_BUSY) return SDI12_BUSY;
+
+  switch(t->step) {
+  case STEP_ACK:
+    if(status == SDI12_OK) {
+      send(t, t->scan_addr, "I!");
+      t->step = STEP_ID;
+    }
+    else {
+      next_scan(t);
+    }
+    break;
+
+  case STEP_ID:
+    if(status == SDI12_OK && t->num_probes < TEROS_MAX_PROBES) {
+      p = &t->probes[t->num_probes++];
+      memset(p, 0, sizeof(*p));
+      p->addr = t->scan_addr;
+      p->model = teros_identify(x->response, x->len);
+    }
+    next_scan(t);
+    break;
+
+  case STEP_START:
+    // aCC! is answered atttnn; the probe measures while the others are
+    // started.
+    if(status == SDI12_OK &&
+       sdi12_parse_measure(x->response, x->len, p->addr, &seconds, &count) &&
+       count > 0 && seconds <= SDI12_MAX_READY_S) {
+      now = x->port->millis(x->port->bus) + seconds * 1000UL +
+            SDI12_READY_SLACK_MS;
+      if((int32_t)(now - t->ready_ms) > 0) t->ready_ms = now;
+      p->measuring = true;
+    }
+    t->index++;
+    next_start(t);
+    break;
+
+  case STEP_DATA:
+    if(status == SDI12_OK && x->len < SDI_RESPONSE_LEN) {
+      memcpy(p->response, x->response, x->len + 1);
+      p->len = x->len;
+      p->ok = true;
+      t->num_failed--;
+    }
+    t->index++;
+    next_data(t);
+    break;
+  }
+
+  return t->step == STEP_IDLE ? SDI12_OK : SDI12_BUSY;
+}
+
+//==============================================================================
+// Identify Probe
+//==============================================================================
+// Tells the model from an aI! reply's model field.
+uint8_t teros_identify(const char* id, uint8_t len) {
+  if(len < ID_MIN_LEN) return TEROS_UNKNOWN;
+  if(strncmp(id + ID_MODEL, "TER12", ID_MODEL_LEN) == 0) return TEROS_12;
+  if(strncmp(id + ID_MODEL, "TER21", ID_MODEL_LEN) == 0) return TEROS_21;
+  return TEROS_UNKNOWN;
+}
+
+//==============================================================================
+// Find Probe
+//==============================================================================
+// The nth probe of a model, counting up from the lowest address, or NULL.
+const teros_probe* teros_find(const teros_probes* t, uint8_t model,
+                              uint8_t n) {
+  for(uint8_t i = 0; i < t->num_probes; i++) {
+    if(t->probes[i].model != model) continue;
+    if(n == 0) return &t->probes[i];
+    n--;
+  }
+  return NULL;
+}
+
+//==============================================================================
+// Probe Values
+//==============================================================================
+// Parses a copy of the probe's data: raw VWC, temperature and conductivity
+// for a TEROS-12; matric potential and temperature (and NaN) for a
+// TEROS-21.
+bool teros_values(const teros_probe* p, float* values) {
+  char     response[SDI_RESPONSE_LEN];
+  uint16_t conductivity;
+
+  if(!p->ok) return false;
+  memcpy(response, p->response, p->len + 1);
+
+  if(p->model == TEROS_12 &&
+     teros_12_parse(response, p->len, &values[0], &values[1], &conductivity)) {
+    values[2] = conductivity;
+    return true;
+  }
+  if(p->model == TEROS_21 &&
+     teros_21_parse(response, p->len, &values[0], &values[1])) {
+    values[2] = NAN;
+    return true;
+  }
+  return false;
+}
+
+//==============================================================================
+// Model Name
+//==============================================================================
+const char* teros_model_name(uint8_t model) {
+  switch(model) {
+  case TEROS_12: return "TEROS-12";
+  case TEROS_21: return "TEROS-21";
+  default:       return "unknown";
+  }
+}
+
+//==============================================================================
+// Send Command
+//==============================================================================
+// cmd is the command after the address.
+static void send(teros_probes* t, char addr, const char* cmd) {
+  char buf[SDI12_CMD_LEN];
+
+  buf[0] = addr;
+  strncpy(buf + 1, cmd, SDI12_CMD_LEN - 2);
+  buf[SDI12_CMD_LEN - 1] = 0;
+  sdi12_command(t->xact, buf);
+}
+
+//==============================================================================
+// Scan Next Address
+//==============================================================================
+static void next_scan(teros_probes* t) {
+  if(t->scan_addr == TEROS_LAST_ADDR) {
+    t->xact->max_retries = SDI12_RETRIES;
+    t->step = STEP_IDLE;
+    return;
+  }
+  t->scan_addr++;
+  send(t, t->scan_addr, "!");
+  t->step = STEP_ACK;
+}
+
+//==============================================================================
+// Start Next Measurement
+//==============================================================================
+// Once every probe is started, waits for the slowest one; if none started
+// there's nothing to read.
+static void next_start(teros_probes* t) {
+  while(t->index < t->num_probes &&
+        t->probes[t->index].model == TEROS_UNKNOWN) {
+    t->index++;
+  }
+  if(t->index < t->num_probes) {
+    send(t, t->probes[t->index].addr, "CC!");
+    return;
+  }
+
+  t->step = STEP_IDLE;
+  for(uint8_t i = 0; i < t->num_probes; i++) {
+    if(t->probes[i].measuring) t->step = STEP_WAIT;
+  }
+}
+
+//==============================================================================
+// Read Next Probe
+//==============================================================================
+static void next_data(teros_probes* t) {
+  while(t->index < t->num_probes && !t->probes[t->index].measuring) {
+    t->index++;
+  }
+  if(t->index < t->num_probes) {
+    send(t, t->probes[t->index].addr, "D0!");
+    return;
+  }
+  t->step = STEP_IDLE;
+}
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics TEROS Probe Table
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Finds the METER soil probes on the SDI-12 bus at boot and reads them all
+// together. teros_discover() asks each address from TEROS_FIRST_ADDR to
+// TEROS_LAST_ADDR for an acknowledgement (a!) and, where one answers, for
+// its identification (aI!), whose model field says which TEROS it is.
+// teros_sample() then starts a concurrent measurement (aCC!, the CRC
+// variant) on every known probe, waits once for the slowest of them, and
+// collects each probe's data (aD0!). Adding a probe to a depth profile
+// only takes giving it a free address, and each extra probe adds its two
+// commands to a reading, not another second of measuring.
+//
+// Both run on an sdi12_xact and are stepped along by teros_service() like
+// the transaction itself.
+//
+//------------------------------------------------------------------------------
+
+#ifndef TEROS_H
+#define TEROS_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sdi12_bus.h>
+#include <sensor_calc.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define TEROS_MAX_PROBES     (6)
+#define TEROS_FIRST_ADDR     ('0')
+#define TEROS_LAST_ADDR      ('9')
+
+// An empty address is asked once more rather than SDI12_RETRIES times, so
+// the scan takes about three seconds.
+#define TEROS_SCAN_RETRIES   (1)
+
+// Probes beyond the ones a plot logs are raw-captured as this plus their
+// address digit.
+#define TEROS_EXTRA_CAPTURE  (10)
+
+#define TEROS_UNKNOWN        (0)
+#define TEROS_12             (1)
+#define TEROS_21             (2)
+
+#define TEROS_NUM_VALUES     (3)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct teros_probe {
+  char     addr;
+  uint8_t  model;
+  bool     measuring;    // Its aCC! was answered this reading.
+  bool     ok;           // response holds this reading's data.
+  uint8_t  len;
+  char     response[SDI_RESPONSE_LEN];
+};
+
+struct teros_probes {
+  sdi12_xact* xact;
+  uint8_t     step;
+  uint8_t     index;     // Probe being measured or read.
+  char        scan_addr;
+  uint32_t    ready_ms;  // When the slowest probe's data is in.
+  uint8_t     num_probes;
+  uint8_t     num_failed;  // Known probes with no data from the last reading.
+  teros_probe probes[TEROS_MAX_PROBES];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void               teros_init(teros_probes* t, sdi12_xact* x);
+void               teros_discover(teros_probes* t);
+void               teros_sample(teros_probes* t);
+uint8_t            teros_service(teros_probes* t);
+uint8_t            teros_identify(const char* id, uint8_t len);
+const teros_probe* teros_find(const teros_probes* t, uint8_t model,
+                              uint8_t n);
+bool               teros_values(const teros_probe* p, float* values);
+const char*        teros_model_name(uint8_t model);
+
+#endif
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics TEROS Profile Log
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; teros.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <math.h>
+#include <SD.h>
+#include "teros_sd.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// volw, perm, bulk_ec and pore_ec.
+#define SOIL_COLUMNS     (4)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Decimal places for each soil column.
+static const uint8_t soil_digits[SOIL_COLUMNS] = {4, 2, 0, 0};
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Write Probe Readings
+//==============================================================================
+// date is the row's timestamp as the plot logs it. A probe that didn't
+// answer this minute gets a row of NaNs, and so do a TEROS-21's soil
+// columns and a pore EC the soil is too dry for.
+bool teros_write(const teros_probes* t, const soil_config* soil, time_t when,
+                 const char* date) {
+  char name[13];
+  bool exists;
+  File file;
+
+  sprintf(name, "%02d-%02d.sdi", month(when), day(when));
+  exists = SD.exists(name);
+  file = SD.open(name, FILE_WRITE);
+  if(!file) return false;
+
+  if(!exists) {
+    file.println(F("time,addr,model,value_1,value_2,value_3,"
+                   "volw,perm,bulk_ec,pore_ec"));
+  }
+
+  for(uint8_t i = 0; i < t->num_probes; i++) {
+    const teros_probe* p = &t->probes[i];
+    float              values[TEROS_NUM_VALUES] = {NAN, NAN, NAN};
+    float              physics[SOIL_COLUMNS] = {NAN, NAN, NAN, NAN};
+    soil_reading       reading;
+
+    if(p->model == TEROS_UNKNOWN) continue;
+    if(!teros_values(p, values)) {
+      values[0] = values[1] = values[2] = NAN;
+    }
+    else if(p->model == TEROS_12) {
+      soil_compute(soil, values[0], values[1], (uint16_t)values[2], &reading);
+      physics[0] = soil_volw(soil, values[0]);
+      physics[1] = (float)reading.perm / SOIL_PERM_SCALE;
+      physics[2] = reading.bulk_ec;
+      if(reading.pore_ec != SOIL_NO_PORE_EC) physics[3] = reading.pore_ec;
+    }
+
+    file.print(date);
+    file.print(',');
+    file.print(p->addr);
+    file.print(',');
+    file.print(teros_model_name(p->model));
+    for(uint8_t v = 0; v < TEROS_NUM_VALUES; v++) {
+      file.print(',');
+      file.print(values[v]);
+    }
+    for(uint8_t v = 0; v < SOIL_COLUMNS; v++) {
+      file.print(',');
+      file.print(physics[v], soil_digits[v]);
+    }
+    file.println();
+  }
+  file.close();
+  return true;
+}
+
+#endif
@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics TEROS Profile Log
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Writes every TEROS probe's reading to a daily MM-DD.sdi file, one line
+// per probe:
+//
+//   time,addr,model,value_1,value_2,value_3,volw,perm,bulk_ec,pore_ec
+//
+// with the values as teros_values() gives them and, for TEROS-12s, what
+// soil_compute() makes of them for the plot's substrate. The plot's hourly
+// log keeps the probes it always had; this is where a depth profile's
+// extra probes and the soil EC end up.
+//
+//------------------------------------------------------------------------------
+
+#ifndef TEROS_SD_H
+#define TEROS_SD_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <soil_physics.h>
+#include "teros.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool teros_write(const teros_probes* t, const soil_config* soil, time_t when,
+                 const char* date);
+
+#endif
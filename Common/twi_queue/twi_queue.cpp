@@ -0,0 +1,319 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics I2C Transaction Queue
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include "twi_queue.h"
+
+// Only the AVR boards have the TWI peripheral.
+#if defined(ARDUINO) && defined(TWCR)
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// TWSR status codes (prescaler bits masked off).
+#define TW_START           (0x08)
+#define TW_REP_START       (0x10)
+#define TW_MT_SLA_ACK      (0x18)
+#define TW_MT_SLA_NACK     (0x20)
+#define TW_MT_DATA_ACK     (0x28)
+#define TW_MT_DATA_NACK    (0x30)
+#define TW_ARB_LOST        (0x38)
+#define TW_MR_SLA_ACK      (0x40)
+#define TW_MR_SLA_NACK     (0x48)
+#define TW_MR_DATA_ACK     (0x50)
+#define TW_MR_DATA_NACK    (0x58)
+#define TW_STATUS_MASK     (0xF8)
+
+#define TWCR_RUN           (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+
+// A stop takes a few bus clocks; this is well past that.
+#define STOP_SPINS         (1000)
+
+// Clocks to free a slave stuck mid-byte, and the half period (100 kHz).
+#define RECOVERY_CLOCKS    (9)
+#define RECOVERY_HALF_US   (5)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// active is on the bus; pending is waiting, high priority first; finished
+// is waiting for twi_service() to run its callback.
+static twi_xfer* volatile active;
+static twi_xfer* volatile pending;
+static twi_xfer* volatile finished;
+static volatile uint8_t   data_index;
+static volatile uint32_t  active_ms;
+static uint16_t           recoveries;
+static bool               servicing;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void start_next();
+static void finish(uint8_t status);
+static void recover_bus();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Start I2C
+//==============================================================================
+void twi_begin() {
+  // Internal pull-ups help the board's external ones on long runs.
+  digitalWrite(SDA, HIGH);
+  digitalWrite(SCL, HIGH);
+  TWSR = 0;
+  TWBR = ((F_CPU / TWI_FREQ) - 16) / 2;
+  TWCR = _BV(TWEN) | _BV(TWIE);
+  active = pending = finished = NULL;
+}
+
+//==============================================================================
+// Queue Transaction
+//==============================================================================
+// Returns false, leaving x alone, if it is too long or still queued, on the
+// bus or waiting for its callback. A finished transaction's status is set
+// before its callback runs, so status alone doesn't say it can go again.
+bool twi_submit(twi_xfer* x) {
+  if(x->write_len > TWI_MAX_DATA || x->read_len > TWI_MAX_DATA) return false;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for(twi_xfer* q = pending; q; q = q->next) {
+      if(q == x) return false;
+    }
+    for(twi_xfer* q = finished; q; q = q->next) {
+      if(q == x) return false;
+    }
+    if(x == active) return false;
+
+    // Behind everything of the same or higher priority.
+    twi_xfer* volatile* link = &pending;
+    while(*link && (*link)->priority >= x->priority) link = &(*link)->next;
+    x->status = TWI_PENDING;
+    x->next = *link;
+    *link = x;
+
+    if(!active) start_next();
+  }
+  return true;
+}
+
+//==============================================================================
+// Service Queue
+//==============================================================================
+// Runs finished transactions' callbacks, oldest first, and times out a
+// transaction stuck on the bus.
+void twi_service() {
+  twi_xfer* done;
+
+  if(servicing) return;
+  servicing = true;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if(active && millis() - active_ms > TWI_TIMEOUT_MS) {
+      TWCR = 0;
+      recover_bus();
+      TWCR = _BV(TWEN) | _BV(TWIE);
+      recoveries++;
+      finish(TWI_TIMEOUT);
+    }
+  }
+
+  for(;;) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      done = finished;
+      if(done) finished = done->next;
+    }
+    if(!done) break;
+    done->next = NULL;
+    if(done->done) done->done(done);
+  }
+  servicing = false;
+}
+
+//==============================================================================
+// Wait For Transaction
+//==============================================================================
+// Blocking, for setup(); TWI_TIMEOUT_MS bounds it. Returns the status.
+uint8_t twi_wait(twi_xfer* x) {
+  while(x->status == TWI_PENDING) twi_service();
+  twi_service();
+  return x->status;
+}
+
+//==============================================================================
+// Bus Recoveries
+//==============================================================================
+uint16_t twi_recoveries() {
+  return recoveries;
+}
+
+//==============================================================================
+// Start Next Transaction
+//==============================================================================
+// Interrupts off.
+static void start_next() {
+  active = pending;
+  if(!active) return;
+  pending = active->next;
+  active->next = NULL;
+  data_index = 0;
+  active_ms = millis();
+  TWCR = TWCR_RUN | _BV(TWSTA);
+}
+
+//==============================================================================
+// Finish Active Transaction
+//==============================================================================
+// Interrupts off. Sends a stop, moves the transaction to the finished list
+// and starts the next.
+static void finish(uint8_t status) {
+  twi_xfer* x = active;
+
+  // A stop can't go out while a slave holds SCL; the timeout sorts that.
+  if(TWCR & _BV(TWEN)) {
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTO);
+    for(uint16_t i = 0; (TWCR & _BV(TWSTO)) && i < STOP_SPINS; i++);
+  }
+
+  x->status = status;
+  x->next = NULL;
+  twi_xfer* volatile* link = &finished;
+  while(*link) link = &(*link)->next;
+  *link = x;
+
+  active = NULL;
+  start_next();
+}
+
+//==============================================================================
+// Recover Bus
+//==============================================================================
+// With the TWI off, clocks SCL by hand until the slave lets go of SDA, then
+// sends a stop.
+static void recover_bus() {
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, OUTPUT);
+  for(uint8_t i = 0; i < RECOVERY_CLOCKS && !digitalRead(SDA); i++) {
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(RECOVERY_HALF_US);
+    digitalWrite(SCL, HIGH);
+    delayMicroseconds(RECOVERY_HALF_US);
+  }
+  pinMode(SDA, OUTPUT);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(RECOVERY_HALF_US);
+  digitalWrite(SCL, HIGH);
+  delayMicroseconds(RECOVERY_HALF_US);
+  digitalWrite(SDA, HIGH);
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+}
+
+//==============================================================================
+// TWI Interrupt
+//==============================================================================
+ISR(TWI_vect) {
+  twi_xfer* x = active;
+  uint8_t   status = TWSR & TW_STATUS_MASK;
+
+  if(!x) {
+    TWCR = _BV(TWEN) | _BV(TWIE);
+    return;
+  }
+
+  switch(status) {
+    case TW_START:
+      data_index = 0;
+      // A write, or the address-only ping with nothing to write or read.
+      if(x->write_len > 0 || x->read_len == 0) {
+        TWDR = x->addr << 1;
+      } else {
+        TWDR = x->addr << 1 | 1;
+      }
+      TWCR = TWCR_RUN;
+      break;
+
+    case TW_REP_START:
+      data_index = 0;
+      TWDR = x->addr << 1 | 1;
+      TWCR = TWCR_RUN;
+      break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if(data_index < x->write_len) {
+        TWDR = x->data[data_index++];
+        TWCR = TWCR_RUN;
+      } else if(x->read_len > 0) {
+        TWCR = TWCR_RUN | _BV(TWSTA);
+      } else {
+        finish(TWI_OK);
+      }
+      break;
+
+    case TW_MR_SLA_ACK:
+      TWCR = TWCR_RUN | (x->read_len > 1 ? _BV(TWEA) : 0);
+      break;
+
+    case TW_MR_DATA_ACK:
+      x->data[data_index++] = TWDR;
+      TWCR = TWCR_RUN | (data_index + 1 < x->read_len ? _BV(TWEA) : 0);
+      break;
+
+    case TW_MR_DATA_NACK:
+      x->data[data_index++] = TWDR;
+      finish(TWI_OK);
+      break;
+
+    case TW_MT_SLA_NACK:
+    case TW_MR_SLA_NACK:
+      finish(TWI_NACK_ADDR);
+      break;
+
+    case TW_MT_DATA_NACK:
+      finish(TWI_NACK_DATA);
+      break;
+
+    case TW_ARB_LOST:
+    default:
+      // Bus error or a state we never ask for; release the bus.
+      TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTO);
+      TWCR = 0;
+      TWCR = _BV(TWEN) | _BV(TWIE);
+      finish(TWI_BUS_ERROR);
+      break;
+  }
+}
+
+#endif
@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics I2C Transaction Queue
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Interrupt-driven I2C master. Drivers fill in a twi_xfer (a write, a read,
+// or a write then a repeated-start read) and submit it; the TWI interrupt
+// runs it and the next queued one without loop() waiting. High-priority
+// transactions (the ADC) go ahead of everything queued at low priority.
+//
+// Completion callbacks run from twi_service(), not the interrupt, so they
+// can submit the next transaction or touch anything loop() does. Call
+// twi_service() from every wait; it also aborts a transaction that takes
+// longer than TWI_TIMEOUT_MS and clocks the bus free, so a sensor holding
+// SCL (the AM2315 stretches it waking up) can't hang the loop until the
+// watchdog fires.
+//
+// Replaces Wire: its interrupt handler is the same vector, so nothing in a
+// plot may use Wire alongside this. Mega only.
+//
+//------------------------------------------------------------------------------
+
+#ifndef TWI_QUEUE_H
+#define TWI_QUEUE_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define TWI_FREQ           (100000UL)
+#define TWI_MAX_DATA       (8)
+#define TWI_TIMEOUT_MS     (25)
+
+#define TWI_PRIORITY_LOW   (0)
+#define TWI_PRIORITY_HIGH  (1)
+
+// Transaction status. Anything but TWI_PENDING is finished, though its
+// callback may not have run yet; drivers go by what their callbacks set.
+#define TWI_PENDING        (0)
+#define TWI_OK             (1)
+#define TWI_NACK_ADDR      (2)
+#define TWI_NACK_DATA      (3)
+#define TWI_BUS_ERROR      (4)
+#define TWI_TIMEOUT        (5)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct twi_xfer;
+typedef void (*twi_callback)(twi_xfer* x);
+
+// Owned by the driver and left alone until it finishes. data holds the
+// bytes to write, then the bytes read (from data[0]).
+struct twi_xfer {
+  uint8_t          addr;
+  uint8_t          write_len;
+  uint8_t          read_len;
+  uint8_t          priority;
+  uint8_t          data[TWI_MAX_DATA];
+  twi_callback     done;
+  void*            context;
+  volatile uint8_t status;
+  twi_xfer*        next;
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     twi_begin();
+bool     twi_submit(twi_xfer* x);
+void     twi_service();
+uint8_t  twi_wait(twi_xfer* x);
+uint16_t twi_recoveries();
+
+#endif
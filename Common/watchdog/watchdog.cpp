@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Watchdog Supervisor
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include "watchdog.h"
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Initialize Supervisor
+//==============================================================================
+void watchdog_init(watchdog_state* w) {
+  w->depth = 0;
+}
+
+//==============================================================================
+// Start Task
+//==============================================================================
+// A task started past WATCHDOG_DEPTH is timed as part of the one it's in.
+void watchdog_push(watchdog_state* w, uint8_t task, uint32_t now) {
+  watchdog_frame* f;
+
+  if(w->depth >= WATCHDOG_DEPTH) return;
+  f = &w->frames[w->depth];
+  f->task = task;
+  f->step = 0;
+  f->since_ms = now;
+  f->deadline_ms = now + watchdog_budget(task);
+  w->depth++;
+}
+
+//==============================================================================
+// Checkpoint Task
+//==============================================================================
+// Only counts for the innermost task, and only if step is new.
+void watchdog_step(watchdog_state* w, uint8_t task, uint8_t step,
+                   uint32_t now) {
+  watchdog_frame* f;
+
+  if(w->depth == 0) return;
+  f = &w->frames[w->depth - 1];
+  if(f->task != task || f->step == step) return;
+  f->step = step;
+  f->since_ms = now;
+  f->deadline_ms = now + watchdog_budget(task);
+}
+
+//==============================================================================
+// End Task
+//==============================================================================
+// Also ends anything started inside the task and not ended. The task it
+// was started from gets its budget afresh.
+void watchdog_pop(watchdog_state* w, uint8_t task, uint32_t now) {
+  uint8_t         depth = w->depth;
+  watchdog_frame* f;
+
+  while(depth > 0 && w->frames[depth - 1].task != task) depth--;
+  if(depth == 0) return;
+  w->depth = depth - 1;
+  if(w->depth == 0) return;
+
+  f = &w->frames[w->depth - 1];
+  f->since_ms = now;
+  f->deadline_ms = now + watchdog_budget(f->task);
+}
+
+//==============================================================================
+// Check Deadline
+//==============================================================================
+bool watchdog_overdue(const watchdog_state* w, uint32_t now) {
+  const watchdog_frame* f = watchdog_top(w);
+
+  return f && (int32_t)(now - f->deadline_ms) > 0;
+}
+
+//==============================================================================
+// Innermost Task
+//==============================================================================
+// NULL when nothing is supervised.
+const watchdog_frame* watchdog_top(const watchdog_state* w) {
+  if(w->depth == 0 || w->depth > WATCHDOG_DEPTH) return NULL;
+  return &w->frames[w->depth - 1];
+}
+
+//==============================================================================
+// Task Budget
+//==============================================================================
+// A switch rather than a table, so it costs no RAM and two tasks can't
+// share a number.
+uint32_t watchdog_budget(uint8_t task) {
+  switch(task) {
+#define WATCHDOG_CASE(name, num, budget) case num: return budget;
+  WATCHDOG_TASKS(WATCHDOG_CASE)
+#undef WATCHDOG_CASE
+  default: return 0;
+  }
+}
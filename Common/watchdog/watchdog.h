@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Watchdog Supervisor
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Keeps track of what the firmware is doing, so the watchdog can tell a
+// slow operation from a hung one. Every long operation is a task with its
+// own budget: the longest it may go between checkpoints. Tasks nest (the
+// ThingSpeak upload runs inside the minute's work, which runs inside the
+// loop), and only the innermost is timed, since the others can't move
+// until it's done. A checkpoint only counts as progress if its step number
+// differs from the last one, so a loop that checkpoints without getting
+// anywhere still runs out its budget.
+//
+// Plain C++: watchdog_io.h runs it from the AVR watchdog interrupt and
+// keeps the post-mortem in EEPROM.
+//
+//------------------------------------------------------------------------------
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Every supervised task: name, number and budget in ms. The number is what
+// the post-mortem records, so never renumber one.
+//
+//   LOOP     the idle loop between minutes
+//   SETUP    setup() between checkpoints
+//   DHCP     Ethernet.begin() and Ethernet.maintain(); the library's DHCP
+//            timeout is 60 s
+//   NTP      one ntp.update(), which waits up to a second per try
+//   SENSORS  read_sensors(), a checkpoint per sample
+//   SOIL     a whole TEROS discovery or reading; six probes that all need
+//            every retry take about 26 s
+//   SD       writing the minute's row, archive and summary, a checkpoint
+//            per file
+//   UPLOAD   one ThingSpeak write: DNS, connect and the 5 s response wait
+#define WATCHDOG_TASKS(X) \
+  X(WATCHDOG_LOOP,     0,  1000) \
+  X(WATCHDOG_SETUP,    1, 10000) \
+  X(WATCHDOG_DHCP,     2, 65000) \
+  X(WATCHDOG_NTP,      3,  3000) \
+  X(WATCHDOG_SENSORS,  4,  3000) \
+  X(WATCHDOG_SOIL,     5, 30000) \
+  X(WATCHDOG_SD,       6,  3000) \
+  X(WATCHDOG_UPLOAD,   7, 20000)
+
+#define WATCHDOG_DEPTH       (4)
+#define WATCHDOG_NO_TASK     (0xFF)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum watchdog_task {
+#define WATCHDOG_ENUM(name, num, budget) name = num,
+  WATCHDOG_TASKS(WATCHDOG_ENUM)
+#undef WATCHDOG_ENUM
+};
+
+struct watchdog_frame {
+  uint8_t  task;
+  uint8_t  step;         // The last checkpoint's step number.
+  uint32_t since_ms;     // When the task last made progress.
+  uint32_t deadline_ms;
+};
+
+struct watchdog_state {
+  uint8_t        depth;
+  watchdog_frame frames[WATCHDOG_DEPTH];
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+void     watchdog_init(watchdog_state* w);
+void     watchdog_push(watchdog_state* w, uint8_t task, uint32_t now);
+void     watchdog_step(watchdog_state* w, uint8_t task, uint8_t step,
+                       uint32_t now);
+void     watchdog_pop(watchdog_state* w, uint8_t task, uint32_t now);
+bool     watchdog_overdue(const watchdog_state* w, uint32_t now);
+const watchdog_frame* watchdog_top(const watchdog_state* w);
+uint32_t watchdog_budget(uint8_t task);
+
+#endif
@@ -0,0 +1,223 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Watchdog
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+// Only built for the boards; watchdog.cpp alone is plain C++.
+#ifdef ARDUINO
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <EEPROM.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+#include <eeprom_map.h>
+#include "watchdog_io.h"
+
+static_assert(sizeof(watchdog_record) <= EEPROM_WATCHDOG_SIZE,
+              "watchdog record doesn't fit its EEPROM region");
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define SHADOW_MAGIC     (0x5744)
+#define RECORD_VERSION   (1)
+
+// shadow.flags
+#define FLAG_CAUGHT      (0x01)
+#define FLAG_REBOOT      (0x02)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct watchdog_shadow {
+  uint16_t       magic;
+  uint8_t        flags;
+  uint8_t        loops;
+  uint32_t       stalled_ms;
+  watchdog_state state;
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Both survive a reset; startup only clears .bss.
+static watchdog_shadow shadow __attribute__((section(".noinit")));
+static uint8_t         reset_flags __attribute__((section(".noinit")));
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void save_reset_flags() __attribute__((naked, used, section(".init3")));
+static void save_post_mortem(watchdog_record* last);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Start Watchdog
+//==============================================================================
+// Call first thing in setup(), which is then supervised as WATCHDOG_SETUP
+// on top of WATCHDOG_LOOP. Returns true, with last filled in, if the board
+// was reset by the watchdog rather than on purpose. last's task and step
+// are filled in after any reset the task stack survived.
+//
+// The plots' stk500v2 bootloader clears MCUSR before the sketch starts, so
+// the flags are usually 0. Then a hang is told from the shadow alone: the
+// interrupt caught a task out and no planned reset followed. A watchdog
+// reset the interrupt never saw can only be told by WDRF.
+bool watchdog_begin(watchdog_record* last) {
+  bool                  kept = shadow.magic == SHADOW_MAGIC;
+  bool                  hung = kept && !(shadow.flags & FLAG_REBOOT) &&
+                               (reset_flags ? reset_flags & _BV(WDRF)
+                                            : shadow.flags & FLAG_CAUGHT);
+  const watchdog_frame* f = kept ? watchdog_top(&shadow.state) : NULL;
+
+  memset(last, 0, sizeof(*last));
+  last->version = RECORD_VERSION;
+  last->task = f ? f->task : WATCHDOG_NO_TASK;
+  last->step = f ? f->step : 0;
+  if(hung) save_post_mortem(last);
+
+  shadow.magic = SHADOW_MAGIC;
+  shadow.flags = 0;
+  shadow.loops = 0;
+  shadow.stalled_ms = 0;
+  watchdog_init(&shadow.state);
+  watchdog_push(&shadow.state, WATCHDOG_LOOP, millis());
+  watchdog_push(&shadow.state, WATCHDOG_SETUP, millis());
+
+  // WDIE can be set without the timed sequence.
+  wdt_enable(WATCHDOG_TICK);
+  WDTCSR |= _BV(WDIE);
+  return hung;
+}
+
+//==============================================================================
+// Start Task
+//==============================================================================
+void watchdog_enter(uint8_t task) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    watchdog_push(&shadow.state, task, millis());
+  }
+}
+
+//==============================================================================
+// Checkpoint Task
+//==============================================================================
+void watchdog_progress(uint8_t task, uint8_t step) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    watchdog_step(&shadow.state, task, step, millis());
+  }
+}
+
+//==============================================================================
+// End Task
+//==============================================================================
+void watchdog_leave(uint8_t task) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    watchdog_pop(&shadow.state, task, millis());
+  }
+}
+
+//==============================================================================
+// Checkpoint Loop
+//==============================================================================
+// Every pass through loop() is progress.
+void watchdog_loop() {
+  watchdog_progress(WATCHDOG_LOOP, ++shadow.loops);
+}
+
+//==============================================================================
+// Planned Reset
+//==============================================================================
+void watchdog_reboot() {
+  cli();
+  shadow.flags |= FLAG_REBOOT;
+  wdt_enable(WDTO_15MS);
+  while(1) ;
+}
+
+//==============================================================================
+// Reset Flags
+//==============================================================================
+// MCUSR as it was at startup (PORF, EXTRF, BORF, WDRF, JTRF); 0 if the
+// bootloader cleared it.
+uint8_t watchdog_reset_flags() {
+  return reset_flags;
+}
+
+//==============================================================================
+// Watchdog Interrupt
+//==============================================================================
+// Re-arms the interrupt while the innermost task is on time; otherwise
+// notes how long it stalled and lets the next timeout reset the board.
+ISR(WDT_vect) {
+  uint32_t              now = millis();
+  const watchdog_frame* f;
+
+  if(!watchdog_overdue(&shadow.state, now)) {
+    WDTCSR |= _BV(WDIE);
+    return;
+  }
+
+  f = watchdog_top(&shadow.state);
+  shadow.flags |= FLAG_CAUGHT;
+  shadow.stalled_ms = now - f->since_ms;
+}
+
+//==============================================================================
+// Save Reset Flags
+//==============================================================================
+// Runs before main(): keeps MCUSR for watchdog_begin() and turns off the
+// watchdog, which stays on at 15 ms after it resets the board. Behind a
+// bootloader that already cleared MCUSR this saves 0.
+static void save_reset_flags() {
+  reset_flags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+//==============================================================================
+// Save Post-Mortem
+//==============================================================================
+// The reset count carries on from the last record, if there is one.
+static void save_post_mortem(watchdog_record* last) {
+  watchdog_record prev;
+
+  EEPROM.get(EEPROM_WATCHDOG_ADDR, prev);
+  last->caught = shadow.flags & FLAG_CAUGHT;
+  last->resets = (prev.version == RECORD_VERSION ? prev.resets : 0) + 1;
+  last->stalled_ms = last->caught ? shadow.stalled_ms : 0;
+  EEPROM.put(EEPROM_WATCHDOG_ADDR, *last);
+}
+
+#endif
@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Watchdog
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Runs the hardware watchdog in interrupt-and-reset mode with a short
+// timeout. Each timeout runs the interrupt, which re-arms it as long as
+// the innermost task (watchdog.h) is inside its budget. Once a task runs
+// out, the interrupt is left disarmed and the next timeout resets the
+// board, so a slow ThingSpeak write no longer reboots it but a hung loop
+// is caught within a second of its budget.
+//
+// The task stack lives in RAM that startup doesn't clear, along with
+// whether the interrupt caught a task out. After a watchdog reset,
+// watchdog_begin() reads the task that hung from it and keeps it in EEPROM
+// with a count of such resets; that works without MCUSR, which the plots'
+// bootloader clears. Planned resets go through watchdog_reboot(), which
+// marks them so they aren't blamed on a task.
+//
+//------------------------------------------------------------------------------
+
+#ifndef WATCHDOG_IO_H
+#define WATCHDOG_IO_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <Arduino.h>
+#include "watchdog.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define WATCHDOG_TICK        (WDTO_250MS)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// The post-mortem of the last watchdog reset.
+struct watchdog_record {
+  uint8_t  version;
+  uint8_t  task;         // WATCHDOG_NO_TASK if nothing was supervised, or
+                         // the task stack was lost with the power.
+  uint8_t  step;
+  bool     caught;       // The interrupt saw the task run out its budget;
+                         // otherwise the interrupt itself never ran.
+  uint16_t resets;       // Watchdog resets since the EEPROM was cleared.
+  uint32_t stalled_ms;   // How long the task went without progress.
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+bool    watchdog_begin(watchdog_record* last);
+void    watchdog_enter(uint8_t task);
+void    watchdog_progress(uint8_t task, uint8_t step);
+void    watchdog_leave(uint8_t task);
+void    watchdog_loop();
+void    watchdog_reboot();
+uint8_t watchdog_reset_flags();
+
+#endif
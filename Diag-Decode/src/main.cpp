@@ -0,0 +1,301 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Diagnostic Decoder
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Turns a plot's serial output back into readable text. Binary diagnostic
+// frames are expanded with the message table in Common/diag/diag_codes.h;
+// anything else (text-mode output) is passed straight through.
+//
+//   diag_decode [-t] [-b BAUD] [PORT_OR_FILE]
+//
+//   -t       prefix every decoded line with the host's local time
+//   -b BAUD  serial baud rate when reading a port (default 9600)
+//
+// Reads stdin if no port or file is given.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <diag_codes.h>
+#include <diag_frame.h>
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct diag_entry {
+  uint8_t     code;
+  const char* text;
+};
+
+// Frame parser state.
+enum parse_state {
+  WAIT_START,
+  WAIT_CODE,
+  WAIT_TYPE,
+  WAIT_LEN,
+  WAIT_PAYLOAD,
+  WAIT_CRC
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DIAG_TABLE_ENTRY(name, code, text) {code, text},
+static const diag_entry diag_table[] = {
+  DIAG_MESSAGES(DIAG_TABLE_ENTRY)
+};
+#undef DIAG_TABLE_ENTRY
+
+static bool     print_time = false;
+static bool     line_start = true;
+static uint64_t bad_frames = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static int    open_input(const char* path, long baud);
+static void   put_text(char c);
+static void   print_frame(uint8_t code, uint8_t type, const uint8_t* payload, uint8_t len);
+static void   print_arg(uint8_t type, const uint8_t* payload, uint8_t len);
+static speed_t baud_constant(long baud);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  const char* path = NULL;
+  long        baud = 9600;
+  int         fd;
+  uint8_t     buf[256];
+  ssize_t     n;
+  parse_state state = WAIT_START;
+  uint8_t     code = 0, type = 0, len = 0, crc = 0, got = 0;
+  uint8_t     payload[DIAG_MAX_PAYLOAD];
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-t") == 0) print_time = true;
+    else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc) baud = atol(argv[++i]);
+    else if(argv[i][0] == '-') {
+      fprintf(stderr, "usage: %s [-t] [-b BAUD] [PORT_OR_FILE]\n", argv[0]);
+      return 2;
+    }
+    else path = argv[i];
+  }
+
+  fd = open_input(path, baud);
+  if(fd < 0) return 1;
+
+  while((n = read(fd, buf, sizeof(buf))) > 0) {
+    for(ssize_t i = 0; i < n; i++) {
+      uint8_t b = buf[i];
+      switch(state) {
+        case WAIT_START:
+          if(b == DIAG_FRAME_START) state = WAIT_CODE;
+          else put_text((char)b);
+          break;
+        case WAIT_CODE:
+          code = b;
+          crc = diag_crc8(0, b);
+          state = WAIT_TYPE;
+          break;
+        case WAIT_TYPE:
+          type = b;
+          crc = diag_crc8(crc, b);
+          state = WAIT_LEN;
+          break;
+        case WAIT_LEN:
+          len = b;
+          got = 0;
+          crc = diag_crc8(crc, b);
+          if(len > DIAG_MAX_PAYLOAD) {
+            bad_frames++;
+            state = WAIT_START;
+          }
+          else {
+            state = (len > 0) ? WAIT_PAYLOAD : WAIT_CRC;
+          }
+          break;
+        case WAIT_PAYLOAD:
+          payload[got++] = b;
+          crc = diag_crc8(crc, b);
+          if(got == len) state = WAIT_CRC;
+          break;
+        case WAIT_CRC:
+          if(b == crc) print_frame(code, type, payload, len);
+          else bad_frames++;
+          state = WAIT_START;
+          break;
+      }
+    }
+    fflush(stdout);
+  }
+
+  if(bad_frames > 0) {
+    fprintf(stderr, "%llu corrupt frames skipped\n", (unsigned long long)bad_frames);
+  }
+  if(fd != STDIN_FILENO) close(fd);
+  return 0;
+}
+
+//==============================================================================
+// Open Input
+//==============================================================================
+// Serial ports are switched to raw mode at the requested baud rate.
+static int open_input(const char* path, long baud) {
+  if(!path) return STDIN_FILENO;
+
+  int fd = open(path, O_RDONLY | O_NOCTTY);
+  if(fd < 0) {
+    perror(path);
+    return -1;
+  }
+
+  if(isatty(fd)) {
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, baud_constant(baud));
+    cfsetospeed(&tio, baud_constant(baud));
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+//==============================================================================
+// Pass Through Text Output
+//==============================================================================
+static void put_text(char c) {
+  if(c == '\r') return;
+  if(line_start && print_time) {
+    char stamp[32];
+    time_t t = time(NULL);
+    strftime(stamp, sizeof(stamp), "%H:%M:%S ", localtime(&t));
+    fputs(stamp, stdout);
+  }
+  putchar(c);
+  line_start = (c == '\n');
+}
+
+//==============================================================================
+// Expand Binary Frame
+//==============================================================================
+static void print_frame(uint8_t code, uint8_t type, const uint8_t* payload, uint8_t len) {
+  const char* text = NULL;
+  for(size_t i = 0; i < sizeof(diag_table) / sizeof(diag_table[0]); i++) {
+    if(diag_table[i].code == code) {
+      text = diag_table[i].text;
+      break;
+    }
+  }
+
+  // Finish any partial text line first.
+  if(!line_start) put_text('\n');
+
+  if(!text) {
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "Diag %u: ", code);
+    for(const char* p = prefix; *p; p++) put_text(*p);
+    print_arg(type, payload, len);
+    put_text('\n');
+    return;
+  }
+
+  for(const char* p = text; *p; p++) {
+    if(*p == '%') print_arg(type, payload, len);
+    else put_text(*p);
+  }
+  put_text('\n');
+}
+
+//==============================================================================
+// Print Frame Argument
+//==============================================================================
+static void print_arg(uint8_t type, const uint8_t* payload, uint8_t len) {
+  char out[64] = "";
+
+  switch(type) {
+    case DIAG_ARG_INT:
+      if(len == 4) {
+        int32_t v = (int32_t)((uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+          ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24));
+        snprintf(out, sizeof(out), "%d", v);
+      }
+      break;
+    case DIAG_ARG_FLOAT:
+      if(len == 4) {
+        float v;
+        memcpy(&v, payload, sizeof(v));
+        snprintf(out, sizeof(out), "%.2f", v);
+      }
+      break;
+    case DIAG_ARG_STR:
+      snprintf(out, sizeof(out), "%.*s", len, (const char*)payload);
+      break;
+    case DIAG_ARG_IP:
+      if(len == 4) {
+        snprintf(out, sizeof(out), "%u.%u.%u.%u",
+          payload[0], payload[1], payload[2], payload[3]);
+      }
+      break;
+    default:
+      break;
+  }
+
+  // Keep line-start tracking intact for the timestamp prefix.
+  for(const char* p = out; *p; p++) put_text(*p);
+}
+
+//==============================================================================
+// Map Baud Rate to termios Constant
+//==============================================================================
+static speed_t baud_constant(long baud) {
+  switch(baud) {
+    case 1200:   return B1200;
+    case 2400:   return B2400;
+    case 4800:   return B4800;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+    default:     return B9600;
+  }
+}
@@ -0,0 +1,718 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Fleet Simulator
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Runs many virtual plots against a local ThingSpeak-Server to size the
+// backend and see where the firmware's upload path falls behind.
+//
+//   fleet_sim [-s HOST:PORT] [-n N[,N...]] [-t SECS] [-x SPEED] [-j THREADS]
+//             [-k SKEW] [-r READ] [-l LOSS] [-D MS] [-w CONFIG]
+//
+//   -s  server (default 127.0.0.1:8080)
+//   -n  plot counts to run, one step each (default 3,30,300)
+//   -t  real seconds per step (default 30)
+//   -x  virtual seconds per real second (default 60)
+//   -j  worker threads (default 16)
+//   -k  largest clock offset between plots, in seconds (default 1)
+//   -r  virtual seconds read_sensors() takes before uploading (default 2)
+//   -l  percent of connections that fail, as a dropped link would (default 0)
+//   -D  extra real milliseconds per upload, for the W5100 path (default 0)
+//   -w  write the channel list for ThingSpeak-Server -c for the largest N
+//       and exit
+//
+// Plot i runs the Plot-((i % 3) + 1) upload schedule:
+//   every minute, after reading sensors:
+//     Plot-1  env channel when minute % 10 == 0
+//     Plot-2  env channel when minute % 10 == 0, then the PV channel
+//     Plot-3  PV channel
+//   at second 30: the debug channel, and Plot-1/2 reset at minute 5
+// Like the firmware, a plot does one thing at a time; an upload that runs
+// past second 30 misses that minute's debug write, and a failed connection
+// (-301) resets the plot. Each plot has its own MAC, channels and write
+// keys, and on loopback connects from its own 127.x.y.z address, the way
+// each board would get its own DHCP lease.
+//
+// The plots share a pool of worker threads. Queue depth is the number of
+// plots whose next action is due but not yet started, sampled every 50 ms;
+// lag is how late an action started.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <plot_log.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// ThingSpeak library results (ThingSpeak.h)
+#define TS_OK_SUCCESS            (200)
+#define TS_ERR_BAD_RESPONSE      (-301)
+#define TS_ERR_TIMEOUT           (-304)
+#define TS_ERR_NOT_INSERTED      (-401)
+#define TS_TIMEOUT_MS            (5000)
+
+// Firmware timing
+#define ENV_UPLOAD_MINUTES       (10)
+#define DEBUG_SECOND             (30)
+#define RESET_MINUTE             (5)
+#define BOOT_SECS                (15)
+#define SECS_PER_HOUR            (3600)
+
+#define MAX_FIELDS               (8)
+#define KEY_LEN                  (16)
+#define CHANNEL_BASE             (10000)
+#define SAMPLE_MS                (50)
+#define RESPONSE_LEN             (512)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum sim_channel {
+  CH_ENV,
+  CH_PV,
+  CH_DBG,
+  NUM_CHANNELS
+};
+
+enum plot_action {
+  ACT_MINUTE,                    // read sensors, then the minute's uploads
+  ACT_DEBUG                      // second-30 debug upload
+};
+
+struct virtual_plot {
+  uint32_t    index;
+  uint8_t     plot_id;
+  uint8_t     mac[6];
+  uint32_t    channels[NUM_CHANNELS];
+  char        keys[NUM_CHANNELS][KEY_LEN + 1];
+  double      skew;              // local clock minus fleet clock
+  int64_t     minute;            // last minute the loop handled
+  plot_action next;
+  double      next_local;        // when next is due, local clock
+};
+
+struct sim_event {
+  double   due;                  // fleet virtual time
+  uint32_t plot;
+
+  bool operator>(const sim_event& o) const { return due > o.due; }
+};
+
+// Per worker, merged at the end of a step.
+struct sim_stats {
+  std::vector<uint32_t> latency_us;
+  std::vector<uint32_t> lag_us;
+  uint64_t uploads;
+  uint64_t failures;
+  uint64_t missed_debug;
+  uint64_t fail_resets;
+  uint64_t hourly_resets;
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const char* const debug_columns[] = {"alive", "low_water", "free_ram"};
+
+// Options
+static sockaddr_in server;
+static double      speed = 60;
+static double      max_skew = 1;
+static double      read_secs = 2;
+static double      loss = 0;
+static int         extra_ms = 0;
+
+// Current step
+static std::vector<virtual_plot> plots;
+static std::priority_queue<sim_event, std::vector<sim_event>,
+                           std::greater<sim_event>> events;
+static std::mutex              events_lock;
+static std::condition_variable events_cv;
+static std::atomic<bool>       done;
+static std::chrono::steady_clock::time_point real_start;
+static double                  virtual_start;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void   make_fleet(uint32_t n);
+static bool   write_config(const char* path);
+static void   run_step(uint32_t n, double secs, unsigned num_threads);
+static void   worker(sim_stats* stats, unsigned seed);
+static void   run_action(virtual_plot* p, double due, sim_stats* stats,
+                         std::mt19937* rng);
+static void   schedule(virtual_plot* p, double from_local);
+static bool   upload(const virtual_plot* p, sim_channel ch, double local,
+                     sim_stats* stats, std::mt19937* rng);
+static int    post_update(const virtual_plot* p, const char* key,
+                          const float* values, uint8_t n, uint32_t* latency_us);
+static uint8_t channel_columns(uint8_t plot_id, sim_channel ch,
+                               const char* const** names);
+static float  sensor_value(const char* name, const virtual_plot* p,
+                           double local, std::mt19937* rng);
+static double virtual_now();
+static std::chrono::steady_clock::time_point real_at(double v);
+static uint32_t percentile(std::vector<uint32_t>* v, double p);
+static void   usage(const char* name);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  std::vector<uint32_t> counts = {3, 30, 300};
+  double                step_secs = 30;
+  unsigned              num_threads = 16;
+  const char*           config = NULL;
+  char                  host[64] = "127.0.0.1";
+  int                   port = 8080;
+
+  for(int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if(strcmp(argv[i], "-s") == 0 && has_value) {
+      if(sscanf(argv[++i], "%63[^:]:%d", host, &port) != 2) usage(argv[0]);
+    }
+    else if(strcmp(argv[i], "-n") == 0 && has_value) {
+      counts.clear();
+      for(char* s = strtok(argv[++i], ","); s; s = strtok(NULL, ",")) {
+        counts.push_back(strtoul(s, NULL, 10));
+      }
+    }
+    else if(strcmp(argv[i], "-t") == 0 && has_value) step_secs = atof(argv[++i]);
+    else if(strcmp(argv[i], "-x") == 0 && has_value) speed = atof(argv[++i]);
+    else if(strcmp(argv[i], "-j") == 0 && has_value) num_threads = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-k") == 0 && has_value) max_skew = atof(argv[++i]);
+    else if(strcmp(argv[i], "-r") == 0 && has_value) read_secs = atof(argv[++i]);
+    else if(strcmp(argv[i], "-l") == 0 && has_value) loss = atof(argv[++i]) / 100;
+    else if(strcmp(argv[i], "-D") == 0 && has_value) extra_ms = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-w") == 0 && has_value) config = argv[++i];
+    else usage(argv[0]);
+  }
+  if(counts.empty() || speed <= 0 || step_secs <= 0 || num_threads == 0 ||
+     read_secs < 0 || read_secs >= DEBUG_SECOND) {
+    usage(argv[0]);
+  }
+
+  if(config) {
+    make_fleet(*std::max_element(counts.begin(), counts.end()));
+    return write_config(config) ? 0 : 1;
+  }
+
+  server.sin_family = AF_INET;
+  server.sin_port = htons(port);
+  if(inet_pton(AF_INET, host, &server.sin_addr) != 1) {
+    fprintf(stderr, "bad server address '%s'\n", host);
+    return 2;
+  }
+
+  printf("%6s %9s %8s %6s %7s %7s %7s %7s %9s %6s %6s %7s %6s %6s\n",
+    "plots", "uploads", "upl/s", "fail", "p50ms", "p99ms", "p999ms", "maxms",
+    "lag99ms", "qavg", "qmax", "missed", "fails", "hourly");
+  for(uint32_t n : counts) run_step(n, step_secs, num_threads);
+  return 0;
+}
+
+//==============================================================================
+// Build Fleet
+//==============================================================================
+// Deterministic, so a config written with -w matches later runs.
+static void make_fleet(uint32_t n) {
+  std::mt19937 rng(2021);
+  std::uniform_real_distribution<double> skew(-max_skew, max_skew);
+  static const char key_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+  plots.assign(n, virtual_plot());
+  for(uint32_t i = 0; i < n; i++) {
+    virtual_plot* p = &plots[i];
+    p->index = i;
+    p->plot_id = i % NUM_PLOTS + 1;
+
+    // Locally administered MAC carrying the plot index.
+    p->mac[0] = 0x02;
+    p->mac[1] = 0x47;
+    p->mac[2] = 0x46;
+    p->mac[3] = i >> 16;
+    p->mac[4] = i >> 8;
+    p->mac[5] = i;
+
+    for(uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      p->channels[c] = CHANNEL_BASE + i * NUM_CHANNELS + c;
+      for(uint8_t k = 0; k < KEY_LEN; k++) {
+        p->keys[c][k] = key_chars[rng() % (sizeof(key_chars) - 1)];
+      }
+      p->keys[c][KEY_LEN] = 0;
+    }
+    p->skew = skew(rng);
+  }
+}
+
+//==============================================================================
+// Write Server Channel List
+//==============================================================================
+static bool write_config(const char* path) {
+  FILE* f = fopen(path, "w");
+
+  if(!f) {
+    perror(path);
+    return false;
+  }
+  fprintf(f, "# fleet_sim channels for %zu plots: CHANNEL WRITE_KEY COLUMNS\n",
+    plots.size());
+  for(const virtual_plot& p : plots) {
+    fprintf(f, "# plot %u (Plot-%u) %02X:%02X:%02X:%02X:%02X:%02X\n", p.index,
+      p.plot_id, p.mac[0], p.mac[1], p.mac[2], p.mac[3], p.mac[4], p.mac[5]);
+    for(uint8_t c = 0; c < NUM_CHANNELS; c++) {
+      const char* const* names;
+      uint8_t n = channel_columns(p.plot_id, (sim_channel)c, &names);
+      if(n == 0) continue;
+      fprintf(f, "%u %s", p.channels[c], p.keys[c]);
+      for(uint8_t i = 0; i < n; i++) fprintf(f, " %s", names[i]);
+      fprintf(f, "\n");
+    }
+  }
+  return fclose(f) == 0;
+}
+
+//==============================================================================
+// Run One Fleet Size
+//==============================================================================
+static void run_step(uint32_t n, double secs, unsigned num_threads) {
+  // Local variables.
+  std::vector<sim_stats>   stats(num_threads);
+  std::vector<std::thread> threads;
+  uint64_t                 depth_sum = 0;
+  uint64_t                 depth_max = 0;
+  uint64_t                 samples = 0;
+
+  make_fleet(n);
+  events = decltype(events)();
+  done = false;
+  real_start = std::chrono::steady_clock::now();
+  virtual_start = time(NULL);
+
+  // Every plot boots now; setup() takes the current minute as handled.
+  for(virtual_plot& p : plots) {
+    double local = virtual_start + p.skew;
+    p.minute = (int64_t)floor(local / SECS_PER_MINUTE);
+    schedule(&p, local);
+    events.push({p.next_local - p.skew, p.index});
+  }
+
+  for(unsigned i = 0; i < num_threads; i++) {
+    threads.emplace_back(worker, &stats[i], i + 1);
+  }
+
+  // Sample the queue while the step runs.
+  auto end = real_start + std::chrono::duration<double>(secs);
+  while(std::chrono::steady_clock::now() < end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(SAMPLE_MS));
+    uint64_t depth = 0;
+    {
+      std::lock_guard<std::mutex> lock(events_lock);
+      double v = virtual_now();
+      auto copy = events;
+      while(!copy.empty() && copy.top().due <= v) {
+        depth++;
+        copy.pop();
+      }
+    }
+    depth_sum += depth;
+    depth_max = std::max(depth_max, depth);
+    samples++;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(events_lock);
+    done = true;
+  }
+  events_cv.notify_all();
+  for(std::thread& t : threads) t.join();
+
+  // Merge and print.
+  sim_stats total = {};
+  for(sim_stats& s : stats) {
+    total.latency_us.insert(total.latency_us.end(), s.latency_us.begin(),
+      s.latency_us.end());
+    total.lag_us.insert(total.lag_us.end(), s.lag_us.begin(), s.lag_us.end());
+    total.uploads += s.uploads;
+    total.failures += s.failures;
+    total.missed_debug += s.missed_debug;
+    total.fail_resets += s.fail_resets;
+    total.hourly_resets += s.hourly_resets;
+  }
+  double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - real_start).count();
+
+  printf("%6u %9llu %8.1f %6llu %7.2f %7.2f %7.2f %7.2f %9.2f %6.1f %6llu "
+    "%7llu %6llu %6llu\n",
+    n, (unsigned long long)total.uploads, total.uploads / elapsed,
+    (unsigned long long)total.failures,
+    percentile(&total.latency_us, 0.50) / 1e3,
+    percentile(&total.latency_us, 0.99) / 1e3,
+    percentile(&total.latency_us, 0.999) / 1e3,
+    percentile(&total.latency_us, 1.0) / 1e3,
+    percentile(&total.lag_us, 0.99) / 1e3,
+    samples ? (double)depth_sum / samples : 0.0, (unsigned long long)depth_max,
+    (unsigned long long)total.missed_debug,
+    (unsigned long long)total.fail_resets,
+    (unsigned long long)total.hourly_resets);
+  fflush(stdout);
+}
+
+//==============================================================================
+// Worker Thread
+//==============================================================================
+// Takes whichever plot is due next, runs its action the way the firmware
+// would (blocking), and puts the plot back with its next action.
+static void worker(sim_stats* stats, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::unique_lock<std::mutex> lock(events_lock);
+
+  while(!done) {
+    if(events.empty()) {
+      events_cv.wait(lock);
+      continue;
+    }
+    sim_event e = events.top();
+    if(e.due > virtual_now()) {
+      events_cv.wait_until(lock, real_at(e.due));
+      continue;
+    }
+    events.pop();
+    lock.unlock();
+
+    virtual_plot* p = &plots[e.plot];
+    run_action(p, e.due, stats, &rng);
+
+    lock.lock();
+    events.push({p->next_local - p->skew, p->index});
+    if(events.top().plot == p->index) events_cv.notify_one();
+  }
+}
+
+//==============================================================================
+// Run Plot Action
+//==============================================================================
+static void run_action(virtual_plot* p, double due, sim_stats* stats,
+                       std::mt19937* rng) {
+  // Local variables.
+  double start = virtual_now();
+  double local = start + p->skew;
+  bool   ok = true;
+
+  stats->lag_us.push_back((uint32_t)((start - due) / speed * 1e6));
+
+  if(p->next == ACT_DEBUG) {
+    int64_t minute = (int64_t)floor(local / SECS_PER_MINUTE);
+    if(p->plot_id != 3 && minute % 60 == RESET_MINUTE) {
+      // system_reset() before the upload; setup() takes BOOT_SECS.
+      stats->hourly_resets++;
+      p->minute = (int64_t)floor((local + BOOT_SECS) / SECS_PER_MINUTE);
+      schedule(p, local + BOOT_SECS);
+      return;
+    }
+    ok = upload(p, CH_DBG, local, stats, rng);
+  }
+  else {
+    // The minute's uploads, in firmware order.
+    int64_t minute = (int64_t)floor((local - read_secs) / SECS_PER_MINUTE);
+    p->minute = minute;
+    if(p->plot_id != 3 && minute % ENV_UPLOAD_MINUTES == 0) {
+      ok = upload(p, CH_ENV, local, stats, rng);
+    }
+    if(ok && p->plot_id != 1) ok = upload(p, CH_PV, local, stats, rng);
+  }
+
+  double end_local = virtual_now() + p->skew;
+  if(!ok) {
+    stats->fail_resets++;
+    p->minute = (int64_t)floor((end_local + BOOT_SECS) / SECS_PER_MINUTE);
+    schedule(p, end_local + BOOT_SECS);
+    return;
+  }
+
+  // A debug second the loop was blocked through is never seen.
+  double first_debug = floor((local - DEBUG_SECOND) / SECS_PER_MINUTE + 1) *
+    SECS_PER_MINUTE + DEBUG_SECOND;
+  for(double d = first_debug; d < end_local; d += SECS_PER_MINUTE) {
+    stats->missed_debug++;
+  }
+  schedule(p, end_local);
+}
+
+//==============================================================================
+// Schedule Next Action
+//==============================================================================
+// From local time t: the next minute boundary (right away if the minute has
+// already changed under a long upload) or the next second 30, whichever
+// comes first.
+static void schedule(virtual_plot* p, double t) {
+  double minute_due = (p->minute + 1) * (double)SECS_PER_MINUTE;
+  if(minute_due < t) minute_due = t;
+  minute_due += read_secs;
+
+  double debug_due = floor((t - DEBUG_SECOND) / SECS_PER_MINUTE + 1) *
+    SECS_PER_MINUTE + DEBUG_SECOND;
+
+  if(debug_due < minute_due) {
+    p->next = ACT_DEBUG;
+    p->next_local = debug_due;
+  }
+  else {
+    p->next = ACT_MINUTE;
+    p->next_local = minute_due;
+  }
+}
+
+//==============================================================================
+// Upload One Channel
+//==============================================================================
+// Returns false when the firmware would reset (TS_ERR_BAD_RESPONSE).
+static bool upload(const virtual_plot* p, sim_channel ch, double local,
+                   sim_stats* stats, std::mt19937* rng) {
+  // Local variables.
+  const char* const* names;
+  float              values[MAX_FIELDS];
+  uint8_t            n = channel_columns(p->plot_id, ch, &names);
+  uint32_t           latency_us = 0;
+  int                result;
+
+  for(uint8_t i = 0; i < n; i++) values[i] = sensor_value(names[i], p, local, rng);
+  if(extra_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(extra_ms));
+
+  if(loss > 0 && std::uniform_real_distribution<double>(0, 1)(*rng) < loss) {
+    result = TS_ERR_BAD_RESPONSE;
+  }
+  else {
+    result = post_update(p, p->keys[ch], values, n, &latency_us);
+    stats->latency_us.push_back(latency_us);
+  }
+
+  stats->uploads++;
+  if(result != TS_OK_SUCCESS) stats->failures++;
+  return result != TS_ERR_BAD_RESPONSE;
+}
+
+//==============================================================================
+// POST /update
+//==============================================================================
+// Sends what ThingSpeak.writeFields() sends: a form body with the key in
+// X-THINGSPEAKAPIKEY, on a fresh connection closed after the response.
+static int post_update(const virtual_plot* p, const char* key,
+                       const float* values, uint8_t n, uint32_t* latency_us) {
+  // Local variables.
+  char   body[256];
+  char   request[768];
+  char   response[RESPONSE_LEN];
+  size_t body_len = 0;
+  size_t got = 0;
+  int    fd;
+  int    one = 1;
+  auto   t0 = std::chrono::steady_clock::now();
+
+  for(uint8_t i = 0; i < n; i++) {
+    body_len += snprintf(body + body_len, sizeof(body) - body_len,
+      "field%u=%.2f&", i + 1, values[i]);
+  }
+  body_len += snprintf(body + body_len, sizeof(body) - body_len, "headers=false");
+  int request_len = snprintf(request, sizeof(request),
+    "POST /update HTTP/1.1\r\n"
+    "Host: api.thingspeak.com\r\n"
+    "Connection: close\r\n"
+    "User-Agent: tslib-arduino/2.0.0 (fleet_sim)\r\n"
+    "X-THINGSPEAKAPIKEY: %s\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: %zu\r\n"
+    "\r\n"
+    "%s", key, body_len, body);
+
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if(fd < 0) return TS_ERR_BAD_RESPONSE;
+  timeval tv = {TS_TIMEOUT_MS / 1000, (TS_TIMEOUT_MS % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  // One source address per plot on loopback, so the fleet doesn't run one
+  // address out of ephemeral ports.
+  if((ntohl(server.sin_addr.s_addr) >> 24) == 127) {
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl((127u << 24) | ((p->mac[3] + 1u) << 16) |
+      (p->mac[4] << 8) | p->mac[5]);
+    bind(fd, (sockaddr*)&local, sizeof(local));
+  }
+
+  if(connect(fd, (sockaddr*)&server, sizeof(server)) != 0 ||
+     send(fd, request, request_len, MSG_NOSIGNAL) != request_len) {
+    close(fd);
+    return TS_ERR_BAD_RESPONSE;
+  }
+
+  for(;;) {
+    ssize_t r = recv(fd, response + got, sizeof(response) - 1 - got, 0);
+    if(r > 0) {
+      got += r;
+      if(got < sizeof(response) - 1) continue;
+    }
+    if(r < 0 && errno == EINTR) continue;
+    if(r < 0) {
+      close(fd);
+      return errno == EAGAIN || errno == EWOULDBLOCK ? TS_ERR_TIMEOUT :
+        TS_ERR_BAD_RESPONSE;
+    }
+    break;
+  }
+  close(fd);
+  *latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - t0).count();
+
+  // Status 200 and a nonzero entry ID.
+  response[got] = 0;
+  int status = 0;
+  const char* entry = strstr(response, "\r\n\r\n");
+  if(sscanf(response, "HTTP/1.%*d %d", &status) != 1 || !entry) {
+    return TS_ERR_BAD_RESPONSE;
+  }
+  if(status != 200) return -status;
+  return atol(entry + 4) > 0 ? TS_OK_SUCCESS : TS_ERR_NOT_INSERTED;
+}
+
+//==============================================================================
+// Channel Columns
+//==============================================================================
+// Which plot columns go to which channel, as each firmware sets them.
+static uint8_t channel_columns(uint8_t plot_id, sim_channel ch,
+                               const char* const** names) {
+  const plot_schema* schema = plot_schema_by_id(plot_id);
+
+  switch(ch) {
+    case CH_ENV:
+      *names = schema->columns;
+      return plot_id == 3 ? 0 : 7;
+    case CH_PV:
+      if(plot_id == 1) return 0;
+      *names = schema->columns + (plot_id == 2 ? 7 : 0);
+      return plot_id == 2 ? 3 : 4;
+    default:
+      *names = debug_columns;
+      return 3;
+  }
+}
+
+//==============================================================================
+// Simulated Sensor
+//==============================================================================
+// A clear-sky day by column type, with noise; the shade plot gets 60% of
+// the sun. Only the shape matters for load testing.
+static float sensor_value(const char* name, const virtual_plot* p,
+                          double local, std::mt19937* rng) {
+  std::normal_distribution<float> noise(0, 1);
+  double hour = fmod(local, SECS_PER_DAY) / SECS_PER_HOUR;
+  double sun = fmax(0, sin(M_PI * (hour - 6) / 12));
+  const char* kind = strrchr(name, '_');
+
+  if(!kind) {
+    // Debug channel: alive, low water, free RAM.
+    if(strcmp(name, "alive") == 0) return 1;
+    return 1200 + (p->index % 200) + noise(*rng);
+  }
+  if(strcmp(kind, "_wsqm") == 0) {
+    return 1000 * sun * (p->plot_id == 2 ? 0.6 : 1) + 10 * noise(*rng);
+  }
+  if(strcmp(kind, "_temp") == 0) return 15 + 15 * sun + noise(*rng);
+  if(strcmp(kind, "_humd") == 0) return 70 - 30 * sun + noise(*rng);
+  if(strcmp(kind, "_volw") == 0) return 30 - 5 * sun + 0.2f * noise(*rng);
+  if(strcmp(kind, "_sowp") == 0) return -30 - 40 * sun + noise(*rng);
+  return 0;
+}
+
+//==============================================================================
+// Fleet Clock
+//==============================================================================
+static double virtual_now() {
+  return virtual_start + speed * std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - real_start).count();
+}
+
+static std::chrono::steady_clock::time_point real_at(double v) {
+  return real_start + std::chrono::duration_cast<
+    std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>((v - virtual_start) / speed));
+}
+
+//==============================================================================
+// Percentile
+//==============================================================================
+static uint32_t percentile(std::vector<uint32_t>* v, double p) {
+  if(v->empty()) return 0;
+
+  size_t i = (size_t)ceil(p * v->size());
+  if(i > 0) i--;
+  std::nth_element(v->begin(), v->begin() + i, v->end());
+  return (*v)[i];
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-s HOST:PORT] [-n N[,N...]] [-t SECS] "
+    "[-x SPEED] [-j THREADS] [-k SKEW] [-r READ] [-l LOSS] [-D MS] "
+    "[-w CONFIG]\n", name);
+  exit(2);
+}
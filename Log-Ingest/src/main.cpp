@@ -0,0 +1,740 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Log Ingest
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Turns a pile of hourly MM-DD_HH.log files pulled off the plots' SD cards
+// into one time-ordered CSV per plot.
+//
+//   log_ingest [-j THREADS] [-o DIR] [-c] [-v] PATH...
+//
+//   -j  worker threads (default: all cores)
+//   -o  output directory for plot-N.csv (default: .)
+//   -c  also write each plot to a plot-N.col column store
+//   -v  list every file with its repaired YYYY-MM-DD_HH name
+//
+// PATHs are log files or directories, which are searched recursively. The
+// plot each row belongs to comes from its column count, so cards from
+// different plots can be ingested together.
+//
+// Files are memory-mapped and cut into chunks at line boundaries; workers
+// parse chunks from their own queue with the schema-specialized
+// log_scanner and steal from the others when theirs runs dry.
+//
+// The file names carry no year, so each file's year is taken from its own
+// rows, or from the nearest file in the same directory that has one. Rows
+// whose clock was obviously wrong (NTP not synced yet) are rebuilt from
+// that year, the file name and the row's minute and second. Duplicate
+// timestamps (the same card dumped twice) are dropped.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <plot_log.h>
+#include <log_scan.h>
+#include <column_store.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Files bigger than this are split across workers.
+#define CHUNK_SIZE          (1 << 20)
+
+// Years outside this range mean the plot's clock wasn't set.
+#define MIN_PLAUSIBLE_YEAR  (2020)
+
+// Share of a file's good rows that must fall in the named hour before its
+// name is trusted to repair bad-clock rows (concatenated dumps fail this).
+#define MIN_HOURLY_SHARE    (0.9)
+
+#define NO_YEAR             (0)
+
+// Most worker threads -j accepts.
+#define MAX_THREADS         (256)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+struct log_file {
+  std::string    path;
+  log_date       name_date;     // from MM-DD_HH.log, year filled in later
+  const char*    data;
+  size_t         size;
+  int            year_votes;
+  bool           hourly;        // rows really belong to the named hour
+};
+
+struct chunk {
+  uint32_t       file;
+  size_t         begin;
+  size_t         end;
+};
+
+struct ingest_row {
+  int64_t        t;
+  uint32_t       file;
+  uint8_t        plot;          // index into plot_schemas
+  bool           clock_bad;
+  log_date       date;
+  float          values[PLOT_LOG_MAX_COLUMNS];
+};
+
+struct chunk_result {
+  std::vector<ingest_row> rows;
+  uint64_t       bad_rows;
+};
+
+struct work_queue {
+  std::mutex          lock;
+  std::deque<uint32_t> chunks;
+};
+
+struct ingest_stats {
+  uint64_t       files;
+  uint64_t       bytes;
+  uint64_t       rows;
+  uint64_t       bad_rows;
+  uint64_t       repaired_rows;
+  uint64_t       dropped_rows;
+  uint64_t       duplicates[NUM_PLOTS];
+  uint64_t       plot_rows[NUM_PLOTS];
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static std::vector<log_file>     files;
+static std::vector<chunk>        chunks;
+static std::vector<chunk_result> results;
+static std::vector<work_queue>   queues;
+static std::atomic<uint64_t>     steals;
+static bool                      columnar;
+static int                       max_year;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static void add_path(const std::string& path);
+static void map_files(std::atomic<size_t>* next, std::atomic<bool>* ok);
+static bool map_file(log_file* f);
+static void make_chunks();
+static void worker(uint32_t id);
+static bool take_chunk(uint32_t id, uint32_t* c);
+static void parse_chunk(uint32_t c);
+template<uint8_t N>
+static void scan_rows(uint32_t file, const char* p, const char* end,
+                      chunk_result* res);
+static void parse_other(uint32_t file, const char* p, const char* eol,
+                        chunk_result* res);
+static uint8_t count_columns(const char* p, const char* end);
+static void repair_years(ingest_stats* stats);
+static bool write_plot(const char* dir, uint8_t plot, ingest_stats* stats);
+static bool plausible(const log_date* date);
+static double seconds_since(const timespec* start);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  const char*  out_dir = ".";
+  unsigned     num_threads = std::thread::hardware_concurrency();
+  bool         verbose = false;
+  bool         have_paths = false;
+  ingest_stats stats = {};
+  timespec     start;
+  time_t       now_t = time(NULL);
+  struct tm    now_tm;
+
+  gmtime_r(&now_t, &now_tm);
+  max_year = now_tm.tm_year + 1900 + 1;
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      const char*   arg = argv[++i];
+      char*         end;
+      unsigned long n;
+      errno = 0;
+      n = strtoul(arg, &end, 10);
+      if(errno || end == arg || *end || arg[0] == '-' ||
+         n == 0 || n > MAX_THREADS) {
+        fprintf(stderr, "bad thread count '%s' (1-%d)\n", arg, MAX_THREADS);
+        return 2;
+      }
+      num_threads = n;
+    }
+    else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      out_dir = argv[++i];
+    }
+    else if(strcmp(argv[i], "-c") == 0) {
+      columnar = true;
+    }
+    else if(strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    }
+    else {
+      add_path(argv[i]);
+      have_paths = true;
+    }
+  }
+  if(!have_paths) {
+    fprintf(stderr, "usage: %s [-j THREADS] [-o DIR] [-c] [-v] PATH...\n", argv[0]);
+    return 2;
+  }
+  if(num_threads == 0) num_threads = 1;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  // Same-directory neighbours are what the year repair looks at.
+  std::sort(files.begin(), files.end(),
+    [](const log_file& a, const log_file& b) { return a.path < b.path; });
+  // Map and parse everything in parallel.
+  std::vector<std::thread> threads;
+  std::atomic<size_t>      next_file(0);
+  std::atomic<bool>        mapped(true);
+  for(uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back(map_files, &next_file, &mapped);
+  }
+  for(std::thread& t : threads) t.join();
+  threads.clear();
+  if(!mapped) return 1;
+  for(const log_file& f : files) stats.bytes += f.size;
+  stats.files = files.size();
+
+  make_chunks();
+  results.resize(chunks.size());
+  queues = std::vector<work_queue>(num_threads);
+  for(uint32_t c = 0; c < chunks.size(); c++) {
+    // Hand out contiguous runs so each worker starts on its own files.
+    queues[(uint64_t)c * num_threads / chunks.size()].chunks.push_back(c);
+  }
+  for(uint32_t i = 0; i < num_threads; i++) threads.emplace_back(worker, i);
+  for(std::thread& t : threads) t.join();
+  threads.clear();
+  double parse_secs = seconds_since(&start);
+
+  repair_years(&stats);
+
+  if(verbose) {
+    for(const log_file& f : files) {
+      if(f.name_date.year == NO_YEAR) {
+        printf("%s -> (no year)\n", f.path.c_str());
+      }
+      else {
+        printf("%s -> %04d-%02d-%02d_%02d\n", f.path.c_str(), f.name_date.year,
+          f.name_date.month, f.name_date.day, f.name_date.hour);
+      }
+    }
+  }
+
+  // One writer per plot.
+  bool written[NUM_PLOTS];
+  for(uint8_t p = 0; p < NUM_PLOTS; p++) {
+    threads.emplace_back([&, p]() { written[p] = write_plot(out_dir, p, &stats); });
+  }
+  for(std::thread& t : threads) t.join();
+  bool ok = written[0] && written[1] && written[2];
+  uint64_t duplicates = 0;
+  for(uint8_t p = 0; p < NUM_PLOTS; p++) {
+    stats.rows += stats.plot_rows[p];
+    duplicates += stats.duplicates[p];
+  }
+  double total_secs = seconds_since(&start);
+
+  fprintf(stderr, "files:      %llu (%.1f MB)\n", (unsigned long long)stats.files,
+    stats.bytes / 1e6);
+  fprintf(stderr, "rows:       %llu (%llu unreadable, %llu clock repaired, "
+    "%llu unrepairable, %llu duplicate)\n", (unsigned long long)stats.rows,
+    (unsigned long long)stats.bad_rows, (unsigned long long)stats.repaired_rows,
+    (unsigned long long)stats.dropped_rows, (unsigned long long)duplicates);
+  for(uint8_t p = 0; p < NUM_PLOTS; p++) {
+    if(stats.plot_rows[p] == 0) continue;
+    fprintf(stderr, "plot %u:     %llu rows\n", plot_schemas[p].plot_id,
+      (unsigned long long)stats.plot_rows[p]);
+  }
+  fprintf(stderr, "parse:      %.3f s on %u threads (%.0f MB/s, %llu chunks, "
+    "%llu stolen)\n", parse_secs, num_threads, stats.bytes / 1e6 / parse_secs,
+    (unsigned long long)chunks.size(), (unsigned long long)steals.load());
+  fprintf(stderr, "total:      %.3f s\n", total_secs);
+  return ok ? 0 : 1;
+}
+
+//==============================================================================
+// Collect Log Files
+//==============================================================================
+static void add_path(const std::string& path) {
+  struct stat st;
+  log_file    f = {};
+
+  if(stat(path.c_str(), &st) != 0) {
+    perror(path.c_str());
+    return;
+  }
+
+  if(S_ISDIR(st.st_mode)) {
+    DIR* dir = opendir(path.c_str());
+    if(!dir) {
+      perror(path.c_str());
+      return;
+    }
+    while(dirent* e = readdir(dir)) {
+      if(e->d_name[0] == '.') continue;
+      std::string child = path + "/" + e->d_name;
+      struct stat cst;
+      if(stat(child.c_str(), &cst) != 0) continue;
+      if(S_ISDIR(cst.st_mode) || log_parse_name(e->d_name, &f.name_date)) {
+        add_path(child);
+      }
+    }
+    closedir(dir);
+    return;
+  }
+
+  if(!log_parse_name(path.c_str(), &f.name_date)) {
+    fprintf(stderr, "%s: not a MM-DD_HH.log file, skipping\n", path.c_str());
+    return;
+  }
+  f.path = path;
+  files.push_back(f);
+}
+
+//==============================================================================
+// File Mapping Thread
+//==============================================================================
+static void map_files(std::atomic<size_t>* next, std::atomic<bool>* ok) {
+  for(size_t i = (*next)++; i < files.size(); i = (*next)++) {
+    if(!map_file(&files[i])) *ok = false;
+  }
+}
+
+//==============================================================================
+// Memory-Map One File
+//==============================================================================
+static bool map_file(log_file* f) {
+  struct stat st;
+  int         fd = open(f->path.c_str(), O_RDONLY);
+
+  if(fd < 0 || fstat(fd, &st) != 0) {
+    perror(f->path.c_str());
+    if(fd >= 0) close(fd);
+    return false;
+  }
+
+  f->size = st.st_size;
+  f->data = NULL;
+  if(f->size > 0) {
+    void* p = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(p == MAP_FAILED) {
+      perror(f->path.c_str());
+      close(fd);
+      return false;
+    }
+    madvise(p, f->size, MADV_SEQUENTIAL);
+    f->data = (const char*)p;
+  }
+  close(fd);
+  return true;
+}
+
+//==============================================================================
+// Split Files Into Chunks
+//==============================================================================
+// A chunk owns the lines that start inside it, so boundaries need no
+// adjusting here; parse_chunk() skips the partial line at the front.
+static void make_chunks() {
+  for(uint32_t i = 0; i < files.size(); i++) {
+    for(size_t begin = 0; begin < files[i].size; begin += CHUNK_SIZE) {
+      chunk c = {i, begin, std::min(files[i].size, begin + CHUNK_SIZE)};
+      chunks.push_back(c);
+    }
+  }
+}
+
+//==============================================================================
+// Worker Thread
+//==============================================================================
+static void worker(uint32_t id) {
+  uint32_t c;
+  while(take_chunk(id, &c)) parse_chunk(c);
+}
+
+//==============================================================================
+// Take Next Chunk
+//==============================================================================
+// Own queue from the back (most recently queued, still warm), other queues
+// from the front.
+static bool take_chunk(uint32_t id, uint32_t* c) {
+  {
+    std::lock_guard<std::mutex> guard(queues[id].lock);
+    if(!queues[id].chunks.empty()) {
+      *c = queues[id].chunks.back();
+      queues[id].chunks.pop_back();
+      return true;
+    }
+  }
+
+  for(size_t n = 1; n < queues.size(); n++) {
+    work_queue& victim = queues[(id + n) % queues.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if(!victim.chunks.empty()) {
+      *c = victim.chunks.front();
+      victim.chunks.pop_front();
+      steals++;
+      return true;
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+// Parse One Chunk
+//==============================================================================
+// Rows go through the log_scanner specialized for the column count of the
+// chunk's first row; anything it rejects gets a second look from the
+// generic parser.
+static void parse_chunk(uint32_t c) {
+  // Local variables.
+  const chunk&    ch = chunks[c];
+  const log_file& f = files[ch.file];
+  chunk_result&   res = results[c];
+  const char*     p = f.data + ch.begin;
+  const char*     stop = f.data + ch.end;
+  const char*     file_end = f.data + f.size;
+
+  // The line straddling the front belongs to the previous chunk, and the
+  // one straddling the back belongs to this one.
+  if(ch.begin > 0 && p[-1] != '\n') {
+    p = (const char*)memchr(p, '\n', file_end - p);
+    p = p ? p + 1 : file_end;
+  }
+  if(stop < file_end && stop[-1] != '\n') {
+    stop = (const char*)memchr(stop, '\n', file_end - stop);
+    stop = stop ? stop + 1 : file_end;
+  }
+
+  res.bad_rows = 0;
+  if(p >= stop) return;
+  switch(count_columns(p, stop)) {
+    case 7:  scan_rows<7>(ch.file, p, stop, &res);  break;
+    case 10: scan_rows<10>(ch.file, p, stop, &res); break;
+    case 4:  scan_rows<4>(ch.file, p, stop, &res);  break;
+    default:
+      while(p < stop) {
+        const char* eol = (const char*)memchr(p, '\n', stop - p);
+        if(!eol) eol = stop;
+        parse_other(ch.file, p, eol, &res);
+        p = eol + 1;
+      }
+      break;
+  }
+}
+
+//==============================================================================
+// Scan Rows Of One Schema
+//==============================================================================
+template<uint8_t N>
+static void scan_rows(uint32_t file, const char* p, const char* end,
+                      chunk_result* res) {
+  log_scanner<N> scanner;
+  uint8_t        plot = plot_schema_by_columns(N) - plot_schemas;
+
+  scanner.scan(p, end, true,
+    [&](int64_t t, const float* values) {
+      ingest_row row;
+      row.t = t;
+      row.file = file;
+      row.plot = plot;
+      log_date_from_time(t, &row.date);
+      row.clock_bad = !plausible(&row.date);
+      memcpy(row.values, values, N * sizeof(float));
+      res->rows.push_back(row);
+    },
+    [&](const char* line, const char* eol) {
+      parse_other(file, line, eol, res);
+    });
+}
+
+//==============================================================================
+// Parse Line The Hard Way
+//==============================================================================
+// Header lines and blank lines are skipped quietly; rows of any plot are
+// kept.
+static void parse_other(uint32_t file, const char* p, const char* eol,
+                        chunk_result* res) {
+  ingest_row row;
+
+  if(eol > p && eol[-1] == '\r') eol--;
+  if(eol == p || log_is_header(p, eol)) return;
+
+  int n = log_parse_row(p, eol, &row.date, row.values, PLOT_LOG_MAX_COLUMNS);
+  const plot_schema* schema = n > 0 ? plot_schema_by_columns(n) : NULL;
+  if(!schema) {
+    res->bad_rows++;
+    return;
+  }
+
+  row.file = file;
+  row.plot = schema - plot_schemas;
+  row.clock_bad = !plausible(&row.date);
+  row.t = log_time_from_date(&row.date);
+  res->rows.push_back(row);
+}
+
+//==============================================================================
+// Count Columns Of First Row
+//==============================================================================
+static uint8_t count_columns(const char* p, const char* end) {
+  while(p < end) {
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if(!eol) eol = end;
+    if(eol - p > 1 && !log_is_header(p, eol)) {
+      return std::count(p, eol, ',');
+    }
+    p = eol + 1;
+  }
+  return 0;
+}
+
+//==============================================================================
+// Repair Years
+//==============================================================================
+static void repair_years(ingest_stats* stats) {
+  // Local variables.
+  std::vector<std::vector<int>> votes(files.size());
+  std::vector<uint64_t>         good_rows(files.size());
+
+  // Each row whose month/day/hour matches its file votes for that file's
+  // year.
+  for(const chunk_result& res : results) {
+    stats->bad_rows += res.bad_rows;
+    for(const ingest_row& row : res.rows) {
+      const log_date& name = files[row.file].name_date;
+      if(row.clock_bad) continue;
+      good_rows[row.file]++;
+      if(row.date.month == name.month && row.date.day == name.day &&
+         row.date.hour == name.hour) {
+        votes[row.file].push_back(row.date.year);
+      }
+    }
+  }
+  for(size_t i = 0; i < files.size(); i++) {
+    std::vector<int>& v = votes[i];
+    files[i].hourly = v.size() >= MIN_HOURLY_SHARE * good_rows[i];
+    if(v.empty()) continue;
+    std::sort(v.begin(), v.end());
+    int best = v[0], best_n = 0;
+    for(size_t j = 0; j < v.size();) {
+      size_t k = j;
+      while(k < v.size() && v[k] == v[j]) k++;
+      if((int)(k - j) > best_n) {
+        best = v[j];
+        best_n = k - j;
+      }
+      j = k;
+    }
+    files[i].name_date.year = best;
+    files[i].year_votes = best_n;
+  }
+
+  // Files with no usable rows borrow from the nearest neighbour in the same
+  // directory (files are sorted by path, so that's within the same season).
+  for(size_t i = 0; i < files.size(); i++) {
+    if(files[i].year_votes > 0) continue;
+    std::string dir = files[i].path.substr(0, files[i].path.rfind('/') + 1);
+    for(size_t d = 1; d < files.size(); d++) {
+      int candidates[2] = {(int)i - (int)d, (int)i + (int)d};
+      bool in_range = false;
+      for(int j : candidates) {
+        if(j < 0 || j >= (int)files.size()) continue;
+        in_range = true;
+        if(files[j].year_votes > 0 &&
+           files[j].path.compare(0, dir.size(), dir) == 0) {
+          files[i].name_date.year = files[j].name_date.year;
+          break;
+        }
+      }
+      if(files[i].name_date.year != NO_YEAR || !in_range) break;
+    }
+  }
+
+  // Rebuild rows logged with an unset clock.
+  for(chunk_result& res : results) {
+    for(ingest_row& row : res.rows) {
+      if(!row.clock_bad) continue;
+      const log_date& name = files[row.file].name_date;
+      if(name.year == NO_YEAR || !files[row.file].hourly) {
+        stats->dropped_rows++;
+        continue;
+      }
+      log_date fixed = name;
+      fixed.minute = row.date.minute;
+      fixed.second = row.date.second;
+      row.date = fixed;
+      row.t = log_time_from_date(&fixed);
+      row.clock_bad = false;
+      stats->repaired_rows++;
+    }
+  }
+}
+
+//==============================================================================
+// Merge And Write One Plot
+//==============================================================================
+// Runs on its own thread; only touches this plot's slots in stats.
+static bool write_plot(const char* dir, uint8_t plot, ingest_stats* stats) {
+  // Local variables.
+  typedef std::pair<int64_t, std::pair<uint32_t, uint32_t>> head;
+  std::vector<std::vector<const ingest_row*>> runs;
+  std::priority_queue<head, std::vector<head>, std::greater<head>> heads;
+  const plot_schema* schema = &plot_schemas[plot];
+  char        csv_path[512];
+  char        col_path[512];
+  char        date_string[LOG_TIME_LEN + 1];
+  FILE*       out;
+  col_store   store;
+  bool        ok = true;
+  int64_t     last_t = INT64_MIN;
+
+  // Gather this plot's rows as sorted runs, one per chunk.
+  for(const chunk_result& res : results) {
+    std::vector<const ingest_row*> run;
+    for(const ingest_row& row : res.rows) {
+      if(row.plot == plot && !row.clock_bad) run.push_back(&row);
+    }
+    if(run.empty()) continue;
+    std::stable_sort(run.begin(), run.end(),
+      [](const ingest_row* a, const ingest_row* b) { return a->t < b->t; });
+    runs.push_back(std::move(run));
+  }
+  if(runs.empty()) return true;
+
+  snprintf(csv_path, sizeof(csv_path), "%s/plot-%u.csv", dir,
+           schema->plot_id);
+  out = fopen(csv_path, "w");
+  if(!out) {
+    perror(csv_path);
+    return false;
+  }
+
+  fprintf(out, "time");
+  for(uint8_t i = 0; i < schema->num_columns; i++) {
+    fprintf(out, ",%s", schema->columns[i]);
+  }
+  fprintf(out, "\n");
+
+  if(columnar) {
+    snprintf(col_path, sizeof(col_path), "%s/plot-%u.col", dir,
+             schema->plot_id);
+    if(!col_create(&store, col_path, schema->plot_id, schema->num_columns,
+                   schema->columns)) {
+      fclose(out);
+      return false;
+    }
+  }
+
+  // K-way merge of the runs.
+  for(uint32_t r = 0; r < runs.size(); r++) {
+    heads.push(head(runs[r][0]->t, std::make_pair(r, 0u)));
+  }
+  while(!heads.empty()) {
+    head h = heads.top();
+    heads.pop();
+    uint32_t r = h.second.first;
+    uint32_t i = h.second.second;
+    const ingest_row* row = runs[r][i];
+    if(i + 1 < runs[r].size()) {
+      heads.push(head(runs[r][i + 1]->t, std::make_pair(r, i + 1)));
+    }
+
+    if(row->t == last_t) {
+      stats->duplicates[plot]++;
+      continue;
+    }
+    last_t = row->t;
+
+    log_format_time(row->t, date_string);
+    fputs(date_string, out);
+    for(uint8_t c = 0; c < schema->num_columns; c++) {
+      fprintf(out, ",%.2f", row->values[c]);
+    }
+    fputc('\n', out);
+    if(columnar) ok &= col_append(&store, row->t, row->values);
+    stats->plot_rows[plot]++;
+  }
+
+  if(columnar) {
+    ok &= col_sync(&store);
+    col_close(&store);
+  }
+  if(fclose(out) != 0) {
+    perror(csv_path);
+    return false;
+  }
+  return ok;
+}
+
+//==============================================================================
+// Check Row Clock
+//==============================================================================
+static bool plausible(const log_date* date) {
+  return date->year >= MIN_PLAUSIBLE_YEAR && date->year <= max_year;
+}
+
+//==============================================================================
+// Elapsed Time
+//==============================================================================
+static double seconds_since(const timespec* start) {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
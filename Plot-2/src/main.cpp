@@ -18,14 +18,30 @@
 #include <ThingSpeak.h>
 #include <NTPClient.h>
 #include <OneWire.h>
-#include <DallasTemperature.h>
+#include <ds18b20_read.h>
 #include <SD.h>
-#include <Adafruit_ADS1X15.h>
-#include <Adafruit_AM2315.h>
+#include <twi_queue.h>
+#include <ads1115.h>
+#include <am2315_io.h>
 #include <SDI12.h>
+#include <sdi12_port.h>
+#include <teros.h>
+#include <teros_sd.h>
+#include <soil_physics.h>
 #include <Time.h>
 #include <TimeLib.h>
-#include <avr/wdt.h>
+#include <watchdog_io.h>
+#include <reset_log_io.h>
+#include <archive_sd.h>
+#include <raw_capture_sd.h>
+#include <daily_summary.h>
+#include <daily_summary_io.h>
+#include <ram_monitor.h>
+#include <diag.h>
+#include <sensor_calc.h>
+#include <calibration.h>
+#include <relay_tx.h>
+#include <load_rules.h>
 #include "secrets.h"
 
 //------------------------------------------------------------------------------
@@ -48,6 +64,7 @@
 #define TMPH_1_HUMD_FIELD   (5)
 #define IRAD_1_WSQM_FIELD   (6)
 #define SOIL_3_SOWP_FIELD   (7)
+#define SOIL_1_PWEC_FIELD   (8)
 
 // ThingSpeak PV Fields
 #define NUM_FIELDS_PV       (3)
@@ -55,24 +72,69 @@
 #define TEMP_3_TEMP_FIELD   (2)
 #define TEMP_4_TEMP_FIELD   (3)
 
+// ThingSpeak Debug Fields
+#define DBG_ALIVE_FIELD     (1)
+#define DBG_LOW_WATER_FIELD (2)
+#define DBG_FREE_RAM_FIELD  (3)
+// Sent with the first debug write after a reset's event is stored; the
+// debug channel needs these fields added first.
+#define DBG_RESET_FIELD     (4)
+#define DBG_DOWNTIME_FIELD  (5)
+#define DBG_UPTIME_FIELD    (6)
+#define DBG_UNPLANNED_FIELD (7)
+#define DBG_DOWN_SUM_FIELD  (8)
+
 // Pin Definitions
 #define ONE_WIRE_PIN        (2)
 #define SD_CS_PIN           (4)
 #define RELAY_TRIG_PIN      (7)
 #define SDI_12_PIN          (62)
 
+// Soil numbers (as in the log columns) of the first TEROS-12 and TEROS-21
+// found; other probes only go to the .sdi file.
+#define SOIL_12_NUM         (1)
+#define SOIL_21_NUM         (3)
+
+// What the plot's TEROS-12s are buried in (soil_physics.h).
+#define SOIL_SUBSTRATE      (SOIL_MINERAL)
+
 // Sensor Parameters
 #define TEMP_PRECISION      (12)
+#define NUM_TEMP_BUSES      (1)
+#define NUM_TEMP_PROBES     (4)
 
 // Program Parameters
 #define TIME_ZONE           (-7)
 #define SECS_PER_HOUR       (3600)
-#define NUM_SAMPLES         (20)
+#define NUM_SAMPLES         (SENSOR_NUM_SAMPLES)
 #define NTP_SYNC_INTERVAL   (600)
 
+// Archive Parameters
+#define PLOT_ID             (2)
+#define ARCHIVE_COLUMNS     (10)
+
+// Daily Summary Parameters
+#define IRAD_COLUMN         (5)
+#define SUNSHINE_WSQM       (120.0f)
+#define HEAT_STRESS_TEMP    (35.0f)
+#define HUMID_HUMD          (90.0f)
+#define PV_HOT_TEMP         (45.0f)
+
 // Debug Parameters
+#define DIAG_MODE           (DIAG_TEXT)
 #define FAIL_RESET
 #define THINGSPEAK_DEBUG
+// Sends pore-water EC as environmental field 8; the channel needs the field
+// added first.
+// #define THINGSPEAK_SOIL_EC
+#define RAW_CAPTURE
+
+// Raw capture calls compile away when RAW_CAPTURE is off.
+#ifdef RAW_CAPTURE
+  #define CAPTURE(call) call
+#else
+  #define CAPTURE(call)
+#endif
 
 //------------------------------------------------------------------------------
 //     ___      __   ___  __   ___  ___  __
@@ -101,32 +163,78 @@ int32_t              thingspeak_response = 0;
 
 // Sensor Objects
 OneWire              oneWire(ONE_WIRE_PIN);
-DallasTemperature    temp_sensors(&oneWire);
-DeviceAddress        temp_1_addr = {TEMP_1_ADDR_0, TEMP_1_ADDR_1, TEMP_1_ADDR_2, TEMP_1_ADDR_3,
-                                    TEMP_1_ADDR_4, TEMP_1_ADDR_5, TEMP_1_ADDR_6, TEMP_1_ADDR_7};
-DeviceAddress        temp_2_addr = {TEMP_2_ADDR_0, TEMP_2_ADDR_1, TEMP_2_ADDR_2, TEMP_2_ADDR_3,
-                                    TEMP_2_ADDR_4, TEMP_2_ADDR_5, TEMP_2_ADDR_6, TEMP_2_ADDR_7};
-DeviceAddress        temp_3_addr = {TEMP_3_ADDR_0, TEMP_3_ADDR_1, TEMP_3_ADDR_2, TEMP_3_ADDR_3,
-                                    TEMP_3_ADDR_4, TEMP_3_ADDR_5, TEMP_3_ADDR_6, TEMP_3_ADDR_7};
-DeviceAddress        temp_4_addr = {TEMP_4_ADDR_0, TEMP_4_ADDR_1, TEMP_4_ADDR_2, TEMP_4_ADDR_3,
-                                    TEMP_4_ADDR_4, TEMP_4_ADDR_5, TEMP_4_ADDR_6, TEMP_4_ADDR_7};
-
-Adafruit_AM2315      am2315;
-Adafruit_ADS1115     ads;
-
-static const char    date_string[23];
-static const char    file_name[12];
+// secrets.h addresses only seed the binding; after that probes are bound
+// at boot from the EEPROM cache.
+static const onewire_rom temp_defaults[NUM_TEMP_PROBES] = {
+  {TEMP_1_ADDR_0, TEMP_1_ADDR_1, TEMP_1_ADDR_2, TEMP_1_ADDR_3,
+   TEMP_1_ADDR_4, TEMP_1_ADDR_5, TEMP_1_ADDR_6, TEMP_1_ADDR_7},
+  {TEMP_2_ADDR_0, TEMP_2_ADDR_1, TEMP_2_ADDR_2, TEMP_2_ADDR_3,
+   TEMP_2_ADDR_4, TEMP_2_ADDR_5, TEMP_2_ADDR_6, TEMP_2_ADDR_7},
+  {TEMP_3_ADDR_0, TEMP_3_ADDR_1, TEMP_3_ADDR_2, TEMP_3_ADDR_3,
+   TEMP_3_ADDR_4, TEMP_3_ADDR_5, TEMP_3_ADDR_6, TEMP_3_ADDR_7},
+  {TEMP_4_ADDR_0, TEMP_4_ADDR_1, TEMP_4_ADDR_2, TEMP_4_ADDR_3,
+   TEMP_4_ADDR_4, TEMP_4_ADDR_5, TEMP_4_ADDR_6, TEMP_4_ADDR_7}
+};
+// One entry per one-wire bus, probes numbered bus by bus as above.
+ds18b20_bus          temp_buses[NUM_TEMP_BUSES] = {{&oneWire, NUM_TEMP_PROBES}};
+ds18b20_array        temp_probes;
+
+SDI12                sdi(SDI_12_PIN);
+sdi12_port           sdi_port;
+sdi12_xact           sdi_xact;
+teros_probes         soil;
+static const soil_config soil_config_1 = {SOIL_SUBSTRATE, &teros_12_cal[1]};
+
+am2315_sensor        ambient;
+ads1115              ads;
+
+static char          date_string[24];
+static char          file_name[13];
 
 File                 log_file;
 
+archive_writer       archive;
+static char          archive_name[13];
+static float         archive_values[ARCHIVE_COLUMNS];
+
+// Sunshine is irradiance over the WMO 120 W/m^2; the others are minutes
+// of heat stress, saturated air and hot panels.
+static const float   summary_thresholds[ARCHIVE_COLUMNS] = {
+  NAN, NAN, NAN, HEAT_STRESS_TEMP, HUMID_HUMD, SUNSHINE_WSQM, NAN,
+  PV_HOT_TEMP, PV_HOT_TEMP, PV_HOT_TEMP
+};
+static const daily_config summary_config = {PLOT_ID, ARCHIVE_COLUMNS, IRAD_COLUMN,
+                                            summary_thresholds};
+daily_summary        summary;
+
+#ifdef RAW_CAPTURE
+raw_capture          capture;
+static char          capture_name[13];
+
+// Each record's length goes in one byte.
+static_assert(NUM_SAMPLES * sizeof(int16_t) <= RAW_MAX_PAYLOAD,
+              "ADC record too long for raw capture");
+static_assert(AM2315_MAX_READINGS * 2 * sizeof(int16_t) <= RAW_MAX_PAYLOAD,
+              "AM2315 record too long for raw capture");
+static_assert(NUM_SAMPLES * NUM_TEMP_PROBES * sizeof(int16_t) <=
+              RAW_MAX_PAYLOAD, "DS18B20 record too long for raw capture");
+#endif
+
 time_t               cur_time;
 time_t               prev_time;
 
+// Load Scheduling
+load_schedule        scheduler;
+static relay_cmd     load_cmds[LOAD_SCHEDULE_MAX_RULES];
+static uint8_t       num_load_cmds;
+static uint8_t       next_load_cmd;
+
 // Sensor Data
 double               soil_1_volw;
 double               soil_3_sowp;
 
 float                soil_1_temp;
+soil_reading         soil_1_phys;
 
 float                temp_1_temp;
 
@@ -150,10 +258,12 @@ float                temp_4_temp;
 
 time_t get_ntp_time();
 void   read_sensors();
+void   schedule_loads();
 bool   create_log_file();
-bool   teros_12_read(double *vwc, float *temp, uint16_t *conductivity);
-bool   teros_21_read(double *matric_potential, float *temp);
-void   system_reset();
+void   soil_discover();
+void   soil_read();
+uint8_t soil_capture_id(const teros_probe* p);
+void   system_reset(uint8_t cause);
 
 //------------------------------------------------------------------------------
 //      __        __          __
@@ -168,18 +278,33 @@ void   system_reset();
 void setup() {
   // Basic system setup.
   Serial.begin(9600);
-  wdt_enable(WDTO_4S);
-  pinMode(RELAY_TRIG_PIN, OUTPUT);
-  digitalWrite(RELAY_TRIG_PIN, HIGH);
+  diag_begin(DIAG_MODE);
+
+  // Supervise setup, and report the task that hung if the watchdog reset
+  // the board. The reset itself is logged once a minute is logged again.
+  watchdog_record hang;
+  bool            hung = watchdog_begin(&hang);
+  if(hung) {
+    diag_int(DIAG_WATCHDOG_TASK, hang.task);
+    diag_int(DIAG_WATCHDOG_STEP, hang.step);
+    if(hang.caught) diag_int(DIAG_WATCHDOG_STALL, hang.stalled_ms);
+    diag_int(DIAG_WATCHDOG_RESETS, hang.resets);
+  }
+  reset_log_begin(&hang, hung);
+  relay_tx_begin(RELAY_TRIG_PIN);
+  load_schedule_init(&scheduler, load_rules, NUM_LOAD_RULES,
+    LOAD_SMOOTHING_MINUTES);
 
   // Initialize internet connection.
+  watchdog_enter(WATCHDOG_DHCP);
   Ethernet.begin(mac);
+  watchdog_leave(WATCHDOG_DHCP);
   #ifdef ONEDOT
   Ethernet.setDnsServerIP(onedot);
   #endif
-  Serial.println(Ethernet.localIP());
-  Serial.println(Ethernet.linkStatus());
-  wdt_reset();
+  diag_ip(DIAG_LOCAL_IP, Ethernet.localIP());
+  diag_int(DIAG_LINK_STATUS, Ethernet.linkStatus());
+  watchdog_progress(WATCHDOG_SETUP, 1);
 
   // Initialize ThingSpeak.
   ThingSpeak.begin(client);
@@ -187,31 +312,47 @@ void setup() {
   // Initialize NTP.
   udp.begin(2390);
   ntp.begin();
+  watchdog_enter(WATCHDOG_NTP);
   ntp.update();
+  watchdog_leave(WATCHDOG_NTP);
   setSyncProvider(get_ntp_time);
   setSyncInterval(NTP_SYNC_INTERVAL);
   cur_time = now();
   prev_time = now();
-  Serial.println(ntp.getFormattedTime());
-  wdt_reset();
-
-  // Initialize sensors.
-  temp_sensors.begin();
-  Serial.println("Temp sensors initialized");
-  Serial.print(temp_sensors.getDeviceCount());
-  Serial.println(" sensors found");
-  am2315.begin();
-  Serial.println("Ambient temp sensor initialized");
-  ads.begin();
-  Serial.println("ADC initialized");
+  diag_str(DIAG_NTP_TIME, ntp.getFormattedTime().c_str());
+  watchdog_progress(WATCHDOG_SETUP, 2);
+
+  // Initialize sensors. A bus is only searched if a bound probe
+  // doesn't answer; any probe that changes role is reported.
+  uint32_t rebound;
+  uint8_t  temp_count = ds18b20_begin(&temp_probes, temp_buses,
+    NUM_TEMP_BUSES, temp_defaults, TEMP_PRECISION, &rebound);
+  diag(DIAG_TEMP_INIT);
+  diag_int(DIAG_TEMP_COUNT, temp_count);
+  for(uint8_t r = 0; r < NUM_TEMP_PROBES; r++) {
+    if(rebound & (1UL << r)) diag_int(DIAG_TEMP_REBOUND, r);
+  }
+  twi_begin();
+  am2315_begin(&ambient);
+  diag(DIAG_AMBIENT_INIT);
+  ads1115_init(&ads, ADS1115_ADDR);
+  diag(DIAG_ADC_INIT);
   sdi.begin();
-  Serial.println("SDI-12 bus initialized");
-  wdt_reset();
+  sdi12_port_init(&sdi_port, &sdi);
+  sdi12_init(&sdi_xact, &sdi_port);
+  diag(DIAG_SDI_INIT);
+  teros_init(&soil, &sdi_xact);
+  soil_discover();
+  watchdog_progress(WATCHDOG_SETUP, 3);
 
   // Initialize SD card.
   SD.begin(SD_CS_PIN);
   create_log_file();
-  wdt_reset();
+  watchdog_progress(WATCHDOG_SETUP, 4);
+
+  // Pick up today's summary where the last reset left it.
+  if(daily_load(&summary, &summary_config)) diag(DIAG_SUMMARY_RESTORED);
+  watchdog_leave(WATCHDOG_SETUP);
 }
 
 //==============================================================================
@@ -219,7 +360,8 @@ void setup() {
 //==============================================================================
 void loop() {
   // Get current time.
-  wdt_reset();
+  watchdog_loop();
+  am2315_service(&ambient);
   prev_time = cur_time;
   cur_time  = now();
 
@@ -227,28 +369,25 @@ void loop() {
   if(minute(prev_time) != minute(cur_time)) {
     if(minute(cur_time) == 0) {
       create_log_file();
-    }
 
-    // If it is the start of a new hour between 9:00 and 17:00, inclusive...
-    if(minute(cur_time) == 0 && (hour(cur_time) >= 9 && hour(cur_time) <= 17)) {
-      // Send load enable sequence.
-      Serial.println("Enabling loads");
-      digitalWrite(RELAY_TRIG_PIN, LOW);
-      delay(20);
-      digitalWrite(RELAY_TRIG_PIN, HIGH);
-      delay(20);
-      digitalWrite(RELAY_TRIG_PIN, LOW);
-      delay(20);
-      digitalWrite(RELAY_TRIG_PIN, HIGH);
+      // Look for probes again if one went missing or was plugged in late.
+      if(soil.num_failed || !teros_find(&soil, TEROS_12, 0) ||
+         !teros_find(&soil, TEROS_21, 0)) {
+        soil_discover();
+      }
     }
 
     // Read system sensors.
-    Serial.println("Reading sensors");
+    diag(DIAG_READING_SENSORS);
     read_sensors();
-    wdt_reset();
+    ram_print_usage();
+
+    // Decide which loads should run from the fresh readings.
+    schedule_loads();
 
     // Log new sensor data to SD card, getting current time first.
-    Serial.println("Writing to card");
+    diag(DIAG_WRITING_CARD);
+    watchdog_enter(WATCHDOG_SD);
     time_t t = now();
     sprintf(date_string, "%04d-%02d-%02d %02d:%02d:%02d PDT",
       year(t), month(t), day(t), hour(t), minute(t), second(t));
@@ -274,13 +413,48 @@ void loop() {
     log_file.print(",");
     log_file.println(temp_4_temp);
     log_file.flush();
-    wdt_reset();
+    if(!teros_write(&soil, &soil_config_1, t, date_string)) {
+      diag(DIAG_SOIL_WRITE_FAIL);
+    }
+    watchdog_progress(WATCHDOG_SD, 1);
+
+    // Append the same row to the compressed archive.
+    archive_values[0] = soil_1_volw;
+    archive_values[1] = soil_1_temp;
+    archive_values[2] = temp_1_temp;
+    archive_values[3] = tmph_1_temp;
+    archive_values[4] = tmph_1_humd;
+    archive_values[5] = irad_1_wsqm;
+    archive_values[6] = soil_3_sowp;
+    archive_values[7] = temp_2_temp;
+    archive_values[8] = temp_3_temp;
+    archive_values[9] = temp_4_temp;
+    if(!archive_writer_append(&archive, t, archive_values)) {
+      diag(DIAG_ARCHIVE_WRITE_FAIL);
+    }
+    watchdog_progress(WATCHDOG_SD, 2);
+
+    // Fold the row into the day's summary. The first row of a new day
+    // writes out the finished one.
+    if(!daily_same_day(&summary, t)) {
+      if(daily_matches(&summary, &summary_config) && !daily_write(&summary)) {
+        diag(DIAG_SUMMARY_WRITE_FAIL);
+      }
+      daily_begin(&summary, &summary_config, t);
+    }
+    daily_add(&summary, &summary_config, archive_values);
+    if(minute(t) % DAILY_SAVE_MINUTES == 0) daily_save(&summary);
+    watchdog_leave(WATCHDOG_SD);
+
+    // The first minute logged after a reset stores the reset's event.
+    if(reset_log_mark(t, thingspeak_response, ram_free())) {
+      reset_log_print(reset_log_unsent());
+    }
 
     // Before attempting to upload to ThingSpeak,
     // log status of internet connection.
-    Serial.println(Ethernet.linkStatus());
-    Serial.println(Ethernet.hardwareStatus());
-    wdt_reset();
+    diag_int(DIAG_LINK_STATUS, Ethernet.linkStatus());
+    diag_int(DIAG_HARDWARE_STATUS, Ethernet.hardwareStatus());
 
     // If the current minute is a multiple of 10,
     // upload environmental data to ThingSpeak.
@@ -294,17 +468,23 @@ void loop() {
       ThingSpeak.setField(TMPH_1_HUMD_FIELD, tmph_1_humd);
       ThingSpeak.setField(IRAD_1_WSQM_FIELD, irad_1_wsqm);
       ThingSpeak.setField(SOIL_3_SOWP_FIELD, (float)soil_3_sowp);
+      #ifdef THINGSPEAK_SOIL_EC
+        if(soil_1_phys.pore_ec != SOIL_NO_PORE_EC) {
+          ThingSpeak.setField(SOIL_1_PWEC_FIELD, soil_1_phys.pore_ec);
+        }
+      #endif
 
       // Attempt ThingSpeak upload.
-      Serial.println("Sending environmental data to ThingSpeak");
+      diag(DIAG_SENDING_ENV);
+      watchdog_enter(WATCHDOG_UPLOAD);
       thingspeak_response = ThingSpeak.writeFields(
         PLOT_2_ENV_CHANNEL, plot_2_env_api_key);
-      Serial.println(thingspeak_response);
-      wdt_reset();
+      watchdog_leave(WATCHDOG_UPLOAD);
+      diag_int(DIAG_THINGSPEAK_RESP, thingspeak_response);
 
       #ifdef FAIL_RESET
         // Reset system if -301 error encountered
-        if(thingspeak_response == THINGSPEAK_FAIL) system_reset();
+        if(thingspeak_response == THINGSPEAK_FAIL) system_reset(RESET_UPLOAD);
       #endif
     }
 
@@ -314,15 +494,16 @@ void loop() {
     ThingSpeak.setField(TEMP_4_TEMP_FIELD, temp_4_temp);
 
     // Attempt ThingSpeak upload.
-    Serial.println("Sending PV data to ThingSpeak");
+    diag(DIAG_SENDING_PV);
+    watchdog_enter(WATCHDOG_UPLOAD);
     thingspeak_response = ThingSpeak.writeFields(
       PLOT_2_PV_CHANNEL, plot_2_pv_api_key);
-    Serial.println(thingspeak_response);
-    wdt_reset();
+    watchdog_leave(WATCHDOG_UPLOAD);
+    diag_int(DIAG_THINGSPEAK_RESP, thingspeak_response);
 
     #ifdef FAIL_RESET
       // Reset system if -301 error encountered
-      if(thingspeak_response == THINGSPEAK_FAIL) system_reset();
+      if(thingspeak_response == THINGSPEAK_FAIL) system_reset(RESET_UPLOAD);
     #endif
 
   }
@@ -331,19 +512,55 @@ void loop() {
   // If the 30th second of the minute has just begun,
   // write to debug channel
   if(second(cur_time) == 30 && second(prev_time) == 29) {
-    if(minute(cur_time) == 5) system_reset();
-    thingspeak_response = ThingSpeak.writeField(
-      PLOT_2_DBG_CHANNEL, 1, 1, PLOT_2_DBG_API_KEY);
+    if(minute(cur_time) == 5) system_reset(RESET_HOURLY);
+    ThingSpeak.setField(DBG_ALIVE_FIELD, 1);
+    ThingSpeak.setField(DBG_LOW_WATER_FIELD, ram_low_water());
+    ThingSpeak.setField(DBG_FREE_RAM_FIELD, ram_free());
+    // The first write after a reset's event is stored also reports it.
+    const reset_event* last_reset = reset_log_unsent();
+    if(last_reset) {
+      ThingSpeak.setField(DBG_RESET_FIELD, last_reset->cause);
+      if(reset_downtime(last_reset) != RESET_NO_TIME) {
+        ThingSpeak.setField(DBG_DOWNTIME_FIELD,
+                            (long)reset_downtime(last_reset));
+      }
+      if(last_reset->uptime_s != RESET_NO_TIME) {
+        ThingSpeak.setField(DBG_UPTIME_FIELD, (long)last_reset->uptime_s);
+      }
+      ThingSpeak.setField(DBG_UNPLANNED_FIELD, reset_unplanned(last_reset));
+      ThingSpeak.setField(DBG_DOWN_SUM_FIELD,
+                          (long)reset_total_down(last_reset));
+    }
+    watchdog_enter(WATCHDOG_UPLOAD);
+    thingspeak_response = ThingSpeak.writeFields(
+      PLOT_2_DBG_CHANNEL, PLOT_2_DBG_API_KEY);
+    watchdog_leave(WATCHDOG_UPLOAD);
+    if(last_reset && thingspeak_response == THINGSPEAK_SUCCESS) {
+      reset_log_sent();
+    }
 
     #ifdef FAIL_RESET
       // Reset system if -301 error encountered
-      if(thingspeak_response == THINGSPEAK_FAIL) system_reset();
+      if(thingspeak_response == THINGSPEAK_FAIL) system_reset(RESET_UPLOAD);
     #endif
   }
   #endif
 
+  // Play out queued load commands one frame at a time; each waveform runs
+  // in the background.
+  if(next_load_cmd < num_load_cmds &&
+     relay_tx_send(load_cmds[next_load_cmd].loads,
+                   load_cmds[next_load_cmd].minutes)) {
+    next_load_cmd++;
+  }
+
+  // Write out raw capture data outside the minute's work.
+  CAPTURE(raw_capture_service(&capture));
+
   // Maintain Ethernet connection.
+  watchdog_enter(WATCHDOG_DHCP);
   Ethernet.maintain();
+  watchdog_leave(WATCHDOG_DHCP);
 }
 
 // Provides the time library with the current real-world time
@@ -351,7 +568,9 @@ void loop() {
 // Returns a time_t type... not sure what it is (time, presumably) just basing format off the example code
 time_t get_ntp_time()
 {
+  watchdog_enter(WATCHDOG_NTP);
   ntp.update();
+  watchdog_leave(WATCHDOG_NTP);
   // Return seconds since Jan. 1 1970, adjusted for time zone in seconds.
   return ntp.getEpochTime();
 }
@@ -360,116 +579,148 @@ time_t get_ntp_time()
 // Read Sensor Data
 //==============================================================================
 void read_sensors() {
+  watchdog_enter(WATCHDOG_SENSORS);
+  CAPTURE(raw_capture_frame(&capture, PLOT_ID, now()));
 
   // Sensor sampling loop.
   // Irradiance.
   int32_t irad_samples = 0;
+  CAPTURE(raw_capture_begin(&capture, RAW_REC_ADC, 1, NUM_SAMPLES * sizeof(int16_t)));
   for (uint8_t i = 0; i < NUM_SAMPLES; i++) {
-    irad_samples += ads.readADC_SingleEnded(0);
+    // The AM2315 gets the bus while the ADC converts.
+    ads1115_start(&ads, 0);
+    while (!ads1115_poll(&ads)) am2315_service(&ambient);
+    int16_t irad_counts = ads.counts;
+    irad_samples += irad_counts;
+    CAPTURE(raw_capture_put(&capture, &irad_counts, sizeof(irad_counts)));
     delayMicroseconds(100);
   }
 
   // Report the average of the samples we gathered.
-  irad_1_wsqm = (irad_samples < 0) ? 0 : irad_samples / NUM_SAMPLES;
+  irad_1_wsqm = irad_mean_counts(irad_samples, NUM_SAMPLES);
   // Convert ADC counts to W/m^2.
-  irad_1_wsqm = (float)((-8E-10 * pow(irad_1_wsqm, 4)) +
-    (3E-6 * pow(irad_1_wsqm, 3)) - (3.02E-3 * pow(irad_1_wsqm, 2)) +
-    (1.1024 * (double)irad_1_wsqm));
-  Serial.print("Irradiance: ");
-  Serial.println(irad_1_wsqm);
-
-  // Sensor sampling.
-  // Soil stuff.
-  // Only use one sample for these because they're fancy
-  uint16_t conductivity;
-  float temp_12, temp_21;
-  double vwc_counts, matric_potential;
-  wdt_reset();
-
-  // Read from TEROS 12.
-  if(teros_12_read(&vwc_counts, &temp_12, &conductivity)) {
-    // Convert ADC counts to volumetric water content using Equation 6 from
-    // TEROS 12 user manual 4.1.1.
-    soil_1_volw = (0.0003879 * vwc_counts) - 0.6956;
-    soil_1_temp = temp_12;
-
-    // Print soil VWC and temperature.
-    Serial.print("Soil VWC: ");
-    Serial.println(soil_1_volw);
-    Serial.print("Soil Temp: ");
-    Serial.println(soil_1_temp);
+  irad_1_wsqm = irad_wsqm(irad_1_wsqm, &irad_cal[1]);
+  diag_int(DIAG_IRAD, irad_1_wsqm);
+  if(ads.errors) diag_int(DIAG_ADC_ERRORS, ads.errors);
+  if(twi_recoveries()) diag_int(DIAG_I2C_RECOVERIES, twi_recoveries());
+
+  // Soil probes, all measuring at once. The plot logs the first TEROS-12
+  // and TEROS-21.
+  const teros_probe* teros_12 = teros_find(&soil, TEROS_12, 0);
+  const teros_probe* teros_21 = teros_find(&soil, TEROS_21, 0);
+  float soil_values[TEROS_NUM_VALUES];
+  watchdog_progress(WATCHDOG_SENSORS, 1);
+  soil_read();
+
+  if(teros_12 && teros_values(teros_12, soil_values)) {
+    // Convert counts to volumetric water content.
+    soil_1_volw = soil_volw(&soil_config_1, soil_values[0]);
+    soil_1_temp = soil_values[1];
+
+    // Bulk EC at 25 C and pore-water EC from the conductivity.
+    soil_compute(&soil_config_1, soil_values[0], soil_values[1],
+                 (uint16_t)soil_values[2], &soil_1_phys);
+
+    // Print soil VWC, temperature and EC.
+    diag_float(DIAG_SOIL_VWC, soil_1_volw);
+    diag_float(DIAG_SOIL_TEMP, soil_1_temp);
+    diag_int(DIAG_SOIL_BULK_EC, soil_1_phys.bulk_ec);
+    diag_int(DIAG_SOIL_PORE_EC, soil_1_phys.pore_ec);
   }
   else {
-    Serial.println("TEROS-12 Error!");
+    diag(DIAG_TEROS_12_ERROR);
   }
-  wdt_reset();
 
-  // Read from TEROS 21
-  if(teros_21_read(&matric_potential, &temp_21)) {
-    soil_3_sowp = matric_potential;
-    Serial.print("Soil Matric Potential: ");
-    Serial.println(soil_3_sowp);
+  if(teros_21 && teros_values(teros_21, soil_values)) {
+    soil_3_sowp = soil_values[0];
+    diag_float(DIAG_SOIL_SOWP, soil_3_sowp);
   }
   else {
-    Serial.println("TEROS-21 Error!");
+    diag(DIAG_TEROS_21_ERROR);
   }
-  wdt_reset();
+  if(sdi_xact.retries) diag_int(DIAG_SDI_RETRIES, sdi_xact.retries);
+  watchdog_progress(WATCHDOG_SENSORS, 2);
 
-  // Sensor sampling loop.
-  // Ambient temperature and humidity.
-  float amb_hum_samples = 0;
-  float amb_temp_samples = 0;
-  float amb_temp, amb_hum;
-  for (uint8_t i = 0; i < NUM_SAMPLES; i++)
-  {
-    am2315.readTemperatureAndHumidity(&amb_temp, &amb_hum);
-    amb_temp_samples += amb_temp;
-    amb_hum_samples += amb_hum;
-    wdt_reset();
-    delayMicroseconds(100);
-  }
-  // Report the average of the samples we gathered.
-  tmph_1_humd = amb_hum_samples / NUM_SAMPLES;
-  tmph_1_temp = amb_temp_samples / NUM_SAMPLES;
+  // Ambient temperature and humidity: the mean of every reading the
+  // sensor made since last minute, read by am2315_service() as it went.
+  CAPTURE(raw_capture_begin(&capture, RAW_REC_AM2315, 1, ambient.count * 2 * sizeof(int16_t)));
+  CAPTURE(raw_capture_put(&capture, ambient.readings, ambient.count * 2 * sizeof(int16_t)));
+  am2315_take(&ambient, &tmph_1_temp, &tmph_1_humd);
+  uint32_t ambient_age = am2315_age(&ambient, millis());
+  if(ambient_age > AM2315_STALE_MS) diag_int(DIAG_AMBIENT_STALE, ambient_age / 1000);
 
   // Print ambient temperature and humidity.
-  Serial.print("Ambient Temp: ");
-  Serial.println(tmph_1_temp);
-  Serial.print("Ambient Humidity: ");
-  Serial.println(tmph_1_humd);
+  diag_float(DIAG_AMBIENT_TEMP, tmph_1_temp);
+  diag_float(DIAG_AMBIENT_HUMD, tmph_1_humd);
 
   // Sensor sampling loop.
-  // DS18B20 temperature.
-  float temp_samples_1 = 0;
-  float temp_samples_2 = 0;
-  float temp_samples_3 = 0;
-  float temp_samples_4 = 0;
+  // DS18B20 temperature. The first pass reads every scratchpad in full
+  // with its CRC; after that only the temperature bytes.
+  int32_t temp_sums[NUM_TEMP_PROBES] = {0};
+  uint8_t temp_counts[NUM_TEMP_PROBES] = {0};
+  CAPTURE(raw_capture_begin(&capture, RAW_REC_DS18B20, NUM_TEMP_PROBES,
+    NUM_SAMPLES * NUM_TEMP_PROBES * sizeof(int16_t)));
   for (uint8_t i = 0; i < NUM_SAMPLES; i++) {
-    // Request temperatures from all sensors.
-    temp_sensors.requestTemperatures();
-
-    //Add to cumulative samples.
-    temp_samples_1 += temp_sensors.getTempC(temp_1_addr);
-    temp_samples_2 += temp_sensors.getTempC(temp_2_addr);
-    temp_samples_3 += temp_sensors.getTempC(temp_3_addr);
-    temp_samples_4 += temp_sensors.getTempC(temp_4_addr);
-    wdt_reset();
+    // Convert and read on every bus.
+    int16_t temp_raw[NUM_TEMP_PROBES];
+    ds18b20_sample(&temp_probes, temp_raw, i == 0);
+    am2315_service(&ambient);
+
+    //Add to cumulative samples, leaving out disconnected readings.
+    for (uint8_t p = 0; p < NUM_TEMP_PROBES; p++) {
+      if (temp_raw[p] > DS18B20_DISCONNECTED_RAW) {
+        temp_sums[p] += temp_raw[p];
+        temp_counts[p]++;
+      }
+    }
+    CAPTURE(raw_capture_put(&capture, temp_raw, sizeof(temp_raw)));
+    watchdog_progress(WATCHDOG_SENSORS, 3 + i);
   }
   // Report the average of the samples we gathered.
-  temp_1_temp = temp_samples_1 / NUM_SAMPLES;
-  temp_2_temp = temp_samples_2 / NUM_SAMPLES;
-  temp_3_temp = temp_samples_3 / NUM_SAMPLES;
-  temp_4_temp = temp_samples_4 / NUM_SAMPLES;
+  temp_1_temp = ds18b20_mean(temp_sums[0], temp_counts[0]);
+  temp_2_temp = ds18b20_mean(temp_sums[1], temp_counts[1]);
+  temp_3_temp = ds18b20_mean(temp_sums[2], temp_counts[2]);
+  temp_4_temp = ds18b20_mean(temp_sums[3], temp_counts[3]);
+  if(temp_probes.crc_errors) diag_int(DIAG_TEMP_CRC_ERRORS, temp_probes.crc_errors);
 
   // Print DS18B20 temperatures.
-  Serial.print("Temp 1: ");
-  Serial.println(temp_1_temp);
-  Serial.print("Temp 2: ");
-  Serial.println(temp_2_temp);
-  Serial.print("Temp 3: ");
-  Serial.println(temp_3_temp);
-  Serial.print("Temp 4: ");
-  Serial.println(temp_4_temp);
+  diag_float(DIAG_TEMP_1, temp_1_temp);
+  diag_float(DIAG_TEMP_2, temp_2_temp);
+  diag_float(DIAG_TEMP_3, temp_3_temp);
+  diag_float(DIAG_TEMP_4, temp_4_temp);
+  watchdog_leave(WATCHDOG_SENSORS);
+}
+
+//==============================================================================
+// Run Load Scheduler
+//==============================================================================
+// Feeds this minute's irradiance and mean PV backsheet temperature to the
+// scheduler and queues whatever relay commands it asks for.
+void schedule_loads() {
+  // Local variables.
+  float   pv_temps[3] = {temp_2_temp, temp_3_temp, temp_4_temp};
+  float   pv_temp = 0;
+  uint8_t num_valid = 0;
+
+  // Skip disconnected probes (logged as -127).
+  for(uint8_t i = 0; i < 3; i++) {
+    if(pv_temps[i] > LOAD_PV_TEMP_INVALID) {
+      pv_temp += pv_temps[i];
+      num_valid++;
+    }
+  }
+  pv_temp = (num_valid > 0) ? pv_temp / num_valid : LOAD_PV_TEMP_INVALID;
+
+  num_load_cmds = load_schedule_step(&scheduler, day(cur_time),
+    hour(cur_time), irad_1_wsqm, pv_temp, load_cmds);
+  next_load_cmd = 0;
+  diag_int(DIAG_LOAD_WSQM, scheduler.filtered_wsqm);
+
+  for(uint8_t i = 0; i < num_load_cmds; i++) {
+    diag(load_cmds[i].minutes ? DIAG_ENABLING_LOADS : DIAG_DISABLING_LOADS);
+    diag_int(DIAG_LOAD_MASK, load_cmds[i].loads);
+    diag_int(DIAG_LOAD_MINUTES, load_cmds[i].minutes);
+  }
 }
 
 //==============================================================================
@@ -486,6 +737,7 @@ bool create_log_file() {
   created = false;
 
   // Close the current file and create a new one.
+  watchdog_enter(WATCHDOG_SD);
   log_file.close();
 
   // Get the current time (MM-DD_HH) and use it as the file name,
@@ -497,197 +749,109 @@ bool create_log_file() {
   // Print filename and failure state.
   if (!log_file)
   {
-    Serial.print("File failed to open with name '");
-    Serial.print(file_name);
-    Serial.println("'");
+    diag_str(DIAG_FILE_OPEN_FAIL, file_name);
   }
   else
   {
-    Serial.print("Opened log_file file with name '");
-    Serial.print(file_name);
-    Serial.println("'");
+    diag_str(DIAG_FILE_OPENED, file_name);
     created = true;
   }
 
+  // Keep the compressed archive on one file per year.
+  sprintf(archive_name, "%04d.arc", year(t));
+  if(!archive_writer_open(&archive, archive_name, PLOT_ID, ARCHIVE_COLUMNS)) {
+    diag_str(DIAG_ARCHIVE_OPEN_FAIL, archive_name);
+  }
+
+  // Raw sensor captures go to one file per day.
+  #ifdef RAW_CAPTURE
+    sprintf(capture_name, "%02d-%02d.raw", month(t), day(t));
+    if(!raw_capture_open(&capture, capture_name)) {
+      diag_str(DIAG_CAPTURE_OPEN_FAIL, capture_name);
+    }
+    diag_int(DIAG_CAPTURE_STALLS, capture.stalls);
+  #endif
+
   // If file did not already exist, initialize first line
   // with ThingSpeak CSV header.
   if(!exists) {
-    log_file.print("created_at,entry_id,field1,field2,field3,field4,");
-    log_file.println("field5,field6,field7,field1,field2,field3");
+    log_file.print(F("created_at,entry_id,field1,field2,field3,field4,"));
+    log_file.println(F("field5,field6,field7,field1,field2,field3"));
   }
+  watchdog_leave(WATCHDOG_SD);
   return created;
 }
 
 //==============================================================================
-// Read TEROS 12 Data
+// Discover Soil Probes
 //==============================================================================
-bool teros_12_read(double *vwc_counts, float *temp, uint16_t *conductivity) {
-  // Local variables.
-  static char* input;
-  char*        temp_str;
-  char*        vwc_str;
-  char*        cond_str;
-  size_t       str_size;
-  bool         valid;
-  bool         temp_neg;
-
-  input     = (char*)malloc(25 * sizeof(char));
-  temp_str  = NULL;
-  vwc_str   = NULL;
-  cond_str  = NULL;
-  valid     = false;
-  temp_neg  = true;
-
-  // Clear SDI buffer and send measure command.
-  sdi.clearBuffer();
-  sdi.sendCommand("0M!");
-  delay(100);
-
-  // If read command succeded...
-  if(sdi.available() > 5) {
-    // Wait remainder of specified 1s, clear buffer,
-    // and send read command.
-    delay(900);
-    sdi.clearBuffer();
-    sdi.sendCommand("0D0!");
-
-    // Spin wait until response is available.
-    while(sdi.available() < 10) ;
-
-    // Read response from sensor, terminate with null character,
-    // and advance starting pointer past prepended null characters.
-    str_size = sdi.readBytesUntil('\n', input, 25);
-    input[str_size] = 0;
-    while(*input == 0) {
-      input++;
-      str_size--;
-    }
-
-    // Get pointers to delimiters within response string.
-    temp_str = strchr(input, '-');
-    vwc_str  = strchr(input, '+');
-    cond_str = strrchr(input, '+');
-
-    // If valid VWC and conductiity delimeters are found,
-    // input is most likely valid.
-    if(vwc_str && cond_str) {
-      valid = true;
-      // Replace delimeters with null characters and advance pointers.
-      vwc_str++;
-      *cond_str = 0;
-      cond_str++;
-
-      // If valid temperature delimeter was not found, temperature is positive.
-      if(!temp_str) {
-        // Find positive delimeter for temperature.
-        temp_str = strchr(vwc_str, '+');
-        temp_neg = false;
-      }
-
-      // Replace temperature delimeter with null character and advance pointer.
-      *temp_str = 0;
-      temp_str++;
-
-      // Convert response substrings to numerical values and store
-      // at specified addresses.
-      *vwc_counts = atof(vwc_str);
-      *temp = temp_neg ? atof(temp_str) * -1 : atof(temp_str);
-      *conductivity = atoi(cond_str);
-    }
+// Scans the SDI-12 addresses for TEROS probes, keeping the AM2315 going
+// meanwhile. Every step of it times out, and the whole scan is supervised
+// as one task.
+void soil_discover() {
+  char probe[16];
+
+  watchdog_enter(WATCHDOG_SOIL);
+  teros_discover(&soil);
+  while(teros_service(&soil) == SDI12_BUSY) {
+    am2315_service(&ambient);
   }
+  watchdog_leave(WATCHDOG_SOIL);
 
-  // Clear SDI buffer once again, just for good measure.
-  sdi.clearBuffer();
-  return valid;
+  diag_int(DIAG_SDI_PROBES, soil.num_probes);
+  for(uint8_t i = 0; i < soil.num_probes; i++) {
+    sprintf(probe, "%c: %s", soil.probes[i].addr,
+      teros_model_name(soil.probes[i].model));
+    diag_str(DIAG_SDI_PROBE, probe);
+  }
 }
 
 //==============================================================================
-// Read TEROS 21 Data
+// Read Soil Probes
 //==============================================================================
-bool teros_21_read(double *matric_potential, float *temp) {
-  // Local variables.
-  static char* input;
-  char*        mtc_pot_str;
-  char*        temp_str;
-  size_t       str_size;
-  bool         valid;
-  bool         temp_neg;
-
-  input       = (char*)malloc(25 * sizeof(char));
-  mtc_pot_str = NULL;
-  temp_str    = NULL;
-  valid       = false;
-  temp_neg    = false;
-
-  // Clear SDI buffer and send measure command.
-  sdi.clearBuffer();
-  sdi.sendCommand("1M!");
-  delay(100);
-
-  // If read command succeeded...
-  if(sdi.available() > 5) {
-    // Wait remainder of specified 1s, clear buffer,
-    // and send read command.
-    delay(900);
-    sdi.clearBuffer();
-    sdi.sendCommand("1D0!");
-
-    // Spin wait until response is available.
-    while(sdi.available() < 10) ;
-
-    // Read response from sensor, terminate with null character,
-    // and advance starting pointer past prepended null characters.
-    str_size = sdi.readBytesUntil('\n', input, 25);
-    input[str_size] = 0;
-    while(*input == 0) {
-      input++;
-      str_size--;
-    }
-
-    // Get pointers to delimiters within response string.
-    mtc_pot_str = strchr(input, '-');
-    temp_str = strchr(input, '+');
-
-
-    // If valid matric potential delimeter is found,
-    // input is most likely valid.
-    if(mtc_pot_str) {
-      valid = true;
-      // Advance pointer to matric potential.
-      mtc_pot_str++;
-
-      // If valid temperature delimeter was not found, temperature is negative.
-      if(!temp_str) {
-        temp_str = strrchr(input, '-');
-        temp_neg = true;
-      }
+void soil_read() {
+  watchdog_enter(WATCHDOG_SOIL);
+  teros_sample(&soil);
+  while(teros_service(&soil) == SDI12_BUSY) {
+    am2315_service(&ambient);
+  }
+  watchdog_leave(WATCHDOG_SOIL);
 
-      // Replace temperature delimeter with null character and advance pointer.
-      *temp_str = 0;
-      temp_str++;
+  // Replies are captured as received, whether or not they parse.
+  for(uint8_t i = 0; i < soil.num_probes; i++) {
+    const teros_probe* p = &soil.probes[i];
 
-      // Convert response substrings to numerical values and store
-      // at specified addresses.
-      *matric_potential = atof(mtc_pot_str) * -1;
-      *temp = temp_neg? atof(temp_str) * -1 : atof(temp_str);
-    }
+    if(p->model == TEROS_UNKNOWN) continue;
+    CAPTURE(raw_capture_sdi(&capture, soil_capture_id(p), p->response, p->len));
+    if(!p->ok) diag_int(DIAG_SDI_NO_RESPONSE, p->addr - '0');
   }
+}
 
-  // Clear SDI buffer once again, just for good measure.
-  sdi.clearBuffer();
-  return valid;
+//==============================================================================
+// Soil Capture Number
+//==============================================================================
+// The logged probes keep their soil numbers so Sensor-Replay finds them.
+uint8_t soil_capture_id(const teros_probe* p) {
+  if(p == teros_find(&soil, TEROS_12, 0)) return SOIL_12_NUM;
+  if(p == teros_find(&soil, TEROS_21, 0)) return SOIL_21_NUM;
+  return TEROS_EXTRA_CAPTURE + p->addr - '0';
 }
 
 //==============================================================================
 // Reset System
 //==============================================================================
-void system_reset() {
+void system_reset(uint8_t cause) {
+  // The last SD and EEPROM writes stay supervised, so a card that hangs
+  // still gets the board reset.
+  watchdog_enter(WATCHDOG_SD);
+  CAPTURE(raw_capture_flush(&capture));
+  if(daily_matches(&summary, &summary_config)) daily_save(&summary);
+  watchdog_leave(WATCHDOG_SD);
+
   // Use watchdog timer and spin-wait to trigger reset.
-  wdt_disable();
-  Serial.println("//////////////////");
-  Serial.println("// SYSTEM RESET //");
-  Serial.println("//////////////////");
+  diag(DIAG_SYSTEM_RESET);
+  diag_flush();
   delay(100);
-  wdt_enable(WDTO_15MS);
-  while(1) ;
+  reset_log_planned(cause);
+  watchdog_reboot();
 }
@@ -18,13 +18,22 @@
 #include <ThingSpeak.h>
 #include <NTPClient.h>
 #include <OneWire.h>
-#include <DallasTemperature.h>
+#include <ds18b20_read.h>
 #include <SD.h>
-#include <Adafruit_ADS1X15.h>
-#include <Adafruit_AM2315.h>
+#include <twi_queue.h>
+#include <ads1115.h>
 #include <Time.h>
 #include <TimeLib.h>
-#include <avr/wdt.h>
+#include <watchdog_io.h>
+#include <reset_log_io.h>
+#include <archive_sd.h>
+#include <raw_capture_sd.h>
+#include <daily_summary.h>
+#include <daily_summary_io.h>
+#include <ram_monitor.h>
+#include <diag.h>
+#include <sensor_calc.h>
+#include <calibration.h>
 #include "secrets.h"
 
 //------------------------------------------------------------------------------
@@ -46,6 +55,18 @@
 #define IRAD_2_WSQM_FIELD   (4)
 
 
+// ThingSpeak Debug Fields
+#define DBG_ALIVE_FIELD     (1)
+#define DBG_LOW_WATER_FIELD (2)
+#define DBG_FREE_RAM_FIELD  (3)
+// Sent with the first debug write after a reset's event is stored; the
+// debug channel needs these fields added first.
+#define DBG_RESET_FIELD     (4)
+#define DBG_DOWNTIME_FIELD  (5)
+#define DBG_UPTIME_FIELD    (6)
+#define DBG_UNPLANNED_FIELD (7)
+#define DBG_DOWN_SUM_FIELD  (8)
+
 // Pin Definitions
 #define ONE_WIRE_PIN        (2)
 #define SD_CS_PIN           (4)
@@ -53,16 +74,36 @@
 
 // Sensor Parameters
 #define TEMP_PRECISION      (12)
+#define NUM_TEMP_BUSES      (1)
+#define NUM_TEMP_PROBES     (3)
 
 // Program Parameters
 #define TIME_ZONE           (-7)
 #define SECS_PER_HOUR       (3600)
-#define NUM_SAMPLES         (20)
+#define NUM_SAMPLES         (SENSOR_NUM_SAMPLES)
 #define NTP_SYNC_INTERVAL   (600)
 
+// Archive Parameters
+#define PLOT_ID             (3)
+#define ARCHIVE_COLUMNS     (4)
+
+// Daily Summary Parameters
+#define IRAD_COLUMN         (3)
+#define SUNSHINE_WSQM       (120.0f)
+#define PV_HOT_TEMP         (45.0f)
+
 // Debug Parameters
+#define DIAG_MODE           (DIAG_TEXT)
 #define FAIL_RESET
 #define THINGSPEAK_DEBUG
+#define RAW_CAPTURE
+
+// Raw capture calls compile away when RAW_CAPTURE is off.
+#ifdef RAW_CAPTURE
+  #define CAPTURE(call) call
+#else
+  #define CAPTURE(call)
+#endif
 
 //------------------------------------------------------------------------------
 //     ___      __   ___  __   ___  ___  __
@@ -90,21 +131,51 @@ int32_t              thingspeak_response = 0;
 
 // Sensor Objects
 OneWire              oneWire(ONE_WIRE_PIN);
-DallasTemperature    temp_sensors(&oneWire);
-DeviceAddress        temp_5_addr = {TEMP_5_ADDR_0, TEMP_5_ADDR_1, TEMP_5_ADDR_2, TEMP_5_ADDR_3,
-                                    TEMP_5_ADDR_4, TEMP_5_ADDR_5, TEMP_5_ADDR_6, TEMP_5_ADDR_7};
-DeviceAddress        temp_6_addr = {TEMP_6_ADDR_0, TEMP_6_ADDR_1, TEMP_6_ADDR_2, TEMP_6_ADDR_3,
-                                    TEMP_6_ADDR_4, TEMP_6_ADDR_5, TEMP_6_ADDR_6, TEMP_6_ADDR_7};
-DeviceAddress        temp_7_addr = {TEMP_7_ADDR_0, TEMP_7_ADDR_1, TEMP_7_ADDR_2, TEMP_7_ADDR_3,
-                                    TEMP_7_ADDR_4, TEMP_7_ADDR_5, TEMP_7_ADDR_6, TEMP_7_ADDR_7};
-
-Adafruit_ADS1115     ads;
-
-static const char    date_string[23];
-static const char    file_name[12];
+// secrets.h addresses only seed the binding; after that probes are bound
+// at boot from the EEPROM cache.
+static const onewire_rom temp_defaults[NUM_TEMP_PROBES] = {
+  {TEMP_5_ADDR_0, TEMP_5_ADDR_1, TEMP_5_ADDR_2, TEMP_5_ADDR_3,
+   TEMP_5_ADDR_4, TEMP_5_ADDR_5, TEMP_5_ADDR_6, TEMP_5_ADDR_7},
+  {TEMP_6_ADDR_0, TEMP_6_ADDR_1, TEMP_6_ADDR_2, TEMP_6_ADDR_3,
+   TEMP_6_ADDR_4, TEMP_6_ADDR_5, TEMP_6_ADDR_6, TEMP_6_ADDR_7},
+  {TEMP_7_ADDR_0, TEMP_7_ADDR_1, TEMP_7_ADDR_2, TEMP_7_ADDR_3,
+   TEMP_7_ADDR_4, TEMP_7_ADDR_5, TEMP_7_ADDR_6, TEMP_7_ADDR_7}
+};
+// One entry per one-wire bus, probes numbered bus by bus as above.
+ds18b20_bus          temp_buses[NUM_TEMP_BUSES] = {{&oneWire, NUM_TEMP_PROBES}};
+ds18b20_array        temp_probes;
+
+ads1115              ads;
+
+static char          date_string[24];
+static char          file_name[13];
 
 File                 log_file;
 
+archive_writer       archive;
+static char          archive_name[13];
+static float         archive_values[ARCHIVE_COLUMNS];
+
+// Sunshine is irradiance over the WMO 120 W/m^2; the others are minutes
+// of hot panels.
+static const float   summary_thresholds[ARCHIVE_COLUMNS] = {
+  PV_HOT_TEMP, PV_HOT_TEMP, PV_HOT_TEMP, SUNSHINE_WSQM
+};
+static const daily_config summary_config = {PLOT_ID, ARCHIVE_COLUMNS, IRAD_COLUMN,
+                                            summary_thresholds};
+daily_summary        summary;
+
+#ifdef RAW_CAPTURE
+raw_capture          capture;
+static char          capture_name[13];
+
+// Each record's length goes in one byte.
+static_assert(NUM_SAMPLES * sizeof(int16_t) <= RAW_MAX_PAYLOAD,
+              "ADC record too long for raw capture");
+static_assert(NUM_SAMPLES * NUM_TEMP_PROBES * sizeof(int16_t) <=
+              RAW_MAX_PAYLOAD, "DS18B20 record too long for raw capture");
+#endif
+
 time_t               cur_time;
 time_t               prev_time;
 
@@ -125,7 +196,7 @@ int16_t              irad_2_wsqm;
 time_t get_ntp_time();
 void   read_sensors();
 bool   create_log_file();
-void   system_reset();
+void   system_reset(uint8_t cause);
 
 //------------------------------------------------------------------------------
 //      __        __          __
@@ -140,14 +211,28 @@ void   system_reset();
 void setup() {
   // Basic system setup.
   Serial.begin(9600);
-  wdt_enable(WDTO_4S);
+  diag_begin(DIAG_MODE);
+
+  // Supervise setup, and report the task that hung if the watchdog reset
+  // the board. The reset itself is logged once a minute is logged again.
+  watchdog_record hang;
+  bool            hung = watchdog_begin(&hang);
+  if(hung) {
+    diag_int(DIAG_WATCHDOG_TASK, hang.task);
+    diag_int(DIAG_WATCHDOG_STEP, hang.step);
+    if(hang.caught) diag_int(DIAG_WATCHDOG_STALL, hang.stalled_ms);
+    diag_int(DIAG_WATCHDOG_RESETS, hang.resets);
+  }
+  reset_log_begin(&hang, hung);
+  watchdog_enter(WATCHDOG_DHCP);
   Ethernet.begin(mac);
+  watchdog_leave(WATCHDOG_DHCP);
   #ifdef ONEDOT
   Ethernet.setDnsServerIP(onedot);
   #endif
-  Serial.println(Ethernet.localIP());
-  Serial.println(Ethernet.linkStatus());
-  wdt_reset();
+  diag_ip(DIAG_LOCAL_IP, Ethernet.localIP());
+  diag_int(DIAG_LINK_STATUS, Ethernet.linkStatus());
+  watchdog_progress(WATCHDOG_SETUP, 1);
 
   // Initialize ThingSpeak.
   ThingSpeak.begin(client);
@@ -155,26 +240,38 @@ void setup() {
   // Initialize NTP.
   udp.begin(2390);
   ntp.begin();
+  watchdog_enter(WATCHDOG_NTP);
   ntp.update();
+  watchdog_leave(WATCHDOG_NTP);
   setSyncProvider(get_ntp_time);
   setSyncInterval(NTP_SYNC_INTERVAL);
   cur_time = now();
   prev_time = now();
-  Serial.println(ntp.getFormattedTime());
-  wdt_reset();
-
-  // Initialize sensors.
-  temp_sensors.begin();
-  Serial.println("Temp sensors initialized");
-  Serial.print(temp_sensors.getDeviceCount());
-  Serial.println(" sensors found");
-  ads.begin();
-  Serial.println("ADC initialized");
+  diag_str(DIAG_NTP_TIME, ntp.getFormattedTime().c_str());
+  watchdog_progress(WATCHDOG_SETUP, 2);
+
+  // Initialize sensors. A bus is only searched if a bound probe
+  // doesn't answer; any probe that changes role is reported.
+  uint32_t rebound;
+  uint8_t  temp_count = ds18b20_begin(&temp_probes, temp_buses,
+    NUM_TEMP_BUSES, temp_defaults, TEMP_PRECISION, &rebound);
+  diag(DIAG_TEMP_INIT);
+  diag_int(DIAG_TEMP_COUNT, temp_count);
+  for(uint8_t r = 0; r < NUM_TEMP_PROBES; r++) {
+    if(rebound & (1UL << r)) diag_int(DIAG_TEMP_REBOUND, r);
+  }
+  twi_begin();
+  ads1115_init(&ads, ADS1115_ADDR);
+  diag(DIAG_ADC_INIT);
 
   // Initialize SD card.
   SD.begin(SD_CS_PIN);
   create_log_file();
-  wdt_reset();
+  watchdog_progress(WATCHDOG_SETUP, 4);
+
+  // Pick up today's summary where the last reset left it.
+  if(daily_load(&summary, &summary_config)) diag(DIAG_SUMMARY_RESTORED);
+  watchdog_leave(WATCHDOG_SETUP);
 }
 
 //==============================================================================
@@ -182,7 +279,7 @@ void setup() {
 //==============================================================================
 void loop() {
   // Get current time.
-  wdt_reset();
+  watchdog_loop();
   prev_time = cur_time;
   cur_time = now();
 
@@ -193,11 +290,12 @@ void loop() {
     }
 
     // Read system sensors.
-    Serial.println("Reading sensors");
+    diag(DIAG_READING_SENSORS);
     read_sensors();
-    wdt_reset();
+    ram_print_usage();
     // Log new sensor data to SD card, getting current time first.
-    Serial.println("Writing to card");
+    diag(DIAG_WRITING_CARD);
+    watchdog_enter(WATCHDOG_SD);
     time_t t = now();
     sprintf(date_string, "%04d-%02d-%02d %02d:%02d:%02d PDT",
       year(t), month(t), day(t), hour(t), minute(t), second(t));
@@ -211,13 +309,39 @@ void loop() {
     log_file.print(",");
     log_file.println(irad_2_wsqm);
     log_file.flush();
-    wdt_reset();
+    watchdog_progress(WATCHDOG_SD, 1);
+
+    // Append the same row to the compressed archive.
+    archive_values[0] = temp_5_temp;
+    archive_values[1] = temp_6_temp;
+    archive_values[2] = temp_7_temp;
+    archive_values[3] = irad_2_wsqm;
+    if(!archive_writer_append(&archive, t, archive_values)) {
+      diag(DIAG_ARCHIVE_WRITE_FAIL);
+    }
+    watchdog_progress(WATCHDOG_SD, 2);
+
+    // Fold the row into the day's summary. The first row of a new day
+    // writes out the finished one.
+    if(!daily_same_day(&summary, t)) {
+      if(daily_matches(&summary, &summary_config) && !daily_write(&summary)) {
+        diag(DIAG_SUMMARY_WRITE_FAIL);
+      }
+      daily_begin(&summary, &summary_config, t);
+    }
+    daily_add(&summary, &summary_config, archive_values);
+    if(minute(t) % DAILY_SAVE_MINUTES == 0) daily_save(&summary);
+    watchdog_leave(WATCHDOG_SD);
+
+    // The first minute logged after a reset stores the reset's event.
+    if(reset_log_mark(t, thingspeak_response, ram_free())) {
+      reset_log_print(reset_log_unsent());
+    }
 
     // Before attempting to upload to ThingSpeak,
     // log status of internet connection.
-    Serial.println(Ethernet.linkStatus());
-    Serial.println(Ethernet.hardwareStatus());
-    wdt_reset();
+    diag_int(DIAG_LINK_STATUS, Ethernet.linkStatus());
+    diag_int(DIAG_HARDWARE_STATUS, Ethernet.hardwareStatus());
 
     // Set ThingSpeak PV fields.
     ThingSpeak.setField(TEMP_5_TEMP_FIELD, temp_5_temp);
@@ -226,15 +350,16 @@ void loop() {
     ThingSpeak.setField(IRAD_2_WSQM_FIELD, irad_2_wsqm);
 
     // Attempt ThingSpeak upload.
-    Serial.println("Sending PV data to ThingSpeak");
+    diag(DIAG_SENDING_PV);
+    watchdog_enter(WATCHDOG_UPLOAD);
     thingspeak_response = ThingSpeak.writeFields(
       PLOT_3_PV_CHANNEL, plot_3_pv_api_key);
-    Serial.println(thingspeak_response);
-    wdt_reset();
+    watchdog_leave(WATCHDOG_UPLOAD);
+    diag_int(DIAG_THINGSPEAK_RESP, thingspeak_response);
 
     #ifdef FAIL_RESET
       // Reset system if -301 error encountered
-      if(thingspeak_response == THINGSPEAK_FAIL) system_reset();
+      if(thingspeak_response == THINGSPEAK_FAIL) system_reset(RESET_UPLOAD);
     #endif
 
   }
@@ -243,18 +368,46 @@ void loop() {
   // If the 30th second of the minute has just begun,
   // write to debug channel
   if(second(cur_time) == 30 && second(prev_time) == 29) {
-    thingspeak_response = ThingSpeak.writeField(
-      PLOT_3_DBG_CHANNEL, 1, 1, PLOT_3_DBG_API_KEY);
+    ThingSpeak.setField(DBG_ALIVE_FIELD, 1);
+    ThingSpeak.setField(DBG_LOW_WATER_FIELD, ram_low_water());
+    ThingSpeak.setField(DBG_FREE_RAM_FIELD, ram_free());
+    // The first write after a reset's event is stored also reports it.
+    const reset_event* last_reset = reset_log_unsent();
+    if(last_reset) {
+      ThingSpeak.setField(DBG_RESET_FIELD, last_reset->cause);
+      if(reset_downtime(last_reset) != RESET_NO_TIME) {
+        ThingSpeak.setField(DBG_DOWNTIME_FIELD,
+                            (long)reset_downtime(last_reset));
+      }
+      if(last_reset->uptime_s != RESET_NO_TIME) {
+        ThingSpeak.setField(DBG_UPTIME_FIELD, (long)last_reset->uptime_s);
+      }
+      ThingSpeak.setField(DBG_UNPLANNED_FIELD, reset_unplanned(last_reset));
+      ThingSpeak.setField(DBG_DOWN_SUM_FIELD,
+                          (long)reset_total_down(last_reset));
+    }
+    watchdog_enter(WATCHDOG_UPLOAD);
+    thingspeak_response = ThingSpeak.writeFields(
+      PLOT_3_DBG_CHANNEL, PLOT_3_DBG_API_KEY);
+    watchdog_leave(WATCHDOG_UPLOAD);
+    if(last_reset && thingspeak_response == THINGSPEAK_SUCCESS) {
+      reset_log_sent();
+    }
 
     #ifdef FAIL_RESET
       // Reset system if -301 error encountered
-      if(thingspeak_response == THINGSPEAK_FAIL) system_reset();
+      if(thingspeak_response == THINGSPEAK_FAIL) system_reset(RESET_UPLOAD);
     #endif
   }
   #endif
 
+  // Write out raw capture data outside the minute's work.
+  CAPTURE(raw_capture_service(&capture));
+
   // Maintain Ethernet connection.
+  watchdog_enter(WATCHDOG_DHCP);
   Ethernet.maintain();
+  watchdog_leave(WATCHDOG_DHCP);
 }
 
 // Provides the time library with the current real-world time
@@ -262,7 +415,9 @@ void loop() {
 // Returns a time_t type... not sure what it is (time, presumably) just basing format off the example code
 time_t get_ntp_time()
 {
+  watchdog_enter(WATCHDOG_NTP);
   ntp.update();
+  watchdog_leave(WATCHDOG_NTP);
   // Return seconds since Jan. 1 1970, adjusted for time zone in seconds.
   return ntp.getEpochTime();
 }
@@ -271,54 +426,62 @@ time_t get_ntp_time()
 // Read Sensor Data
 //==============================================================================
 void read_sensors() {
+  watchdog_enter(WATCHDOG_SENSORS);
+  CAPTURE(raw_capture_frame(&capture, PLOT_ID, now()));
 
   // Sensor sampling loop.
   // Irradiance.
   int32_t irad_samples = 0;
+  CAPTURE(raw_capture_begin(&capture, RAW_REC_ADC, 2, NUM_SAMPLES * sizeof(int16_t)));
   for (uint8_t i = 0; i < NUM_SAMPLES; i++) {
-    irad_samples += ads.readADC_SingleEnded(0);
+    int16_t irad_counts = ads1115_read(&ads, 0);
+    irad_samples += irad_counts;
+    CAPTURE(raw_capture_put(&capture, &irad_counts, sizeof(irad_counts)));
 
     delayMicroseconds(100);
   }
   // Report the average of the samples we gathered.
-  irad_2_wsqm = (irad_samples < 0) ? 0 : irad_samples / NUM_SAMPLES;
-  Serial.print("Irradiance ADC: ");
-  Serial.println(irad_2_wsqm);
+  irad_2_wsqm = irad_mean_counts(irad_samples, NUM_SAMPLES);
+  diag_int(DIAG_IRAD_ADC, irad_2_wsqm);
   // Convert ADC counts to W/m^2.
-  irad_2_wsqm = (float)((-6E-10 * pow(irad_2_wsqm, 4)) +
-    (2.7E-6 * pow(irad_2_wsqm, 3)) - (3.1E-3 * pow(irad_2_wsqm, 2)) +
-    (1.1 * (double)irad_2_wsqm));
-  Serial.print("Irradiance: ");
-  Serial.println(irad_2_wsqm);
+  irad_2_wsqm = irad_wsqm(irad_2_wsqm, &irad_cal[2]);
+  diag_int(DIAG_IRAD, irad_2_wsqm);
+  if(ads.errors) diag_int(DIAG_ADC_ERRORS, ads.errors);
+  if(twi_recoveries()) diag_int(DIAG_I2C_RECOVERIES, twi_recoveries());
 
   // Sensor sampling loop.
-  // DS18B20 temperature.
-  float temp_samples_1 = 0;
-  float temp_samples_2 = 0;
-  float temp_samples_3 = 0;
+  // DS18B20 temperature. The first pass reads every scratchpad in full
+  // with its CRC; after that only the temperature bytes.
+  int32_t temp_sums[NUM_TEMP_PROBES] = {0};
+  uint8_t temp_counts[NUM_TEMP_PROBES] = {0};
+  CAPTURE(raw_capture_begin(&capture, RAW_REC_DS18B20, NUM_TEMP_PROBES,
+    NUM_SAMPLES * NUM_TEMP_PROBES * sizeof(int16_t)));
   for (uint8_t i = 0; i < NUM_SAMPLES; i++) {
-    // Request temperatures from all sensors.
-    temp_sensors.requestTemperatures();
-
-    //Add to cumulative samples.
-    temp_samples_1 += temp_sensors.getTempC(temp_5_addr);
-    temp_samples_2 += temp_sensors.getTempC(temp_6_addr);
-    temp_samples_3 += temp_sensors.getTempC(temp_7_addr);
-    wdt_reset();
+    // Convert and read on every bus.
+    int16_t temp_raw[NUM_TEMP_PROBES];
+    ds18b20_sample(&temp_probes, temp_raw, i == 0);
+
+    //Add to cumulative samples, leaving out disconnected readings.
+    for (uint8_t p = 0; p < NUM_TEMP_PROBES; p++) {
+      if (temp_raw[p] > DS18B20_DISCONNECTED_RAW) {
+        temp_sums[p] += temp_raw[p];
+        temp_counts[p]++;
+      }
+    }
+    CAPTURE(raw_capture_put(&capture, temp_raw, sizeof(temp_raw)));
+    watchdog_progress(WATCHDOG_SENSORS, 1 + i);
   }
   // Report the average of the samples we gathered.
-  temp_5_temp = temp_samples_1 / NUM_SAMPLES;
-  temp_6_temp = temp_samples_2 / NUM_SAMPLES;
-  temp_7_temp = temp_samples_3 / NUM_SAMPLES;
+  temp_5_temp = ds18b20_mean(temp_sums[0], temp_counts[0]);
+  temp_6_temp = ds18b20_mean(temp_sums[1], temp_counts[1]);
+  temp_7_temp = ds18b20_mean(temp_sums[2], temp_counts[2]);
+  if(temp_probes.crc_errors) diag_int(DIAG_TEMP_CRC_ERRORS, temp_probes.crc_errors);
 
   // Print DS18B20 temperatures.
-  Serial.print("Temp 1: ");
-  Serial.println(temp_5_temp);
-  Serial.print("Temp 2: ");
-  Serial.println(temp_6_temp);
-  Serial.print("Temp 3: ");
-  Serial.println(temp_7_temp);
-
+  diag_float(DIAG_TEMP_5, temp_5_temp);
+  diag_float(DIAG_TEMP_6, temp_6_temp);
+  diag_float(DIAG_TEMP_7, temp_7_temp);
+  watchdog_leave(WATCHDOG_SENSORS);
 }
 
 //==============================================================================
@@ -335,6 +498,7 @@ bool create_log_file() {
   created = false;
 
   // Close the current file and create a new one.
+  watchdog_enter(WATCHDOG_SD);
   log_file.close();
 
   // Get the current time (MM-DD_HH) and use it as the file name,
@@ -346,36 +510,53 @@ bool create_log_file() {
   // Print filename and failure state.
   if (!log_file)
   {
-    Serial.print("File failed to open with name '");
-    Serial.print(file_name);
-    Serial.println("'");
+    diag_str(DIAG_FILE_OPEN_FAIL, file_name);
   }
   else
   {
-    Serial.print("Opened log_file file with name '");
-    Serial.print(file_name);
-    Serial.println("'");
+    diag_str(DIAG_FILE_OPENED, file_name);
     created = true;
   }
 
+  // Keep the compressed archive on one file per year.
+  sprintf(archive_name, "%04d.arc", year(t));
+  if(!archive_writer_open(&archive, archive_name, PLOT_ID, ARCHIVE_COLUMNS)) {
+    diag_str(DIAG_ARCHIVE_OPEN_FAIL, archive_name);
+  }
+
+  // Raw sensor captures go to one file per day.
+  #ifdef RAW_CAPTURE
+    sprintf(capture_name, "%02d-%02d.raw", month(t), day(t));
+    if(!raw_capture_open(&capture, capture_name)) {
+      diag_str(DIAG_CAPTURE_OPEN_FAIL, capture_name);
+    }
+    diag_int(DIAG_CAPTURE_STALLS, capture.stalls);
+  #endif
+
   // If file did not already exist, initialize first line
   // with ThingSpeak CSV header.
   if(!exists) {
-    log_file.println("created_at,entry_id,field1,field2,field3,field4");
+    log_file.println(F("created_at,entry_id,field1,field2,field3,field4"));
   }
+  watchdog_leave(WATCHDOG_SD);
   return created;
 }
 
 //==============================================================================
 // Reset System
 //==============================================================================
-void system_reset() {
+void system_reset(uint8_t cause) {
+  // The last SD and EEPROM writes stay supervised, so a card that hangs
+  // still gets the board reset.
+  watchdog_enter(WATCHDOG_SD);
+  CAPTURE(raw_capture_flush(&capture));
+  if(daily_matches(&summary, &summary_config)) daily_save(&summary);
+  watchdog_leave(WATCHDOG_SD);
+
   // Use watchdog timer and spin-wait to trigger reset.
-  wdt_disable();
-  Serial.println("//////////////////");
-  Serial.println("// SYSTEM RESET //");
-  Serial.println("//////////////////");
+  diag(DIAG_SYSTEM_RESET);
+  diag_flush();
   delay(100);
-  wdt_enable(WDTO_15MS);
-  while(1) ;
+  reset_log_planned(cause);
+  watchdog_reboot();
 }
@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Cross-Plot Join
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Aligns the plots' column stores onto a common time grid and prints paired
+// differences between them, e.g. sun vs shade soil moisture.
+//
+//   plot_join [-f FROM] [-t TO] [-g SECS] [-T SECS] [-m asof|linear]
+//             [-j THREADS] [-d A-B]... [-s] STORE...
+//
+//   -f, -t  range, "YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS" (default: the span
+//           all stores cover)
+//   -g      grid step in seconds (default 60)
+//   -T      how far a sample may be from a grid point (default 300)
+//   -m      as-of join or linear interpolation (default linear)
+//   -j      threads; the range is split into that many time partitions
+//   -d      difference to compute, as COLUMN-COLUMN; column names are
+//           unique across plots (default: soil_0_volw-soil_1_volw,
+//           irad_0_wsqm-irad_1_wsqm, irad_0_wsqm-irad_2_wsqm, when the
+//           stores have them)
+//   -s      print count/mean/min/max of each difference to stderr
+//
+// Each partition streams through the stores with its own cursors and
+// spools its rows to a temporary file, so memory stays bounded however
+// long the range; the files are then copied out in order.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+#include <vector>
+#include <column_store.h>
+#include <plot_join.h>
+#include <plot_log.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define MAX_STORES        (NUM_PLOTS)
+#define MAX_DIFFS         (16)
+#define MAX_REFS          (2 * MAX_DIFFS)
+#define DEFAULT_STEP      (60)
+#define DEFAULT_TOLERANCE (300)
+#define COPY_BUF_SIZE     (1 << 16)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// A column in one of the stores, and where it lands in that store's
+// join_stream output.
+struct column_ref {
+  const char* name;
+  uint8_t     store;
+  uint8_t     column;
+  uint8_t     slot;
+};
+
+struct diff_spec {
+  uint8_t a;                  // indexes into refs
+  uint8_t b;
+};
+
+struct diff_stats {
+  uint64_t count;
+  double   sum;
+  float    min;
+  float    max;
+};
+
+struct partition {
+  int64_t    from;
+  int64_t    to;
+  FILE*      out;
+  uint64_t   rows;
+  diff_stats stats[MAX_DIFFS];
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const char* const default_diffs[] = {
+  "soil_0_volw-soil_1_volw",
+  "irad_0_wsqm-irad_1_wsqm",
+  "irad_0_wsqm-irad_2_wsqm",
+};
+
+static col_store  stores[MAX_STORES];
+static uint8_t    num_stores;
+static column_ref refs[MAX_REFS];
+static uint8_t    num_refs;
+static diff_spec  diffs[MAX_DIFFS];
+static uint8_t    num_diffs;
+static int64_t    step = DEFAULT_STEP;
+static int64_t    tolerance = DEFAULT_TOLERANCE;
+static join_mode  mode = JOIN_LINEAR;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool parse_when(const char* arg, int64_t* t);
+static bool add_diff(const char* spec, bool quiet);
+static int  add_ref(const char* name);
+static void run_partition(partition* p);
+static void usage(const char* name);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  int64_t                from = INT64_MIN;
+  int64_t                to = INT64_MAX;
+  unsigned               num_threads = std::thread::hardware_concurrency();
+  bool                   print_stats = false;
+  std::vector<const char*> diff_args;
+  std::vector<partition> parts;
+
+  for(int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if(strcmp(argv[i], "-f") == 0 && has_value) {
+      if(!parse_when(argv[++i], &from)) usage(argv[0]);
+    }
+    else if(strcmp(argv[i], "-t") == 0 && has_value) {
+      if(!parse_when(argv[++i], &to)) usage(argv[0]);
+    }
+    else if(strcmp(argv[i], "-g") == 0 && has_value) step = atol(argv[++i]);
+    else if(strcmp(argv[i], "-T") == 0 && has_value) tolerance = atol(argv[++i]);
+    else if(strcmp(argv[i], "-j") == 0 && has_value) num_threads = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-m") == 0 && has_value) {
+      i++;
+      if(strcmp(argv[i], "asof") == 0) mode = JOIN_ASOF;
+      else if(strcmp(argv[i], "linear") == 0) mode = JOIN_LINEAR;
+      else usage(argv[0]);
+    }
+    else if(strcmp(argv[i], "-d") == 0 && has_value) diff_args.push_back(argv[++i]);
+    else if(strcmp(argv[i], "-s") == 0) print_stats = true;
+    else if(argv[i][0] != '-' && num_stores < MAX_STORES) {
+      if(!col_open(&stores[num_stores], argv[i], false)) return 1;
+      num_stores++;
+    }
+    else usage(argv[0]);
+  }
+  if(num_stores == 0 || step <= 0 || tolerance < 0) usage(argv[0]);
+  if(num_threads == 0) num_threads = 1;
+
+  // Resolve the differences against the stores' column names.
+  if(diff_args.empty()) {
+    for(const char* spec : default_diffs) add_diff(spec, true);
+  }
+  for(const char* spec : diff_args) {
+    if(!add_diff(spec, false)) return 2;
+  }
+  if(num_diffs == 0) {
+    fprintf(stderr, "none of the differences match these stores\n");
+    return 2;
+  }
+
+  // Default to the span every store covers.
+  if(from == INT64_MIN || to == INT64_MAX) {
+    int64_t first = INT64_MIN, last = INT64_MAX;
+    for(uint8_t s = 0; s < num_stores; s++) {
+      if(stores[s].header->num_rows == 0) continue;
+      if(col_first_time(&stores[s]) > first) first = col_first_time(&stores[s]);
+      if(col_last_time(&stores[s]) < last) last = col_last_time(&stores[s]);
+    }
+    if(from == INT64_MIN) from = first;
+    if(to == INT64_MAX) to = last + 1;
+  }
+  from = (from + step - 1) / step * step;
+  if(to <= from) {
+    fprintf(stderr, "empty range\n");
+    return 2;
+  }
+
+  // Split the grid into equal time partitions.
+  int64_t points = (to - from + step - 1) / step;
+  if((int64_t)num_threads > points) num_threads = points;
+  parts.resize(num_threads);
+  for(unsigned i = 0; i < num_threads; i++) {
+    parts[i].from = from + points * i / num_threads * step;
+    parts[i].to = from + points * (i + 1) / num_threads * step;
+    parts[i].out = tmpfile();
+    if(!parts[i].out) {
+      perror("tmpfile");
+      return 1;
+    }
+  }
+  parts[num_threads - 1].to = to;
+
+  std::vector<std::thread> threads;
+  for(partition& p : parts) threads.emplace_back(run_partition, &p);
+  for(std::thread& t : threads) t.join();
+
+  // Header, then each partition's rows in order.
+  printf("time");
+  for(uint8_t r = 0; r < num_refs; r++) printf(",%s", refs[r].name);
+  for(uint8_t d = 0; d < num_diffs; d++) {
+    printf(",%s-%s", refs[diffs[d].a].name, refs[diffs[d].b].name);
+  }
+  printf("\n");
+  fflush(stdout);
+
+  static char buf[COPY_BUF_SIZE];
+  for(partition& p : parts) {
+    size_t n;
+    rewind(p.out);
+    while((n = fread(buf, 1, sizeof(buf), p.out)) > 0) fwrite(buf, 1, n, stdout);
+    fclose(p.out);
+  }
+  fflush(stdout);
+
+  if(print_stats) {
+    uint64_t rows = 0;
+    for(const partition& p : parts) rows += p.rows;
+    fprintf(stderr, "%llu grid points, %u partitions\n",
+      (unsigned long long)rows, num_threads);
+
+    for(uint8_t d = 0; d < num_diffs; d++) {
+      diff_stats total = {0, 0, INFINITY, -INFINITY};
+      for(const partition& p : parts) {
+        total.count += p.stats[d].count;
+        total.sum += p.stats[d].sum;
+        total.min = fminf(total.min, p.stats[d].min);
+        total.max = fmaxf(total.max, p.stats[d].max);
+      }
+      fprintf(stderr, "%s-%s: %llu paired, mean %.3f, min %.2f, max %.2f\n",
+        refs[diffs[d].a].name, refs[diffs[d].b].name,
+        (unsigned long long)total.count,
+        total.count ? total.sum / total.count : NAN, total.min, total.max);
+    }
+  }
+
+  for(uint8_t s = 0; s < num_stores; s++) col_close(&stores[s]);
+  return 0;
+}
+
+//==============================================================================
+// Parse Time Argument
+//==============================================================================
+static bool parse_when(const char* arg, int64_t* t) {
+  char     buf[LOG_TIME_LEN + 1];
+  log_date date;
+
+  if(strlen(arg) == 10) {
+    snprintf(buf, sizeof(buf), "%s 00:00:00", arg);
+    arg = buf;
+  }
+  if(!log_parse_time(arg, arg + strlen(arg), &date)) return false;
+  *t = log_time_from_date(&date);
+  return true;
+}
+
+//==============================================================================
+// Add Difference
+//==============================================================================
+// Defaults are skipped quietly when a store is missing.
+static bool add_diff(const char* spec, bool quiet) {
+  char  a[COL_NAME_LEN];
+  const char* dash = strchr(spec, '-');
+
+  if(!dash || dash == spec || dash - spec >= COL_NAME_LEN ||
+     num_diffs == MAX_DIFFS) {
+    if(!quiet) fprintf(stderr, "bad difference '%s'\n", spec);
+    return false;
+  }
+  memcpy(a, spec, dash - spec);
+  a[dash - spec] = 0;
+
+  int ra = add_ref(a);
+  int rb = ra < 0 ? -1 : add_ref(dash + 1);
+  if(ra < 0 || rb < 0) {
+    if(!quiet) fprintf(stderr, "no store has the columns in '%s'\n", spec);
+    return false;
+  }
+  diffs[num_diffs].a = ra;
+  diffs[num_diffs].b = rb;
+  num_diffs++;
+  return true;
+}
+
+//==============================================================================
+// Resolve Column Name
+//==============================================================================
+// Returns the reference index, adding one if needed, or -1.
+static int add_ref(const char* name) {
+  for(uint8_t r = 0; r < num_refs; r++) {
+    if(strcmp(refs[r].name, name) == 0) return r;
+  }
+
+  for(uint8_t s = 0; s < num_stores; s++) {
+    int c = col_find_column(&stores[s], name);
+    if(c < 0) continue;
+
+    // Each store's stream outputs its referenced columns in ref order.
+    uint8_t slot = 0;
+    for(uint8_t r = 0; r < num_refs; r++) slot += refs[r].store == s;
+
+    refs[num_refs].name = stores[s].header->names[c];
+    refs[num_refs].store = s;
+    refs[num_refs].column = c;
+    refs[num_refs].slot = slot;
+    return num_refs++;
+  }
+  return -1;
+}
+
+//==============================================================================
+// Join One Time Partition
+//==============================================================================
+static void run_partition(partition* p) {
+  // Local variables.
+  join_stream streams[MAX_STORES];
+  float       values[MAX_STORES][COL_MAX_COLUMNS];
+  char        date_string[LOG_TIME_LEN + 1];
+
+  for(uint8_t d = 0; d < num_diffs; d++) {
+    p->stats[d].min = INFINITY;
+    p->stats[d].max = -INFINITY;
+  }
+
+  for(uint8_t s = 0; s < num_stores; s++) {
+    uint8_t columns[COL_MAX_COLUMNS];
+    uint8_t n = 0;
+    for(uint8_t r = 0; r < num_refs; r++) {
+      if(refs[r].store == s) columns[n++] = refs[r].column;
+    }
+    join_stream_init(&streams[s], &stores[s], columns, n, p->from, tolerance);
+  }
+
+  for(int64_t t = p->from; t < p->to; t += step) {
+    for(uint8_t s = 0; s < num_stores; s++) {
+      join_stream_sample(&streams[s], t, mode, tolerance, values[s]);
+    }
+
+    log_format_time(t, date_string);
+    fputs(date_string, p->out);
+    for(uint8_t r = 0; r < num_refs; r++) {
+      fprintf(p->out, ",%.2f", values[refs[r].store][refs[r].slot]);
+    }
+    for(uint8_t d = 0; d < num_diffs; d++) {
+      const column_ref& a = refs[diffs[d].a];
+      const column_ref& b = refs[diffs[d].b];
+      float diff = values[a.store][a.slot] - values[b.store][b.slot];
+      fprintf(p->out, ",%.2f", diff);
+
+      if(isnan(diff)) continue;
+      diff_stats* st = &p->stats[d];
+      st->count++;
+      st->sum += diff;
+      if(diff < st->min) st->min = diff;
+      if(diff > st->max) st->max = diff;
+    }
+    fputc('\n', p->out);
+    p->rows++;
+  }
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-f FROM] [-t TO] [-g SECS] [-T SECS] "
+    "[-m asof|linear] [-j THREADS] [-d A-B]... [-s] STORE...\n", name);
+  exit(2);
+}
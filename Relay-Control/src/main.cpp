@@ -1,41 +1,168 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Relay Controller
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
 #include <Arduino.h>
+#include <util/atomic.h>
+#include <relay_protocol.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Pin Definitions
+#define TRIG_PIN        (7)
+#define LOAD_A_PIN      (8)
+#define LOAD_B_PIN      (9)
+
+// Program Parameters
+#define NUM_LOADS       (2)
+#define MS_PER_MINUTE   (60000UL)
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const uint8_t     load_pins[NUM_LOADS] = {LOAD_A_PIN, LOAD_B_PIN};
 
-#define DELAY_TIME (600000)
-#define DEBOUNCE_TIME (25)
+// Load State
+static bool              load_on[NUM_LOADS];
+static uint32_t          load_start[NUM_LOADS];
+static uint32_t          load_duration[NUM_LOADS];
 
+// Edge Capture (written by the pin change interrupt)
+static volatile uint8_t  pulses[RELAY_MAX_PULSES];
+static volatile uint8_t  num_pulses;
+static volatile bool     overflow;
+static volatile uint32_t fall_us;
+static volatile uint32_t last_edge_ms;
 
-uint8_t relay_on;
-uint64_t disable_time;
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
 
+void run_command(const relay_cmd* cmd);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Setup Routine
+//==============================================================================
 void setup() {
-  // put your setup code here, to run once:
-  pinMode(7, INPUT_PULLUP);
-  pinMode(8, OUTPUT);
-  pinMode(9, OUTPUT);
+  pinMode(TRIG_PIN, INPUT_PULLUP);
+  for(uint8_t i = 0; i < NUM_LOADS; i++) {
+    pinMode(load_pins[i], OUTPUT);
+    digitalWrite(load_pins[i], LOW);
+  }
 
+  // Pin 7 is PD7/PCINT23: capture every edge in the background.
+  PCMSK2 |= _BV(PCINT23);
+  PCIFR  |= _BV(PCIF2);
+  PCICR  |= _BV(PCIE2);
 }
 
+//==============================================================================
+// Main Loop
+//==============================================================================
 void loop() {
-  // put your main code here, to run repeatedly:
-  
-  if(!relay_on) {
-    if(!digitalRead(7)) {
-      delay(DEBOUNCE_TIME);
-      if(digitalRead(7)) {
-        delay(DEBOUNCE_TIME);
-          if(!digitalRead(7)) {
-          digitalWrite(8, HIGH);
-          digitalWrite(9, HIGH);
-          disable_time = millis() + DELAY_TIME;
-          relay_on = 1;
-
-        }
-      }
+  // Local variables.
+  uint8_t   frame[RELAY_MAX_PULSES];
+  uint8_t   count = 0;
+  bool      lost = false;
+  bool      complete = false;
+  relay_cmd cmd;
+
+  // A frame is over once the line has sat idle HIGH long enough.
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if(num_pulses > 0 && digitalRead(TRIG_PIN) &&
+       millis() - last_edge_ms > RELAY_FRAME_END_MS) {
+      count = num_pulses;
+      lost = overflow;
+      for(uint8_t i = 0; i < count; i++) frame[i] = pulses[i];
+      num_pulses = 0;
+      overflow = false;
+      complete = true;
+    }
+  }
+
+  if(complete && !lost && relay_decode(frame, count, &cmd)) {
+    run_command(&cmd);
+  }
+
+  // Turn loads off when their time is up.
+  for(uint8_t i = 0; i < NUM_LOADS; i++) {
+    if(load_on[i] && millis() - load_start[i] >= load_duration[i]) {
+      digitalWrite(load_pins[i], LOW);
+      load_on[i] = false;
     }
   }
-  else if(millis() >= disable_time) {
-    digitalWrite(8, LOW);
-    digitalWrite(9, LOW);
-    relay_on = 0;
+}
+
+//==============================================================================
+// Apply Relay Command
+//==============================================================================
+void run_command(const relay_cmd* cmd) {
+  for(uint8_t i = 0; i < NUM_LOADS; i++) {
+    if(!(cmd->loads & (1 << i))) continue;
+
+    // Zero minutes switches the load off; anything else (re)starts its timer.
+    if(cmd->minutes == 0) {
+      digitalWrite(load_pins[i], LOW);
+      load_on[i] = false;
+    }
+    else {
+      digitalWrite(load_pins[i], HIGH);
+      load_on[i] = true;
+      load_start[i] = millis();
+      load_duration[i] = cmd->minutes * MS_PER_MINUTE;
+    }
   }
 }
+
+//==============================================================================
+// Trigger Pin Change Interrupt
+//==============================================================================
+// Records the width of each LOW pulse in ms. Glitches shorter than
+// RELAY_GLITCH_MS are ignored.
+ISR(PCINT2_vect) {
+  uint32_t t = micros();
+
+  // Falling edge: pulse starts.
+  if(!(PIND & _BV(PIND7))) {
+    fall_us = t;
+    return;
+  }
+
+  // Rising edge: pulse ends.
+  uint32_t width_ms = (t - fall_us) / 1000;
+  if(width_ms < RELAY_GLITCH_MS) return;
+  if(width_ms > 255) width_ms = 255;
+
+  if(num_pulses < RELAY_MAX_PULSES) pulses[num_pulses++] = width_ms;
+  else overflow = true;
+  last_edge_ms = millis();
+}
\ No newline at end of file
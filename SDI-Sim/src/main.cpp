@@ -0,0 +1,598 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics SDI-12 Simulator
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Reads a simulated TEROS-12 on a virtual clock, once with the plots' old
+// blocking teros_12_read() and once with the sdi12_bus transactions the
+// plots run now, for a healthy sensor and for slow, garbled, absent and
+// failing ones. For each it reports how many readings came back right,
+// how long a reading took and the longest the plot's loop was stalled
+// (the time nothing else, like the AM2315 or the watchdog, got a turn).
+// The old reader runs under the plots' 4 s watchdog.
+//
+// Then it puts one to TEROS_MAX_PROBES healthy probes on the bus and
+// compares how long discovery takes, how long reading them one after
+// another the old way takes, and how long teros_sample()'s batch takes.
+//
+//   sdi_sim [-n TRIALS] [-p PROB] [-s SEED]
+//
+//   -n TRIALS  readings per sensor and reader (default 200)
+//   -p PROB    chance of a bit error per garbled character (default 0.02)
+//   -s SEED    random seed (default 1)
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sdi12_bus.h>
+#include <sensor_calc.h>
+#include <teros.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// 1200 baud, 10 bits a character; a command goes out after a 12 ms break
+// and 8.33 ms of marking.
+#define CHAR_US            (8333)
+#define WAKE_US            (20333)
+#define SPEC_LATENCY_US    (10000)
+
+// The sensors, at addresses from '0' up. Each says a measurement takes a
+// second but is done well before that. Replies are formats taking the
+// sensor's address; data gets its CRC if the measurement was aMC! or aCC!.
+#define FIRST_ADDR         ('0')
+#define MEASURE_US         (150000)
+#define MEASURE_REPLY      "%c0013\r\n"
+#define CONCURRENT_REPLY   "%c00103\r\n"
+#define SERVICE_REQUEST    "%c\r\n"
+#define ID_REPLY           "%c13METER   TER12 112T12-00001\r\n"
+#define DATA_VALUES        "%c+1863.85+22.5+1"
+#define REPLY_LEN          (48)
+#define TRUE_RAW           (1863.85f)
+#define TRUE_TEMP          (22.5f)
+#define TRUE_COND          (1)
+
+// How the slow sensor answers.
+#define SLOW_LATENCY_US    (80000)
+#define SLOW_CHAR_US       (15000)
+#define SLOW_MEASURE_US    (950000)
+
+// How much of the data line the truncated sensor gets out.
+#define TRUNCATED_LEN      (6)
+
+// Commands the dropout sensor misses before it answers again.
+#define DROPOUT_COMMANDS   (2)
+
+// The plots' watchdog, Stream's default timeout, and how long one pass of
+// the plot's wait loop takes besides the SDI-12 work.
+#define WATCHDOG_US        (4000000)
+#define STREAM_TIMEOUT_US  (1000000)
+#define LOOP_PASS_US       (500)
+#define SPIN_US            (10)
+
+#define MAX_PENDING        (64)
+#define DEFAULT_TRIALS     (200)
+#define DEFAULT_GARBLE     (0.02)
+
+// Outcome of one reading.
+#define RESULT_OK          (0)
+#define RESULT_WRONG       (1)
+#define RESULT_FAILED      (2)
+#define RESULT_WATCHDOG    (3)
+#define NUM_RESULTS        (4)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum sensor_kind {
+  SENSOR_OK,
+  SENSOR_SLOW,
+  SENSOR_GARBLED,
+  SENSOR_ABSENT,
+  SENSOR_DROPOUT,
+  SENSOR_TRUNCATED,
+  NUM_SENSORS
+};
+
+// A character on its way from the sensor. Each command starts the queue
+// over, so it never holds more than a couple of lines.
+struct pending_char {
+  uint64_t at_us;
+  int      c;
+};
+
+// The bus and the sensors on it, which all behave the same.
+struct sim_bus {
+  uint64_t     now_us;
+  sensor_kind  kind;
+  uint8_t      num_sensors;
+  pending_char pending[MAX_PENDING];
+  uint16_t     head;
+  uint16_t     tail;
+  uint64_t     ready_us[TEROS_MAX_PROBES];  // When each one's data is in.
+  bool         crc[TEROS_MAX_PROBES];       // And whether it has a CRC.
+  uint16_t     commands;    // Commands heard this reading.
+};
+
+struct reader_stats {
+  uint32_t results[NUM_RESULTS];
+  uint64_t total_us;
+  uint64_t longest_us;
+  uint64_t stall_us;
+  uint64_t retries;
+};
+
+typedef uint8_t (*reader)(sim_bus* bus, uint64_t* stall_us,
+                          uint16_t* retries);
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const char* sensor_names[NUM_SENSORS] = {
+  "healthy", "slow", "garbled", "absent", "dropout", "truncated"
+};
+
+static double   garble_prob = DEFAULT_GARBLE;
+static uint64_t rng_state = 1;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static uint8_t  legacy_read(sim_bus* bus, uint64_t* stall_us,
+                            uint16_t* retries);
+static uint8_t  legacy_read_at(sim_bus* bus, char addr, uint64_t* stall_us);
+static uint8_t  xact_read(sim_bus* bus, uint64_t* stall_us,
+                          uint16_t* retries);
+static uint8_t  check_reading(char* response, uint8_t len);
+static void     bus_reset(sim_bus* bus, sensor_kind kind,
+                          uint8_t num_sensors);
+static void     bus_send(void* ctx, const char* cmd);
+static int      bus_read(void* ctx);
+static int      bus_available(sim_bus* bus);
+static void     bus_clear(void* ctx);
+static uint32_t bus_millis(void* ctx);
+static void     sensor_reply(sim_bus* bus, const char* line,
+                             uint64_t latency_us, uint64_t char_us);
+static void     run(reader r, const char* name, sensor_kind kind,
+                    uint32_t trials);
+static void     run_profiles();
+static uint64_t run_table(sim_bus* bus, teros_probes* t, bool discover);
+static double   rng_uniform();
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  uint32_t trials = DEFAULT_TRIALS;
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      trials = strtoul(argv[++i], NULL, 10);
+    }
+    else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      garble_prob = atof(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      rng_state = strtoull(argv[++i], NULL, 10);
+    }
+    else {
+      fprintf(stderr, "usage: %s [-n TRIALS] [-p PROB] [-s SEED]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(trials == 0 || rng_state == 0) {
+    fprintf(stderr, "trials and seed must be more than 0\n");
+    return 2;
+  }
+
+  printf("%-10s %-7s %6s %6s %6s %6s %8s %8s %8s %7s\n", "sensor", "reader",
+         "ok", "wrong", "failed", "wdt", "mean ms", "max ms", "stall ms",
+         "retries");
+  for(int k = 0; k < NUM_SENSORS; k++) {
+    run(legacy_read, "old", (sensor_kind)k, trials);
+    run(xact_read, "xact", (sensor_kind)k, trials);
+  }
+  run_profiles();
+  return 0;
+}
+
+//==============================================================================
+// Old Reader
+//==============================================================================
+static uint8_t legacy_read(sim_bus* bus, uint64_t* stall_us,
+                           uint16_t* retries) {
+  *retries = 0;
+  return legacy_read_at(bus, FIRST_ADDR, stall_us);
+}
+
+//==============================================================================
+// Old Reader At Address
+//==============================================================================
+// teros_12_read() as the plots had it, on the simulated bus. It never
+// yields, so the whole reading is one stall.
+static uint8_t legacy_read_at(sim_bus* bus, char addr, uint64_t* stall_us) {
+  uint64_t start = bus->now_us;
+  char     input[SDI_RESPONSE_LEN];
+  char     cmd[SDI12_CMD_LEN];
+  uint8_t  str_size = 0;
+  uint8_t  result = RESULT_FAILED;
+
+  bus_clear(bus);
+  snprintf(cmd, sizeof(cmd), "%cM!", addr);
+  bus_send(bus, cmd);
+  bus->now_us += 100000;
+
+  if(bus_available(bus) > 5) {
+    bus->now_us += 900000;
+    bus_clear(bus);
+    snprintf(cmd, sizeof(cmd), "%cD0!", addr);
+    bus_send(bus, cmd);
+
+    // The spin wait, which only the watchdog ends.
+    while(bus_available(bus) < 10) {
+      bus->now_us += SPIN_US;
+      if(bus->now_us - start >= WATCHDOG_US) {
+        *stall_us = bus->now_us - start;
+        return RESULT_WATCHDOG;
+      }
+    }
+
+    // readBytesUntil() waits up to the stream timeout for each character.
+    while(str_size < SDI_RESPONSE_LEN - 1) {
+      uint64_t wait_start = bus->now_us;
+      int      c;
+
+      while((c = bus_read(bus)) < 0 &&
+            bus->now_us - wait_start < STREAM_TIMEOUT_US) {
+        bus->now_us += SPIN_US;
+      }
+      if(c < 0 || c == '\n') break;
+      input[str_size++] = (char)c;
+    }
+    input[str_size] = 0;
+    result = check_reading(input, str_size);
+  }
+
+  bus_clear(bus);
+  *stall_us = bus->now_us - start;
+  return result;
+}
+
+//==============================================================================
+// Transaction Reader
+//==============================================================================
+// What the plots do now: step the transaction along between the other
+// things the wait loop services.
+static uint8_t xact_read(sim_bus* bus, uint64_t* stall_us,
+                         uint16_t* retries) {
+  sdi12_port port = {bus, bus_send, bus_read, bus_clear, bus_millis};
+  sdi12_xact xact;
+
+  *stall_us = 0;
+  sdi12_init(&xact, &port);
+  sdi12_measure(&xact, FIRST_ADDR);
+  for(;;) {
+    uint64_t pass_start = bus->now_us;
+    uint8_t  status = sdi12_service(&xact);
+
+    if(bus->now_us - pass_start > *stall_us) {
+      *stall_us = bus->now_us - pass_start;
+    }
+    if(status != SDI12_BUSY) break;
+    bus->now_us += LOOP_PASS_US;
+  }
+
+  *retries = xact.retries;
+  if(xact.status != SDI12_OK) return RESULT_FAILED;
+  return check_reading(xact.response, xact.len);
+}
+
+//==============================================================================
+// Check Reading
+//==============================================================================
+// A reading that parses to other values than the sensor sent got corrupted
+// on the way without anyone noticing.
+static uint8_t check_reading(char* response, uint8_t len) {
+  float    raw;
+  float    temp;
+  uint16_t cond;
+
+  if(!teros_12_parse(response, len, &raw, &temp, &cond)) return RESULT_FAILED;
+  if(raw != TRUE_RAW || temp != TRUE_TEMP || cond != TRUE_COND) {
+    return RESULT_WRONG;
+  }
+  return RESULT_OK;
+}
+
+//==============================================================================
+// Reset Bus
+//==============================================================================
+static void bus_reset(sim_bus* bus, sensor_kind kind,
+                      uint8_t num_sensors) {
+  uint64_t now = bus->now_us;
+
+  memset(bus, 0, sizeof(*bus));
+  bus->now_us = now;
+  bus->kind = kind;
+  bus->num_sensors = num_sensors;
+}
+
+//==============================================================================
+// Send Command
+//==============================================================================
+// Takes as long as putting the command on the wire does. The break stops
+// anything the sensor was still sending, and then it answers the way its
+// kind does.
+static void bus_send(void* ctx, const char* cmd) {
+  sim_bus*    bus = (sim_bus*)ctx;
+  uint8_t     sensor = (uint8_t)(cmd[0] - FIRST_ADDR);
+  const char* op = cmd + 1;
+  uint64_t    latency = SPEC_LATENCY_US;
+  uint64_t    spacing = CHAR_US;
+  uint64_t    measure = MEASURE_US;
+  char        reply[REPLY_LEN];
+
+  bus->now_us += WAKE_US + strlen(cmd) * CHAR_US;
+  bus->head = bus->tail = 0;
+  bus->commands++;
+
+  if(sensor >= bus->num_sensors || bus->kind == SENSOR_ABSENT) return;
+  if(bus->kind == SENSOR_DROPOUT && bus->commands <= DROPOUT_COMMANDS) return;
+  if(bus->kind == SENSOR_SLOW) {
+    latency = SLOW_LATENCY_US;
+    spacing = SLOW_CHAR_US;
+    measure = SLOW_MEASURE_US;
+  }
+
+  if(strcmp(op, "!") == 0) {
+    snprintf(reply, REPLY_LEN, SERVICE_REQUEST, cmd[0]);
+    sensor_reply(bus, reply, latency, spacing);
+  }
+  else if(strcmp(op, "I!") == 0) {
+    snprintf(reply, REPLY_LEN, ID_REPLY, cmd[0]);
+    sensor_reply(bus, reply, latency, spacing);
+  }
+  else if(strcmp(op, "M!") == 0 || strcmp(op, "C!") == 0 ||
+          strcmp(op, "MC!") == 0 || strcmp(op, "CC!") == 0) {
+    bool concurrent = op[0] == 'C';
+
+    bus->crc[sensor] = op[1] == 'C';
+
+    snprintf(reply, REPLY_LEN, concurrent ? CONCURRENT_REPLY : MEASURE_REPLY,
+             cmd[0]);
+    sensor_reply(bus, reply, latency, spacing);
+    bus->ready_us[sensor] = bus->pending[bus->tail - 1].at_us + measure;
+
+    // All but the slow sensor say when an aM! measurement is in; aC!
+    // measurements never do.
+    if(!concurrent && bus->kind != SENSOR_SLOW) {
+      snprintf(reply, REPLY_LEN, SERVICE_REQUEST, cmd[0]);
+      sensor_reply(bus, reply, bus->ready_us[sensor] - bus->now_us, spacing);
+    }
+  }
+  else if(strcmp(op, "D0!") == 0) {
+    if(bus->now_us < bus->ready_us[sensor]) {
+      snprintf(reply, REPLY_LEN, SERVICE_REQUEST, cmd[0]);
+    }
+    else {
+      size_t len = snprintf(reply, REPLY_LEN, DATA_VALUES, cmd[0]);
+
+      if(bus->crc[sensor]) {
+        sdi12_crc(reply, len, reply + len);
+        len += SDI12_CRC_LEN;
+      }
+      strcpy(reply + len, "\r\n");
+
+      // It browns out partway through the line.
+      if(bus->kind == SENSOR_TRUNCATED) reply[TRUNCATED_LEN] = 0;
+    }
+    sensor_reply(bus, reply, latency, spacing);
+  }
+}
+
+//==============================================================================
+// Read Character
+//==============================================================================
+static int bus_read(void* ctx) {
+  sim_bus* bus = (sim_bus*)ctx;
+  int      c;
+
+  if(bus->head == bus->tail || bus->pending[bus->head].at_us > bus->now_us) {
+    return -1;
+  }
+  c = bus->pending[bus->head].c;
+  bus->head++;
+  return c;
+}
+
+//==============================================================================
+// Characters Received
+//==============================================================================
+static int bus_available(sim_bus* bus) {
+  int n = 0;
+
+  for(uint16_t i = bus->head; i < bus->tail; i++) {
+    if(bus->pending[i].at_us > bus->now_us) break;
+    n++;
+  }
+  return n;
+}
+
+//==============================================================================
+// Clear Received Characters
+//==============================================================================
+// Like SDI12::clearBuffer(), only what has already come in is dropped.
+static void bus_clear(void* ctx) {
+  sim_bus* bus = (sim_bus*)ctx;
+
+  while(bus->head != bus->tail &&
+        bus->pending[bus->head].at_us <= bus->now_us) {
+    bus->head++;
+  }
+}
+
+//==============================================================================
+// Current Time
+//==============================================================================
+static uint32_t bus_millis(void* ctx) {
+  return (uint32_t)(((sim_bus*)ctx)->now_us / 1000);
+}
+
+//==============================================================================
+// Queue Sensor Reply
+//==============================================================================
+// Queues line, starting latency_us from now. A garbled sensor flips a bit
+// of each character with probability garble_prob.
+static void sensor_reply(sim_bus* bus, const char* line, uint64_t latency_us,
+                         uint64_t char_us) {
+  uint64_t at = bus->now_us + latency_us;
+
+  for(const char* p = line; *p; p++) {
+    int c = *p;
+
+    if(bus->kind == SENSOR_GARBLED && rng_uniform() < garble_prob) {
+      c ^= 1 << (int)(rng_uniform() * 7);
+    }
+    at += char_us;
+    bus->pending[bus->tail].at_us = at;
+    bus->pending[bus->tail].c = c;
+    bus->tail++;
+  }
+}
+
+//==============================================================================
+// Run Reader
+//==============================================================================
+// Takes trials readings a minute apart and prints one line of results.
+static void run(reader r, const char* name, sensor_kind kind,
+                uint32_t trials) {
+  sim_bus      bus;
+  reader_stats stats;
+
+  memset(&stats, 0, sizeof(stats));
+  bus.now_us = 0;
+  for(uint32_t t = 0; t < trials; t++) {
+    uint64_t start;
+    uint64_t stall;
+    uint16_t retries;
+    uint8_t  result;
+
+    bus.now_us = (uint64_t)t * 60000000ULL;
+    bus_reset(&bus, kind, 1);
+    start = bus.now_us;
+    result = r(&bus, &stall, &retries);
+
+    stats.results[result]++;
+    stats.total_us += bus.now_us - start;
+    if(bus.now_us - start > stats.longest_us) {
+      stats.longest_us = bus.now_us - start;
+    }
+    if(stall > stats.stall_us) stats.stall_us = stall;
+    stats.retries += retries;
+  }
+
+  printf("%-10s %-7s %6u %6u %6u %6u %8.0f %8.0f %8.0f %7.2f\n",
+         sensor_names[kind], name, stats.results[RESULT_OK],
+         stats.results[RESULT_WRONG], stats.results[RESULT_FAILED],
+         stats.results[RESULT_WATCHDOG],
+         stats.total_us / 1000.0 / trials, stats.longest_us / 1000.0,
+         stats.stall_us / 1000.0, (double)stats.retries / trials);
+}
+
+//==============================================================================
+// Run Profiles
+//==============================================================================
+// Puts 1 to TEROS_MAX_PROBES healthy probes on the bus and prints how long
+// discovery, the old one-at-a-time reads and a batch read take.
+static void run_profiles() {
+  sdi12_port   port = {NULL, bus_send, bus_read, bus_clear, bus_millis};
+  sdi12_xact   xact;
+  teros_probes probes;
+  sim_bus      bus;
+
+  printf("\n%-7s %6s %8s %8s %8s %8s\n", "probes", "found", "scan ms",
+         "old ms", "batch ms", "batch ok");
+  for(uint8_t n = 1; n <= TEROS_MAX_PROBES; n++) {
+    uint64_t scan_us;
+    uint64_t old_us;
+    uint64_t batch_us;
+    uint64_t start;
+    uint64_t stall;
+
+    bus.now_us = 0;
+    bus_reset(&bus, SENSOR_OK, n);
+    port.bus = &bus;
+    sdi12_init(&xact, &port);
+    teros_init(&probes, &xact);
+    scan_us = run_table(&bus, &probes, true);
+
+    start = bus.now_us;
+    for(uint8_t i = 0; i < n; i++) legacy_read_at(&bus, FIRST_ADDR + i, &stall);
+    old_us = bus.now_us - start;
+
+    batch_us = run_table(&bus, &probes, false);
+
+    printf("%-7u %6u %8.0f %8.0f %8.0f %8u\n", n, probes.num_probes,
+           scan_us / 1000.0, old_us / 1000.0, batch_us / 1000.0,
+           probes.num_probes - probes.num_failed);
+  }
+}
+
+//==============================================================================
+// Run Probe Table
+//==============================================================================
+// Runs a discovery or a batch read to the end and returns how long it took.
+static uint64_t run_table(sim_bus* bus, teros_probes* t, bool discover) {
+  uint64_t start = bus->now_us;
+
+  if(discover) teros_discover(t);
+  else teros_sample(t);
+  while(teros_service(t) == SDI12_BUSY) bus->now_us += LOOP_PASS_US;
+  return bus->now_us - start;
+}
+
+//==============================================================================
+// Random Number
+//==============================================================================
+// xorshift64*, uniform in [0, 1).
+static double rng_uniform() {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return (rng_state * 0x2545F4914F6CDD1DULL >> 11) * (1.0 / 9007199254740992.0);
+}
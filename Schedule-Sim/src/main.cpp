@@ -0,0 +1,464 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Load Schedule Simulator
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Replays Plot-2 MM-DD_HH.log files through the irradiance-aware load
+// scheduler (the same code the plot runs) and through the old fixed clock
+// schedule (both loads for 10 minutes at the top of every hour from 9:00 to
+// 17:00), and compares how much load time each gives and how much of it
+// lands in good sun.
+//
+// Commands reach the simulated Relay-Control through a model of the trigger
+// wire: each minute's frames are sent back to back, as Plot-2 does, and
+// decoded the way Relay-Control does, so frames the receiver would merge or
+// drop are counted as lost. Before replaying, two back-to-back frames are
+// checked on their own; if they don't both come through the exit code is 1.
+//
+//   schedule_sim [-v] [-r RULE]... FILE...
+//
+//   -v       print a per-minute trace as CSV to stdout
+//   -r RULE  replace the built-in rules; RULE is
+//            loads,start,end,on,off,min_on,min_off,refresh,budget
+//            and may be given up to LOAD_SCHEDULE_MAX_RULES times
+//
+// Give the files in time order; shell glob order works for MM-DD_HH names
+// within a year.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <load_rules.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+// Plot-2 log columns (after the timestamp).
+#define NUM_COLUMNS        (10)
+#define IRAD_COLUMN        (5)
+#define PV_FIRST_COLUMN    (7)
+#define PV_NUM_COLUMNS     (3)
+
+// Relay-Control loads.
+#define NUM_LOADS          (2)
+
+// The schedule Plot-2 used before the scheduler.
+#define CLOCK_START_HOUR   (9)
+#define CLOCK_END_HOUR     (17)
+#define CLOCK_ON_MINUTES   (10)
+
+// Minutes on below this much derated irradiance count as wasted.
+#define LOW_SUN_WSQM       (200)
+
+// Start pulse, a gap and pulse per bit, and the closing idle (relay_tx.cpp).
+#define WIRE_SEGMENTS      (1 + 2 * RELAY_FRAME_BITS + 1)
+
+#define LINE_LEN           (256)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// Relay-Control as seen from outside: per-load minutes remaining.
+struct relay_model {
+  uint16_t remaining[NUM_LOADS];
+};
+
+struct load_stats {
+  uint64_t on_minutes;
+  uint64_t low_sun_minutes;
+  double   insolation_wh;   // derated Wh/m^2 seen while on
+};
+
+struct strategy {
+  const char* name;
+  relay_model relay;
+  load_stats  loads[NUM_LOADS];
+  uint64_t    commands;
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static load_rule     rules[LOAD_SCHEDULE_MAX_RULES];
+static uint8_t       num_rules;
+static load_schedule scheduler;
+static strategy      sched;
+static strategy      clock_sched;
+static bool          verbose;
+static uint64_t      num_rows;
+static uint64_t      num_bad_rows;
+static double        available_wh;
+static uint64_t      frames_sent;
+static uint64_t      frames_lost;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool    parse_rule(const char* arg, load_rule* rule);
+static bool    replay_file(const char* path);
+static bool    parse_row(char* line, struct tm* tm, float* values);
+static void    step_row(const struct tm* tm, const float* values);
+static uint8_t relay_wire(const relay_cmd* cmds, uint8_t num_cmds,
+                          relay_cmd* out);
+static bool    wire_check();
+static void    apply_cmd(strategy* s, const relay_cmd* cmd);
+static uint8_t tick(strategy* s, float eff);
+static void    print_report(const strategy* s);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  bool ok = true;
+  int  num_files = 0;
+
+  // Pick up rule overrides first so every file sees the same rules.
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      if(num_rules == LOAD_SCHEDULE_MAX_RULES ||
+         !parse_rule(argv[i + 1], &rules[num_rules])) {
+        fprintf(stderr, "bad rule '%s'\n", argv[i + 1]);
+        return 2;
+      }
+      num_rules++;
+      i++;
+    }
+  }
+  if(num_rules == 0) {
+    memcpy(rules, load_rules, sizeof(load_rules));
+    num_rules = NUM_LOAD_RULES;
+  }
+  load_schedule_init(&scheduler, rules, num_rules, LOAD_SMOOTHING_MINUTES);
+  sched.name = "irradiance";
+  clock_sched.name = "clock";
+
+  if(!wire_check()) {
+    fprintf(stderr, "relay wire: back-to-back frames don't both decode\n");
+    ok = false;
+  }
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-v") == 0) {
+      if(!verbose) printf("time,irad,pv_temp,derated,filtered,sched_loads,clock_loads\n");
+      verbose = true;
+      continue;
+    }
+    if(strcmp(argv[i], "-r") == 0) {
+      i++;
+      continue;
+    }
+    ok &= replay_file(argv[i]);
+    num_files++;
+  }
+
+  if(num_files == 0) {
+    fprintf(stderr, "usage: %s [-v] [-r RULE]... FILE...\n", argv[0]);
+    return 2;
+  }
+
+  fprintf(stderr, "rows:      %llu (%llu unreadable)\n",
+    (unsigned long long)num_rows, (unsigned long long)num_bad_rows);
+  fprintf(stderr, "available: %.1f Wh/m^2 derated insolation\n", available_wh);
+  fprintf(stderr, "relay:     %llu frames sent, %llu lost on the wire\n",
+    (unsigned long long)frames_sent, (unsigned long long)frames_lost);
+  print_report(&sched);
+  print_report(&clock_sched);
+  return ok ? 0 : 1;
+}
+
+//==============================================================================
+// Parse Rule Argument
+//==============================================================================
+static bool parse_rule(const char* arg, load_rule* rule) {
+  unsigned loads, start, end, min_on, min_off, refresh, budget;
+  int      on, off;
+
+  if(sscanf(arg, "%u,%u,%u,%d,%d,%u,%u,%u,%u", &loads, &start, &end, &on,
+            &off, &min_on, &min_off, &refresh, &budget) != 9) {
+    return false;
+  }
+  if(loads == 0 || loads > RELAY_LOADS_ALL || start > 23 || end > 23 ||
+     off > on || min_on > 255 || min_off > 255 || refresh == 0 ||
+     refresh > 255 || budget > 0xFFFF) {
+    return false;
+  }
+
+  rule->loads = loads;
+  rule->start_hour = start;
+  rule->end_hour = end;
+  rule->on_wsqm = on;
+  rule->off_wsqm = off;
+  rule->min_on_minutes = min_on;
+  rule->min_off_minutes = min_off;
+  rule->refresh_minutes = refresh;
+  rule->max_daily_minutes = budget;
+  return true;
+}
+
+//==============================================================================
+// Replay One Log File
+//==============================================================================
+static bool replay_file(const char* path) {
+  // Local variables.
+  FILE*     in;
+  char      line[LINE_LEN];
+  struct tm tm;
+  float     values[NUM_COLUMNS];
+
+  in = fopen(path, "r");
+  if(!in) {
+    perror(path);
+    return false;
+  }
+
+  while(fgets(line, sizeof(line), in)) {
+    // Header lines and blank lines are skipped quietly.
+    if(strncmp(line, "created_at", 10) == 0 || line[0] == '\n' ||
+       line[0] == '\r') {
+      continue;
+    }
+    if(!parse_row(line, &tm, values)) {
+      num_bad_rows++;
+      continue;
+    }
+    step_row(&tm, values);
+    num_rows++;
+  }
+
+  fclose(in);
+  return true;
+}
+
+//==============================================================================
+// Parse Log Row
+//==============================================================================
+static bool parse_row(char* line, struct tm* tm, float* values) {
+  char* p;
+  char* end;
+
+  memset(tm, 0, sizeof(*tm));
+  if(sscanf(line, "%d-%d-%d %d:%d:%d", &tm->tm_year, &tm->tm_mon,
+            &tm->tm_mday, &tm->tm_hour, &tm->tm_min, &tm->tm_sec) != 6) {
+    return false;
+  }
+  tm->tm_year -= 1900;
+  tm->tm_mon -= 1;
+
+  p = strchr(line, ',');
+  for(uint8_t i = 0; i < NUM_COLUMNS; i++) {
+    if(!p) return false;
+    values[i] = strtof(p + 1, &end);
+    if(end == p + 1) return false;
+    p = strchr(end, ',');
+  }
+  return true;
+}
+
+//==============================================================================
+// Advance Both Strategies One Row
+//==============================================================================
+static void step_row(const struct tm* tm, const float* values) {
+  // Local variables.
+  relay_cmd cmds[LOAD_SCHEDULE_MAX_RULES];
+  relay_cmd received[LOAD_SCHEDULE_MAX_RULES];
+  uint8_t   num_cmds;
+  uint8_t   num_received;
+  float     irad = values[IRAD_COLUMN];
+  float     pv_temp = 0;
+  uint8_t   num_valid = 0;
+  float     eff;
+  uint8_t   sched_mask;
+  uint8_t   clock_mask;
+
+  // Same PV temperature handling as Plot-2's schedule_loads().
+  for(uint8_t i = 0; i < PV_NUM_COLUMNS; i++) {
+    if(values[PV_FIRST_COLUMN + i] > LOAD_PV_TEMP_INVALID) {
+      pv_temp += values[PV_FIRST_COLUMN + i];
+      num_valid++;
+    }
+  }
+  pv_temp = (num_valid > 0) ? pv_temp / num_valid : LOAD_PV_TEMP_INVALID;
+  eff = load_schedule_derate(irad, pv_temp);
+  available_wh += eff / 60;
+
+  num_cmds = load_schedule_step(&scheduler, tm->tm_mday, tm->tm_hour, irad,
+                                pv_temp, cmds);
+  num_received = relay_wire(cmds, num_cmds, received);
+  frames_sent += num_cmds;
+  frames_lost += num_cmds - num_received;
+  for(uint8_t i = 0; i < num_received; i++) apply_cmd(&sched, &received[i]);
+
+  if(tm->tm_min == 0 && tm->tm_hour >= CLOCK_START_HOUR &&
+     tm->tm_hour <= CLOCK_END_HOUR) {
+    relay_cmd cmd = {RELAY_LOADS_ALL, CLOCK_ON_MINUTES};
+    apply_cmd(&clock_sched, &cmd);
+  }
+
+  sched_mask = tick(&sched, eff);
+  clock_mask = tick(&clock_sched, eff);
+
+  if(verbose) {
+    printf("%04d-%02d-%02d %02d:%02d:%02d,%.1f,%.2f,%.1f,%.1f,%u,%u\n",
+      tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour,
+      tm->tm_min, tm->tm_sec, irad, pv_temp, eff, scheduler.filtered_wsqm,
+      sched_mask, clock_mask);
+  }
+}
+
+//==============================================================================
+// Send Frames Over The Wire
+//==============================================================================
+// Lays the frames out as relay_tx_send() does, each starting the moment the
+// one before finishes its idle, and decodes the line as Relay-Control does:
+// the interrupt records each LOW pulse at its rising edge, and the loop,
+// looking every millisecond, closes the frame after RELAY_FRAME_END_MS of
+// HIGH. Returns how many commands came through, in out.
+static uint8_t relay_wire(const relay_cmd* cmds, uint8_t num_cmds,
+                          relay_cmd* out) {
+  // Local variables.
+  uint8_t  segments[LOAD_SCHEDULE_MAX_RULES * WIRE_SEGMENTS];
+  uint16_t num_segments = 0;
+  uint8_t  pulses[RELAY_MAX_PULSES];
+  uint8_t  num_pulses = 0;
+  bool     overflow = false;
+  uint8_t  num_out = 0;
+  uint32_t t = 0;
+  uint32_t last_edge = 0;
+
+  for(uint8_t c = 0; c < num_cmds; c++) {
+    uint16_t word = relay_encode(cmds[c].loads, cmds[c].minutes);
+    segments[num_segments++] = RELAY_START_MS;
+    for(int8_t bit = RELAY_FRAME_BITS - 1; bit >= 0; bit--) {
+      segments[num_segments++] = RELAY_GAP_MS;
+      segments[num_segments++] = (word >> bit) & 1 ? RELAY_ONE_MS
+                                                   : RELAY_ZERO_MS;
+    }
+    segments[num_segments++] = RELAY_IDLE_MS;
+  }
+
+  // Every frame is an even number of segments, so even ones are LOW.
+  for(uint16_t i = 0; i < num_segments; i++) {
+    if(i % 2 == 0) {
+      t += segments[i];
+      if(num_pulses < RELAY_MAX_PULSES) pulses[num_pulses++] = segments[i];
+      else overflow = true;
+      last_edge = t;
+      continue;
+    }
+
+    for(uint8_t ms = 1; ms <= segments[i]; ms++) {
+      if(num_pulses > 0 && t + ms - last_edge > RELAY_FRAME_END_MS) {
+        if(!overflow && relay_decode(pulses, num_pulses, &out[num_out])) {
+          num_out++;
+        }
+        num_pulses = 0;
+        overflow = false;
+      }
+    }
+    t += segments[i];
+  }
+
+  // The line stays idle after the last frame.
+  if(num_pulses > 0 && !overflow &&
+     relay_decode(pulses, num_pulses, &out[num_out])) {
+    num_out++;
+  }
+  return num_out;
+}
+
+//==============================================================================
+// Check Back-To-Back Frames
+//==============================================================================
+// One load off and the other refreshed in the same minute, as the
+// scheduler does.
+static bool wire_check() {
+  relay_cmd cmds[2] = {{RELAY_LOAD_A, 0}, {RELAY_LOAD_B, 15}};
+  relay_cmd received[2];
+
+  return relay_wire(cmds, 2, received) == 2 &&
+         received[0].loads == cmds[0].loads &&
+         received[0].minutes == cmds[0].minutes &&
+         received[1].loads == cmds[1].loads &&
+         received[1].minutes == cmds[1].minutes;
+}
+
+//==============================================================================
+// Apply Relay Command
+//==============================================================================
+// Mirrors Relay-Control's run_command().
+static void apply_cmd(strategy* s, const relay_cmd* cmd) {
+  for(uint8_t i = 0; i < NUM_LOADS; i++) {
+    if(cmd->loads & (1 << i)) s->relay.remaining[i] = cmd->minutes;
+  }
+  s->commands++;
+}
+
+//==============================================================================
+// Run Loads For One Minute
+//==============================================================================
+// Returns the mask of loads that were on.
+static uint8_t tick(strategy* s, float eff) {
+  uint8_t mask = 0;
+
+  for(uint8_t i = 0; i < NUM_LOADS; i++) {
+    if(s->relay.remaining[i] == 0) continue;
+    s->relay.remaining[i]--;
+    s->loads[i].on_minutes++;
+    s->loads[i].insolation_wh += eff / 60;
+    if(eff < LOW_SUN_WSQM) s->loads[i].low_sun_minutes++;
+    mask |= 1 << i;
+  }
+  return mask;
+}
+
+//==============================================================================
+// Print Strategy Summary
+//==============================================================================
+static void print_report(const strategy* s) {
+  fprintf(stderr, "\n%s schedule: %llu commands\n", s->name,
+    (unsigned long long)s->commands);
+  for(uint8_t i = 0; i < NUM_LOADS; i++) {
+    const load_stats* l = &s->loads[i];
+    fprintf(stderr, "  load %c: %6llu min on, %6llu in low sun, "
+      "%.1f Wh/m^2 while on (%.0f W/m^2 average)\n", 'A' + i,
+      (unsigned long long)l->on_minutes,
+      (unsigned long long)l->low_sun_minutes, l->insolation_wh,
+      l->on_minutes ? l->insolation_wh * 60 / l->on_minutes : 0.0);
+  }
+}
@@ -0,0 +1,822 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics Sensor Replay
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Regression harness for read_sensors() and the calibration math. Feeds
+// recorded minutes through the plots' sensor code (Common/sensor_calc,
+// built natively) on a virtual clock and diffs the rows it would log
+// against the reference logs.
+//
+//   sensor_replay [-o] [-v] [-e TOL] [-p] FILE...
+//
+//   -o  print the replayed rows to stdout
+//   -v  print every mismatching field to stderr
+//   -e  tolerance for a field to still match (default 0: same text)
+//   -p  check soil_physics' tables against the float equations (no FILEs
+//       needed)
+//
+// FILEs are hourly MM-DD_HH.log files or merged plot-N.csv from Log-Ingest,
+// in time order; each row's column count says which plot logged it. Logs
+// hold only derived values, so for each row the raw readings that produce
+// it are rebuilt: the ADS1115 count the irradiance polynomial maps to the
+// logged W/m^2, TEROS-12/21 SDI-12 responses carrying the logged counts and
+// temperatures, and AM2315/DS18B20 samples at the logged means. Those go
+// through the same averaging, parsing, conversion and Print formatting as
+// on the board, so a change to any of them shows up as mismatches.
+//
+// MM-DD.raw files from the plots' raw capture mode (Common/raw_capture) are
+// replayed from the readings the sensors actually gave. When any are given,
+// the logs only serve as the reference rows, matched by plot and minute.
+//
+// The virtual clock also checks the minute cadence: rows filed in the wrong
+// hourly file, missed and repeated minutes, and RTC jumps.
+//
+// -p sweeps soil_physics over the raw counts and soil temperatures the
+// plots see and compares its fixed-point water content, permittivity and
+// bulk EC with the equations they're tabulated from, in double.
+//
+// Exits 1 if any row differs or soil_physics is out of tolerance, so it can
+// gate CI on a season of logs.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <plot_log.h>
+#include <sensor_calc.h>
+#include <calibration.h>
+#include <raw_capture.h>
+#include <soil_physics.h>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define MAX_PROBES       (4)
+#define LINE_LEN         (512)
+#define MAX_ADC_COUNTS   (32767)
+#define TEROS_21_TEMP    (20.0f)
+#define MAX_GAP_MINUTES  (24 * 60)
+#define DS18B20_PER_C    (128)
+#define AM2315_PER_UNIT  (10)
+
+// The soil_physics sweep: raw counts and soil temperatures the plots see,
+// in steps of the 1/16ths it works in, and how far off it may be. Below a
+// permittivity of SOIL_DRY_PERM the 1/100 units are most of the error, so
+// it's held to an absolute error there.
+#define SOIL_RAW_LOW     (1850)
+#define SOIL_RAW_HIGH    (3200)
+#define SOIL_TEMP_LOW    (-5)
+#define SOIL_TEMP_HIGH   (45)
+#define SOIL_STEP        (0.0625)
+#define SOIL_TEST_EC     (1000)
+#define SOIL_DRY_PERM    (5.0)
+#define SOIL_VWC_TOL     (0.0006)
+#define SOIL_DRY_TOL     (0.012)
+#define SOIL_PERM_TOL    (0.002)
+#define SOIL_EC_TOL      (0.001)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+// One minute of raw readings, as read_sensors() gets them.
+struct raw_minute {
+  int64_t t;
+  uint8_t plot_id;
+  uint8_t num_records;
+  int16_t irad[SENSOR_NUM_SAMPLES];
+  char    teros_12[SDI_RESPONSE_LEN];
+  uint8_t teros_12_len;
+  char    teros_21[SDI_RESPONSE_LEN];
+  uint8_t teros_21_len;
+  uint8_t amb_count;
+  int16_t amb_temp[AM2315_MAX_READINGS];
+  int16_t amb_humd[AM2315_MAX_READINGS];
+  int16_t probes[SENSOR_NUM_SAMPLES][MAX_PROBES];
+};
+
+// A plot's firmware state: the globals read_sensors() writes, which keep
+// their last value when a read fails.
+struct plot_state {
+  bool    seen;
+  float   values[PLOT_LOG_MAX_COLUMNS];
+  int64_t last_minute;
+};
+
+struct column_stats {
+  uint64_t mismatches;
+  float    max_diff;
+};
+
+struct replay_stats {
+  uint64_t     rows;
+  uint64_t     rows_differing;
+  uint64_t     skipped;
+  uint64_t     misfiled;
+  uint64_t     missed_minutes;
+  uint64_t     repeated_minutes;
+  uint64_t     clock_jumps;
+  uint64_t     frames;
+  uint64_t     incomplete_frames;
+  uint64_t     unmatched_frames;
+  uint32_t     torn_bytes;
+  column_stats columns[NUM_PLOTS][PLOT_LOG_MAX_COLUMNS];
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool         print_rows = false;
+static bool         verbose = false;
+static float        tolerance = 0;
+static plot_state   plots[NUM_PLOTS];
+static replay_stats stats;
+
+// Logged W/m^2 to the mean count that produces it, per irradiance sensor.
+static std::unordered_map<int, int16_t> irad_inverse[NUM_IRAD_SENSORS];
+
+// Reference rows by plot and minute, when replaying raw captures.
+static std::unordered_map<int64_t, std::string> reference;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool is_raw_file(const char* path);
+static bool replay_log(const char* path, bool reference_only);
+static bool replay_raw(const char* path);
+static void replay_frame(raw_minute* raw, const char* where);
+static void replay_row(const plot_schema* schema, const raw_minute* raw,
+                       const char* line, const char* where);
+static void rebuild_raw(const plot_schema* schema, const float* logged,
+                        raw_minute* raw);
+static void read_sensors(const plot_schema* schema, const raw_minute* raw,
+                         float* values);
+static int  format_row(const plot_schema* schema, int64_t t,
+                       const float* values, char* buf);
+static void check_cadence(const plot_schema* schema, int64_t t,
+                          const log_date* file_hour);
+static int16_t irad_counts_for(uint8_t sensor, float wsqm);
+static void spread(int32_t total, int16_t* samples, uint8_t stride);
+static int  expected_records(const plot_schema* schema);
+static int64_t reference_key(uint8_t plot_id, int64_t t);
+static bool column_is(const char* name, const char* prefix, const char* kind);
+static void print_summary(double secs);
+static bool check_soil_physics();
+static double soil_perm(double raw);
+static double soil_topp(double perm);
+static double soil_soilless(double raw);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  std::vector<const char*> logs;
+  std::vector<const char*> captures;
+  bool                     ok = true;
+  bool                     check_soil = false;
+  clock_t                  start = clock();
+
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-o") == 0) print_rows = true;
+    else if(strcmp(argv[i], "-v") == 0) verbose = true;
+    else if(strcmp(argv[i], "-e") == 0 && i + 1 < argc) tolerance = atof(argv[++i]);
+    else if(strcmp(argv[i], "-p") == 0) check_soil = true;
+    else if(is_raw_file(argv[i])) captures.push_back(argv[i]);
+    else logs.push_back(argv[i]);
+  }
+  if(logs.empty() && captures.empty() && !check_soil) {
+    fprintf(stderr, "usage: %s [-o] [-v] [-e TOL] [-p] FILE...\n", argv[0]);
+    return 2;
+  }
+  if(check_soil) {
+    ok &= check_soil_physics();
+    if(logs.empty() && captures.empty()) return ok ? 0 : 1;
+  }
+
+  for(const char* path : logs) ok &= replay_log(path, !captures.empty());
+  for(const char* path : captures) ok &= replay_raw(path);
+
+  print_summary((double)(clock() - start) / CLOCKS_PER_SEC);
+  return ok && stats.rows_differing == 0 ? 0 : 1;
+}
+
+//==============================================================================
+// Detect Raw Capture File
+//==============================================================================
+static bool is_raw_file(const char* path) {
+  size_t len = strlen(path);
+  return len > 4 && (strcmp(path + len - 4, ".raw") == 0 ||
+                     strcmp(path + len - 4, ".RAW") == 0);
+}
+
+//==============================================================================
+// Replay One Log File
+//==============================================================================
+// With reference_only the rows are just kept for replay_raw() to compare
+// against.
+static bool replay_log(const char* path, bool reference_only) {
+  // Local variables.
+  FILE*       in = fopen(path, "r");
+  char        line[LINE_LEN];
+  char        where[LINE_LEN];
+  log_date    file_hour;
+  log_date    date;
+  float       logged[PLOT_LOG_MAX_COLUMNS];
+  raw_minute  raw;
+  bool        hourly = log_parse_name(path, &file_hour);
+  uint64_t    line_num = 0;
+
+  if(!in) {
+    perror(path);
+    return false;
+  }
+
+  while(fgets(line, sizeof(line), in)) {
+    size_t len = strlen(line);
+    line_num++;
+    while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+      line[--len] = 0;
+    }
+    if(len == 0 || log_is_header(line, line + len)) continue;
+
+    int n = log_parse_row(line, line + len, &date, logged, PLOT_LOG_MAX_COLUMNS);
+    const plot_schema* schema = n > 0 ? plot_schema_by_columns(n) : NULL;
+    if(!schema) {
+      stats.skipped++;
+      continue;
+    }
+
+    raw.t = log_time_from_date(&date);
+    if(reference_only) {
+      reference[reference_key(schema->plot_id, raw.t)] = line;
+      continue;
+    }
+
+    check_cadence(schema, raw.t, hourly ? &file_hour : NULL);
+    rebuild_raw(schema, logged, &raw);
+    snprintf(where, sizeof(where), "%s:%llu", path, (unsigned long long)line_num);
+    replay_row(schema, &raw, line, where);
+  }
+
+  fclose(in);
+  return true;
+}
+
+//==============================================================================
+// Replay One Raw Capture File
+//==============================================================================
+static bool replay_raw(const char* path) {
+  // Local variables.
+  FILE*                in = fopen(path, "rb");
+  std::vector<uint8_t> data;
+  uint8_t              chunk[65536];
+  size_t               n;
+  raw_record           rec;
+  raw_minute           raw;
+  bool                 in_frame = false;
+  char                 where[LINE_LEN];
+
+  if(!in) {
+    perror(path);
+    return false;
+  }
+  while((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  fclose(in);
+
+  const uint8_t* p = data.data();
+  const uint8_t* end = p + data.size();
+
+  while(raw_next(&p, end, &rec, &stats.torn_bytes)) {
+    if(rec.type == RAW_REC_FRAME) {
+      if(in_frame) replay_frame(&raw, where);
+      memset(&raw, 0, sizeof(raw));
+      raw.plot_id = rec.sensor;
+      raw.t = raw_get_u32(rec.payload + 2);
+      snprintf(where, sizeof(where), "%s@%ld", path,
+        (long)(rec.payload - RAW_HEADER_SIZE - data.data()));
+      in_frame = true;
+      continue;
+    }
+    if(!in_frame) continue;
+
+    const plot_schema* schema = plot_schema_by_id(raw.plot_id);
+    uint8_t            samples = rec.len / sizeof(int16_t);
+    raw.num_records++;
+
+    switch(rec.type) {
+      case RAW_REC_ADC:
+        for(uint8_t i = 0; i < samples && i < SENSOR_NUM_SAMPLES; i++) {
+          raw.irad[i] = raw_get_i16(rec.payload + 2 * i);
+        }
+        break;
+      case RAW_REC_AM2315:
+        // However many readings the sensor made that minute.
+        raw.amb_count = 0;
+        for(uint8_t i = 0; i < samples / 2 && i < AM2315_MAX_READINGS; i++) {
+          raw.amb_temp[i] = raw_get_i16(rec.payload + 4 * i);
+          raw.amb_humd[i] = raw_get_i16(rec.payload + 4 * i + 2);
+          raw.amb_count++;
+        }
+        break;
+      case RAW_REC_DS18B20:
+        for(uint16_t i = 0; rec.sensor > 0 && i < samples; i++) {
+          uint16_t s = i / rec.sensor;
+          uint8_t  probe = i % rec.sensor;
+          if(s < SENSOR_NUM_SAMPLES && probe < MAX_PROBES) {
+            raw.probes[s][probe] = raw_get_i16(rec.payload + 2 * i);
+          }
+        }
+        break;
+      case RAW_REC_SDI:
+        // Which sensor the soil number is tells which parser it needs.
+        for(uint8_t c = 0; schema && c < schema->num_columns; c++) {
+          const char* name = schema->columns[c];
+          char*       response = NULL;
+          uint8_t*    len = NULL;
+          if(name[5] - '0' != rec.sensor) continue;
+          if(column_is(name, "soil", "volw")) {
+            response = raw.teros_12;
+            len = &raw.teros_12_len;
+          }
+          else if(column_is(name, "soil", "sowp")) {
+            response = raw.teros_21;
+            len = &raw.teros_21_len;
+          }
+          if(!response) continue;
+          *len = rec.len < SDI_RESPONSE_LEN ? rec.len : SDI_RESPONSE_LEN - 1;
+          memcpy(response, rec.payload, *len);
+          response[*len] = 0;
+        }
+        break;
+    }
+  }
+  if(in_frame) replay_frame(&raw, where);
+  return true;
+}
+
+//==============================================================================
+// Replay One Raw Frame
+//==============================================================================
+static void replay_frame(raw_minute* raw, const char* where) {
+  const plot_schema* schema = plot_schema_by_id(raw->plot_id);
+
+  stats.frames++;
+  if(!schema || raw->num_records != expected_records(schema)) {
+    stats.incomplete_frames++;
+    return;
+  }
+  check_cadence(schema, raw->t, NULL);
+
+  auto it = reference.find(reference_key(schema->plot_id, raw->t));
+  if(it == reference.end()) stats.unmatched_frames++;
+  replay_row(schema, raw, it == reference.end() ? NULL : it->second.c_str(),
+    where);
+}
+
+//==============================================================================
+// Replay One Minute
+//==============================================================================
+// Runs the raw readings through the plot's sensor code and compares the
+// row it would log against the reference line, if there is one.
+static void replay_row(const plot_schema* schema, const raw_minute* raw,
+                       const char* line, const char* where) {
+  // Local variables.
+  plot_state* plot = &plots[schema->plot_id - 1];
+  char        row[LINE_LEN];
+  const char* a = line;
+  const char* b = row;
+  bool        differs = false;
+
+  read_sensors(schema, raw, plot->values);
+  format_row(schema, raw->t, plot->values, row);
+  stats.rows++;
+  if(print_rows) puts(row);
+  if(!line) return;
+
+  // Field by field after the timestamp.
+  a = strchr(a, ',');
+  b = strchr(b, ',');
+  for(uint8_t c = 0; c < schema->num_columns && a && b; c++) {
+    const char* a_end = strchr(a + 1, ',');
+    const char* b_end = strchr(b + 1, ',');
+    size_t      a_len = a_end ? a_end - a - 1 : strlen(a + 1);
+    size_t      b_len = b_end ? b_end - b - 1 : strlen(b + 1);
+
+    if(a_len != b_len || memcmp(a + 1, b + 1, a_len) != 0) {
+      float diff = fabsf(strtof(a + 1, NULL) - strtof(b + 1, NULL));
+      if(!(diff <= tolerance)) {
+        column_stats* cs = &stats.columns[schema->plot_id - 1][c];
+        cs->mismatches++;
+        if(diff > cs->max_diff || isnan(diff)) cs->max_diff = diff;
+        differs = true;
+        if(verbose) {
+          fprintf(stderr, "%s: %s logged %.*s, replayed %.*s\n", where,
+            schema->columns[c], (int)a_len, a + 1, (int)b_len, b + 1);
+        }
+      }
+    }
+    a = a_end;
+    b = b_end;
+  }
+  stats.rows_differing += differs;
+}
+
+//==============================================================================
+// Rebuild Raw Readings
+//==============================================================================
+// Raw readings the sensors could have given for a logged row. Mean columns
+// get samples summing to the logged mean times the sample count, in the
+// sensor's own units.
+static void rebuild_raw(const plot_schema* schema, const float* logged,
+                        raw_minute* raw) {
+  // Local variables.
+  uint8_t probe = 0;
+  float   soil_temp = 0;
+
+  for(uint8_t c = 0; c < schema->num_columns; c++) {
+    if(column_is(schema->columns[c], "soil", "temp")) soil_temp = logged[c];
+  }
+
+  raw->plot_id = schema->plot_id;
+  raw->teros_12_len = raw->teros_21_len = 0;
+  raw->teros_12[0] = raw->teros_21[0] = 0;
+
+  for(uint8_t c = 0; c < schema->num_columns; c++) {
+    const char* name = schema->columns[c];
+    uint8_t     sensor = name[5] - '0';
+    float       v = logged[c];
+
+    if(column_is(name, "irad", "wsqm")) {
+      int16_t counts = irad_counts_for(sensor, v);
+      for(uint8_t i = 0; i < SENSOR_NUM_SAMPLES; i++) raw->irad[i] = counts;
+    }
+    else if(column_is(name, "soil", "volw")) {
+      const teros_12_line* cal = &teros_12_cal[sensor];
+      raw->teros_12_len = snprintf(raw->teros_12, SDI_RESPONSE_LEN,
+        "0+%.2f%+.2f+0", (v - cal->offset) / cal->slope, soil_temp);
+    }
+    else if(column_is(name, "soil", "sowp")) {
+      raw->teros_21_len = snprintf(raw->teros_21, SDI_RESPONSE_LEN,
+        "1-%.2f%+.2f", -v, TEROS_21_TEMP);
+    }
+    else if(column_is(name, "tmph", "temp")) {
+      raw->amb_count = SENSOR_NUM_SAMPLES;
+      spread(lroundf(v * AM2315_PER_UNIT * SENSOR_NUM_SAMPLES), raw->amb_temp, 1);
+    }
+    else if(column_is(name, "tmph", "humd")) {
+      spread(lroundf(v * AM2315_PER_UNIT * SENSOR_NUM_SAMPLES), raw->amb_humd, 1);
+    }
+    else if(column_is(name, "temp", "temp") && probe < MAX_PROBES) {
+      spread(lroundf(v * DS18B20_PER_C * SENSOR_NUM_SAMPLES),
+        &raw->probes[0][probe], MAX_PROBES);
+      probe++;
+    }
+  }
+}
+
+//==============================================================================
+// Plot read_sensors()
+//==============================================================================
+// The board's read_sensors() minus the I/O, column by column: values holds
+// the plot's globals and keeps the last good reading when a parse fails.
+static void read_sensors(const plot_schema* schema, const raw_minute* raw,
+                         float* values) {
+  // Local variables.
+  char     response[SDI_RESPONSE_LEN];
+  float    vwc_counts, temp_12, matric_potential, temp_21;
+  uint16_t conductivity;
+  bool     teros_12_ok = false;
+  bool     teros_21_ok = false;
+  uint8_t  probe = 0;
+
+  if(raw->teros_12_len > 0) {
+    memcpy(response, raw->teros_12, raw->teros_12_len + 1);
+    teros_12_ok = teros_12_parse(response, raw->teros_12_len, &vwc_counts,
+      &temp_12, &conductivity);
+  }
+  if(raw->teros_21_len > 0) {
+    memcpy(response, raw->teros_21, raw->teros_21_len + 1);
+    teros_21_ok = teros_21_parse(response, raw->teros_21_len,
+      &matric_potential, &temp_21);
+  }
+
+  for(uint8_t c = 0; c < schema->num_columns; c++) {
+    const char* name = schema->columns[c];
+    uint8_t     sensor = name[5] - '0';
+
+    if(column_is(name, "irad", "wsqm")) {
+      int32_t irad_samples = 0;
+      for(uint8_t i = 0; i < SENSOR_NUM_SAMPLES; i++) irad_samples += raw->irad[i];
+      int16_t counts = irad_mean_counts(irad_samples, SENSOR_NUM_SAMPLES);
+      values[c] = irad_wsqm(counts, &irad_cal[sensor]);
+    }
+    else if(column_is(name, "soil", "volw")) {
+      if(teros_12_ok) values[c] = teros_12_volw(vwc_counts, &teros_12_cal[sensor]);
+    }
+    else if(column_is(name, "soil", "temp")) {
+      if(teros_12_ok) values[c] = temp_12;
+    }
+    else if(column_is(name, "soil", "sowp")) {
+      if(teros_21_ok) values[c] = matric_potential;
+    }
+    else if(column_is(name, "tmph", "temp") || column_is(name, "tmph", "humd")) {
+      const int16_t* samples = name[7] == 't' ? raw->amb_temp : raw->amb_humd;
+      int32_t sum = 0;
+      for(uint8_t i = 0; i < raw->amb_count; i++) sum += samples[i];
+      values[c] = am2315_mean(sum, raw->amb_count);
+    }
+    else if(column_is(name, "temp", "temp") && probe < MAX_PROBES) {
+      int32_t sum = 0;
+      uint8_t n = 0;
+      for(uint8_t i = 0; i < SENSOR_NUM_SAMPLES; i++) {
+        if(raw->probes[i][probe] > DS18B20_DISCONNECTED_RAW) {
+          sum += raw->probes[i][probe];
+          n++;
+        }
+      }
+      values[c] = ds18b20_mean(sum, n);
+      probe++;
+    }
+  }
+}
+
+//==============================================================================
+// Format Log Row
+//==============================================================================
+// As loop() prints it: irradiance is an int16_t, everything else a float.
+static int format_row(const plot_schema* schema, int64_t t,
+                      const float* values, char* buf) {
+  int len;
+
+  log_format_time(t, buf);
+  len = LOG_TIME_LEN;
+  for(uint8_t c = 0; c < schema->num_columns; c++) {
+    buf[len++] = ',';
+    if(column_is(schema->columns[c], "irad", "wsqm")) {
+      len += sprintf(buf + len, "%d", (int16_t)values[c]);
+    }
+    else {
+      len += log_format_value(values[c], buf + len);
+    }
+  }
+  return len;
+}
+
+//==============================================================================
+// Check Minute Cadence
+//==============================================================================
+// loop() reads once per minute and opens a new MM-DD_HH.log at minute 0.
+static void check_cadence(const plot_schema* schema, int64_t t,
+                          const log_date* file_hour) {
+  plot_state* plot = &plots[schema->plot_id - 1];
+  int64_t     minute = t / SECS_PER_MINUTE;
+
+  if(file_hour) {
+    log_date date;
+    log_date_from_time(t, &date);
+    if(date.month != file_hour->month || date.day != file_hour->day ||
+       date.hour != file_hour->hour) {
+      stats.misfiled++;
+    }
+  }
+
+  if(plot->seen) {
+    int64_t gap = minute - plot->last_minute;
+    // A step back or a jump of more than a day is the RTC losing its time,
+    // not the logger missing minutes.
+    if(gap < 0 || gap > MAX_GAP_MINUTES) stats.clock_jumps++;
+    else if(gap == 0) stats.repeated_minutes++;
+    else stats.missed_minutes += gap - 1;
+  }
+  plot->seen = true;
+  plot->last_minute = minute;
+}
+
+//==============================================================================
+// Irradiance Counts For Logged Value
+//==============================================================================
+// The smallest mean count the calibration maps to the logged W/m^2, or the
+// closest one if none maps to it exactly.
+static int16_t irad_counts_for(uint8_t sensor, float wsqm) {
+  std::unordered_map<int, int16_t>* inverse = &irad_inverse[sensor];
+
+  if(inverse->empty()) {
+    for(int32_t m = MAX_ADC_COUNTS; m >= 0; m--) {
+      (*inverse)[irad_wsqm(m, &irad_cal[sensor])] = m;
+    }
+  }
+
+  auto it = inverse->find((int)wsqm);
+  if(it != inverse->end()) return it->second;
+
+  int16_t best = 0;
+  float   best_diff = INFINITY;
+  for(const auto& kv : *inverse) {
+    float diff = fabsf(kv.first - wsqm);
+    if(diff < best_diff) {
+      best_diff = diff;
+      best = kv.second;
+    }
+  }
+  return best;
+}
+
+//==============================================================================
+// Spread Total Over Samples
+//==============================================================================
+// SENSOR_NUM_SAMPLES values, stride apart, that differ by at most one and
+// add up to total.
+static void spread(int32_t total, int16_t* samples, uint8_t stride) {
+  int32_t base = total / SENSOR_NUM_SAMPLES;
+  int32_t extra = total % SENSOR_NUM_SAMPLES;
+  int32_t step = extra < 0 ? -1 : 1;
+
+  for(uint8_t i = 0; i < SENSOR_NUM_SAMPLES; i++) {
+    samples[i * stride] = base + (i < abs(extra) ? step : 0);
+  }
+}
+
+//==============================================================================
+// Expected Records Per Frame
+//==============================================================================
+// One per irradiance sensor, SDI-12 sensor and sampling loop.
+static int expected_records(const plot_schema* schema) {
+  int  n = 0;
+  bool tmph = false;
+  bool probes = false;
+
+  for(uint8_t c = 0; c < schema->num_columns; c++) {
+    const char* name = schema->columns[c];
+    if(column_is(name, "irad", "wsqm") || column_is(name, "soil", "volw") ||
+       column_is(name, "soil", "sowp")) {
+      n++;
+    }
+    tmph |= strncmp(name, "tmph", 4) == 0;
+    probes |= strncmp(name, "temp", 4) == 0;
+  }
+  return n + tmph + probes;
+}
+
+//==============================================================================
+// Reference Row Key
+//==============================================================================
+static int64_t reference_key(uint8_t plot_id, int64_t t) {
+  return t / SECS_PER_MINUTE * NUM_PLOTS + plot_id - 1;
+}
+
+//==============================================================================
+// Column Kind
+//==============================================================================
+// Column names are prefix_N_kind, e.g. soil_0_volw.
+static bool column_is(const char* name, const char* prefix, const char* kind) {
+  return strncmp(name, prefix, 4) == 0 && strcmp(name + 7, kind) == 0;
+}
+
+//==============================================================================
+// Print Summary
+//==============================================================================
+static void print_summary(double secs) {
+  fprintf(stderr, "rows:             %llu (%llu differ, %llu skipped)\n",
+    (unsigned long long)stats.rows, (unsigned long long)stats.rows_differing,
+    (unsigned long long)stats.skipped);
+  for(uint8_t p = 0; p < NUM_PLOTS; p++) {
+    for(uint8_t c = 0; c < plot_schemas[p].num_columns; c++) {
+      const column_stats* cs = &stats.columns[p][c];
+      if(cs->mismatches == 0) continue;
+      fprintf(stderr, "  %-14s %llu mismatches, max diff %g\n",
+        plot_schemas[p].columns[c], (unsigned long long)cs->mismatches,
+        cs->max_diff);
+    }
+  }
+  if(stats.frames) {
+    fprintf(stderr, "raw frames:       %llu (%llu incomplete, %llu unmatched, "
+      "%lu torn bytes)\n", (unsigned long long)stats.frames,
+      (unsigned long long)stats.incomplete_frames,
+      (unsigned long long)stats.unmatched_frames,
+      (unsigned long)stats.torn_bytes);
+  }
+  fprintf(stderr, "misfiled rows:    %llu\n", (unsigned long long)stats.misfiled);
+  fprintf(stderr, "missed minutes:   %llu\n", (unsigned long long)stats.missed_minutes);
+  fprintf(stderr, "repeated minutes: %llu\n", (unsigned long long)stats.repeated_minutes);
+  fprintf(stderr, "clock jumps:      %llu\n", (unsigned long long)stats.clock_jumps);
+  if(secs > 0) {
+    fprintf(stderr, "replayed %.0f rows/s, %.0fx real time\n", stats.rows / secs,
+      stats.rows * SECS_PER_MINUTE / secs);
+  }
+}
+
+//==============================================================================
+// Check Soil Physics
+//==============================================================================
+// Prints the largest error of each soil_physics result over the sweep and
+// returns false if any is out of tolerance.
+static bool check_soil_physics() {
+  soil_config  topp = {SOIL_TOPP, NULL};
+  soil_config  soilless = {SOIL_SOILLESS, NULL};
+  soil_reading a, b;
+  double       topp_err = 0, soilless_err = 0, dry_err = 0, perm_err = 0;
+  double       ec_err = 0;
+  bool         ok;
+
+  for(double raw = SOIL_RAW_LOW; raw <= SOIL_RAW_HIGH; raw += SOIL_STEP) {
+    double perm = soil_perm(raw);
+
+    soil_compute(&topp, raw, 20, SOIL_TEST_EC, &a);
+    soil_compute(&soilless, raw, 20, SOIL_TEST_EC, &b);
+    topp_err = fmax(topp_err, fabs((double)a.volw / SOIL_VWC_SCALE -
+                                   soil_topp(perm)));
+    soilless_err = fmax(soilless_err, fabs((double)b.volw / SOIL_VWC_SCALE -
+                                           soil_soilless(raw)));
+    if(perm < SOIL_DRY_PERM) {
+      dry_err = fmax(dry_err, fabs((double)a.perm / SOIL_PERM_SCALE - perm));
+    }
+    else {
+      perm_err = fmax(perm_err, fabs((double)a.perm / SOIL_PERM_SCALE - perm) /
+                                perm);
+    }
+  }
+
+  // Sheets and Hendrickx (1995).
+  for(double t = SOIL_TEMP_LOW; t <= SOIL_TEMP_HIGH; t += SOIL_STEP) {
+    double ec = SOIL_TEST_EC * (0.4470 + 1.4034 * exp(-t / 26.815));
+
+    soil_compute(&topp, SOIL_RAW_LOW, t, SOIL_TEST_EC, &a);
+    ec_err = fmax(ec_err, fabs(a.bulk_ec - ec) / ec);
+  }
+
+  ok = topp_err <= SOIL_VWC_TOL && soilless_err <= SOIL_VWC_TOL &&
+       dry_err <= SOIL_DRY_TOL && perm_err <= SOIL_PERM_TOL &&
+       ec_err <= SOIL_EC_TOL;
+  fprintf(stderr, "soil_physics:     Topp volw %.5f, soilless volw %.5f, "
+    "perm %.4f below %g and %.3f%% above, bulk EC %.3f%%: %s\n", topp_err,
+    soilless_err, dry_err, SOIL_DRY_PERM, perm_err * 100, ec_err * 100,
+    ok ? "ok" : "OUT OF TOLERANCE");
+  return ok;
+}
+
+//==============================================================================
+// Permittivity
+//==============================================================================
+// TEROS 12 manual: sqrt(permittivity) is a cubic in raw, no less than 1.
+static double soil_perm(double raw) {
+  double root = ((2.887e-9 * raw - 2.080e-5) * raw + 5.276e-2) * raw - 43.39;
+  return root < 1 ? 1 : root * root;
+}
+
+//==============================================================================
+// Topp Water Content
+//==============================================================================
+static double soil_topp(double perm) {
+  double v = ((4.3e-6 * perm - 5.5e-4) * perm + 2.92e-2) * perm - 5.3e-2;
+  return v < 0 ? 0 : (v > 1 ? 1 : v);
+}
+
+//==============================================================================
+// Soilless Media Water Content
+//==============================================================================
+static double soil_soilless(double raw) {
+  double v = ((6.771e-10 * raw - 5.105e-6) * raw + 1.302e-2) * raw - 10.848;
+  return v < 0 ? 0 : (v > 1 ? 1 : v);
+}
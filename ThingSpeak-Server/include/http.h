@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics ThingSpeak Server HTTP Helpers
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Just enough HTTP/1.1 for the ThingSpeak client library and load tools:
+// request line, headers, Content-Length bodies (no chunked encoding),
+// keep-alive, and url-encoded query/form parameters.
+//
+//------------------------------------------------------------------------------
+
+#ifndef HTTP_H
+#define HTTP_H
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string>
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define HTTP_MAX_HEADER  (8192)
+#define HTTP_MAX_BODY    (4 << 20)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum http_parse_result {
+  HTTP_INCOMPLETE,
+  HTTP_COMPLETE,
+  HTTP_BAD
+};
+
+struct http_request {
+  std::string method;
+  std::string path;              // without the query string
+  std::string query;
+  std::string body;
+  std::string api_key;           // X-THINGSPEAKAPIKEY header
+  std::string content_type;
+  bool        keep_alive;
+  size_t      length;            // bytes of the buffer this request used
+};
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+http_parse_result http_parse(const char* buf, size_t len, http_request* req);
+bool http_param(const std::string& params, const char* name, std::string* value);
+void http_respond(std::string* out, int status, const char* content_type,
+                  const std::string& body, bool keep_alive);
+
+#endif
@@ -0,0 +1,190 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics ThingSpeak Server HTTP Helpers
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "http.h"
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const char* status_text(int status);
+static std::string url_decode(const char* p, const char* end);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Parse Request
+//==============================================================================
+// Parses the request at the start of buf. HTTP_INCOMPLETE means more bytes
+// are needed; on HTTP_COMPLETE, req->length says how many were used so
+// pipelined requests can follow.
+http_parse_result http_parse(const char* buf, size_t len, http_request* req) {
+  // Local variables.
+  const char* head_end = NULL;
+  const char* line;
+  const char* eol;
+  size_t      content_length = 0;
+
+  for(size_t i = 3; i < len; i++) {
+    if(buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n') {
+      head_end = buf + i + 1;
+      break;
+    }
+  }
+  if(!head_end) return len > HTTP_MAX_HEADER ? HTTP_BAD : HTTP_INCOMPLETE;
+
+  // Request line: METHOD TARGET VERSION
+  eol = (const char*)memchr(buf, '\r', head_end - buf);
+  const char* sp1 = (const char*)memchr(buf, ' ', eol - buf);
+  const char* sp2 = sp1 ? (const char*)memchr(sp1 + 1, ' ', eol - sp1 - 1) : NULL;
+  if(!sp2) return HTTP_BAD;
+
+  req->method.assign(buf, sp1);
+  const char* target = sp1 + 1;
+  const char* q = (const char*)memchr(target, '?', sp2 - target);
+  req->path.assign(target, q ? q : sp2);
+  req->query.assign(q ? q + 1 : sp2, sp2);
+  req->keep_alive = strncmp(sp2 + 1, "HTTP/1.1", 8) == 0;
+  req->api_key.clear();
+  req->content_type.clear();
+
+  // Headers we care about.
+  for(line = eol + 2; line < head_end - 2; line = eol + 2) {
+    eol = (const char*)memchr(line, '\r', head_end - line);
+    const char* colon = (const char*)memchr(line, ':', eol - line);
+    if(!colon) return HTTP_BAD;
+
+    size_t      name_len = colon - line;
+    const char* value = colon + 1;
+    while(value < eol && *value == ' ') value++;
+
+    if(name_len == 14 && strncasecmp(line, "Content-Length", 14) == 0) {
+      content_length = strtoul(value, NULL, 10);
+      if(content_length > HTTP_MAX_BODY) return HTTP_BAD;
+    }
+    else if(name_len == 12 && strncasecmp(line, "Content-Type", 12) == 0) {
+      req->content_type.assign(value, eol);
+    }
+    else if(name_len == 10 && strncasecmp(line, "Connection", 10) == 0) {
+      if(strncasecmp(value, "close", 5) == 0) req->keep_alive = false;
+      else if(strncasecmp(value, "keep-alive", 10) == 0) req->keep_alive = true;
+    }
+    else if(name_len == 18 && strncasecmp(line, "X-THINGSPEAKAPIKEY", 18) == 0) {
+      req->api_key.assign(value, eol);
+    }
+    else if(name_len == 17 && strncasecmp(line, "Transfer-Encoding", 17) == 0) {
+      return HTTP_BAD;
+    }
+  }
+
+  if((size_t)(buf + len - head_end) < content_length) return HTTP_INCOMPLETE;
+  req->body.assign(head_end, content_length);
+  req->length = head_end - buf + content_length;
+  return HTTP_COMPLETE;
+}
+
+//==============================================================================
+// Look Up Parameter
+//==============================================================================
+// Finds name in a url-encoded "a=1&b=2" string and decodes its value.
+bool http_param(const std::string& params, const char* name, std::string* value) {
+  const char* p = params.c_str();
+  const char* end = p + params.size();
+  size_t      name_len = strlen(name);
+
+  while(p < end) {
+    const char* amp = (const char*)memchr(p, '&', end - p);
+    if(!amp) amp = end;
+    if((size_t)(amp - p) > name_len && p[name_len] == '=' &&
+       strncmp(p, name, name_len) == 0) {
+      *value = url_decode(p + name_len + 1, amp);
+      return true;
+    }
+    p = amp + 1;
+  }
+  return false;
+}
+
+//==============================================================================
+// Build Response
+//==============================================================================
+// Appends a complete response to out.
+void http_respond(std::string* out, int status, const char* content_type,
+                  const std::string& body, bool keep_alive) {
+  char head[256];
+
+  snprintf(head, sizeof(head),
+    "HTTP/1.1 %d %s\r\n"
+    "Content-Type: %s\r\n"
+    "Content-Length: %zu\r\n"
+    "Connection: %s\r\n"
+    "\r\n",
+    status, status_text(status), content_type, body.size(),
+    keep_alive ? "keep-alive" : "close");
+  out->append(head);
+  out->append(body);
+}
+
+//==============================================================================
+// Status Text
+//==============================================================================
+static const char* status_text(int status) {
+  switch(status) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    default:  return "Internal Server Error";
+  }
+}
+
+//==============================================================================
+// URL Decode
+//==============================================================================
+static std::string url_decode(const char* p, const char* end) {
+  std::string s;
+
+  s.reserve(end - p);
+  for(; p < end; p++) {
+    if(*p == '+') {
+      s += ' ';
+    }
+    else if(*p == '%' && end - p > 2 && isxdigit(p[1]) && isxdigit(p[2])) {
+      char hex[3] = {p[1], p[2], 0};
+      s += (char)strtol(hex, NULL, 16);
+      p += 2;
+    }
+    else {
+      s += *p;
+    }
+  }
+  return s;
+}
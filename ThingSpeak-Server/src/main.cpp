@@ -0,0 +1,1077 @@
+//------------------------------------------------------------------------------
+// GFU Agrivoltaics ThingSpeak Server
+// Nathaniel Hudson
+// nhudson18@georgefox.edu
+// Summer 2021
+//------------------------------------------------------------------------------
+//
+// Local stand-in for api.thingspeak.com, so the upload path can be load
+// tested without the real service and its rate limits. Implements
+//
+//   GET|POST /update                        -> entry ID, or "0"
+//   POST     /channels/ID/bulk_update.json  -> {"success":true}
+//   GET      /channels/ID/feeds.json        -> channel and feed JSON
+//
+// Each channel is a column store, DIR/channel-ID.col, one row per entry,
+// so the data can be read back with Col-Query or Plot-Join.
+//
+//   thingspeak_server [-p PORT] [-d DIR] [-c CONFIG] [-A] [-r SECS]
+//                     [-i SECS] [-v]
+//
+//   -p  TCP port (default 8080)
+//   -d  directory for the channel stores (default .)
+//   -c  channel list, one "CHANNEL WRITE_KEY [COLUMN...]" per line; the
+//       columns name fields 1, 2, ... (default field1..field8)
+//   -A  accept unknown write keys, giving each a new 8-field channel
+//       numbered after the configured ones
+//   -r  minimum seconds between updates to a channel, as ThingSpeak
+//       enforces (default 0, off)
+//   -i  seconds between latency reports on stderr (default 10; 0 reports
+//       only at exit)
+//   -v  print endpoint, status and latency of every request to stdout
+//
+// Latency runs from the first byte of a request arriving to the last byte
+// of its response being written. Stores are synced every few seconds and
+// on SIGINT/SIGTERM.
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//             __             __   ___  __
+//     | |\ | /  ` |    |  | |  \ |__  /__`
+//     | | \| \__, |___ \__/ |__/ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <column_store.h>
+#include <plot_log.h>
+#include "http.h"
+
+//------------------------------------------------------------------------------
+//      __   ___  ___         ___  __
+//     |  \ |__  |__  | |\ | |__  /__`
+//     |__/ |___ |    | | \| |___ .__/
+//
+//------------------------------------------------------------------------------
+
+#define DEFAULT_PORT      (8080)
+#define MAX_FIELDS        (8)
+#define MAX_EVENTS        (256)
+#define READ_CHUNK        (65536)
+#define SYNC_INTERVAL     (5)
+#define FEED_RESULTS      (100)
+#define FEED_MAX_RESULTS  (8000)
+
+// Latency histogram: exact below 8 us, then 8 buckets per power of two.
+#define LAT_SUB_BITS      (3)
+#define LAT_BUCKETS       (64 << LAT_SUB_BITS)
+
+//------------------------------------------------------------------------------
+//     ___      __   ___  __   ___  ___  __
+//      |  \ / |__) |__  |  \ |__  |__  /__`
+//      |   |  |    |___ |__/ |___ |    .__/
+//
+//------------------------------------------------------------------------------
+
+enum endpoint {
+  EP_UPDATE,
+  EP_BULK,
+  EP_FEED,
+  EP_OTHER,
+  NUM_ENDPOINTS
+};
+
+struct channel {
+  uint32_t    id;
+  std::string key;
+  col_store   store;
+  int64_t     last_update;         // server clock, for the rate limit
+  bool        dirty;
+};
+
+// Response written but not yet flushed, waiting for its latency sample.
+struct pending {
+  endpoint ep;
+  bool     ok;
+  int      status;
+  uint64_t start_us;
+};
+
+struct connection {
+  int                  fd;
+  std::string          in;
+  std::string          out;
+  size_t               out_pos;
+  uint64_t             start_us;   // first byte of the request being read
+  bool                 closing;
+  bool                 want_write;
+  std::vector<pending> waiting;
+};
+
+struct latency_hist {
+  uint64_t count;
+  uint64_t rejected;               // errors and "0" updates
+  uint64_t total_us;
+  uint64_t max_us;
+  uint64_t buckets[LAT_BUCKETS];
+};
+
+struct bulk_entry {
+  bool        has_time;
+  std::string created_at;
+  int64_t     delta_t;
+  float       values[MAX_FIELDS];
+};
+
+// Cursor over a JSON text.
+struct json_reader {
+  const char* p;
+  const char* end;
+};
+
+//------------------------------------------------------------------------------
+//                __          __        ___  __
+//     \  /  /\  |__) |  /\  |__) |    |__  /__`
+//      \/  /~~\ |  \ | /~~\ |__) |___ |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static const char* const endpoint_names[NUM_ENDPOINTS] = {
+  "update", "bulk", "feed", "other"
+};
+
+static std::unordered_map<uint32_t, channel*>    channels;
+static std::unordered_map<std::string, channel*> channels_by_key;
+static uint32_t          next_channel_id = 1;
+static const char*       store_dir = ".";
+static bool              auto_channels = false;
+static int64_t           rate_limit = 0;
+static bool              verbose = false;
+static int               epoll_fd;
+static latency_hist      interval_hist[NUM_ENDPOINTS];
+static latency_hist      total_hist[NUM_ENDPOINTS];
+static volatile sig_atomic_t stopping = 0;
+
+//------------------------------------------------------------------------------
+//      __   __   __  ___  __  ___      __   ___  __
+//     |__) |__) /  \  |  /  \  |  \ / |__) |__  /__`
+//     |    |  \ \__/  |  \__/  |   |  |    |___ .__/
+//
+//------------------------------------------------------------------------------
+
+static bool     load_config(const char* path);
+static channel* add_channel(uint32_t id, const std::string& key,
+                            const std::vector<std::string>& names, bool fresh);
+static int      open_listener(uint16_t port);
+static void     accept_connections(int listen_fd);
+static void     on_readable(connection* c);
+static bool     flush(connection* c);
+static void     close_connection(connection* c);
+static endpoint handle(const http_request& req, std::string* out, int* status,
+                       bool* ok);
+static endpoint handle_update(const http_request& req, std::string* out,
+                              int* status, bool* ok);
+static endpoint handle_bulk(uint32_t id, const http_request& req,
+                            std::string* out, int* status, bool* ok);
+static endpoint handle_feed(uint32_t id, const http_request& req,
+                            std::string* out, int* status, bool* ok);
+static bool     parse_bulk(const std::string& body, std::string* key,
+                           std::vector<bulk_entry>* entries);
+static bool     json_expect(json_reader* j, char c);
+static bool     json_string(json_reader* j, std::string* s);
+static bool     json_scalar(json_reader* j, std::string* s, bool* is_null);
+static bool     json_skip(json_reader* j);
+static bool     parse_created_at(const std::string& s, int64_t* t);
+static void     format_created_at(int64_t t, char* buf, size_t len);
+static bool     parse_field(const std::string& s, float* value);
+static void     record_latency(const pending& p, uint64_t end_us);
+static void     report(const latency_hist* hists, double secs, const char* title);
+static uint32_t lat_bucket(uint64_t us);
+static uint64_t lat_bucket_top(uint32_t b);
+static uint64_t lat_percentile(const latency_hist* h, double p);
+static uint64_t now_us();
+static void     on_signal(int sig);
+static void     usage(const char* name);
+
+//------------------------------------------------------------------------------
+//      __        __          __
+//     |__) |  | |__) |    | /  `
+//     |    \__/ |__) |___ | \__,
+//
+//------------------------------------------------------------------------------
+
+//==============================================================================
+// Main
+//==============================================================================
+int main(int argc, char** argv) {
+  // Local variables.
+  uint16_t           port = DEFAULT_PORT;
+  const char*        config = NULL;
+  int                report_secs = 10;
+  int                listen_fd;
+  epoll_event        events[MAX_EVENTS];
+  struct sigaction   sa;
+
+  for(int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if(strcmp(argv[i], "-p") == 0 && has_value) port = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-d") == 0 && has_value) store_dir = argv[++i];
+    else if(strcmp(argv[i], "-c") == 0 && has_value) config = argv[++i];
+    else if(strcmp(argv[i], "-A") == 0) auto_channels = true;
+    else if(strcmp(argv[i], "-r") == 0 && has_value) rate_limit = atol(argv[++i]);
+    else if(strcmp(argv[i], "-i") == 0 && has_value) report_secs = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-v") == 0) verbose = true;
+    else usage(argv[0]);
+  }
+  if(!config && !auto_channels) usage(argv[0]);
+  if(config && !load_config(config)) return 1;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  listen_fd = open_listener(port);
+  if(listen_fd < 0) return 1;
+  epoll_fd = epoll_create1(0);
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+  fprintf(stderr, "listening on port %u, %zu channels\n", port, channels.size());
+
+  uint64_t start_us = now_us();
+  uint64_t last_sync_us = start_us;
+  uint64_t last_report_us = start_us;
+
+  while(!stopping) {
+    int n = epoll_wait(epoll_fd, events, MAX_EVENTS, 1000);
+    if(n < 0 && errno != EINTR) {
+      perror("epoll_wait");
+      break;
+    }
+
+    for(int i = 0; i < n; i++) {
+      connection* c = (connection*)events[i].data.ptr;
+      if(!c) {
+        accept_connections(listen_fd);
+        continue;
+      }
+      if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) on_readable(c);
+      else if(events[i].events & EPOLLOUT) flush(c);
+    }
+
+    // Housekeeping between batches of events.
+    uint64_t now = now_us();
+    if(now - last_sync_us >= SYNC_INTERVAL * 1000000ULL) {
+      for(auto& kv : channels) {
+        if(kv.second->dirty) col_sync(&kv.second->store);
+        kv.second->dirty = false;
+      }
+      last_sync_us = now;
+    }
+    if(report_secs > 0 && now - last_report_us >= report_secs * 1000000ULL) {
+      report(interval_hist, (now - last_report_us) / 1e6, "last interval");
+      memset(interval_hist, 0, sizeof(interval_hist));
+      last_report_us = now;
+    }
+  }
+
+  report(total_hist, (now_us() - start_us) / 1e6, "total");
+  for(auto& kv : channels) {
+    col_sync(&kv.second->store);
+    col_close(&kv.second->store);
+  }
+  close(listen_fd);
+  return 0;
+}
+
+//==============================================================================
+// Load Channel List
+//==============================================================================
+static bool load_config(const char* path) {
+  // Local variables.
+  FILE* f = fopen(path, "r");
+  char  line[1024];
+  int   line_num = 0;
+
+  if(!f) {
+    perror(path);
+    return false;
+  }
+
+  while(fgets(line, sizeof(line), f)) {
+    std::vector<std::string> words;
+    line_num++;
+    for(char* w = strtok(line, " \t\r\n"); w; w = strtok(NULL, " \t\r\n")) {
+      if(w[0] == '#') break;
+      words.push_back(w);
+    }
+    if(words.empty()) continue;
+
+    uint32_t id = strtoul(words[0].c_str(), NULL, 10);
+    if(words.size() < 2 || id == 0 || words.size() - 2 > MAX_FIELDS ||
+       channels.count(id) || channels_by_key.count(words[1])) {
+      fprintf(stderr, "%s:%d: bad channel\n", path, line_num);
+      fclose(f);
+      return false;
+    }
+    std::vector<std::string> names(words.begin() + 2, words.end());
+    if(!add_channel(id, words[1], names, false)) {
+      fclose(f);
+      return false;
+    }
+  }
+
+  fclose(f);
+  return true;
+}
+
+//==============================================================================
+// Add Channel
+//==============================================================================
+// Opens the channel's store, creating it if it doesn't exist yet or if
+// fresh is set.
+static channel* add_channel(uint32_t id, const std::string& key,
+                            const std::vector<std::string>& names, bool fresh) {
+  // Local variables.
+  channel*    ch = new channel();
+  char        path[512];
+  const char* name_ptrs[MAX_FIELDS];
+  char        defaults[MAX_FIELDS][8];
+  uint8_t     num_fields = names.empty() ? MAX_FIELDS : names.size();
+
+  for(uint8_t i = 0; i < num_fields; i++) {
+    snprintf(defaults[i], sizeof(defaults[i]), "field%u", i + 1);
+    name_ptrs[i] = names.empty() ? defaults[i] : names[i].c_str();
+  }
+
+  snprintf(path, sizeof(path), "%s/channel-%u.col", store_dir, id);
+  bool ok = !fresh && access(path, F_OK) == 0 ?
+    col_open(&ch->store, path, true) :
+    col_create(&ch->store, path, 0, num_fields, name_ptrs);
+  if(!ok) {
+    delete ch;
+    return NULL;
+  }
+
+  ch->id = id;
+  ch->key = key;
+  ch->last_update = INT64_MIN;
+  channels[id] = ch;
+  channels_by_key[key] = ch;
+  if(id >= next_channel_id) next_channel_id = id + 1;
+  return ch;
+}
+
+//==============================================================================
+// Open Listening Socket
+//==============================================================================
+static int open_listener(uint16_t port) {
+  int         fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int         one = 1;
+  sockaddr_in addr = {};
+
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if(fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+     listen(fd, SOMAXCONN) != 0) {
+    perror("listen");
+    if(fd >= 0) close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+//==============================================================================
+// Accept New Connections
+//==============================================================================
+static void accept_connections(int listen_fd) {
+  int one = 1;
+
+  for(;;) {
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK);
+    if(fd < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        perror("accept");
+      }
+      return;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    connection* c = new connection();
+    c->fd = fd;
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+//==============================================================================
+// Read And Handle Requests
+//==============================================================================
+static void on_readable(connection* c) {
+  // Local variables.
+  char         buf[READ_CHUNK];
+  bool         eof = false;
+  http_request req;
+
+  for(;;) {
+    ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+    if(n > 0) {
+      if(c->in.empty()) c->start_us = now_us();
+      c->in.append(buf, n);
+      continue;
+    }
+    if(n == 0) eof = true;
+    else if(errno == EINTR) continue;
+    else if(errno != EAGAIN && errno != EWOULDBLOCK) eof = true;
+    break;
+  }
+
+  // Handle every complete request; pipelined ones queue up in order.
+  while(!c->closing && !c->in.empty()) {
+    http_parse_result r = http_parse(c->in.data(), c->in.size(), &req);
+    if(r == HTTP_INCOMPLETE) break;
+
+    pending p;
+    p.start_us = c->start_us;
+    if(r == HTTP_BAD) {
+      http_respond(&c->out, 400, "text/plain", "0", false);
+      p.ep = EP_OTHER;
+      p.status = 400;
+      p.ok = false;
+      c->closing = true;
+      c->in.clear();
+    }
+    else {
+      p.ep = handle(req, &c->out, &p.status, &p.ok);
+      c->in.erase(0, req.length);
+      if(!c->in.empty()) c->start_us = now_us();
+      if(!req.keep_alive) c->closing = true;
+    }
+    c->waiting.push_back(p);
+  }
+
+  if(eof && c->out.size() == c->out_pos) {
+    close_connection(c);
+    return;
+  }
+  if(eof) c->closing = true;
+  flush(c);
+}
+
+//==============================================================================
+// Write Pending Output
+//==============================================================================
+// Returns false if the connection was closed.
+static bool flush(connection* c) {
+  while(c->out_pos < c->out.size()) {
+    ssize_t n = send(c->fd, c->out.data() + c->out_pos,
+      c->out.size() - c->out_pos, MSG_NOSIGNAL);
+    if(n > 0) {
+      c->out_pos += n;
+      continue;
+    }
+    if(n < 0 && errno == EINTR) continue;
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if(!c->want_write) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.ptr = c;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_write = true;
+      }
+      return true;
+    }
+    close_connection(c);
+    return false;
+  }
+
+  // Everything written: the queued requests are done.
+  uint64_t end_us = now_us();
+  for(const pending& p : c->waiting) record_latency(p, end_us);
+  c->waiting.clear();
+  c->out.clear();
+  c->out_pos = 0;
+
+  if(c->closing) {
+    close_connection(c);
+    return false;
+  }
+  if(c->want_write) {
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_write = false;
+  }
+  return true;
+}
+
+//==============================================================================
+// Close Connection
+//==============================================================================
+static void close_connection(connection* c) {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+  close(c->fd);
+  delete c;
+}
+
+//==============================================================================
+// Route Request
+//==============================================================================
+static endpoint handle(const http_request& req, std::string* out, int* status,
+                       bool* ok) {
+  // Local variables.
+  uint32_t id;
+  int      len = 0;
+  char     rest[32] = "";
+
+  *ok = false;
+  if(req.path == "/update" || req.path == "/update.json") {
+    return handle_update(req, out, status, ok);
+  }
+
+  if(sscanf(req.path.c_str(), "/channels/%u/%n", &id, &len) == 1 && len > 0) {
+    snprintf(rest, sizeof(rest), "%s", req.path.c_str() + len);
+    if(strcmp(rest, "bulk_update.json") == 0) {
+      return handle_bulk(id, req, out, status, ok);
+    }
+    if(strcmp(rest, "feeds.json") == 0) {
+      return handle_feed(id, req, out, status, ok);
+    }
+  }
+
+  *status = 404;
+  http_respond(out, *status, "text/plain", "0", req.keep_alive);
+  return EP_OTHER;
+}
+
+//==============================================================================
+// Single Update
+//==============================================================================
+// Parameters come from the form body of a POST (as the Arduino library
+// sends them) or the query string. The response body is the new entry's
+// ID, or "0" when nothing was stored, which the library reports as
+// TS_ERR_NOT_INSERTED.
+static endpoint handle_update(const http_request& req, std::string* out,
+                              int* status, bool* ok) {
+  // Local variables.
+  const std::string& params =
+    req.method == "POST" && !req.body.empty() ? req.body : req.query;
+  std::string key = req.api_key;
+  std::string value;
+  channel*    ch;
+  int64_t     now = time(NULL);
+  int64_t     t = now;
+  float       values[MAX_FIELDS];
+
+  http_param(params, "api_key", &key);
+  auto it = channels_by_key.find(key);
+  if(it != channels_by_key.end()) {
+    ch = it->second;
+  }
+  else if(auto_channels && !key.empty()) {
+    ch = add_channel(next_channel_id, key, std::vector<std::string>(), true);
+    if(ch) fprintf(stderr, "created channel %u\n", ch->id);
+  }
+  else {
+    ch = NULL;
+  }
+  if(!ch) {
+    *status = 401;
+    http_respond(out, *status, "text/plain", "0", req.keep_alive);
+    return EP_UPDATE;
+  }
+
+  *status = 200;
+  uint8_t num_fields = ch->store.header->num_columns;
+  for(uint8_t i = 0; i < num_fields; i++) {
+    char name[8];
+    snprintf(name, sizeof(name), "field%u", i + 1);
+    values[i] = NAN;
+    if(http_param(params, name, &value)) parse_field(value, &values[i]);
+  }
+
+  bool accepted = rate_limit == 0 || ch->last_update == INT64_MIN ||
+                  now - ch->last_update >= rate_limit;
+  if(accepted && http_param(params, "created_at", &value)) {
+    accepted = parse_created_at(value, &t);
+  }
+  if(accepted) accepted = col_append(&ch->store, t, values);
+  if(!accepted) {
+    http_respond(out, *status, "text/plain", "0", req.keep_alive);
+    return EP_UPDATE;
+  }
+
+  ch->last_update = now;
+  ch->dirty = true;
+  *ok = true;
+  http_respond(out, *status, "text/plain",
+    std::to_string(ch->store.header->num_rows), req.keep_alive);
+  return EP_UPDATE;
+}
+
+//==============================================================================
+// Bulk Update
+//==============================================================================
+// Entries carry either an absolute created_at or a relative delta_t; as on
+// ThingSpeak, a relative entry is delta_t seconds before the entry after
+// it, and the last one is stamped with the time the request arrived.
+// Entries older than what the channel already holds are dropped.
+static endpoint handle_bulk(uint32_t id, const http_request& req,
+                            std::string* out, int* status, bool* ok) {
+  // Local variables.
+  std::string             key;
+  std::vector<bulk_entry> entries;
+  std::vector<int64_t>    times;
+  int64_t                 now = time(NULL);
+  size_t                  stored = 0;
+
+  auto it = channels.find(id);
+  if(req.method != "POST") {
+    *status = 405;
+  }
+  else if(!parse_bulk(req.body, &key, &entries)) {
+    *status = 400;
+  }
+  else if(it == channels.end() || it->second->key != key) {
+    *status = 401;
+  }
+  else if(rate_limit > 0 && it->second->last_update != INT64_MIN &&
+          now - it->second->last_update < rate_limit) {
+    *status = 429;
+  }
+  else {
+    *status = 202;
+  }
+  if(*status != 202) {
+    http_respond(out, *status, "application/json", "{\"success\":false}",
+      req.keep_alive);
+    return EP_BULK;
+  }
+
+  channel* ch = it->second;
+  times.resize(entries.size());
+  for(size_t i = entries.size(); i-- > 0;) {
+    if(entries[i].has_time) {
+      if(!parse_created_at(entries[i].created_at, &times[i])) times[i] = INT64_MIN;
+    }
+    else if(i + 1 < entries.size()) {
+      times[i] = times[i + 1] - entries[i + 1].delta_t;
+    }
+    else {
+      times[i] = now;
+    }
+  }
+  for(size_t i = 0; i < entries.size(); i++) {
+    if(times[i] != INT64_MIN &&
+       col_append(&ch->store, times[i], entries[i].values)) {
+      stored++;
+    }
+  }
+
+  if(stored > 0) {
+    ch->last_update = now;
+    ch->dirty = true;
+  }
+  *ok = stored == entries.size();
+  if(stored == 0) *status = 400;
+  http_respond(out, *status, "application/json",
+    *ok ? "{\"success\":true}" : "{\"success\":false}", req.keep_alive);
+  return EP_BULK;
+}
+
+//==============================================================================
+// Channel Feed
+//==============================================================================
+// Returns the most recent "results" entries (default 100, at most 8000),
+// optionally limited to "start" <= created_at <= "end".
+static endpoint handle_feed(uint32_t id, const http_request& req,
+                            std::string* out, int* status, bool* ok) {
+  // Local variables.
+  std::string value;
+  std::string body;
+  int64_t     from = INT64_MIN;
+  int64_t     to = INT64_MAX;
+  uint64_t    results = FEED_RESULTS;
+  col_cursor  cursor;
+  char        buf[128];
+
+  auto it = channels.find(id);
+  if(it == channels.end()) {
+    *status = 404;
+    http_respond(out, *status, "application/json", "-1", req.keep_alive);
+    return EP_FEED;
+  }
+  if(http_param(req.query, "results", &value)) {
+    results = strtoull(value.c_str(), NULL, 10);
+    if(results > FEED_MAX_RESULTS) results = FEED_MAX_RESULTS;
+  }
+  if((http_param(req.query, "start", &value) && !parse_created_at(value, &from)) ||
+     (http_param(req.query, "end", &value) && !parse_created_at(value, &to))) {
+    *status = 400;
+    http_respond(out, *status, "application/json", "-1", req.keep_alive);
+    return EP_FEED;
+  }
+
+  // Row indexes of the range, then keep only its tail.
+  const col_store* s = &it->second->store;
+  uint64_t num_rows = s->header->num_rows;
+  col_cursor_seek(&cursor, s, from);
+  uint64_t first = col_cursor_valid(&cursor) ?
+    (uint64_t)cursor.block * COL_BLOCK_ROWS + cursor.row : num_rows;
+  uint64_t last = num_rows;
+  if(to != INT64_MAX) {
+    col_cursor_seek(&cursor, s, to + 1);
+    if(col_cursor_valid(&cursor)) {
+      last = (uint64_t)cursor.block * COL_BLOCK_ROWS + cursor.row;
+    }
+  }
+  if(last < first) last = first;
+  if(last - first > results) first = last - results;
+
+  uint8_t num_fields = s->header->num_columns;
+  snprintf(buf, sizeof(buf), "{\"channel\":{\"id\":%u,\"name\":\"channel %u\"",
+    id, id);
+  body = buf;
+  for(uint8_t c = 0; c < num_fields; c++) {
+    snprintf(buf, sizeof(buf), ",\"field%u\":\"%s\"", c + 1, s->header->names[c]);
+    body += buf;
+  }
+  snprintf(buf, sizeof(buf), ",\"last_entry_id\":%llu},\"feeds\":[",
+    (unsigned long long)num_rows);
+  body += buf;
+
+  for(uint64_t i = first; i < last; i++) {
+    uint32_t block = i / COL_BLOCK_ROWS;
+    uint32_t row = i % COL_BLOCK_ROWS;
+    char     date[32];
+
+    format_created_at(col_block_times(s, block)[row], date, sizeof(date));
+    snprintf(buf, sizeof(buf), "%s{\"created_at\":\"%s\",\"entry_id\":%llu",
+      i == first ? "" : ",", date, (unsigned long long)i + 1);
+    body += buf;
+    for(uint8_t c = 0; c < num_fields; c++) {
+      float v = col_block_values(s, block, c)[row];
+      if(isnan(v)) snprintf(buf, sizeof(buf), ",\"field%u\":null", c + 1);
+      else snprintf(buf, sizeof(buf), ",\"field%u\":\"%g\"", c + 1, v);
+      body += buf;
+    }
+    body += '}';
+  }
+  body += "]}";
+
+  *status = 200;
+  *ok = true;
+  http_respond(out, *status, "application/json", body, req.keep_alive);
+  return EP_FEED;
+}
+
+//==============================================================================
+// Parse Bulk Update Body
+//==============================================================================
+// {"write_api_key":"KEY","updates":[{"created_at":"...","field1":1.5},
+//  {"delta_t":15,"field1":"2"}, ...]}
+static bool parse_bulk(const std::string& body, std::string* key,
+                       std::vector<bulk_entry>* entries) {
+  // Local variables.
+  json_reader j = {body.data(), body.data() + body.size()};
+  std::string name;
+  std::string value;
+  bool        is_null;
+
+  if(!json_expect(&j, '{')) return false;
+  while(!json_expect(&j, '}')) {
+    if(!json_string(&j, &name) || !json_expect(&j, ':')) return false;
+
+    if(name == "write_api_key") {
+      if(!json_string(&j, key)) return false;
+    }
+    else if(name == "updates") {
+      if(!json_expect(&j, '[')) return false;
+      while(!json_expect(&j, ']')) {
+        bulk_entry e;
+        e.has_time = false;
+        e.delta_t = 0;
+        for(uint8_t i = 0; i < MAX_FIELDS; i++) e.values[i] = NAN;
+
+        if(!json_expect(&j, '{')) return false;
+        while(!json_expect(&j, '}')) {
+          unsigned field;
+          if(!json_string(&j, &name) || !json_expect(&j, ':') ||
+             !json_scalar(&j, &value, &is_null)) {
+            return false;
+          }
+          if(name == "created_at") {
+            e.has_time = true;
+            e.created_at = value;
+          }
+          else if(name == "delta_t") {
+            e.delta_t = atoll(value.c_str());
+          }
+          else if(sscanf(name.c_str(), "field%u", &field) == 1 &&
+                  field >= 1 && field <= MAX_FIELDS && !is_null) {
+            parse_field(value, &e.values[field - 1]);
+          }
+          json_expect(&j, ',');
+        }
+        entries->push_back(e);
+        json_expect(&j, ',');
+      }
+    }
+    else if(!json_skip(&j)) {
+      return false;
+    }
+    json_expect(&j, ',');
+  }
+  return !key->empty();
+}
+
+//==============================================================================
+// JSON: Consume Character
+//==============================================================================
+// Skips whitespace, then consumes c if it is next.
+static bool json_expect(json_reader* j, char c) {
+  while(j->p < j->end && isspace((unsigned char)*j->p)) j->p++;
+  if(j->p < j->end && *j->p == c) {
+    j->p++;
+    return true;
+  }
+  return false;
+}
+
+//==============================================================================
+// JSON: String
+//==============================================================================
+static bool json_string(json_reader* j, std::string* s) {
+  if(!json_expect(j, '"')) return false;
+  s->clear();
+  while(j->p < j->end && *j->p != '"') {
+    if(*j->p == '\\' && j->p + 1 < j->end) j->p++;
+    *s += *j->p++;
+  }
+  if(j->p == j->end) return false;
+  j->p++;
+  return true;
+}
+
+//==============================================================================
+// JSON: Scalar
+//==============================================================================
+// A string, or the text of a number or literal.
+static bool json_scalar(json_reader* j, std::string* s, bool* is_null) {
+  *is_null = false;
+  if(json_expect(j, '"')) {
+    j->p--;
+    return json_string(j, s);
+  }
+  const char* start = j->p;
+  while(j->p < j->end && !strchr(",}] \t\r\n", *j->p)) j->p++;
+  if(j->p == start) return false;
+  s->assign(start, j->p);
+  *is_null = *s == "null";
+  return true;
+}
+
+//==============================================================================
+// JSON: Skip Value
+//==============================================================================
+static bool json_skip(json_reader* j) {
+  std::string s;
+  bool        is_null;
+  char        close;
+
+  if(json_expect(j, '{')) close = '}';
+  else if(json_expect(j, '[')) close = ']';
+  else return json_scalar(j, &s, &is_null);
+
+  while(!json_expect(j, close)) {
+    if(close == '}' && (!json_string(j, &s) || !json_expect(j, ':'))) {
+      return false;
+    }
+    if(!json_skip(j)) return false;
+    json_expect(j, ',');
+  }
+  return true;
+}
+
+//==============================================================================
+// Parse created_at
+//==============================================================================
+// ISO 8601 as ThingSpeak takes it: "YYYY-MM-DD HH:MM:SS" or with a 'T',
+// then nothing (UTC), "Z", or an offset like "-0700" / "-07:00".
+static bool parse_created_at(const std::string& s, int64_t* t) {
+  // Local variables.
+  char        buf[20];
+  log_date    date;
+  const char* p;
+  int         hours = 0;
+  int         minutes = 0;
+
+  if(s.size() < 19) return false;
+  memcpy(buf, s.data(), 19);
+  buf[19] = 0;
+  if(buf[10] == 'T') buf[10] = ' ';
+  if(!log_parse_time(buf, buf + 19, &date)) return false;
+  *t = log_time_from_date(&date);
+
+  p = s.c_str() + 19;
+  while(*p == ' ') p++;
+  if(*p == 0 || strcmp(p, "Z") == 0) return true;
+  if((*p != '+' && *p != '-') ||
+     (sscanf(p + 1, "%2d:%2d", &hours, &minutes) != 2 &&
+      sscanf(p + 1, "%2d%2d", &hours, &minutes) != 2)) {
+    return false;
+  }
+  int64_t offset = hours * 3600 + minutes * SECS_PER_MINUTE;
+  *t -= *p == '-' ? -offset : offset;
+  return true;
+}
+
+//==============================================================================
+// Format created_at
+//==============================================================================
+static void format_created_at(int64_t t, char* buf, size_t len) {
+  log_date date;
+
+  log_date_from_time(t, &date);
+  snprintf(buf, len, "%04d-%02u-%02uT%02u:%02u:%02uZ", date.year, date.month,
+    date.day, date.hour, date.minute, date.second);
+}
+
+//==============================================================================
+// Parse Field Value
+//==============================================================================
+static bool parse_field(const std::string& s, float* value) {
+  char* end;
+  float v = strtof(s.c_str(), &end);
+
+  if(s.empty() || *end != 0) return false;
+  *value = v;
+  return true;
+}
+
+//==============================================================================
+// Record Latency
+//==============================================================================
+static void record_latency(const pending& p, uint64_t end_us) {
+  uint64_t us = end_us - p.start_us;
+
+  for(latency_hist* h : {&interval_hist[p.ep], &total_hist[p.ep]}) {
+    h->count++;
+    h->rejected += !p.ok;
+    h->total_us += us;
+    if(us > h->max_us) h->max_us = us;
+    h->buckets[lat_bucket(us)]++;
+  }
+  if(verbose) printf("%s %d %llu\n", endpoint_names[p.ep], p.status,
+    (unsigned long long)us);
+}
+
+//==============================================================================
+// Print Latency Report
+//==============================================================================
+static void report(const latency_hist* hists, double secs, const char* title) {
+  fprintf(stderr, "%s (%.1f s):\n", title, secs);
+  for(uint8_t e = 0; e < NUM_ENDPOINTS; e++) {
+    const latency_hist* h = &hists[e];
+    if(h->count == 0) continue;
+    fprintf(stderr, "  %-6s %8llu req %6llu rejected %9.1f req/s  "
+      "mean %6llu us  p50 %6llu  p90 %6llu  p99 %6llu  max %6llu\n",
+      endpoint_names[e], (unsigned long long)h->count,
+      (unsigned long long)h->rejected, h->count / secs,
+      (unsigned long long)(h->total_us / h->count),
+      (unsigned long long)lat_percentile(h, 0.50),
+      (unsigned long long)lat_percentile(h, 0.90),
+      (unsigned long long)lat_percentile(h, 0.99),
+      (unsigned long long)h->max_us);
+  }
+}
+
+//==============================================================================
+// Latency Bucket Index
+//==============================================================================
+static uint32_t lat_bucket(uint64_t us) {
+  if(us < (1u << LAT_SUB_BITS)) return us;
+
+  uint32_t msb = 63 - __builtin_clzll(us);
+  uint32_t sub = (us >> (msb - LAT_SUB_BITS)) & ((1u << LAT_SUB_BITS) - 1);
+  return ((msb - LAT_SUB_BITS + 1) << LAT_SUB_BITS) + sub;
+}
+
+//==============================================================================
+// Latency Bucket Upper Bound
+//==============================================================================
+static uint64_t lat_bucket_top(uint32_t b) {
+  if(b < (1u << LAT_SUB_BITS)) return b;
+
+  uint32_t msb = (b >> LAT_SUB_BITS) + LAT_SUB_BITS - 1;
+  uint64_t sub = b & ((1u << LAT_SUB_BITS) - 1);
+  return (((1ULL << LAT_SUB_BITS) + sub + 1) << (msb - LAT_SUB_BITS)) - 1;
+}
+
+//==============================================================================
+// Latency Percentile
+//==============================================================================
+static uint64_t lat_percentile(const latency_hist* h, double p) {
+  uint64_t target = (uint64_t)ceil(h->count * p);
+  uint64_t seen = 0;
+
+  for(uint32_t b = 0; b < LAT_BUCKETS; b++) {
+    seen += h->buckets[b];
+    if(seen >= target && seen > 0) {
+      uint64_t top = lat_bucket_top(b);
+      return top < h->max_us ? top : h->max_us;
+    }
+  }
+  return h->max_us;
+}
+
+//==============================================================================
+// Monotonic Clock
+//==============================================================================
+static uint64_t now_us() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//==============================================================================
+// Signal Handler
+//==============================================================================
+static void on_signal(int sig) {
+  (void)sig;
+  stopping = 1;
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-p PORT] [-d DIR] [-c CONFIG] [-A] [-r SECS] "
+    "[-i SECS] [-v]\n", name);
+  exit(2);
+}